@@ -0,0 +1,175 @@
+/*
+ * EnvironmentGrid implementation
+ *
+ * Released under the GPL version 3.
+ *
+ */
+
+#ifndef __ENVIRONMENT_GRID_H__
+#define __ENVIRONMENT_GRID_H__
+
+#include "slam6d/data_types.h"
+#include "slam6d/globals.icc"
+
+#include <vector>
+#include <unordered_map>
+#include <limits>
+#include <algorithm>
+#include <cmath>
+#include <stdint.h>
+
+/**
+ * @brief Sparse uniform grid over the environment for CTYPE4 of
+ * collision_model
+ *
+ * The cell size equals the search radius, so all environment points within
+ * the radius of a query point lie in the 27 cells around it and every cell
+ * is found with a single hash lookup. The points are stored sorted by cell.
+ * Cells whose points all collide already are flagged as done and skipped,
+ * which makes the large overlap between consecutive poses almost free.
+ */
+class EnvironmentGrid {
+public:
+    EnvironmentGrid(DataXYZ &environment, double cellsize)
+        : m_cellsize(cellsize), m_size(environment.size())
+    {
+        for (int k = 0; k < 3; ++k) {
+            m_min[k] = std::numeric_limits<double>::max();
+            m_max[k] = -std::numeric_limits<double>::max();
+        }
+        std::vector<uint64_t> keys(m_size);
+        for (size_t i = 0; i < m_size; ++i) {
+            for (int k = 0; k < 3; ++k) {
+                m_min[k] = std::min(m_min[k], environment[i][k]);
+                m_max[k] = std::max(m_max[k], environment[i][k]);
+            }
+            keys[i] = key(environment[i]);
+        }
+        // counting sort of the point indices by cell
+        std::vector<size_t> cell_of_point(m_size);
+        for (size_t i = 0; i < m_size; ++i) {
+            auto it = m_cells.find(keys[i]);
+            if (it == m_cells.end()) {
+                it = m_cells.insert(std::make_pair(keys[i], m_start.size())).first;
+                m_start.push_back(0);
+            }
+            cell_of_point[i] = it->second;
+            m_start[it->second]++;
+        }
+        size_t sum = 0;
+        for (size_t c = 0; c < m_start.size(); ++c) {
+            size_t tmp = m_start[c];
+            m_start[c] = sum;
+            sum += tmp;
+        }
+        m_start.push_back(sum);
+        m_index.resize(m_size);
+        m_points.resize(3 * m_size);
+        std::vector<size_t> fill(m_start.begin(), m_start.end() - 1);
+        for (size_t i = 0; i < m_size; ++i) {
+            size_t j = fill[cell_of_point[i]]++;
+            m_index[j] = i;
+            m_points[3*j + 0] = environment[i][0];
+            m_points[3*j + 1] = environment[i][1];
+            m_points[3*j + 2] = environment[i][2];
+        }
+        m_remaining.resize(m_start.size() - 1);
+        for (size_t c = 0; c + 1 < m_start.size(); ++c)
+            m_remaining[c] = m_start[c+1] - m_start[c];
+        m_colliding.resize(m_size, 0);
+    }
+
+    size_t numCells() const { return m_start.size() - 1; }
+
+    /*
+     * returns false if the axis aligned box [lo, hi] does not touch the
+     * bounding box of the environment grown by the search radius
+     */
+    bool overlaps(const double *lo, const double *hi) const
+    {
+        for (int k = 0; k < 3; ++k) {
+            if (hi[k] < m_min[k] - m_cellsize || lo[k] > m_max[k] + m_cellsize)
+                return false;
+        }
+        return true;
+    }
+
+    /*
+     * marks all environment points p with Dist2(p, q) < sqRad2 as colliding
+     */
+    void collide(const double *q, double sqRad2)
+    {
+        int64_t c[3];
+        for (int k = 0; k < 3; ++k)
+            c[k] = (int64_t)floor(q[k] / m_cellsize);
+        for (int64_t dx = -1; dx <= 1; ++dx)
+        for (int64_t dy = -1; dy <= 1; ++dy)
+        for (int64_t dz = -1; dz <= 1; ++dz) {
+            auto it = m_cells.find(pack(c[0] + dx, c[1] + dy, c[2] + dz));
+            if (it == m_cells.end())
+                continue;
+            size_t cell = it->second;
+            size_t remaining;
+#pragma omp atomic read
+            remaining = m_remaining[cell];
+            if (remaining == 0)
+                continue;
+            for (size_t j = m_start[cell]; j < m_start[cell + 1]; ++j) {
+                if (Dist2(q, &m_points[3*j]) >= sqRad2)
+                    continue;
+                char was_colliding;
+#pragma omp atomic capture
+                { was_colliding = m_colliding[j]; m_colliding[j] = 1; }
+                if (!was_colliding) {
+#pragma omp atomic
+                    m_remaining[cell]--;
+                }
+            }
+        }
+    }
+
+    /*
+     * writes the result back in the order of the environment points and
+     * returns the number of colliding points
+     */
+    size_t getColliding(std::vector<bool> &colliding) const
+    {
+        size_t num_colliding = 0;
+        for (size_t j = 0; j < m_size; ++j) {
+            if (m_colliding[j]) {
+                colliding[m_index[j]] = true;
+                num_colliding++;
+            }
+        }
+        return num_colliding;
+    }
+
+private:
+    uint64_t pack(int64_t x, int64_t y, int64_t z) const
+    {
+        // 21 bits per axis, enough for two million cells in every direction
+        return ((uint64_t)(x & 0x1FFFFF) << 42)
+             | ((uint64_t)(y & 0x1FFFFF) << 21)
+             | (uint64_t)(z & 0x1FFFFF);
+    }
+
+    uint64_t key(const double *p) const
+    {
+        return pack((int64_t)floor(p[0] / m_cellsize),
+                    (int64_t)floor(p[1] / m_cellsize),
+                    (int64_t)floor(p[2] / m_cellsize));
+    }
+
+    double m_cellsize;
+    size_t m_size;
+    double m_min[3], m_max[3];
+    std::unordered_map<uint64_t, size_t> m_cells;
+    // points of cell c are m_start[c] ... m_start[c+1]-1
+    std::vector<size_t> m_start;
+    std::vector<size_t> m_index;
+    std::vector<double> m_points;
+    std::vector<size_t> m_remaining;
+    std::vector<char> m_colliding;
+};
+
+#endif
@@ -59,7 +59,13 @@ public:
   void readTrajectory(const char* dir_path, double* pose,unsigned int identifiers);
   void Trans_Mat(Curves* CurrentPoint,Curves* NextPoint);
   //void Trans_Mat2(Curves* CurrentPoint,Curves* NextPoint);
-  MatrixXd Opt_rot(VectorXd A,VectorXd B);
+  //! transformation between two points of one trajectory as in Trans_Mat,
+  //  without storing it, so it can be called from several threads
+  static void Rel_Trans(const Vector3d &current, const Vector3d &next,
+                        Matrix<double,DIMENSIONS,DIMENSIONS> &rot,
+                        Matrix<double,DIMENSIONS,1> &trans,
+                        Matrix<double,DIMENSIONS+1,DIMENSIONS+1> &transformation);
+  static MatrixXd Opt_rot(VectorXd A,VectorXd B);
 
 public:
     std::vector<double> *m_point;
@@ -0,0 +1,98 @@
+/**
+ * @file occupancyGrid.h
+ *
+ * Sparse, bit-packed 3D occupancy grid.
+ *
+ */
+
+#ifndef OCCUPANCY_GRID_H_
+#define OCCUPANCY_GRID_H_
+
+//==============================================================================
+//  Includes
+//==============================================================================
+// C++ includes.
+#include <vector>
+#include <unordered_map>
+#include <cstddef>
+#include <stdint.h>
+
+//==============================================================================
+//  Class declaration.
+//==============================================================================
+namespace floorplan {
+
+/**
+ * A boolean occupancy grid of xCount * yCount * zCount voxels, Y being the
+ * vertical axis. Only bricks of 8x8x8 voxels that contain an occupied voxel
+ * are stored, in a hash map keyed by the brick coordinates. A brick is 8
+ * 64 bit words, one per horizontal layer, with bit x + 8 * z set for an
+ * occupied voxel, so the projections reduce to popcounts and bit scans of
+ * these words. Memory thus grows with the occupied surface of the scene
+ * instead of its bounding box.
+ */
+class OccupancyGrid {
+public:
+    static const int BRICK_BITS = 3;
+    static const int BRICK_SIZE = 1 << BRICK_BITS;  //!< Voxels per brick edge.
+
+    OccupancyGrid(const int& xCount, const int& yCount, const int& zCount);
+
+    inline int sizeX() const { return xCount; }
+    inline int sizeY() const { return yCount; }
+    inline int sizeZ() const { return zCount; }
+
+    /**
+     * Marks the voxel as occupied. Voxels outside of the grid are ignored.
+     */
+    void set(const int& x, const int& y, const int& z);
+
+    /**
+     * Returns true if the voxel is occupied.
+     */
+    bool get(const int& x, const int& y, const int& z) const;
+
+    /**
+     * Adds the occupied voxels of another grid of the same size.
+     */
+    void merge(const OccupancyGrid& other);
+
+    /**
+     * The number of occupied voxels.
+     */
+    size_t count() const;
+
+    /**
+     * The number of stored bricks, 64 bytes of voxels each.
+     */
+    inline size_t brickCount() const { return bricks.size(); }
+
+    /**
+     * Number of occupied voxels in each horizontal layer, indexed by y.
+     */
+    std::vector<int> layerCounts() const;
+
+    /**
+     * Number of occupied voxels in each vertical column over the layers y
+     * for which useLayer[y] is true, indexed by [x][z].
+     */
+    std::vector<std::vector<int> > columnCounts(const std::vector<bool>& useLayer) const;
+
+private:
+    struct Brick {
+        uint64_t layers[BRICK_SIZE];
+    };
+
+    typedef std::unordered_map<uint64_t, Brick> BrickMap;
+
+    static inline uint64_t key(const int& bx, const int& by, const int& bz) {
+        return ((uint64_t) bx << 42) | ((uint64_t) by << 21) | (uint64_t) bz;
+    }
+
+    int xCount, yCount, zCount;
+    BrickMap bricks;
+};
+
+} /* namespace floorplan */
+
+#endif /* OCCUPANCY_GRID_H_ */
@@ -16,6 +16,7 @@
 #include "floorplan/point3d.h"
 #include "floorplan/vector3d.h"
 #include "floorplan/commonTypes.h"
+#include "floorplan/occupancyGrid.h"
 #include "slam6d/io_types.h"
 #include "slam6d/Boctree.h"
 
@@ -53,9 +54,9 @@ public:
 
 private:
     /**
-     * Computes a 3D boolean occupancy grid.
+     * Computes a 3D boolean occupancy grid, filled in parallel.
      */
-    std::vector<std::vector<std::vector<bool> > > compute3DOccGrid(const double& voxDimInCm,
+    OccupancyGrid compute3DOccGrid(const double& voxDimInCm,
             const double& minHeight = -std::numeric_limits<double>::max(),
             const double& maxHeight = +std::numeric_limits<double>::max());
 
@@ -43,7 +43,6 @@ namespace model {
 class Scene {
 private:
     // private fields
-    static const double PRECISION;       //!< Precision at which to draw the 3d Bresenham line.
     static const double RAY_DIST;        //!< The max distance to consider that a ray hit something.
     static const double PATCH_DIST;      //!< The distance between each discrete patch on a wall surface.
     static const double WALL_DIST;       //!< Tolerance to consider a point part of a wall, squared.
@@ -52,7 +51,7 @@ private:
 
 public:
     // public fields
-    SearchTree *octTree;               //!< An efficient octree containing the points.
+    BOctTree<double> *octTree;         //!< An efficient octree containing the points.
     double **octTreePoints;            //!< Used to construct the octree.
     unsigned int nrPoints;             //!< The total number of points in the octree.
 
@@ -120,9 +119,9 @@ public:
     void detectWalls();
 
     /**
-     * Performs ray casting from source point to destination and returns true
-     * if the ray successfully reached the destination point, returning the
-     * point it hit along the way.
+     * Performs ray casting from source point to extraDist behind the
+     * destination and returns true if the ray hit a point along the way,
+     * returning the position on the ray where it did.
      */
     bool castRay(const model::Point3d& src, const model::Point3d& dest, const double& extraDist,
             Point3d& ptHit);
@@ -186,11 +185,6 @@ private:
             const int& i, const int& j,
             const Label& target, const Label& replacement);
 
-    /**
-     * Returns true if the cube centered at the given coordinates is occupied.
-     */
-    bool isOccupied(const Point3d& center, const double& width);
-
 };
 
 } /* namespace model */
@@ -10,6 +10,8 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unordered_map>
+#include <vector>
+#include <cstdint>
 
 namespace po = boost::program_options;
 
@@ -83,18 +85,364 @@ double py_mod(double a, double b);
 
 struct voxel voxel_of_point(const double *p, double voxel_size);
 
-// FIXME: test the runtime if empty_voxels and voxel_occupied_by_slice are not
-// pointers
+/*
+ * Map from the occupied voxels to the ids of the scan slices with points in
+ * them. Instead of a hash map of std::set, which costs about a hundred bytes
+ * per voxel and forty per slice, the voxels are kept in an open addressing
+ * hash table of 32 bit indices into a dense array of 32 bit voxel
+ * coordinates. The slice ids of all voxels are stored back to back in one
+ * array, sorted ascending per voxel, so a lookup returns a pointer range that
+ * can be searched without copying.
+ *
+ * On top of that, two coarse levels record which blocks of 8x8x8 voxels and
+ * which cells of 2x2x2 voxels in them contain any occupied voxel at all, so
+ * that rays through free space can skip the lookup of the individual voxels.
+ * The cells of a block are a 64 bit mask stored with the block.
+ *
+ * The table is split into shards by the hash of the voxel so that the
+ * shards can be filled by different threads. Building first collects the
+ * distinct voxels of every slice in parallel and then fills every shard
+ * from the slices in ascending order. The result does not depend on the
+ * number of threads.
+ */
+class VoxelOccupancy {
+public:
+	typedef uint32_t slice_t;
+
+	// sorted slice ids of a voxel, empty if the voxel is not occupied
+	struct slices {
+		const slice_t *first;
+		const slice_t *last;
+		const slice_t *begin() const { return first; }
+		const slice_t *end() const { return last; }
+		bool empty() const { return first == last; }
+		size_t size() const { return last - first; }
+	};
+
+	VoxelOccupancy();
+
+	void build(const std::unordered_map<size_t, DataXYZ> &points_by_slice,
+		   double voxel_size, int jobs);
+
+	slices find(const struct voxel &v) const;
+
+	bool contains(const struct voxel &v) const
+	{
+		return !find(v).empty();
+	}
+
+	// the block of the coarse level that v lies in
+	static struct voxel block_of(const struct voxel &v)
+	{
+		return voxel(v.x >> block_bits, v.y >> block_bits,
+			     v.z >> block_bits);
+	}
+
+	// the bit of the 2x2x2 cell that v lies in within the mask of its block
+	static uint64_t cell_bit_of(const struct voxel &v)
+	{
+		return (uint64_t)1 << (((v.x >> 1) & 3) | ((v.y >> 1) & 3) << 2 |
+				       ((v.z >> 1) & 3) << 4);
+	}
+
+	// mask of the cells of the block with an occupied voxel
+	uint64_t block_mask(const struct voxel &block) const;
+
+	// number of occupied voxels
+	size_t size() const { return num_voxels; }
+
+	// all occupied voxels
+	std::vector<struct voxel> voxels() const;
+
+	// memory held by the index in bytes
+	size_t memory() const;
+
+private:
+	static const unsigned shard_bits = 6;
+	static const unsigned block_bits = 3;
+	static const size_t num_shards = 1 << shard_bits;
+
+	// voxel coordinates stored with 32 bit
+	struct key {
+		int32_t x;
+		int32_t y;
+		int32_t z;
+
+		bool operator==(const key &rhs) const
+		{
+			return x == rhs.x && y == rhs.y && z == rhs.z;
+		}
+
+		bool operator<(const key &rhs) const
+		{
+			if (x != rhs.x) {
+				return x < rhs.x;
+			}
+			if (y != rhs.y) {
+				return y < rhs.y;
+			}
+			return z < rhs.z;
+		}
+	};
+
+	struct shard {
+		// slot -> 1 + index into voxels, 0 marks an empty slot
+		std::vector<uint32_t> table;
+		std::vector<key> voxels;
+		// slices of voxels[i] are slices[offsets[i]..offsets[i+1]]
+		std::vector<uint32_t> offsets;
+		std::vector<slice_t> slices;
+	};
+
+	static key make_key(const struct voxel &v);
+	static uint64_t hash(const key &k);
+	// slot of k in the table of s, or the empty slot to insert it into
+	static size_t probe(const shard &s, const key &k, uint64_t h,
+			    bool &found);
+	static void rehash(shard &s, size_t capacity);
+
+	std::vector<shard> shards;
+	size_t num_voxels;
+	// open addressing table of the occupied blocks and their cell masks,
+	// empty slots have x == empty_block
+	static const int32_t empty_block;
+	std::vector<key> blocks;
+	std::vector<uint64_t> block_masks;
+};
+
 struct visitor_args {
 	std::set<struct voxel> *empty_voxels;
-	std::unordered_map<struct voxel, std::set<size_t>>
-	    *voxel_occupied_by_slice;
+	const VoxelOccupancy *voxel_occupied_by_slice;
 	size_t current_slice;
 	size_t diff;
 };
 
 bool visitor(struct voxel voxel, void *data);
 
+/*
+ * Visitor for walk_voxels() marking the voxels a ray of the current slice
+ * passes through as free, like visitor(). Blocks and cells of the coarse
+ * levels without occupied voxels are skipped without looking up their
+ * voxels. The results
+ * of the voxels in occupied blocks are kept in a small direct mapped cache,
+ * because the rays of a slice all start at the scanner and pass through the
+ * same voxels near it again and again. Both carry over from one ray to the
+ * next, so the rays of a slice should go through the same carver in scan
+ * order.
+ */
+class FreeSpaceCarver {
+public:
+	FreeSpaceCarver(const VoxelOccupancy &occupied,
+			std::set<struct voxel> &empty_voxels,
+			size_t current_slice, size_t diff)
+	    : occupied(occupied), cache(cache_size), have_block(false),
+	      last_block(0, 0, 0), last_block_mask(0)
+	{
+		args.empty_voxels = &empty_voxels;
+		args.voxel_occupied_by_slice = &occupied;
+		args.current_slice = current_slice;
+		args.diff = diff;
+	}
+
+	bool operator()(const struct voxel &v)
+	{
+		struct voxel block = VoxelOccupancy::block_of(v);
+		if (!have_block || block != last_block) {
+			have_block = true;
+			last_block = block;
+			last_block_mask = occupied.block_mask(block);
+		}
+		if (!(last_block_mask & VoxelOccupancy::cell_bit_of(v))) {
+			return true;
+		}
+		size_t slot = (v.x * 73856093 ^ v.y * 19349663 ^ v.z * 83492791) &
+			      (cache_size - 1);
+		entry &e = cache[slot];
+		if (e.valid && e.x == v.x && e.y == v.y && e.z == v.z) {
+			return e.result;
+		}
+		e.x = v.x;
+		e.y = v.y;
+		e.z = v.z;
+		e.valid = true;
+		e.result = visitor(v, &args);
+		return e.result;
+	}
+
+private:
+	static const size_t cache_size = 4096;
+
+	struct entry {
+		ssize_t x, y, z;
+		bool valid = false;
+		bool result;
+	};
+
+	const VoxelOccupancy &occupied;
+	struct visitor_args args;
+	std::vector<entry> cache;
+	bool have_block;
+	struct voxel last_block;
+	uint64_t last_block_mask;
+};
+
+/*
+ * walk voxels as described in
+ *   Fast Voxel Traversal Algorithm for Ray Tracing
+ *   by John Amanatides, Andrew Woo
+ *   Eurographics ’87
+ *   http://www.cs.yorku.ca/~amana/research/grid.pdf
+ *
+ * The visitor is called with every voxel on the way from start_pos to
+ * end_pos and returns false to stop the walk. It is a template so that the
+ * visitor can be inlined into the stepping loop.
+ */
+template <class Visitor>
+void walk_voxels(const double *const start_pos, const double *const end_pos,
+		 const double voxel_size, Visitor &visitor)
+{
+	const double direction[3] = {end_pos[0] - start_pos[0],
+				     end_pos[1] - start_pos[1],
+				     end_pos[2] - start_pos[2]};
+	if (direction[0] == 0 && direction[1] == 0 && direction[2] == 0) {
+		// FIXME: should we really abort here? Should we not at least call
+		// visitor() on the start_voxel?
+		return;
+	}
+	const struct voxel start_voxel = voxel_of_point(start_pos, voxel_size);
+	const struct voxel end_voxel = voxel_of_point(end_pos, voxel_size);
+	visitor(start_voxel);
+	if (start_voxel == end_voxel) {
+		return;
+	}
+	/*
+	 * The coordinates are kept in arrays indexed by the axis, so that
+	 * the three axes are handled by the same code.
+	 *
+	 * tMax: value t at which the segment crosses the first voxel boundary
+	 *       in the given direction
+	 * step: in which direction to increase the voxel count (1 or -1)
+	 * tDelta: value t needed to span the voxel size in the given direction
+	 *         up to the target
+	 */
+	ssize_t start[3] = {start_voxel.x, start_voxel.y, start_voxel.z};
+	const ssize_t end[3] = {end_voxel.x, end_voxel.y, end_voxel.z};
+	double tDelta[3], tMax[3], maxMult[3];
+	ssize_t step[3];
+	for (int k = 0; k < 3; ++k) {
+		if (direction[k] == 0) {
+			tDelta[k] = 0;
+			step[k] = 0;
+			tMax[k] = std::numeric_limits<double>::infinity();
+			maxMult[k] = std::numeric_limits<double>::infinity();
+			continue;
+		}
+		step[k] = direction[k] > 0 ? 1 : -1;
+		tDelta[k] = step[k] * voxel_size / direction[k];
+		tMax[k] = tDelta[k] *
+			  (1.0 - py_mod(step[k] * (start_pos[k] / voxel_size), 1.0));
+		maxMult[k] = (end[k] - start[k]) * step[k];
+		if (step[k] == -1 && tMax[k] == tDelta[k] && start[k] != end[k]) {
+			start[k] -= 1;
+			maxMult[k] -= 1;
+		}
+	}
+	ssize_t cur[3] = {start[0], start[1], start[2]};
+	// FIXME: don't call visitor() unconditionally but only if cur_voxel
+	// unequal start_voxel
+	visitor(voxel(cur[0], cur[1], cur[2]));
+	if (cur[0] == end[0] && cur[1] == end[1] && cur[2] == end[2]) {
+		return;
+	}
+	/*
+	 * An additional voxel must only be added in six of the eight different
+	 * directions that we can step into. If we step in all positive or
+	 * in all negative directions, then no additional voxel is added.
+	 */
+	const bool mixed = (step[0] == 1 || step[1] == 1 || step[2] == 1) &&
+			   (step[0] == -1 || step[1] == -1 || step[2] == -1);
+	/*
+	 * in contrast to the original algorithm by John Amanatides and Andrew Woo
+	 * we increment a counter and multiply the step size instead of adding up
+	 * the steps. Doing the latter might introduce errors because due to
+	 * floating point precision errors, 0.1+0.1+0.1 is unequal 3*0.1.
+	 * The counters are doubles, which count exactly up to 2^53, so that
+	 * they need no conversion in the loop.
+	 */
+	double mult[3] = {0, 0, 0};
+	const double tMaxStart[3] = {tMax[0], tMax[1], tMax[2]};
+	/*
+	 * iterate until either:
+	 *  - the final voxel is reached
+	 *  - tMax is reached by all tMax-coordinates
+	 *  - the visitor stops the walk
+	 */
+	while (1) {
+		const double minVal = std::min(std::min(tMax[0], tMax[1]), tMax[2]);
+		const bool stepped[3] = {minVal == tMax[0], minVal == tMax[1],
+					 minVal == tMax[2]};
+		if (stepped[0]) {
+			mult[0] += 1;
+			cur[0] += step[0];
+			tMax[0] = tMaxStart[0] + mult[0] * tDelta[0];
+		}
+		if (stepped[1]) {
+			mult[1] += 1;
+			cur[1] += step[1];
+			tMax[1] = tMaxStart[1] + mult[1] * tDelta[1];
+		}
+		if (stepped[2]) {
+			mult[2] += 1;
+			cur[2] += step[2];
+			tMax[2] = tMaxStart[2] + mult[2] * tDelta[2];
+		}
+		/*
+		 * If we end up stepping in more than one direction at the same time,
+		 * then we must also assess if we have to add the voxel that we just
+		 * "graced" in the process.
+		 */
+		if (mixed && stepped[0] + stepped[1] + stepped[2] > 1) {
+			ssize_t add[3] = {cur[0], cur[1], cur[2]};
+			/*
+			 * a voxel was only possibly missed if we stepped into a
+			 * negative direction and if that step was actually carried
+			 * out in this iteration
+			 */
+			bool past_end = false;
+			for (int k = 0; k < 3 && !past_end; ++k) {
+				if (!stepped[k]) {
+					continue;
+				}
+				if (step[k] < 0) {
+					past_end = mult[k] > maxMult[k] + 1;
+					add[k] += 1;
+				} else {
+					past_end = mult[k] > maxMult[k];
+				}
+			}
+			if (past_end) {
+				break;
+			}
+			// FIXME: only call visitor if add_voxel unequal cur_voxel
+			if (!visitor(voxel(add[0], add[1], add[2]))) {
+				break;
+			}
+		}
+		/*
+		 * non-exact versions of this algorithm might never reach the end voxel,
+		 * so we abort early using a different criterion
+		 */
+		if ((stepped[0] && mult[0] > maxMult[0]) ||
+		    (stepped[1] && mult[1] > maxMult[1]) ||
+		    (stepped[2] && mult[2] > maxMult[2])) {
+			break;
+		}
+		if (!visitor(voxel(cur[0], cur[1], cur[2]))) {
+			break;
+		}
+	}
+}
+
 void walk_voxels(const double *const start_pos, const double *const end_pos,
 		 const double voxel_size, bool (*visitor)(struct voxel, void *),
 		 void *data);
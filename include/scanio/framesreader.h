@@ -3,4 +3,7 @@
 #include <string>
 #include <iostream>
 void readFramesAndTransform(std::string dir, int start, int end, int frame, bool use_pose=false, bool reduced=false);
+// only sets the transformation matrices of the scans, the points are left
+// untouched, e.g. because they are not loaded but streamed
+void readFrames(std::string dir, int start, int end, int frame, bool use_pose=false);
 #endif
@@ -6,6 +6,7 @@
 #include <string>
 #include <sstream>
 #include <list>
+#include <vector>
 #include "slam6d/pointfilter.h"
 #include "slam6d/io_types.h"
 #include "slam6d/scan_settings.h"
@@ -112,7 +113,28 @@ bool readASCII(std::istream& infile,
         std::vector<int>* type = 0,
         std::vector<float>* deviation = 0,
         std::vector<double>* normal = 0,
-        std::streamsize bufsize = 128);
+        std::streamsize bufsize = 128,
+        size_t chunk_size = 0,
+        std::function<bool ()> chunk_done = nullptr);
+
+/* removes the values of the points from index begin on whose keep flag is 0
+ * from a channel with width values per point, the accepted ones are moved to
+ * the front in their order */
+template <typename T>
+void compact_channel(std::vector<T>* v, size_t begin, size_t width,
+        const unsigned char* keep, size_t n)
+{
+    if (v == 0 || v->size() != (begin + n) * width) return;
+    T* data = v->data();
+    size_t accepted = begin;
+    for (size_t i = 0; i < n; ++i) {
+        if (!keep[i]) continue;
+        for (size_t k = 0; k < width; ++k)
+            data[accepted * width + k] = data[(begin + i) * width + k];
+        accepted++;
+    }
+    v->resize(accepted * width);
+}
 
 unsigned int strtoarray(std:: string opts, char **&opts_array, const char * deliminator=" ");
 
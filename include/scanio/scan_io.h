@@ -18,7 +18,79 @@
 #include <list>
 #include <map>
 #include <vector>
+#include <functional>
 
+/**
+ * @brief A consecutive block of points of a scan
+ *
+ * Holds the same channels that ScanIO::readScan fills in, but only for a
+ * bounded number of points at a time. Channels that are not supported by
+ * the ScanIO stay empty.
+ */
+struct ScanChunk {
+  std::vector<double> xyz;
+  std::vector<unsigned char> rgb;
+  std::vector<float> reflectance;
+  std::vector<float> temperature;
+  std::vector<float> amplitude;
+  std::vector<int> type;
+  std::vector<float> deviation;
+  std::vector<double> normal;
+
+  //! Number of points in this chunk
+  size_t size() const {
+    if (!xyz.empty()) return xyz.size() / 3;
+    if (!rgb.empty()) return rgb.size() / 3;
+    if (!reflectance.empty()) return reflectance.size();
+    if (!temperature.empty()) return temperature.size();
+    if (!amplitude.empty()) return amplitude.size();
+    if (!type.empty()) return type.size();
+    if (!deviation.empty()) return deviation.size();
+    return normal.size() / 3;
+  }
+
+  //! Empty all channels but keep their capacity for the next chunk
+  void clear() {
+    xyz.clear(); rgb.clear(); reflectance.clear(); temperature.clear();
+    amplitude.clear(); type.clear(); deviation.clear(); normal.clear();
+  }
+
+  //! Remove the points that do not pass the filter from all channels
+  void filter(PointFilter& filter) {
+    size_t n = size();
+    if (xyz.size() != 3 * n || n == 0) return;
+    std::vector<unsigned char> keep(n);
+    if (filter.check(xyz.data(), n, keep.data()) == n) return;
+    compact_channel(&xyz, 0, 3, keep.data(), n);
+    compact_channel(&rgb, 0, 3, keep.data(), n);
+    compact_channel(&reflectance, 0, 1, keep.data(), n);
+    compact_channel(&temperature, 0, 1, keep.data(), n);
+    compact_channel(&amplitude, 0, 1, keep.data(), n);
+    compact_channel(&type, 0, 1, keep.data(), n);
+    compact_channel(&deviation, 0, 1, keep.data(), n);
+    compact_channel(&normal, 0, 3, keep.data(), n);
+  }
+};
+
+/**
+ * @brief Summary of a scan that is available without reading its points
+ *
+ * The bounding box is given in the 3DTK (left handed) coordinate system.
+ */
+struct ScanHeader {
+  //! Number of points stored in the file, before any filtering
+  size_t nr_points;
+  //! Whether min and max hold a valid bounding box
+  bool has_bbox;
+  double min[3], max[3];
+};
+
+/**
+ * Callback receiving the chunks of ScanIO::readScanChunked. The chunk may be
+ * modified or swapped out, it is cleared before it is filled again. Return
+ * false to stop reading the scan early.
+ */
+typedef std::function<bool (ScanChunk& chunk)> ScanChunkHandler;
 
 
 /**
@@ -71,6 +143,30 @@ public:
    */
   virtual void readScan(const char* dir_path, const char* identifier, PointFilter& filter, std::vector<double>* xyz = 0, std::vector<unsigned char>* rgb = 0, std::vector<float>* reflectance = 0, std::vector<float>* temperature = 0, std::vector<float>* amplitude = 0, std::vector<int>* type = 0, std::vector<float>* deviation = 0, std::vector<double>* normal = 0);
 
+  /**
+   * Given a scan identifier, stream the contents of this particular scan in
+   * chunks of at most chunk_size points, so that the whole scan never has to
+   * be held in memory. All supported channels are read.
+   *
+   * The default implementation reads the whole scan with readScan and hands
+   * it out in slices. ScanIOs that can read incrementally override this.
+   *
+   * @param dir_path The directory the scan is contained in
+   * @param identifier IO-specific identifier for the particular scan
+   * @param filter Filter object which each point is tested on by its position
+   * @param chunk_size Maximum number of points per chunk
+   * @param handler Called for every chunk, stops reading if it returns false
+   */
+  virtual void readScanChunked(const char* dir_path, const char* identifier, PointFilter& filter, size_t chunk_size, ScanChunkHandler handler);
+
+  /**
+   * Reads the point count and the bounding box of a scan if the file format
+   * stores them in its header.
+   *
+   * @return false if the ScanIO cannot provide this information up front
+   */
+  virtual bool readScanHeader(const char* dir_path, const char* identifier, ScanHeader& header) { return false; }
+
   /**
    * Given a scan identifier, get the modification time of this particular
    * scan from the underlying file system.
@@ -119,6 +215,17 @@ protected:
   virtual ScanDataTransform& getTransform() { return transform2uos; }
 };
 
+/**
+ * @brief Base for the ASCII formats that are read by ScanIO::readScan
+ *
+ * Streams the scan file line by line instead of reading it as a whole, the
+ * format is still described by getSpec, getTransform and the file affixes.
+ */
+class ScanIO_ascii : public ScanIO {
+public:
+  virtual void readScanChunked(const char* dir_path, const char* identifier, PointFilter& filter, size_t chunk_size, ScanChunkHandler handler);
+};
+
 // Since the shared object files are loaded on the fly, we
 // need class factories
 
@@ -35,6 +35,14 @@ public:
 				    std::vector<int>* type,
             std::vector<float>* deviation,
             std::vector<double>* normal);
+  virtual void readScanChunked(const char* dir_path,
+				    const char* identifier,
+				    PointFilter& filter,
+				    size_t chunk_size,
+				    ScanChunkHandler handler);
+  virtual bool readScanHeader(const char* dir_path,
+				    const char* identifier,
+				    ScanHeader& header);
   virtual bool supports(IODataType type);
 };
 
@@ -0,0 +1,54 @@
+/**
+ * @file
+ * @brief IO of the levels of detail of a tile tree as scans
+ */
+
+#ifndef __SCAN_IO_TILES_H__
+#define __SCAN_IO_TILES_H__
+
+#include "scan_io.h"
+
+/**
+ * @brief Reads a tile tree written by buildTiles
+ *
+ * The directory is the tile tree, scan number N is the point cloud at level
+ * of detail N, i.e., the points of all tiles up to level N, in global
+ * coordinates and with a zero pose. An optional file scanNNN.region with
+ * the six numbers minx miny minz maxx maxy maxz restricts scan NNN to this
+ * box, only the tiles intersecting it are read.
+ *
+ * The compiled class is available as shared object file
+ */
+class ScanIO_tiles : public ScanIO {
+public:
+  virtual std::list<std::string> readDirectory(const char* dir_path,
+                                               unsigned int start,
+                                               unsigned int end);
+  virtual std::list<std::string> readDirectory(dataset_settings& dss);
+  virtual void readPose(const char* dir_path,
+                        const char* identifier,
+                        double* pose);
+  virtual time_t lastModified(const char* dir_path, const char* identifier);
+  virtual void readScan(const char* dir_path,
+                        const char* identifier,
+                        PointFilter& filter,
+                        std::vector<double>* xyz,
+                        std::vector<unsigned char>* rgb,
+                        std::vector<float>* reflectance,
+                        std::vector<float>* temperature,
+                        std::vector<float>* amplitude,
+                        std::vector<int>* type,
+                        std::vector<float>* deviation,
+                        std::vector<double>* normal);
+  virtual void readScanChunked(const char* dir_path,
+                               const char* identifier,
+                               PointFilter& filter,
+                               size_t chunk_size,
+                               ScanChunkHandler handler);
+  virtual bool readScanHeader(const char* dir_path,
+                              const char* identifier,
+                              ScanHeader& header);
+  virtual bool supports(IODataType type);
+};
+
+#endif
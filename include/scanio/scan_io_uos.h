@@ -16,7 +16,7 @@
  *
  * The compiled class is available as shared object file
  */
-class ScanIO_uos : public ScanIO {
+class ScanIO_uos : public ScanIO_ascii {
 };
 
 #endif
@@ -18,7 +18,7 @@
  *
  * The compiled class is available as shared object file
  */
-class ScanIO_uos_normal : public ScanIO {
+class ScanIO_uos_normal : public ScanIO_ascii {
 protected:
   static IODataType spec[];
   virtual IODataType* getSpec() { return spec; }
@@ -16,7 +16,7 @@
  *
  * The compiled class is available as shared object file
  */
-class ScanIO_uos_rgb : public ScanIO {
+class ScanIO_uos_rgb : public ScanIO_ascii {
 protected:
   static IODataType spec[];
   virtual IODataType* getSpec() { return spec; }
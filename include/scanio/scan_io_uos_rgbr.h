@@ -17,7 +17,7 @@
  *
  * The compiled class is available as shared object file
  */
-class ScanIO_uos_rgbr : public ScanIO {
+class ScanIO_uos_rgbr : public ScanIO_ascii {
 protected:
   static IODataType spec[];
   virtual IODataType* getSpec() { return spec; }
@@ -18,7 +18,7 @@
  *
  * The compiled class is available as shared object file
  */
-class ScanIO_uosc : public ScanIO {
+class ScanIO_uosc : public ScanIO_ascii {
 protected:
   static IODataType spec[];
   virtual IODataType* getSpec() { return spec; }
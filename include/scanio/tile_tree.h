@@ -0,0 +1,187 @@
+/**
+ * @file
+ * @brief Out-of-core multi-resolution tiling of registered point clouds
+ *
+ * A tile tree is an octree over the points of all scans in global
+ * coordinates that is stored in a directory: the index tiles.idx and one
+ * file per tile. Every tile holds a subsample of the points in its cube
+ * with a spacing that halves from level to level, its children hold the
+ * remaining points. The tiles up to a level therefore give the whole
+ * point cloud at the resolution of that level, and a region is read by
+ * visiting only the tiles intersecting it.
+ */
+
+#ifndef __TILE_TREE_H__
+#define __TILE_TREE_H__
+
+#include "scanio/scan_io.h"
+
+#include <string>
+#include <vector>
+#include <map>
+#include <functional>
+#include <stdint.h>
+
+/**
+ * @brief One point as stored in a tile file
+ *
+ * The coordinates are quantized with the scale of the tree relative to the
+ * origin of the tree.
+ */
+struct TilePoint {
+  int32_t x, y, z;
+  float reflectance;
+  unsigned char rgb[3];
+  unsigned char pad;
+};
+
+//! Entry of the tile index
+struct TileNode {
+  //! "r" followed by the octant of the tile on every level below the root
+  std::string name;
+  int level;
+  uint64_t nr_points;
+};
+
+/**
+ * @brief Read access to a tile tree directory
+ */
+class TileTree {
+public:
+  //! Reads the index of the tile tree in dir
+  TileTree(const std::string& dir);
+
+  //! Deepest level of the tree
+  int getDepth() const { return depth; }
+
+  //! Bounding box of the points in the tree
+  void getBounds(double* min, double* max) const;
+
+  //! Number of points in the tiles up to max_level
+  uint64_t countPoints(int max_level) const;
+
+  /**
+   * Streams the points of all tiles up to max_level in chunks of at most
+   * chunk_size points. If min and max are given, only the tiles
+   * intersecting this box are read and the points outside of it dropped.
+   * Reading stops early if the handler returns false.
+   */
+  void read(int max_level, const double* min, const double* max,
+            size_t chunk_size, ScanChunkHandler handler) const;
+
+  //! Name of the index file in a tile tree directory
+  static const char* index_name;
+
+  static void readTile(const std::string& path, std::vector<TilePoint>& pts);
+  static void writeTile(const std::string& path,
+                        const std::vector<TilePoint>& pts);
+
+private:
+  bool readNode(const std::string& name, int level, const int64_t* origin,
+                int max_level, const double* min, const double* max,
+                size_t chunk_size, ScanChunk& chunk,
+                ScanChunkHandler& handler) const;
+
+  std::string dir;
+  double scale;
+  double origin[3];
+  //! edge length of the cube of the root tile in quantization steps
+  int64_t size;
+  double bounds_min[3], bounds_max[3];
+  int depth;
+  std::map<std::string, TileNode> nodes;
+};
+
+/**
+ * @brief Builds a tile tree from scans that are streamed several times
+ *
+ * The memory consumption is bounded by the parameters and not by the size
+ * of the input:
+ *
+ * 1. Unless the bounding box is given, a first pass over all scans
+ *    determines it.
+ * 2. A second pass counts the points in a 128^3 grid. The cells are
+ *    merged into chunks of at most max_chunk_points points, the largest
+ *    octree cubes that are small enough.
+ * 3. A third pass appends the points to one temporary file per chunk,
+ *    holding at most buffer_points points in memory. Chunks that are
+ *    still too large because a cell of the grid is dense are streamed
+ *    into the files of their octants until they are small enough.
+ * 4. The chunks are split into tiles in parallel, each thread holds the
+ *    points of one chunk.
+ * 5. The tiles above the chunks are filled bottom up by moving a subsample
+ *    of the root tiles of their children up.
+ */
+class TileTreeWriter {
+public:
+  /**
+   * Streams the points of scan number scan in global coordinates to the
+   * handler, reflectance and rgb may be left empty.
+   */
+  typedef std::function<void (size_t scan, ScanChunkHandler handler)>
+    ScanStream;
+
+  /**
+   * @param dir output directory, created if missing
+   * @param scale quantization step of the coordinates in the units of the
+   *              scans, the extent of the points may be up to 2^30 steps
+   * @param max_node_points tiles with more points are split
+   * @param max_chunk_points largest number of points held in memory by
+   *                         one thread while splitting
+   * @param buffer_points largest number of points buffered before they are
+   *                      written to the temporary chunk files
+   */
+  TileTreeWriter(const std::string& dir, double scale = 0.1,
+                 size_t max_node_points = 50000,
+                 size_t max_chunk_points = 5000000,
+                 size_t buffer_points = 10000000);
+
+  //! Bounding box of all points, saves the first pass over the scans
+  void setBounds(const double* min, const double* max);
+
+  //! Builds the tree from nr_scans scans
+  void build(size_t nr_scans, ScanStream stream);
+
+  //! Largest number of points of a chunk in the last build
+  size_t getLargestChunk() const { return largest_chunk; }
+
+private:
+  struct Cube {
+    std::string name;
+    int level;
+    int64_t origin[3];
+  };
+
+  bool quantize(const double* p, TilePoint& tp) const;
+  void partition(const std::vector<std::vector<uint64_t> >& counts,
+                 int level, int64_t x, int64_t y, int64_t z,
+                 const std::string& name);
+  void appendChunk(const std::string& name, std::vector<TilePoint>& pts) const;
+  void flushBuffers(std::vector<std::vector<TilePoint> >& buffers);
+  void splitChunks();
+  void splitTile(std::vector<TilePoint>& pts, const Cube& cube,
+                 std::vector<TileNode>& result) const;
+  void moveUp(const Cube& cube, std::map<std::string, TileNode>& result) const;
+  void writeIndex(const std::map<std::string, TileNode>& result) const;
+  std::string tilePath(const std::string& name) const;
+  std::string chunkPath(const std::string& name) const;
+
+  std::string dir;
+  double scale;
+  size_t max_node_points, max_chunk_points, buffer_points;
+
+  bool has_bounds;
+  double bounds_min[3], bounds_max[3];
+  int log2size;
+  int64_t size;
+  //! level of the counting grid
+  int grid_level;
+
+  //! the cubes that are split in memory and the ones above them
+  std::vector<Cube> chunks, upper;
+  //! chunk of every cell of the counting grid
+  std::vector<int32_t> chunk_of_cell;
+  size_t largest_chunk;
+};
+
+#endif
@@ -42,12 +42,12 @@ public:
   //  CacheDataAccess(const CacheDataAccess&) = delete;
 
   //! Aquires a lock on the mutex and takes assigned data
-  CacheDataAccess(ip::interprocess_upgradable_mutex& mutex, unsigned int& size, unsigned char* data);
+  CacheDataAccess(ip::interprocess_upgradable_mutex& mutex, std::size_t size, unsigned char* data);
 
   CacheDataAccess(CacheDataAccess&& other) : DataPointer(other) {}
 
   //! Non-locking version
-  //CacheDataAccess(unsigned int& size, unsigned char* data);
+  //CacheDataAccess(std::size_t size, unsigned char* data);
 
   //! Transfers the lock to this instance and also takes assigned data
   //CacheDataAccess(const CacheDataAccess& other);
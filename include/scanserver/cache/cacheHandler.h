@@ -8,6 +8,8 @@
 #ifndef CACHE_HANDLER_H
 #define CACHE_HANDLER_H
 
+#include <cstddef>
+
 class CacheManager;
 class CacheObject;
 
@@ -36,7 +38,7 @@ public:
    * The data to be saved it given in the arguments and will be removed by the CacheManager after this function returns.
    * @throw possibly IO/stream/conversion errors in overloaded classes
    */
-  virtual void save(unsigned char* data, unsigned int size) = 0;
+  virtual void save(unsigned char* data, std::size_t size) = 0;
 
   /**
    * Called by the CacheManager when a CacheObject has been invalidated.
@@ -68,7 +68,7 @@ public:
     * @return Pointer to the allocated space in the object
     * @throws when no memory could be allocated because removing all remaining (non read-locked) CacheObjects removed didn't free enough memory.
     */
-  unsigned char* allocateCacheObject(CacheObject* obj, unsigned int size);
+  unsigned char* allocateCacheObject(CacheObject* obj, std::size_t size);
 
   /**
    * Invalidate a CacheObject and its handler.
@@ -91,7 +91,7 @@ private:
    * Allocates memory for a CO. Will throw a bad_alloc if it fails so.
    * Only to be called within allocateCacheObject.
    */
-  unsigned char* load(CacheObject* obj, unsigned int size);
+  unsigned char* load(CacheObject* obj, std::size_t size);
 
   /**
    * Removes cached data from a CO and marks it as unloaded.
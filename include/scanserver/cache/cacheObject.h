@@ -66,8 +66,8 @@ public:
    * Allocate space to write into.
    * Repeated calls will always create new space without saving the old one, no CacheHandler calls will be made for this CacheObject.
    */
-  template<void(*F)(CacheObject*, unsigned int)>
-  inline CacheDataAccess createCacheData(unsigned int size)
+  template<void(*F)(CacheObject*, std::size_t)>
+  inline CacheDataAccess createCacheData(std::size_t size)
   {
     // lock read mutex to prevent removal in between calls
     ip::sharable_lock<ip::interprocess_upgradable_mutex> use(m_mutex_in_use);
@@ -103,7 +103,7 @@ public:
   static void openSharedMemory(const char* shm_name);
 private:
   //! Size in bytes of contained data
-  unsigned int m_size;
+  std::size_t m_size;
 
   //! Handle to contained data in CacheObject exclusive shared memory, used to obtain process-local pointers
   ip::managed_shared_memory::handle_t m_handle;
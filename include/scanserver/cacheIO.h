@@ -9,6 +9,7 @@
 #define CACHE_IO_H
 
 #include <string>
+#include <cstddef>
 
 /**
  * @brief Serialization management for binary data, intended for use in CacheHandlers.
@@ -31,13 +32,13 @@ public:
   static IDType getId();
 
   //! Check if a physical representation of this cache entry exists and returns non-zero size for the data
-  static unsigned int check(IDType& id);
+  static std::size_t check(IDType& id);
 
   //! Read from file into the data pointer
   static void read(IDType& id, char* data);
 
   //! Write data into a file represented by id
-  static void write(IDType& id, char* data, unsigned int size);
+  static void write(IDType& id, char* data, std::size_t size);
 private:
   static std::string path;
   static unsigned int free_id;
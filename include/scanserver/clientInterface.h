@@ -130,7 +130,7 @@ public:
   bool loadCacheObject(CacheObject* obj);
 
   //! Called from SharedScan, request enough memory to hold reduced points
-  void allocateCacheObject(CacheObject* obj, unsigned int size);
+  void allocateCacheObject(CacheObject* obj, std::size_t size);
 
   //! Called from SharedScan, let the CacheManager invalide a CacheObject
   void invalidateCacheObject(CacheObject* obj);
@@ -9,6 +9,7 @@
 #define SCANSERVER_FRAME_IO_H
 
 #include "scanserver/frame.h"
+#include "slam6d/framesFile.h"
 
 
 
@@ -18,11 +19,11 @@
 class FrameIO
 {
 public:
-  //! Loads a frames file and fills the given shared vector
+  //! Loads a text or binary frames file and fills the given shared vector
   static void loadFile(const char* dir, const char* identifier, FrameVector& frames);
 
-  //! Saves a frames file from a shared frames vector
-  static void saveFile(const char* dir, const char* identifier, const FrameVector& frames, bool append = false);
+  //! Saves a frames file in the given format from a shared frames vector
+  static void saveFile(const char* dir, const char* identifier, const FrameVector& frames, bool append = false, FramesFormat format = FRAMES_TEXT);
 };
 
 #endif //SCANSERVER_FRAME_IO_H
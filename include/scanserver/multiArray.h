@@ -27,13 +27,13 @@ public:
   TripleArray(TripleArray&& other) : CacheDataAccess(other) {}
 
   //! Represent the CacheData as an array of T[3]'s
-  inline return_type* operator[](unsigned int i) const
+  inline return_type* operator[](size_t i) const
   {
     return reinterpret_cast<return_type*>(getData()) + (i*3);
   }
 
   //! Count of T[3] objects in this CacheData
-  inline unsigned int size() const { return CacheDataAccess::getSize() / (3*sizeof(return_type)); }
+  inline size_t size() const { return CacheDataAccess::getSize() / (3*sizeof(return_type)); }
 };
 
 /**
@@ -49,13 +49,13 @@ public:
   SingleArray(SingleArray&& other) : CacheDataAccess(other) {}
 
   //! Represent the CacheData as an array of T's
-  inline return_type& operator[](unsigned int i) const
+  inline return_type& operator[](size_t i) const
   {
     return *(reinterpret_cast<return_type*>(getData()) + i);
   }
 
   //! Count of T objects in this CacheData
-  inline unsigned int size() const { return CacheDataAccess::getSize() / sizeof(return_type); }
+  inline size_t size() const { return CacheDataAccess::getSize() / sizeof(return_type); }
 };
 
 typedef TripleArray<double> DataXYZ;
@@ -74,9 +74,9 @@ class Array {
 public:
   //! Create a temporary array and fill it sequentially with pointers to each point
   Array(const TripleArray<T>& data) {
-    unsigned int size = data.size();
+    size_t size = data.size();
     m_array = new T*[size];
-    for(unsigned int i = 0; i < size; ++i)
+    for(size_t i = 0; i < size; ++i)
       m_array[i] = data[i];
   }
 
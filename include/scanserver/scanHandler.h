@@ -36,7 +36,7 @@ public:
   /**
    * Does nothing unless binary caching is enabled, which will save the contents via CacheIO.
    */
-  virtual void save(unsigned char* data, unsigned int size);
+  virtual void save(unsigned char* data, std::size_t size);
 
   //! Enable binary caching of scan data
   static void setBinaryCaching();
@@ -48,7 +48,7 @@ private:
   bool loadCacheObject(CacheObject* obj);
 
   //! Allocate call from SharedScan, relayed to CacheManager
-  void allocateCacheObject(CacheObject* obj, unsigned int size);
+  void allocateCacheObject(CacheObject* obj, std::size_t size);
 
   //! Invalidate call from SharedScan, relayed to CacheManager
   void invalidateCacheObject(CacheObject* obj);
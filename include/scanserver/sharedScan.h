@@ -9,6 +9,7 @@
 #define SHARED_SCAN_H
 
 #include "scanserver/frame.h"
+#include "slam6d/framesFile.h"
 #include "slam6d/io_types.h"
 #include "slam6d/data_types.h"
 #include "slam6d/pointfilter.h"
@@ -143,7 +144,10 @@ public:
   void addFrame(double* transformation, unsigned int type);
 
   //! Save frames into a file for later use
-  void saveFrames(bool append = false);
+  void saveFrames(bool append = false, FramesFormat format = FRAMES_TEXT);
+
+  //! Format of the last saveFrames call
+  FramesFormat getFramesFormat() const { return m_frames_format; }
 
   //! Clear existing frames
   void clearFrames();
@@ -167,30 +171,30 @@ public:
   DataXYZ getXYZReduced();
 
   //! Create a new set of reduced points
-  DataXYZ createXYZReduced(unsigned int size);
+  DataXYZ createXYZReduced(std::size_t size);
 
 
   //! Create a new set of reflectance
-  DataReflectance createReflectance(unsigned int size);
+  DataReflectance createReflectance(std::size_t size);
 
 
   //! Reduced untransformed points
   DataXYZ getXYZReducedOriginal();
 
   //! Create a new set of reduced points originals
-  DataXYZ createXYZReducedOriginal(unsigned int size);
+  DataXYZ createXYZReducedOriginal(std::size_t size);
 
   //! Individual reduced points to use in show if requested
   TripleArray<float> getXYZReducedShow();
 
   //! Create a new set of reduced points for use in show
-  TripleArray<float> createXYZReducedShow(unsigned int size);
+  TripleArray<float> createXYZReducedShow(std::size_t size);
 
   //! Cached tree structure for show
   DataPointer getOcttree();
 
   //! Create a cached tree structure for show
-  DataPointer createOcttree(unsigned int size);
+  DataPointer createOcttree(std::size_t size);
 
   //! ScanHandler related prefetching values to combine loading of separate cache objects
   void prefetch(unsigned int type) { m_prefetch |= type; }
@@ -230,6 +234,7 @@ private:
   SharedString m_show_parameters;
   SharedString m_octtree_parameters;
   bool m_load_frames_file;
+  FramesFormat m_frames_format;
 
 protected:
   ip::offset_ptr<double> m_pose;
@@ -252,7 +257,7 @@ private:
   static void onCacheMiss(CacheObject* obj);
 
   //! Static callback for cache object creation calls
-  static void onAllocation(CacheObject* obj, unsigned int size);
+  static void onAllocation(CacheObject* obj, std::size_t size);
 
   //! Static callback for cache object invalidation
   static void onInvalidation(CacheObject* obj);
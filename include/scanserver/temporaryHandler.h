@@ -38,7 +38,7 @@ public:
    * Serialize all data into a file
    * It will do so if either the written flag isn't set, or static data flag isn't set regardless of the written flag.
    */
-  virtual void save(unsigned char* data, unsigned int size);
+  virtual void save(unsigned char* data, std::size_t size);
 
   //! Reset flag for having a cached file, causing reads to fail and saves to overwrite older files.
   virtual void invalidate() { m_written = false; }
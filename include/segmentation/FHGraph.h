@@ -14,7 +14,6 @@
 #define __FHGRAPH_H__
 
 #include <vector>
-#include <list>
 
 #include <slam6d/point.h>
 #include <slam6d/scan.h>
@@ -24,7 +23,7 @@
 class FHGraph {
 public:
   FHGraph(std::vector< Point > *ps,
-		double weight(Point, Point),
+		double weight(const Point&, const Point&),
 		double sigma,
 		double eps,
 		int neighbors,
@@ -37,7 +36,8 @@ public:
   void dispose();
 
 private:
-  void compute_neighbors(double weight(Point, Point), double eps);
+  void compute_neighbors(double weight(const Point&, const Point&),
+                         double eps);
   void do_gauss(double sigma);
   void without_gauss();
 
@@ -50,7 +50,13 @@ private:
   float radius;
 
   struct he{ int x; float w; };
-  std::vector< std::list<he> > adjency_list;
+
+  /**
+   * neighbourhood graph in compressed sparse row layout, the half edges
+   * of point i are adjacency[offsets[i]] ... adjacency[offsets[i+1]-1]
+   */
+  std::vector<size_t> offsets;
+  std::vector<he> adjacency;
 };
 
 #endif
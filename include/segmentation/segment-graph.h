@@ -33,6 +33,18 @@ typedef struct {
 
 bool operator<(const edge &a, const edge &b);
 
+/*
+ * Sort edges by non-decreasing weight
+ *
+ * Stable LSD radix sort on the bit pattern of the float weights. The
+ * histogram and scatter steps of every pass run in parallel with OpenMP,
+ * the result does not depend on the number of threads.
+ *
+ * num_edges: number of edges in the array
+ * edges: array of edges, sorted in place
+ */
+void sort_edges(int num_edges, edge *edges);
+
 /*
  * Segment a graph
  *
@@ -211,7 +211,7 @@ class ColorManager {
 
   public:
 
-    ColorManager(unsigned int _buckets, unsigned int pointdim, float *_mins, float *_maxs, const float *_color = 0) : buckets(_buckets) {
+    ColorManager(unsigned int _buckets, unsigned int pointdim, float *_mins, float *_maxs, const float *_color = 0) : buckets(_buckets), version(0) {
       if (_color) {
         color[0] = _color[0];
         color[1] = _color[1];
@@ -271,6 +271,33 @@ class ColorManager {
       glTexCoord1f( (float)((val[currentdim]-min)/extent) );
     }
 
+    /**
+     * The colour setColor would use, for vertex arrays. Unless hasRGB is
+     * true this is a texture coordinate into the colour map.
+     */
+    virtual float getTexCoord(float *val) {
+      return (float)((val[currentdim]-min)/extent);
+    }
+    virtual float getTexCoord(double *val) {
+      return (float)((val[currentdim]-min)/extent);
+    }
+
+    //! Whether points are coloured by getRGB instead of getTexCoord
+    virtual bool hasRGB() const {
+      return false;
+    }
+    virtual void getRGB(float *val, unsigned char *rgb) {
+      rgb[0] = rgb[1] = rgb[2] = 255;
+    }
+    virtual void getRGB(double *val, unsigned char *rgb) {
+      rgb[0] = rgb[1] = rgb[2] = 255;
+    }
+
+    //! Changes whenever the colours of the points change, to update colours stored in vertex arrays
+    unsigned int getVersion() const {
+      return version;
+    }
+
     virtual void setColorMap(ColorMap &cm) {
       for (unsigned int i = 0; i <= buckets; i++) {
         cm.calcColor(colormap[i], i, buckets);
@@ -291,6 +318,7 @@ class ColorManager {
         max = _max;
       }
       extent = max - min;
+      version++;
     }
 
     float** getFloatColormap() {
@@ -329,6 +357,7 @@ class ColorManager {
       max = maxs[currentdim];
 
       extent = max - min;
+      version++;
     }
 
     unsigned int buckets;
@@ -348,6 +377,8 @@ class ColorManager {
 
     float color[3];
 
+    unsigned int version;
+
 };
 
 class CColorManager : public ColorManager {
@@ -392,6 +423,16 @@ class CColorManager : public ColorManager {
       glColor3ubv(color);
     }
 
+    bool hasRGB() const {
+      return true;
+    }
+    void getRGB(float *val, unsigned char *rgb) {
+      memcpy(rgb, &val[colordim], 3);
+    }
+    void getRGB(double *val, unsigned char *rgb) {
+      memcpy(rgb, &val[colordim], 3);
+    }
+
   private:
     unsigned int colordim;
     GLboolean color_state;
@@ -29,6 +29,8 @@
 #define GLuint int
 #define GLdouble double
 #define GLenum int
+#define GLsizei int
+#define GLvoid void
 #define glPushMatrix() ((void)0)
 #define glPopMatrix() ((void)0)
 #define glMultMatrix(a) ((void)0)
@@ -80,6 +82,12 @@
 #define GL_TEXTURE_2D 0
 #define glTexImage2D(a, b, c, d, e, f, g, h, i) ((void)0)
 #define glGenTextures(a, b) ((void)0)
+#define glEnableClientState(a) ((void)0)
+#define glDisableClientState(a) ((void)0)
+#define glVertexPointer(a, b, c, d) ((void)0)
+#define glColorPointer(a, b, c, d) ((void)0)
+#define glTexCoordPointer(a, b, c, d) ((void)0)
+#define glDrawArrays(a, b, c) ((void)0)
 
 #define gluLookAt(a, b, c, d, e, f, g, h, i) ((void)0)
 #define gluPerspective(a, b, c, d) ((void)0)
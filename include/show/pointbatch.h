@@ -0,0 +1,108 @@
+#ifndef __POINTBATCH_H__
+#define __POINTBATCH_H__
+
+#include "show/colormanager.h"
+
+#include <vector>
+#include <cstddef>
+
+/**
+ * @brief Vertex arrays of the points of a tree, drawn in ranges
+ *
+ * The points are stored once with their colours and drawn by a list of
+ * (first, count) ranges into the arrays, which is collected each frame by the
+ * culling and LOD decisions of the tree. Ranges that continue each other are
+ * merged, so completely visible subtrees are drawn by a single call. With
+ * the ARB_vertex_buffer_object extension the arrays are uploaded into buffer
+ * objects once and only the colours are uploaded again after they changed.
+ */
+class PointBatch {
+public:
+  PointBatch();
+  ~PointBatch();
+
+  //! Remove all points and the draw list
+  void clear();
+
+  //! Append the coordinates of a point
+  template <class T>
+  inline void addPoint(const T *p) {
+    xyz.push_back((float)p[0]);
+    xyz.push_back((float)p[1]);
+    xyz.push_back((float)p[2]);
+    uploaded = false;
+  }
+
+  //! Number of stored points
+  inline size_t size() const { return xyz.size() / 3; }
+
+  //! Whether the stored colours are those of the ColorManager in its current state
+  bool colorsValid(ColorManager *cm) const;
+
+  /**
+   * Prepare colour storage for the given ColorManager, returning an array of
+   * size() texture coordinates or size() rgb triples to be filled depending
+   * on cm->hasRGB().
+   */
+  float* texCoordsFor(ColorManager *cm);
+  unsigned char* rgbFor(ColorManager *cm);
+
+  //! Start a new draw list
+  inline void clearDrawList() {
+    ranges.clear();
+    visible = 0;
+  }
+
+  //! Add count points starting at first to the draw list
+  inline void addRange(size_t first, size_t count) {
+    if (count == 0) return;
+    if (!ranges.empty() && ranges.back().first + ranges.back().count == first) {
+      ranges.back().count += count;
+    } else {
+      Range r = { first, count };
+      ranges.push_back(r);
+    }
+    visible += count;
+  }
+
+  //! Number of draw calls in the current draw list
+  inline size_t drawCalls() const { return ranges.size(); }
+
+  //! Number of points in the current draw list
+  inline size_t visiblePoints() const { return visible; }
+
+  /**
+   * Draw the current draw list, coloured by the arrays prepared for cm or
+   * by the current GL colour if cm is null
+   */
+  void draw(ColorManager *cm);
+
+  /**
+   * Order of n points in which each prefix is spread evenly over all of
+   * them, so a LOD subset of a leaf is a prefix of its points.
+   */
+  static void spreadOrder(unsigned int n, std::vector<unsigned int> &order);
+
+private:
+  struct Range {
+    size_t first;
+    size_t count;
+  };
+
+  std::vector<float> xyz;
+  std::vector<float> texcoords;
+  std::vector<unsigned char> rgb;
+
+  //! ColorManager and its version the colours were computed for
+  ColorManager *colorManager;
+  unsigned int colorVersion;
+
+  std::vector<Range> ranges;
+  size_t visible;
+
+  //! Buffer objects, if supported
+  GLuint buffers[2];
+  bool uploaded, colorsUploaded;
+};
+
+#endif
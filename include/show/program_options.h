@@ -71,6 +71,8 @@ struct display_settings {
 
   bool hide_label;
   bool hide_classLabels;
+
+  bool batch_points;
 };
 
 struct window_settings {
@@ -113,7 +115,8 @@ void setDisplayOptions(double& scale, GLfloat& fov, int& viewmode,
 		       bool& noPoints, bool& noCameras, bool& noPath, bool& noPoses,
 		       bool& noFog, int& fogType, GLfloat& fogDensity,
 		       Position& position, Quaternion& rotation, float& pzoom,
-		       int& pointsize, bool& hide_classLabels, boost::program_options::options_description& display_options);
+		       int& pointsize, bool& hide_classLabels, bool& batchPoints,
+		       boost::program_options::options_description& display_options);
 void setColorOptions(Color& bgcolor, bool& color, ShowColormap& colormap,
 		     float& colormin, float& colormax,
 		     int& scansColored, bool& noAnimColor,
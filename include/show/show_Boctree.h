@@ -13,6 +13,7 @@
 #include "show/scancolormanager.h"
 #include "show/viewcull.h"
 #include "show/colordisplay.h"
+#include "show/pointbatch.h"
 #include "slam6d/scan.h"
 
 using namespace show;
@@ -44,6 +45,24 @@ protected:
   Scan* m_scan;
   ScanColorManager* scm;
 
+  //! Points of all leaves in vertex arrays, built on the first batched draw
+  PointBatch m_batch;
+
+  //! Point in the tree for each vertex in m_batch, for computing colours
+  std::vector<T*> m_batch_source;
+
+  //! Range of vertices in m_batch of a node, nodes and leaves in depth first order
+  struct BatchNode {
+    size_t first;
+    size_t end;
+    //! index of the next node that isn't part of this subtree
+    size_t next;
+  };
+  std::vector<BatchNode> m_batch_nodes;
+
+  //! Draw via m_batch instead of immediate mode
+  static bool batched;
+
   void init(ScanColorManager* _scm) {
     scm = _scm;
     setColorManager(0);
@@ -84,7 +103,10 @@ public:
   void lockCachedTree() {
     if(m_scan != 0 && m_cache_access == 0) {
       m_cache_access = new DataOcttree(m_scan->get("octtree"));
-      m_tree = &(m_cache_access->get());
+      BOctTree<T>* tree = &(m_cache_access->get());
+      // batches point into the tree, rebuild them if it moved
+      if (tree != m_tree) clearBatch();
+      m_tree = tree;
     }
   }
 
@@ -161,7 +183,52 @@ public:
     current_lod_mode = (current_lod_mode+1)%3;
   }
 
+  /**
+   * Draw via vertex arrays collected by buildDrawList instead of
+   * immediate mode. Off by default, as the vertex arrays hold a second
+   * copy of all points.
+   */
+  static void setBatched(bool b) { batched = b; }
+
+  /**
+   * Cull the tree and collect the visible points into the draw list of the
+   * point batch. lod_mode < 0 selects all points like draw(), otherwise the
+   * points of drawLOD for that LOD mode and ratio. The vertex arrays are
+   * built on the first call.
+   */
+  void buildDrawList(int lod_mode, float ratio = 1.0) {
+    if (m_batch_nodes.empty()) buildBatch();
+    updateBatchColors();
+    m_batch.clearDrawList();
+    if (m_batch_nodes.empty()) return;
+    switch (lod_mode) {
+      case 0:
+        collectOctTreeCulledLOD(maxtargetpoints * ratio, m_tree->getRoot(), m_tree->getCenter(), m_tree->getSize(), 0);
+        break;
+      case 1:
+        collectOctTreeCulledLOD2(ratio, m_tree->getRoot(), m_tree->getCenter(), m_tree->getSize(), 0);
+        break;
+      default:
+        collectOctTreeAllCulled(m_tree->getRoot(), m_tree->getCenter(), m_tree->getSize(), 0);
+        break;
+    }
+  }
+
+  const PointBatch& getBatch() const { return m_batch; }
+
+  //! Release the vertex arrays, they are rebuilt on the next batched draw
+  void clearBatch() {
+    m_batch.clear();
+    m_batch_source.clear();
+    m_batch_nodes.clear();
+  }
+
   void drawLOD(float ratio) {
+    if (batched && current_lod_mode < 2) {
+      buildDrawList(current_lod_mode, ratio);
+      m_batch.draw(cm);
+      return;
+    }
     switch (current_lod_mode) {
       case 0:
         glBegin(GL_POINTS);
@@ -194,6 +261,11 @@ public:
   }
 
   void draw() {
+    if (batched) {
+      buildDrawList(-1);
+      m_batch.draw(cm);
+      return;
+    }
     glBegin(GL_POINTS);
     displayOctTreeAllCulled(m_tree->getRoot(), m_tree->getCenter(), m_tree->getSize());
     glEnd();
@@ -243,6 +315,238 @@ protected:
     return max*POPCOUNT(node.valid);
   }
 
+  //! Fill m_batch with the points of all leaves in traversal order
+  void buildBatch() {
+    clearBatch();
+    std::vector<unsigned int> order;
+    buildBatch(m_tree->getRoot(), order);
+  }
+
+  void buildBatch(const bitoct &node, std::vector<unsigned int> &order) {
+    size_t self = m_batch_nodes.size();
+    m_batch_nodes.push_back(BatchNode());
+    m_batch_nodes[self].first = m_batch_source.size();
+
+    bitunion<T> *children;
+    bitoct::getChildren(node, children);
+
+    for (short i = 0; i < 8; i++) {
+      if (  ( 1 << i ) & node.valid ) {   // if ith node exists
+        if (  ( 1 << i ) & node.leaf ) {   // if ith node is leaf get center
+          pointrep *points = children->getPointreps();
+          unsigned int length = points[0].length;
+          T *point = &(points[1].v);  // first point
+          BatchNode leaf;
+          leaf.first = m_batch_source.size();
+          // LOD subsets of a leaf are prefixes of its vertices
+          PointBatch::spreadOrder(length, order);
+          for(unsigned int iterator = 0; iterator < length; iterator++ ) {
+            T *p = point + order[iterator]*POINTDIM;
+            m_batch.addPoint(p);
+            m_batch_source.push_back(p);
+          }
+          leaf.end = m_batch_source.size();
+          leaf.next = m_batch_nodes.size() + 1;
+          m_batch_nodes.push_back(leaf);
+        } else { // recurse
+          buildBatch(children->node, order);
+        }
+        ++children; // next child
+      }
+    }
+
+    m_batch_nodes[self].end = m_batch_source.size();
+    m_batch_nodes[self].next = m_batch_nodes.size();
+  }
+
+  //! Recompute the colours in m_batch if the color manager changed
+  void updateBatchColors() {
+    if (!cm || m_batch.colorsValid(cm)) return;
+    size_t n = m_batch_source.size();
+    if (cm->hasRGB()) {
+      unsigned char *rgb = m_batch.rgbFor(cm);
+      for (size_t i = 0; i < n; i++) cm->getRGB(m_batch_source[i], rgb + 3*i);
+    } else {
+      float *tex = m_batch.texCoordsFor(cm);
+      for (size_t i = 0; i < n; i++) tex[i] = cm->getTexCoord(m_batch_source[i]);
+    }
+  }
+
+  // The collect functions make the same decisions as their display
+  // counterparts, but add vertex ranges to the draw list of m_batch instead
+  // of emitting points. idx is the index of node in m_batch_nodes.
+
+  void collectOctTreeAllCulled(const bitoct &node, const T* center, T size, size_t idx) {
+    int res = CubeInFrustum2(center[0], center[1], center[2], size);
+    if (res==0) return;  // culled do not continue with this branch of the tree
+
+    if (res == 2) { // if entirely within frustrum discontinue culling
+      const BatchNode &self = m_batch_nodes[idx];
+      m_batch.addRange(self.first, self.end - self.first);
+      return;
+    }
+
+    T ccenter[3];
+    bitunion<T> *children;
+    bitoct::getChildren(node, children);
+
+    size_t c = idx + 1;
+    for (short i = 0; i < 8; i++) {
+      if (  ( 1 << i ) & node.valid ) {   // if ith node exists
+        const BatchNode &child = m_batch_nodes[c];
+        if (  ( 1 << i ) & node.leaf ) {   // if ith node is leaf get center
+          m_batch.addRange(child.first, child.end - child.first);
+        } else { // recurse
+          BOctTree<T>::childcenter(center, ccenter, size, i);  // childrens center
+          collectOctTreeAllCulled( children->node, ccenter, size/2.0, c);
+        }
+        c = child.next;
+        ++children; // next child
+      }
+    }
+  }
+
+  void collectOctTreeLOD2(float ratio, const bitoct &node, const T* center, T size, size_t idx) {
+    T ccenter[3];
+    bitunion<T> *children;
+    bitoct::getChildren(node, children);
+
+    size_t c = idx + 1;
+    for (short i = 0; i < 8; i++) {
+      if (  ( 1 << i ) & node.valid ) {   // if ith node exists
+        const BatchNode &child = m_batch_nodes[c];
+        BOctTree<T>::childcenter(center, ccenter, size, i);  // childrens center
+        int l = LOD2(ccenter[0], ccenter[1], ccenter[2], size/2.0);
+        l = std::max((int)(l*l*ratio), 0);
+        if (  ( 1 << i ) & node.leaf ) {   // if ith node is leaf get center
+          size_t length = child.end - child.first;
+          // only a single pixel on screen only paint one point
+          m_batch.addRange(child.first, std::min(length, l > 1 ? (size_t)l : 1));
+        } else if (l > 0) { // recurse
+          collectOctTreeCulledLOD2(ratio, children->node, ccenter, size/2.0, c);
+        }
+        c = child.next;
+        ++children; // next child
+      }
+    }
+  }
+
+  void collectOctTreeCulledLOD2(float ratio, const bitoct &node, const T* center, T size, size_t idx) {
+    int res = CubeInFrustum2(center[0], center[1], center[2], size);
+    if (res==0) return;  // culled do not continue with this branch of the tree
+
+    if (res == 2) { // if entirely within frustrum discontinue culling
+      collectOctTreeLOD2(ratio, node, center, size, idx);
+      return;
+    }
+
+    T ccenter[3];
+    bitunion<T> *children;
+    bitoct::getChildren(node, children);
+
+    size_t c = idx + 1;
+    for (short i = 0; i < 8; i++) {
+      if (  ( 1 << i ) & node.valid ) {   // if ith node exists
+        const BatchNode &child = m_batch_nodes[c];
+        BOctTree<T>::childcenter(center, ccenter, size, i);  // childrens center
+        if (  ( 1 << i ) & node.leaf ) {   // if ith node is leaf get center
+          // check if leaf is visible
+          if ( CubeInFrustum(ccenter[0], ccenter[1], ccenter[2], size/2.0) ) {
+            int l = LOD2(ccenter[0], ccenter[1], ccenter[2], size/2.0);
+            l = std::max((int)(l*l*ratio), 0);
+            size_t length = child.end - child.first;
+            m_batch.addRange(child.first, std::min(length, (size_t)l));
+          }
+        } else { // recurse
+          collectOctTreeCulledLOD2(ratio, children->node, ccenter, size/2.0, c);
+        }
+        c = child.next;
+        ++children; // next child
+      }
+    }
+  }
+
+  //! Number of points displayOctTreeLOD paints for a leaf
+  size_t lodCount(size_t length, long targetpts, const T* ccenter, T size) {
+    if (length > 10 && !LOD(ccenter[0], ccenter[1], ccenter[2], size) ) {
+      return 1;  // only a single pixel on screen only paint one point
+    } else if ((long)length <= targetpts) {
+      return length;
+    }
+    return targetpts;
+  }
+
+  void collectOctTreeLOD(long targetpts, const bitoct &node, const T* center, T size, size_t idx) {
+    if (targetpts <= 0) return; // no need to display anything
+
+    T ccenter[3];
+    bitunion<T> *children;
+    bitoct::getChildren(node, children);
+
+    unsigned short nc = POPCOUNT(node.valid);
+    long newtargetpts = targetpts;
+    if (nc > 0) {
+      newtargetpts = newtargetpts/nc;
+      if (newtargetpts <= 0 ) return;
+    }
+
+    size_t c = idx + 1;
+    for (short i = 0; i < 8; i++) {
+      if (  ( 1 << i ) & node.valid ) {   // if ith node exists
+        const BatchNode &child = m_batch_nodes[c];
+        BOctTree<T>::childcenter(center, ccenter, size, i);  // childrens center
+        if (  ( 1 << i ) & node.leaf ) {   // if ith node is leaf get center
+          m_batch.addRange(child.first, lodCount(child.end - child.first, newtargetpts, ccenter, size/2.0));
+        } else { // recurse
+          collectOctTreeLOD(newtargetpts, children->node, ccenter, size/2.0, c);
+        }
+        c = child.next;
+        ++children; // next child
+      }
+    }
+  }
+
+  void collectOctTreeCulledLOD(long targetpts, const bitoct &node, const T* center, T size, size_t idx) {
+    if (targetpts <= 0) return; // no need to display anything
+
+    int res = CubeInFrustum2(center[0], center[1], center[2], size);
+    if (res==0) return;  // culled do not continue with this branch of the tree
+
+    if (res == 2) { // if entirely within frustrum discontinue culling
+      collectOctTreeLOD(targetpts, node, center, size, idx);
+      return;
+    }
+
+    T ccenter[3];
+    bitunion<T> *children;
+    bitoct::getChildren(node, children);
+
+    unsigned short nc = POPCOUNT(node.valid);
+    long newtargetpts = targetpts;
+    if (nc > 0) {
+      newtargetpts = newtargetpts/nc;
+      if (newtargetpts <= 0 ) return;
+    }
+
+    size_t c = idx + 1;
+    for (short i = 0; i < 8; i++) {
+      if (  ( 1 << i ) & node.valid ) {   // if ith node exists
+        const BatchNode &child = m_batch_nodes[c];
+        BOctTree<T>::childcenter(center, ccenter, size, i);  // childrens center
+        if (  ( 1 << i ) & node.leaf ) {   // if ith node is leaf get center
+          // check if leaf is visible
+          if ( CubeInFrustum(ccenter[0], ccenter[1], ccenter[2], size/2.0) ) {
+            m_batch.addRange(child.first, lodCount(child.end - child.first, newtargetpts, ccenter, size/2.0));
+          }
+        } else { // recurse
+          collectOctTreeCulledLOD(newtargetpts, children->node, ccenter, size/2.0, c);
+        }
+        c = child.next;
+        ++children; // next child
+      }
+    }
+  }
+
   void displayOctTreeAll(const bitoct &node) {
 //    T ccenter[3];
     bitunion<T> *children;
@@ -964,4 +1268,7 @@ protected:
   }
 };
 
+template <class T>
+bool Show_BOctTree<T>::batched = false;
+
 #endif
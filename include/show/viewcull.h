@@ -158,6 +158,13 @@ short ScreenDist(T *point) {
 }
 
 void ExtractFrustum(short detail);
+/**
+ * Like ExtractFrustum(short) but with explicitly given column major modelview
+ * and projection matrices and viewport instead of the current GL state, so
+ * the culling can be used without a GL context.
+ */
+void ExtractFrustum(const double *modl, const double *proj,
+                    const int *viewport, short detail);
 void ExtractFrustum(float *frust[6]);
 
 
@@ -166,6 +173,8 @@ int  CubeInFrustum2( float x, float y, float z, float size );
 char PlaneAABB( float x, float y, float z, float size, float *plane );
 
 void remViewport();
+void remViewport(const double *modelMatrix, const double *projMatrix,
+                 const int *viewport);
 bool LOD(float x, float y, float z, float size);
 int LOD2(float x, float y, float z, float size);
 
@@ -1464,6 +1464,200 @@ public:
     _FindPointsAlongDir(threadNum, node->node, child_bit/2, cx, cy, cz);
     return pointsSearch[threadNum].knnRangePoints;
   }
+  /**
+   * Ray queries
+   *
+   * A point is hit by the ray origin + t * dir, 0 <= t <= maxDist, if its
+   * distance to this segment is at most radius. dir need not be normalized,
+   * t is measured in the units of the points. The octree is traversed in ray
+   * order: the children of a node are visited in the order in which the ray
+   * enters their boxes enlarged by radius, so FirstHit stops as soon as no
+   * unvisited node can contain an earlier hit and SegmentOccupied stops at
+   * the first hit. Unlike the nearest neighbour searches the ray queries do
+   * not use the thread local params and may be called concurrently.
+   */
+
+  /**
+   * Returns the point with the smallest t that is hit by the ray, or 0 if
+   * there is none. If dist is given it is set to t of that point.
+   */
+  T* FirstHit(const double *origin, const double *dir, double radius,
+              double maxDist, double *dist = 0) const
+  {
+    RayQuery q;
+    if (!initRay(q, origin, dir, radius, maxDist, RAY_FIRST)) return 0;
+    _castRay(q, *root, center, size);
+    if (dist && q.hit) *dist = q.best_t;
+    return q.hit;
+  }
+
+  //! Appends all points hit by the ray to hits, in no particular order
+  void RayHits(const double *origin, const double *dir, double radius,
+               double maxDist, std::vector<T*> &hits) const
+  {
+    RayQuery q;
+    if (!initRay(q, origin, dir, radius, maxDist, RAY_ALL)) return;
+    q.hits = &hits;
+    _castRay(q, *root, center, size);
+  }
+
+  //! Whether any point is within radius of the segment from p1 to p2
+  bool SegmentOccupied(const double *p1, const double *p2, double radius) const
+  {
+    double dir[3] = { p2[0] - p1[0], p2[1] - p1[1], p2[2] - p1[2] };
+    RayQuery q;
+    if (!initRay(q, p1, dir, radius, sqrt(Len2(dir)), RAY_ANY)) return false;
+    _castRay(q, *root, center, size);
+    return q.hit != 0;
+  }
+
+  /**
+   * FirstHit for n rays from a common origin towards the targets, each
+   * ending extraDist behind its target. hits[i] is the first point hit by
+   * ray i or 0, dists (if given) receives t of these points. The rays are
+   * cast in parallel.
+   */
+  void FirstHits(const double *origin, const double * const *targets,
+                 int n, double radius, double extraDist, T **hits,
+                 double *dists = 0) const
+  {
+#pragma omp parallel for schedule(dynamic, 64)
+    for (int i = 0; i < n; i++) {
+      double dir[3] = { targets[i][0] - origin[0],
+                        targets[i][1] - origin[1],
+                        targets[i][2] - origin[2] };
+      hits[i] = FirstHit(origin, dir, radius, sqrt(Len2(dir)) + extraDist,
+                         dists ? &dists[i] : 0);
+    }
+  }
+
+protected:
+
+  enum RayMode { RAY_FIRST, RAY_ALL, RAY_ANY };
+
+  //! State of a single ray query, kept on the stack of the caller
+  struct RayQuery {
+    double o[3], d[3], inv[3];
+    double radius, radius2, tmax;
+    //! t of the earliest hit so far, nodes entered later are skipped
+    double best_t;
+    T *hit;
+    std::vector<T*> *hits;
+    RayMode mode;
+  };
+
+  bool initRay(RayQuery &q, const double *origin, const double *dir,
+               double radius, double maxDist, RayMode mode) const
+  {
+    double len = sqrt(Len2(dir));
+    if (len == 0.0 || maxDist < 0.0) return false;
+    for (int k = 0; k < 3; k++) {
+      q.o[k] = origin[k];
+      q.d[k] = dir[k] / len;
+      q.inv[k] = q.d[k] != 0.0 ? 1.0 / q.d[k] : 0.0;
+    }
+    q.radius = radius;
+    q.radius2 = radius * radius;
+    q.tmax = maxDist;
+    q.best_t = maxDist;
+    q.hit = 0;
+    q.hits = 0;
+    q.mode = mode;
+    return true;
+  }
+
+  /**
+   * Entry t of the ray into the box with the given center and half size
+   * enlarged by the query radius. Every point hit at t lies in this box,
+   * hence no point of the box can be hit before the entry.
+   */
+  static bool rayBox(const RayQuery &q, const T *c, T halfsize, double &tenter)
+  {
+    double t0 = 0.0, t1 = q.tmax;
+    double h = halfsize + q.radius;
+    for (int k = 0; k < 3; k++) {
+      double lo = c[k] - h - q.o[k];
+      double hi = c[k] + h - q.o[k];
+      if (q.d[k] == 0.0) {
+        if (lo > 0.0 || hi < 0.0) return false;
+        continue;
+      }
+      double ta = lo * q.inv[k], tb = hi * q.inv[k];
+      if (ta > tb) std::swap(ta, tb);
+      if (ta > t0) t0 = ta;
+      if (tb < t1) t1 = tb;
+      if (t0 > t1) return false;
+    }
+    tenter = t0;
+    return true;
+  }
+
+  void _castRay(RayQuery &q, const bitoct &node, const T *pcenter, T psize) const
+  {
+    bitunion<T> *children;
+    bitoct::getChildren(node, children);
+
+    // enlarged boxes of the existing children the ray passes through
+    T ccenter[8][3];
+    double tenter[8];
+    unsigned char index[8], order[8];
+    unsigned char n = 0;
+    for (unsigned char i = 0, c = 0; i < 8; i++) {
+      if (!(( 1 << i ) & node.valid)) continue;
+      childcenter(pcenter, ccenter[n], psize, i);
+      if (rayBox(q, ccenter[n], psize / 2.0, tenter[n]) && tenter[n] <= q.best_t) {
+        index[n] = i;
+        order[n] = c;
+        n++;
+      }
+      c++;
+    }
+
+    // visit them front to back, insertion sort on the entry
+    unsigned char seq[8];
+    for (unsigned char i = 0; i < n; i++) {
+      unsigned char j = i;
+      while (j > 0 && tenter[seq[j - 1]] > tenter[i]) {
+        seq[j] = seq[j - 1];
+        j--;
+      }
+      seq[j] = i;
+    }
+
+    for (unsigned char s = 0; s < n; s++) {
+      unsigned char k = seq[s];
+      if (tenter[k] > q.best_t) return; // all remaining children are behind
+      if (( 1 << index[k] ) & node.leaf) {
+        _castRayInLeaf(q, &children[order[k]]);
+      } else {
+        _castRay(q, children[order[k]].node, ccenter[k], psize / 2.0);
+      }
+      if (q.mode == RAY_ANY && q.hit) return;
+    }
+  }
+
+  void _castRayInLeaf(RayQuery &q, bitunion<T> *leaf) const
+  {
+    T *points = leaf->getPoints();
+    unsigned int length = leaf->getLength();
+    for (unsigned int i = 0; i < length; i++, points += POINTDIM) {
+      double v[3] = { points[0] - q.o[0], points[1] - q.o[1], points[2] - q.o[2] };
+      double t = v[0] * q.d[0] + v[1] * q.d[1] + v[2] * q.d[2];
+      if (t < 0.0) t = 0.0;
+      else if (t > q.tmax) t = q.tmax;
+      // distance to the closest point of the segment
+      double e[3] = { v[0] - t * q.d[0], v[1] - t * q.d[1], v[2] - t * q.d[2] };
+      if (Len2(e) > q.radius2) continue;
+      if (q.mode == RAY_ALL) {
+        q.hits->push_back(points);
+      } else if (!q.hit || t < q.best_t) {
+        q.best_t = t;
+        q.hit = points;
+        if (q.mode == RAY_ANY) return;
+      }
+    }
+  }
+
 protected:
 
   /**
@@ -8,10 +8,13 @@ using std::string;
 #include <iostream>
 #include <fstream>
 #include <stdexcept>
+#include <vector>
+#include <map>
 #include <boost/program_options.hpp>
 #include <boost/filesystem.hpp>
 
 #include "slam6d/scan.h"
+#include "slam6d/provenance.h"
 #include "globals.icc"
 
 namespace po = boost::program_options;
@@ -108,6 +111,8 @@ po::options_description generic("Generic options");
          << "each MetaScan has a .frames file. The purpose of this program is to split the" << std::endl
          << ".frames files back and apply the relative transformation onto the corresponding single scans." << std::endl
          << bold_on << "Important: Use the same filters and reduction params as with condense!" << bold_off << std::endl
+         << "If condense was run with --stream, the scanXXX.src files list the source scans" << std::endl
+         << "and the filter and reduction params are not needed." << std::endl
          << "Example usage:" << std::endl
          << "\tbin/atomize /condensed/dir /original/dir [params used for condense]" << std::endl
          << "\tbin/atomize dat/test/cond dat/test -S 10 -s 200 -e 1000 --min 10 --max 100 -r 10 -O 1 " << std::endl;
@@ -48,6 +48,7 @@ public:
 
   virtual time_t getLastModified();
   virtual DataPointer get(const std::string& identifier);
+  virtual DataPointer get(FieldId id);
   virtual void get(IODataType types);
   virtual DataPointer create(const std::string& identifier, size_t size);
   virtual void clear(const std::string& identifier);
@@ -89,6 +90,26 @@ private:
   // length
   std::map<std::string, std::pair<unsigned char*, size_t> > m_data;
 
+  //! Guards insertion into and lookup in m_data
+  boost::mutex m_mutex_data;
+
+  //! Number of field handles answered without locking
+  static const FieldId max_field_slots = 32;
+
+  /**
+   * Entries of m_data of completely loaded or computed fields by handle,
+   * set by get(FieldId) and read without locking
+   */
+  std::atomic<const std::pair<unsigned char*, size_t>*>
+    m_field_slots[max_field_slots] = {};
+
+  //! Look up \a identifier in m_data under the lock
+  bool findData(const std::string& identifier,
+                std::pair<unsigned char*, size_t>& field);
+
+  //! Remove an entry of m_data from m_field_slots before it changes
+  void unpublishField(const std::pair<unsigned char*, size_t>* field);
+
 #ifdef WITH_MMAP_SCAN
   std::map<std::string, int> m_mmap_fds;
 
@@ -17,6 +17,10 @@ using std::string;
 #include "scanio/writer.h"
 #include "scanio/framesreader.h"
 #include "slam6d/basicScan.h"
+#include "slam6d/voxelReducer.h"
+#include "slam6d/provenance.h"
+#include "slam6d/pointfilter.h"
+#include "scanio/scan_io.h"
 #include "slam6d/globals.icc"
 
 #ifdef _MSC_VER
@@ -269,7 +273,8 @@ void validate(boost::any& v, const std::vector<std::string>& values,
 int parse_options(int argc, char **argv, std::string &dir, double &red, int &rand,
             int &start, int &end, int &maxDist, int &minDist, bool &trustpose,
             bool &use_xyz, bool &use_reflectance, bool &use_type, bool &use_color, int &octree, IOType &type, std::string& customFilter, double &scaleFac,
-	    bool &hexfloat, bool &high_precision, int &frame, bool &use_normals, int &split, bool& global, bool& rm_scatter, bool& skip_empty)
+	    bool &hexfloat, bool &high_precision, int &frame, bool &use_normals, int &split, bool& global, bool& rm_scatter, bool& skip_empty,
+	    size_t &stream_chunk)
 {
 po::options_description generic("Generic options");
   generic.add_options()
@@ -327,7 +332,12 @@ po::options_description generic("Generic options");
     ("global,g", po::bool_switch(&global)->default_value(false),
      "Use global reference frame for export")
     ("skipEmpty", po::bool_switch(&skip_empty)->default_value(false),
-     "Skip a scan if it is empty (or becomes empty while applying filters)");
+     "Skip a scan if it is empty (or becomes empty while applying filters)")
+    ("stream", po::value<size_t>(&stream_chunk)->default_value(0),
+     "Stream the scans in chunks of <arg> points and merge them into one voxel grid "
+     "per MetaScan instead of loading them (needs -r). Memory then only depends on "
+     "the number of occupied voxels of one MetaScan. Writes the source scans of every "
+     "MetaScan to scanXXX.src for atomize.");
 
   po::options_description hidden("Hidden options");
   hidden.add_options()
@@ -580,4 +590,82 @@ Scan* createMetaScan(vector<Scan*> splitscans,
     return s;
 }
 
+/**
+ * Streams the points of a scan in chunks of chunk_size points, transforms
+ * them with transMat and adds them to the voxel grid of the MetaScan with
+ * the number of the scan as source. Returns the number of points read.
+ */
+size_t streamScan(Scan* scan, IOType iotype, PointFilter &filter,
+                  size_t chunk_size, const double* transMat,
+                  VoxelReducer &reducer, int source)
+{
+    ScanIO* sio = ScanIO::getScanIO(iotype);
+    size_t nr_points = 0;
+
+    std::string identifiers = scan->getIdentifier();
+    size_t pos;
+    do {
+        pos = identifiers.find_first_of(';');
+        std::string current_identifier = identifiers.substr(0, pos);
+        if (pos != std::string::npos) identifiers = identifiers.substr(pos + 1);
+
+        sio->readScanChunked(scan->getPath().c_str(), current_identifier.c_str(),
+            filter, chunk_size, [&](ScanChunk &chunk) -> bool {
+            size_t n = chunk.size();
+            transform3points(transMat, chunk.xyz.data(), n);
+            reducer.add(chunk.xyz.data(),
+                        chunk.reflectance.size() == n ? chunk.reflectance.data() : 0,
+                        chunk.rgb.size() == 3*n ? chunk.rgb.data() : 0,
+                        n, source);
+            nr_points += n;
+            return true;
+        });
+    } while (pos != std::string::npos);
+
+    return nr_points;
+}
+
+/**
+ * Writes the points of a streamed MetaScan with the same units and columns
+ * as writeMetaScan.
+ */
+void writeStreamedMetaScan(std::ofstream &ptsout,
+                           std::vector<double> &pts,
+                           std::vector<float> &refls,
+                           std::vector<unsigned char> &rgbs,
+                           bool use_reflectance,
+                           bool use_xyz,
+                           bool use_color,
+                           bool hexfloat,
+                           bool high_precision,
+                           unsigned int types,
+                           double scaleFac = 1.0)
+{
+    size_t n = pts.size() / 3;
+    DataXYZ xyz(DataPointer((unsigned char*)pts.data(), sizeof(double)*3*n));
+    if(use_reflectance) {
+        if (!(types & PointType::USE_REFLECTANCE)) refls.assign(n, 255);
+        DataReflectance r(DataPointer((unsigned char*)refls.data(), sizeof(float)*n));
+        if(use_xyz) {
+            writeXYZPointsReflectance(ptsout, xyz, r, scaleFac);
+        } else {
+            writeUOSPointsReflectance(ptsout, xyz, r, scaleFac*100.0);
+        }
+    } else if(use_color) {
+        if (!(types & PointType::USE_COLOR)) rgbs.assign(3*n, 0);
+        DataRGB rgb(DataPointer(rgbs.data(), 3*n));
+        if(use_xyz) {
+            writeXYZRGB(ptsout, xyz, rgb, scaleFac, hexfloat, high_precision);
+        } else {
+            writeUOSRGB(ptsout, xyz, rgb, scaleFac*100.0, hexfloat, high_precision);
+        }
+    } else {
+        if(use_xyz) {
+            writeXYZPoints(ptsout, xyz, 0.01);
+        } else {
+            writeUOSPoints(ptsout, xyz);
+        }
+    }
+}
+
 #endif //_CONDENSE_H
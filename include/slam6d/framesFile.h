@@ -0,0 +1,100 @@
+#ifndef __FRAMES_FILE_H__
+#define __FRAMES_FILE_H__
+
+#include "slam6d/frame.h"
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+/**
+ * Formats in which the .frames files are written
+ */
+enum FramesFormat {
+  //! one line with the 16 matrix entries and the type per frame
+  FRAMES_TEXT,
+  //! binary, runs of unchanged poses are run length encoded
+  FRAMES_BINARY,
+  //! binary, changed poses are stored relative to the previous one
+  FRAMES_BINARY_DELTA
+};
+
+/**
+ * @brief Binary .frames files with random access to every frame
+ *
+ * slam6D appends a frame to every scan in each ICP and LUM iteration, most of
+ * them repeating the pose of the previous frame. The binary format stores
+ * a run of frames with the same pose and type as a single record. A changed
+ * pose is stored either as the full matrix or, for FRAMES_BINARY_DELTA, as a
+ * quaternion and translation relative to the previous pose, which halves the
+ * size of these records. Deltas are only written if they reproduce the pose
+ * to 1e-9 relative accuracy, so poses with scale fall back to full matrices.
+ *
+ * Every full matrix record is a key frame and listed in an index at the end of
+ * the file, and at most key_interval records follow a key frame before the
+ * next one. A frame is thus decoded by a binary search in the index and
+ * replaying a bounded number of records, without reading the whole file.
+ *
+ * Layout, in native byte order:
+ *   header:  char magic[8], uint32 version, uint32 key_interval,
+ *            uint64 frames, uint64 records, uint64 index_offset,
+ *            uint64 index_entries
+ *   records: uint32 kind, uint32 type, uint64 count, followed by 16 doubles
+ *            for a matrix, 7 doubles (quaternion, translation) for a delta
+ *            or nothing for a repetition of the previous pose
+ *   index:   pairs of uint64 first frame and uint64 offset of the key frames
+ *
+ * The files keep the name scanXXX.frames, readers tell the formats apart by
+ * the magic number.
+ */
+class FramesFile {
+public:
+  /**
+   * Open a binary frames file, memory mapped if WITH_MMAP_SCAN is set.
+   * Throws a std::runtime_error if it cannot be read or is no binary frames
+   * file.
+   */
+  FramesFile(const std::string& filename);
+  ~FramesFile();
+
+  //! Number of frames in the file
+  size_t size() const { return m_frames; }
+
+  //! Decode frame i, replaying the records from the preceding key frame
+  void get(size_t i, Frame& frame) const;
+
+  //! Decode all frames and append them to frames
+  void getAll(std::vector<Frame>& frames) const;
+
+  //! Whether the file exists and starts with the magic of binary frames
+  static bool isBinary(const std::string& filename);
+
+  /**
+   * Append all frames of a text or binary frames file to frames. Text files
+   * are parsed up to the first malformed line.
+   */
+  static void read(const std::string& filename, std::vector<Frame>& frames);
+
+  /**
+   * Write n frames in the given format. With append the frames are added to
+   * the existing file, which for the binary formats is rewritten. Frames
+   * appended to a binary file stay binary.
+   */
+  static void write(const std::string& filename, const Frame* frames,
+                    size_t n, FramesFormat format, bool append = false);
+
+  //! Key frame distance in records used by write
+  static const unsigned int key_interval = 64;
+
+private:
+  const char* record(size_t offset) const;
+
+  const char* m_data;
+  size_t m_size;
+  size_t m_frames;
+  size_t m_index_offset, m_index_entries;
+  //! file contents if they are not memory mapped
+  std::vector<char> m_buffer;
+};
+
+#endif
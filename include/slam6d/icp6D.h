@@ -69,6 +69,7 @@ public:
   inline void set_max_num_iterations(int max_num_iterations);
   inline void set_cad_matching (bool cad_matching);
   inline bool get_cad_matching (void);
+  inline void set_deferred_transform(bool deferred_transform);
   inline void set_meta(bool meta);
   inline int get_nr_pointPair();
 
@@ -148,6 +149,12 @@ protected:
    * Window size for ICP with metascans
    */
   int max_num_metascans;
+
+  /**
+   * apply the transformations of an ICP run to the reduced points of the
+   * current scan once at its end instead of in every iteration
+   */
+  bool deferred_transform;
 };
 
 #include "icp6D.icc"
@@ -32,6 +32,7 @@ public:
 
   virtual const char* getIdentifier() const { return m_shared_scan->getIdentifier(); }
 
+  using Scan::get;
   virtual DataPointer get(const std::string& identifier);
   virtual void get(IODataType types);
   virtual DataPointer create(const std::string& identifier, size_t size);
@@ -33,6 +33,7 @@ public:
 
   virtual const char* getIdentifier() const { return "metascan"; }
 
+  using Scan::get;
   virtual DataPointer get(const std::string& identifier)
   {
     std::map<std::string, std::pair<unsigned char*, size_t>>::iterator it = m_pairs.find(identifier);
@@ -52,7 +52,34 @@ void calculateNormalsAdaptiveKNN(std::vector<Point> &normals,
 						                     const int kmax,
                                  const double _rPos[3]);
 
-void calculateNormal(std::vector<Point> temp, double *norm, double *eigen);
+/**
+ * Normal of the neighbourhood temp as the eigenvector of the smallest
+ * eigenvalue of its covariance. The eigenvalues are returned in ascending
+ * order in eigen.
+ */
+void calculateNormal(const std::vector<Point> &temp, double *norm, double *eigen);
+
+/**
+ * Covariance of the n points, as the upper triangle
+ * {c00, c01, c02, c11, c12, c22}.
+ */
+void covariance3x3(const Point *points, size_t n, double cov[6]);
+
+/**
+ * Closed form eigen decomposition of the symmetric 3x3 matrix given by its
+ * upper triangle A = {a00, a01, a02, a11, a12, a22}. The eigenvalues are
+ * returned in ascending order, evec[3*i .. 3*i+2] is the unit eigenvector of
+ * eval[i]. Does not allocate and is exact up to rounding, unlike an iterative
+ * solver.
+ */
+void eigenSymmetric3x3(const double A[6], double eval[3], double evec[9]);
+
+/**
+ * Normals and ascending eigenvalues of a batch of n covariances as given by
+ * covariance3x3, stored one after another in cov, norm and eigen.
+ */
+void calculateNormalsCovariance(size_t n, const double *cov,
+                                double *norm, double *eigen);
 
 void flipNormals(std::vector<Point> &normals);
 void flipNormalsUp(std::vector<Point> &normals);
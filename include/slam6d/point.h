@@ -64,7 +64,7 @@ public:
   inline bool operator==(const Point &p) const;
 
   inline void transform(const double alignxf[16]);
-  inline double distance(const Point& p);
+  inline double distance(const Point& p) const;
   inline friend std::ostream& operator<<(std::ostream& os, const Point& p);
   inline friend std::istream& operator>>(std::istream& is, Point& p);
 
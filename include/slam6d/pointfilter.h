@@ -44,6 +44,15 @@ public:
 
   //! Check a point, returning success if all contained Checker functions accept that point (implemented in .icc)
   inline bool check(double* point);
+
+  /**
+   * Checks n points stored as consecutive x, y, z triples at once. keep[i]
+   * is set to 1 if point i is accepted and to 0 otherwise, the number of
+   * accepted points is returned. The range and height tests run as one fused
+   * pass over all points without virtual calls, the remaining checkers like
+   * custom filters and the mutators only see the points accepted so far.
+   */
+  size_t check(double* xyz, size_t n, unsigned char* keep);
 private:
   //! Storage for parameter keys and values
   std::map<std::string, std::string> m_params;
@@ -57,6 +66,12 @@ private:
   //! Allocation of the checkers
   void createCheckers();
 
+  //! Range and height limits of the fused pass, squared for the ranges
+  bool m_has_max, m_has_min, m_has_top, m_has_bottom;
+  double m_max2, m_min2, m_top, m_bottom;
+  //! Checkers of the chain that are not part of the fused pass, in order
+  std::vector<Checker*> m_remaining;
+
   // factory magic
   template<typename T> friend struct CheckerFactory;
   static std::map<std::string, Checker* (*)(const std::string&)>* factory;
@@ -84,6 +99,7 @@ struct CheckerFactory {
 };
 
 class CheckerRangeMax : public Checker {
+  friend class PointFilter;
 public:
   CheckerRangeMax(const std::string& value);
   virtual bool test(double* point);
@@ -92,6 +108,7 @@ private:
 };
 
 class CheckerRangeMin : public Checker {
+  friend class PointFilter;
 public:
   CheckerRangeMin(const std::string& value);
   virtual bool test(double* point);
@@ -100,6 +117,7 @@ private:
 };
 
 class CheckerHeightTop : public Checker {
+  friend class PointFilter;
 public:
   CheckerHeightTop(const std::string& value);
   virtual bool test(double* point);
@@ -108,6 +126,7 @@ private:
 };
 
 class CheckerHeightBottom : public Checker {
+  friend class PointFilter;
 public:
   CheckerHeightBottom(const std::string& value);
   virtual bool test(double* point);
@@ -0,0 +1,71 @@
+/*
+ * poseIndex implementation
+ *
+ * Released under the GPL version 3.
+ *
+ */
+
+#ifndef __POSE_INDEX_H__
+#define __POSE_INDEX_H__
+
+#include <vector>
+#include <unordered_map>
+#include <cstddef>
+#include <stdint.h>
+
+class Scan;
+
+/**
+ * @brief Radius queries over scan positions
+ *
+ * The positions are kept in a hash grid with the query radius as cell size,
+ * so a query looks at the 27 cells around it, independent of the number of
+ * scans. Positions can be inserted one by one while the scans are matched
+ * and moved when loop closing or global relaxation changes the poses.
+ */
+class PoseIndex {
+public:
+  //! Index for queries with a radius of about cellSize
+  PoseIndex(double cellSize);
+
+  //! Add the position of scan id, or move it if it is already present
+  void insert(int id, const double *pos);
+
+  //! Add the position of scan id, taken from Scan::allScans
+  void insert(int id);
+
+  //! Take the positions of all indexed scans from Scan::allScans again
+  void update();
+
+  //! Whether scan id is indexed
+  inline bool contains(int id) const {
+    return id >= 0 && (size_t)id < present.size() && present[id];
+  }
+
+  inline size_t size() const { return count; }
+
+  /**
+   * The scans whose squared distance to pos is below radius2, in ascending
+   * order of their ids.
+   */
+  void radiusSearch(const double *pos, double radius2,
+                    std::vector<int> &result) const;
+
+private:
+  uint64_t key(const double *pos) const;
+  uint64_t key(int64_t cx, int64_t cy, int64_t cz) const;
+  void remove(int id);
+
+  double cell_size, inv_cell_size;
+
+  //! cell number to the scans in it
+  std::unordered_map<uint64_t, std::vector<int> > cells;
+
+  //! per scan id: position, cell and whether it is indexed
+  std::vector<double> positions;
+  std::vector<uint64_t> cell_of;
+  std::vector<bool> present;
+  size_t count;
+};
+
+#endif
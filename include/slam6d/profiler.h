@@ -0,0 +1,94 @@
+/**
+ * @file
+ * @brief Low overhead timers and counters for the stages of the registration
+ *
+ * The stages of slam6D report the time they take and a stage specific count
+ * per scan. Values are accumulated per thread without locking and merged when
+ * written. Disabled, which is the default, a timed scope costs one relaxed
+ * atomic load.
+ */
+
+#ifndef __PROFILER_H__
+#define __PROFILER_H__
+
+#include <atomic>
+#include <chrono>
+#include <ostream>
+#include <string>
+
+//! Stages of the registration, times of nested stages are included
+enum ProfileStage {
+  PROFILE_SCAN_LOAD,        //!< reading and filtering a scan, counts points
+  PROFILE_REDUCTION,        //!< reduction of a scan, counts reduced points
+  PROFILE_TREE_BUILD,       //!< search tree creation, counts points
+  PROFILE_CORRESPONDENCES,  //!< point pair search, counts point pairs
+  PROFILE_MINIMIZATION,     //!< pose estimation from the point pairs
+  PROFILE_LOOP_DETECTION,   //!< search for loops and graph edges, counts edges
+  PROFILE_GRAPH_SOLVE,      //!< solving the linear system of the graph
+  PROFILE_STAGES
+};
+
+class Profiler {
+public:
+  //! Start or stop the recording
+  static void setEnabled(bool enabled);
+
+  static inline bool enabled() {
+    return s_enabled.load(std::memory_order_relaxed);
+  }
+
+  //! Seconds on a monotonic clock
+  static inline double now() {
+    return std::chrono::duration<double>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+  /**
+   * Account one call of \a seconds to \a stage of scan number \a scan,
+   * -1 for work not belonging to a single scan
+   */
+  static void addTime(ProfileStage stage, int scan, double seconds);
+
+  //! Add \a count to the counter of \a stage of scan number \a scan
+  static void addCount(ProfileStage stage, int scan, unsigned long long count);
+
+  /**
+   * Write the merged values of all threads per stage and per scan.
+   * Call this after the profiled work is done.
+   */
+  static void writeJSON(std::ostream& out);
+  static void writeCSV(std::ostream& out);
+
+  //! Write to \a filename as JSON if it ends in .json, CSV otherwise
+  static void write(const std::string& filename);
+
+  //! Forget all recorded values
+  static void reset();
+
+  static const char* stageName(ProfileStage stage);
+
+private:
+  static std::atomic<bool> s_enabled;
+};
+
+/**
+ * @brief Times its lifetime as a call of a stage, if profiling is enabled
+ */
+class ProfileScope {
+public:
+  ProfileScope(ProfileStage stage, int scan = -1) :
+    m_stage(stage), m_scan(scan),
+    m_start(Profiler::enabled() ? Profiler::now() : -1.0) {}
+
+  ~ProfileScope() {
+    if (m_start >= 0.0)
+      Profiler::addTime(m_stage, m_scan, Profiler::now() - m_start);
+  }
+
+private:
+  ProfileStage m_stage;
+  int m_scan;
+  double m_start;
+};
+
+#endif
@@ -0,0 +1,36 @@
+/** @file
+ *  @brief Provenance of the points of condensed MetaScans
+ *
+ *  When condense streams its scans through a VoxelReducer it knows for every
+ *  kept point the scan it stems from. It writes this next to each MetaScan
+ *  as scanXXX.src, one line "identifier count" per source scan, so that
+ *  atomize can map the MetaScan back to its source scans without reading
+ *  them again.
+ */
+
+#ifndef __PROVENANCE_H__
+#define __PROVENANCE_H__
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * Writes one line per source with its identifier and the number of points
+ * whose entry in point_source is its position in identifiers. Sources
+ * without points, e.g. skipped empty scans, are listed with 0 points.
+ */
+void writeProvenance(std::ostream& out,
+                     const std::vector<std::string>& identifiers,
+                     const std::vector<int>& point_source);
+
+/**
+ * Reads scanXXX.src of the MetaScan fileCounter in dir. Returns false if
+ * there is no such file, the association then has to be reconstructed
+ * from the original scans. counts is only filled if non-null.
+ */
+bool readProvenance(const std::string& dir, int fileCounter,
+                    std::vector<std::string>& identifiers,
+                    std::vector<size_t>* counts = 0);
+
+#endif
@@ -16,9 +16,11 @@
 #include "point_type.h"
 #include "ptpair.h"
 #include "pairingMode.h"
+#include "framesFile.h"
 
 #include <string>
 #include <vector>
+#include <atomic>
 
 #include <boost/thread/mutex.hpp>
 #include <boost/thread/locks.hpp>
@@ -32,7 +34,7 @@
 
 //! SearchTree types
 enum nns_type {
-  simpleKD, ANNTree, BOCTree, BruteForce
+  simpleKD, ANNTree, BOCTree, BruteForce, UniformGrid
 };
 
 class Scan;
@@ -41,6 +43,33 @@ typedef std::vector<Scan*> ScanVector;
 class SearchTree;
 class ANNkd_tree;
 
+/**
+ * @brief One-time initialization, lock-free once it has been done
+ *
+ * Concurrent callers of call() wait for the first one to run the function,
+ * all later calls only cost an atomic load instead of locking a mutex.
+ */
+class OnceFlag {
+public:
+  OnceFlag() : m_done(false) {}
+
+  template <class F>
+  void call(F f) {
+    if (m_done.load(std::memory_order_acquire)) return;
+    boost::lock_guard<boost::mutex> lock(m_mutex);
+    if (m_done.load(std::memory_order_relaxed)) return;
+    f();
+    m_done.store(true, std::memory_order_release);
+  }
+
+  //! Whether a call() has completed
+  bool done() const { return m_done.load(std::memory_order_acquire); }
+
+private:
+  std::atomic<bool> m_done;
+  boost::mutex m_mutex;
+};
+
 /** HOWTO scan
 
   First: Load scans (if you want to use the scanmanager, use ManagedScan)
@@ -144,6 +173,9 @@ public:
   // current processing command
   static std::string processing_command;
 
+  // format in which saveFrames writes the .frames files
+  static FramesFormat frames_format;
+
   /**
     * Attempt to read a directory under \a path and return its read scans.
     * No scans are loaded at this point, only checked if all exist.
@@ -189,6 +221,9 @@ public:
   // set string of current processing command
   static void setProcessingCommand(int argc, char** argv);
 
+  // write the .frames files as text or in one of the binary formats
+  static void setFramesFormat(FramesFormat format);
+
   //! Input filtering for all points based on their euclidean length
   virtual void setRangeFilter(double max, double min) = 0;
 
@@ -260,6 +295,31 @@ public:
    */
   virtual DataPointer get(const std::string& identifier) = 0;
 
+  //! Handle of an interned data field identifier, see fieldId
+  typedef unsigned int FieldId;
+
+  //! Handles of the fields accessed in hot loops, interned at startup
+  static const FieldId FIELD_XYZ = 0;
+  static const FieldId FIELD_XYZ_REDUCED = 1;
+  static const FieldId FIELD_XYZ_REDUCED_ORIGINAL = 2;
+  static const FieldId FIELD_NORMAL = 3;
+  static const FieldId FIELD_NORMAL_REDUCED = 4;
+
+  /**
+   * Intern the data field \a identifier, the same identifier always gets
+   * the same handle. Resolve handles once outside of loops.
+   */
+  static FieldId fieldId(const std::string& identifier);
+
+  //! Identifier of an interned data field
+  static std::string fieldName(FieldId id);
+
+  /**
+   * Get the data field \a id like get(fieldName(id)). Implementations may
+   * answer fields that are already loaded or computed without locking.
+   */
+  virtual DataPointer get(FieldId id) { return get(fieldName(id)); }
+
   /**
    * Load the requested IODataTypes, joined by |, from the scan file.
    *
@@ -294,6 +354,11 @@ public:
     return (T(get(identifier))).size();
   }
 
+  template<typename T>
+  size_t size(FieldId id) {
+    return (T(get(id))).size();
+  }
+
   /* Frame handling functions */
 
   /**
@@ -358,6 +423,13 @@ public:
                        const AlgoType type,
                        int islum = 0);
 
+  //! Collect the transformations of the reduced points instead of applying them
+  void deferReducedTransform();
+  //! Apply the collected transformation to the reduced points
+  void applyReducedTransform();
+  //! Transformation still to be applied to the reduced points, 0 if none
+  inline const double* getPendingTransform() const;
+
   // Scan matching functions
   static void getPtPairs(std::vector<PtPair> *pairs,
                          Scan* Source,
@@ -412,6 +484,14 @@ protected:
    */
   double dalignxf[16];
 
+  /**
+   * While m_defer_reduced is set, transform leaves the reduced points as
+   * they are and collects the transformations in pendingxf instead. The
+   * correspondence search applies it to the points on the fly.
+   */
+  bool m_defer_reduced;
+  double pendingxf[16];
+
   //! Defines the method used for nearest neighbor search and which tree to use
   int nns_method;
 
@@ -442,11 +522,14 @@ protected:
   //! Leaf node size of a k-d tree
   int searchtree_bucketsize;
 
-  //! Flag whether "xyz reduced" has been initialized for this Scan yet
-  bool m_has_reduced = false;
+  //! Whether "xyz reduced" has been initialized for this Scan yet
+  OnceFlag m_reduced_once;
 
-  //! Flag whether "normals" has been initialized for this Scan yet
-  bool m_has_normals = false;
+  //! Whether "normals" has been initialized for this Scan yet
+  OnceFlag m_normals_once;
+
+  //! Whether the search tree has been created for this Scan yet
+  OnceFlag m_search_tree_once;
 
   //! Reduction value used for octtree input
   double octtree_reduction_voxelSize;
@@ -467,8 +550,8 @@ protected:
   Scan();
 
   /**
-   * This function handles the reduction of points. It builds a lock for
-   * multithread-safety and calls calcReducedOnDemandPrivate.
+   * This function handles the reduction of points. It calls
+   * calcReducedOnDemandPrivate exactly once, even from multiple threads.
    *
    * The intention is to reduce points, transforme them to the initial pose and
    * then copy them to original for the SearchTree.
@@ -476,8 +559,8 @@ protected:
   void calcReducedOnDemand();
 
   /**
-   * This function handles the computation of the normals. It builds a lock for
-   * multithread-safety and calls caldNormalsOnDemandPrivate.
+   * This function handles the computation of the normals. It calls
+   * caldNormalsOnDemandPrivate exactly once, even from multiple threads.
    */
   void calcNormalsOnDemand();
 
@@ -522,12 +605,6 @@ private:
 
   //! Calculate the covariance matrix of a leaf
   NEWMAT::SymmetricMatrix calcCovarianceMatrix(std::vector<double*>& leaf);
-
-public:
-  //! Mutex for safely reducing points and creating the search tree
-  //  just once in a multithreaded environment it can not be compiled
-  //  in win32 use boost 1.48, therefore we remeove it temporarily
-  boost::mutex m_mutex_reduction, m_mutex_create_tree, m_mutex_normals;
 };
 
 #include "scan.icc"
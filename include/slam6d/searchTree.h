@@ -109,7 +109,8 @@ public:
 					 double &sum,
 					 double *centroid_m,
 					 double *centroid_d,
-					 PairingMode pairing_mode = CLOSEST_POINT);
+					 PairingMode pairing_mode = CLOSEST_POINT,
+					 const double *target_alignxf = 0);
 };
 
 #endif
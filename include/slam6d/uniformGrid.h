@@ -0,0 +1,69 @@
+/*
+ * UniformGridSearch implementation
+ *
+ * Released under the GPL version 3.
+ *
+ */
+
+#ifndef __UNIFORM_GRID_H__
+#define __UNIFORM_GRID_H__
+
+#include "slam6d/searchTree.h"
+
+#include <vector>
+#include <unordered_map>
+#include <stdint.h>
+
+/**
+ * @brief Closest point search in a uniform grid of cubic cells
+ *
+ * CPU version of the fixed radius search of CuGrid. The points are sorted by
+ * the cell they fall into, so the points of a cell are contiguous in memory,
+ * both as xyz triples that are returned by FindClosest and as separate x, y
+ * and z arrays on which the distances of a whole cell are evaluated in one
+ * vectorized loop. A query visits the cells in rings around its own cell
+ * and stops as soon as no cell of the next ring can hold a closer point, so
+ * for dense points it rarely leaves the 27 cells around the query. The cells
+ * are indexed by a dense table if the grid is not much larger than the
+ * number of points and by a hash map otherwise.
+ *
+ * FindClosest keeps no state between queries, so it may be called by any
+ * number of threads at once.
+ */
+class UniformGridSearch : public SearchTree {
+public:
+  /**
+   * Sort the n points into a grid with the given cell size. A cell size of
+   * 0 picks one from the point density.
+   */
+  UniformGridSearch(double **pts, size_t n, double cellSize = 0.0);
+
+  virtual ~UniformGridSearch();
+
+  /**
+   * The closest point with a squared distance below maxdist2 to _p, or 0
+   * if there is none. threadNum is ignored.
+   */
+  double *FindClosest(double *_p, double maxdist2, int threadNum = 0) const;
+
+  inline double getCellSize() const { return cell_size; }
+
+private:
+  //! Range of the sorted points in cell (cx, cy, cz), false if empty
+  bool cellRange(long cx, long cy, long cz, uint32_t &begin, uint32_t &end) const;
+
+  double cell_size, inv_cell_size;
+  double origin[3];
+  long dims[3];
+
+  //! the points sorted by cell, as triples and per coordinate
+  std::vector<double> xyz, xs, ys, zs;
+
+  //! dense index: the points of cell i are cell_start[i] to cell_start[i+1]
+  std::vector<uint32_t> cell_start;
+  //! sparse index from the cell number to the range of its points
+  std::unordered_map<uint64_t, std::pair<uint32_t, uint32_t> > cell_map;
+  bool dense;
+};
+
+#endif
@@ -0,0 +1,98 @@
+/** @file
+ *  @brief Voxel grid point reduction for streamed point clouds
+ *
+ *  In contrast to the octree based reduction the points do not have to be
+ *  known in advance. They are added in arbitrary chunks and only one voxel
+ *  record per occupied voxel is kept, so the memory consumption depends on
+ *  the size of the result and not on the size of the input.
+ */
+
+#ifndef __VOXEL_REDUCER_H__
+#define __VOXEL_REDUCER_H__
+
+#include <vector>
+#include <unordered_map>
+#include <random>
+#include <stdint.h>
+
+class VoxelReducer {
+public:
+  /**
+   * @param voxelSize edge length of the voxels
+   * @param nrpts points kept per voxel, with the same meaning as for the
+   *              octree reduction: 0 keeps the point closest to the voxel
+   *              center, N > 0 keeps N randomly chosen points and -1
+   *              averages all points of a voxel
+   * @param minPoints voxels containing fewer points are dropped
+   * @param seed seed of the random selection, the result only depends on
+   *             the seed and on the order of the input points
+   */
+  VoxelReducer(double voxelSize, int nrpts = 0, size_t minPoints = 0,
+               unsigned int seed = 0);
+
+  /**
+   * Adds n points. reflectance and rgb may be null, they then are reported
+   * as 0 in the result. source identifies where the points came from, e.g.
+   * the number of the scan when several scans are merged.
+   */
+  void add(const double* xyz, const float* reflectance,
+           const unsigned char* rgb, size_t n, int source = -1);
+
+  /**
+   * Appends the reduced points in the order their voxels were first seen.
+   * reflectance, rgb and source are only filled if non-null. The source of
+   * a point is the one it was added with, for averaged voxels the source of
+   * the first point in the voxel.
+   */
+  void getPoints(std::vector<double>& xyz,
+                 std::vector<float>* reflectance = 0,
+                 std::vector<unsigned char>* rgb = 0,
+                 std::vector<int>* source = 0) const;
+
+  //! Number of occupied voxels so far
+  size_t size() const { return counts.size(); }
+
+  //! Forget all points, e.g. before starting with the next scan
+  void clear();
+
+private:
+  struct VoxelKey {
+    int64_t x, y, z;
+    bool operator==(const VoxelKey& o) const {
+      return x == o.x && y == o.y && z == o.z;
+    }
+  };
+
+  struct VoxelKeyHash {
+    size_t operator()(const VoxelKey& k) const {
+      uint64_t h = (uint64_t)k.x * 73856093ULL;
+      h ^= (uint64_t)k.y * 19349663ULL;
+      h ^= (uint64_t)k.z * 83492791ULL;
+      return (size_t)h;
+    }
+  };
+
+  void store(size_t slot, const double* p, const float* r,
+             const unsigned char* c, int source);
+
+  double voxelSize;
+  int nrpts;
+  size_t minPoints;
+  //! number of slots per voxel
+  size_t width;
+  std::mt19937 rng;
+
+  std::unordered_map<VoxelKey, size_t, VoxelKeyHash> voxels;
+  //! number of points that fell into each voxel
+  std::vector<uint64_t> counts;
+  //! squared distance of the kept point to the center, for nrpts == 0
+  std::vector<double> centerDist;
+
+  // width slots per voxel, for nrpts == -1 they hold the running sums
+  std::vector<double> slotXYZ;
+  std::vector<double> slotReflectance;
+  std::vector<double> slotRGB;
+  std::vector<int> slotSource;
+};
+
+#endif
@@ -16,6 +16,7 @@
 #include "slam6d/globals.icc"
 #include "slam6d/kdIndexed.h"
 #include "scanio/scan_io.h"
+#include "collision/environmentGrid.h"
 
 #include <time.h>
 #include <sys/stat.h>
@@ -38,7 +39,7 @@ namespace po = boost::program_options;
 #define strncasecmp _strnicmp
 #endif
 
-enum collision_method { CTYPE1, CTYPE2, CTYPE3 };
+enum collision_method { CTYPE1, CTYPE2, CTYPE3, CTYPE4 };
 enum penetrationdepth_method { PDTYPE1, PDTYPE2 };
 
 /*
@@ -64,6 +65,7 @@ void validate(boost::any& v, const std::vector<std::string>& values,
     if (strcasecmp(arg.c_str(), "type1") == 0) v = CTYPE1;
     else if (strcasecmp(arg.c_str(), "type2") == 0) v = CTYPE2;
     else if (strcasecmp(arg.c_str(), "type3") == 0) v = CTYPE3;
+    else if (strcasecmp(arg.c_str(), "type4") == 0) v = CTYPE4;
     else throw std::runtime_error(std::string("collision method ")
             + arg + std::string(" is unknown"));
 }
@@ -107,7 +109,12 @@ void parse_options(int argc, char **argv, IOType &iotype, std::string &dir,
          "number of threads to run in parallel. Default: 1")
 		("transform", po::value<std::string>(&transform)->default_value("1:0:0:0:0:1:0:0:0:0:1:0:0:0:0:1"))
 #endif
-        ("collisionmethod,c", po::value<collision_method>(&cmethod)->default_value(CTYPE1),"CPU collision method")
+        ("collisionmethod,c", po::value<collision_method>(&cmethod)->default_value(CTYPE1),
+         "CPU collision method:\n"
+         "type1 -> kd-tree radius search per model point and pose\n"
+         "type2 -> kd-tree segment search between consecutive poses\n"
+         "type3 -> mark everything as colliding\n"
+         "type4 -> voxel grid lookup, same result as type1")
         ("penetrationdepthmethod,p", po::value<penetrationdepth_method>(&pdmethod)->default_value(PDTYPE1))
         ("usecuda,C", po::value<bool>(&use_cuda)->zero_tokens(),"Use NVIDIA CUDA")
 		("device,D", po::value<int>(&cuda_device)->default_value(0));
@@ -432,6 +439,89 @@ size_t handle_pointcloud(std::vector<Point> &pointmodel, DataXYZ &environment,
     return num_colliding;
 }
 
+size_t grid_handle_pointcloud(std::vector<Point> &pointmodel, DataXYZ &environment,
+                       std::vector<Frame> const &trajectory,
+                       std::vector<bool> &colliding,
+                       double radius, int jobs)
+{
+    std::cerr << "environment: " << environment.size() << std::endl;
+    std::cerr << "building voxel grid..." << std::endl;
+    EnvironmentGrid grid(environment, radius);
+    std::cerr << "occupied cells: " << grid.numCells() << std::endl;
+
+    // bounding box of the model, its transformed corners bound every pose
+    double model_min[3], model_max[3];
+    for (int k = 0; k < 3; ++k) {
+        model_min[k] = std::numeric_limits<double>::max();
+        model_max[k] = -std::numeric_limits<double>::max();
+    }
+    for (const auto &it : pointmodel) {
+        double p[3] = {it.x, it.y, it.z};
+        for (int k = 0; k < 3; ++k) {
+            model_min[k] = std::min(model_min[k], p[k]);
+            model_max[k] = std::max(model_max[k], p[k]);
+        }
+    }
+
+    double sqRad2 = radius*radius;
+    std::cerr << "computing collisions with r = " << radius << " and " << jobs << " threads" << std::endl;
+    time_t before = time(NULL);
+    size_t culled = 0;
+    int end = trajectory.size();
+#ifdef _OPENMP
+    omp_set_num_threads(jobs);
+#pragma omp parallel for schedule(dynamic) reduction(+:culled)
+#endif
+    for(
+#if defined(_MSC_VER) and defined(_OPENMP)
+		// MSVC only supports OpenMP 2.5 where the counter must be signed
+		// There is also no ssize_t on non-POSIX platforms but sizeof(long) == sizeof(void*)
+		long
+#else
+		size_t
+#endif
+		j = 0; j < trajectory.size(); ++j) {
+        std::cerr << (j*100.0)/end << " %\r";
+        std::cerr.flush();
+        const double *alignxf = trajectory[j].transformation;
+        // swept bounding box of the model for this pose
+        double lo[3], hi[3];
+        for (int k = 0; k < 3; ++k) {
+            lo[k] = std::numeric_limits<double>::max();
+            hi[k] = -std::numeric_limits<double>::max();
+        }
+        for (int c = 0; c < 8; ++c) {
+            double corner[3] = {
+                (c & 1) ? model_max[0] : model_min[0],
+                (c & 2) ? model_max[1] : model_min[1],
+                (c & 4) ? model_max[2] : model_min[2] };
+            transform3(alignxf, corner);
+            for (int k = 0; k < 3; ++k) {
+                lo[k] = std::min(lo[k], corner[k]);
+                hi[k] = std::max(hi[k], corner[k]);
+            }
+        }
+        if (!grid.overlaps(lo, hi)) {
+            culled++;
+            continue;
+        }
+        for (const auto &it : pointmodel) {
+            double point1[3] = {it.x, it.y, it.z};
+            transform3(alignxf, point1);
+            grid.collide(point1, sqRad2);
+        }
+    }
+	// print an empty line to start new output not in the same line that
+	// contained the progress output but the next
+	std::cerr << std::endl;
+    size_t num_colliding = grid.getColliding(colliding);
+    time_t after = time(NULL);
+    std::cerr << "culled poses: " << culled << std::endl;
+    std::cerr << "colliding: " << num_colliding << std::endl;
+    std::cerr << "took: " << difftime(after, before) << " seconds" << std::endl;
+    return num_colliding;
+}
+
 #ifdef WITH_CUDA
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -912,6 +1002,8 @@ int main(int argc, char **argv)
 			for (unsigned int i = 0; i < environment.size(); ++i) {
 				colliding[i] = true;
 			}
+		} else if (cmethod == CTYPE4) {
+			num_colliding = grid_handle_pointcloud(pointmodel, environment, trajectory, colliding, radius, jobs);
 		} else {
 			num_colliding = handle_pointcloud(pointmodel, environment, trajectory, colliding, radius, cmethod, jobs);
 		}
@@ -2127,6 +2127,44 @@ void dp_optimal_point_sampling_Both(std::vector<double> *point_g,std::vector<dou
 
 
 }
+/*
+ * Table of the dynamic programming of dp_optimal_point_sampling_Single. Only
+ * the rows of a column within the sliding window around the diagonal are
+ * ever written, so each column i just stores the rows lo[i] to lo[i+1]-lo[i]
+ * elements down from there, all other entries have the default value. The
+ * memory is O(r * window_size) instead of O(c * r).
+ */
+template <class T>
+class DPBand {
+public:
+  DPBand(int cols, T dflt) : lo(cols, 0), first(cols + 1, 0), dflt(dflt) {}
+
+  //! allocate rows from..to of column col, columns are added in order
+  void add_column(int col, int from, int to) {
+    lo[col] = from;
+    first[col + 1] = first[col] + MAX(0, to - from + 1);
+    data.resize(first[col + 1], dflt);
+  }
+
+  inline int rows_begin(int col) const { return lo[col]; }
+  inline int rows_end(int col) const { return lo[col] + (int)(first[col + 1] - first[col]); }
+
+  inline T get(int row, int col) const {
+    if (row < rows_begin(col) || row >= rows_end(col)) return dflt;
+    return data[first[col] + (row - lo[col])];
+  }
+
+  inline T& at(int row, int col) {
+    return data[first[col] + (row - lo[col])];
+  }
+
+private:
+  std::vector<int> lo;
+  std::vector<size_t> first;
+  std::vector<T> data;
+  T dflt;
+};
+
 void dp_optimal_point_sampling_Single(std::vector<double> *point_curve1,std::vector<double> *point_curve2,unsigned int *opt_index,double alpha,double beta,int window_size,int type) {
 
    // defines the radius of the window size
@@ -2136,38 +2174,17 @@ void dp_optimal_point_sampling_Single(std::vector<double> *point_curve1,std::vec
     double c_i=double(c);
     double r_i=double(r);
 
-   // Variables for intermidate computations
-
-    MatrixXd cost1=MatrixXd::Constant(c,r,inf);
-    MatrixXd cost2=MatrixXd::Constant(c,r,inf);
-    MatrixXd cost3=MatrixXd::Constant(c,r,inf);
-
-
-    VectorXi index1 = VectorXi::Zero(r);
-    VectorXi index2 = VectorXi::Zero(r);
-    VectorXi index3 = VectorXi::Zero(r);
-
-    MatrixXd temp_ind1 =MatrixXd::Zero(c,r);
-    MatrixXd temp_ind2 =MatrixXd::Zero(c,r);
-    MatrixXd temp_ind3 =MatrixXd::Zero(c,r);
-
+   // Variables for intermidate computations. Only the cost of the
+   // constrained objective functional is needed for the solution, the
+   // deformation and area costs on their own are not kept.
 
-    cost1(0,0) = 0;
-    cost2(0,0) = 0;
-    cost3(0,0) = 0;
+    DPBand<double> cost(r, inf);
+    DPBand<int> temp_ind(r, 0);
+    VectorXi index = VectorXi::Zero(r);
 
-    index1(0) = 1;
-    index2(0) = 1;
-    index3(0) = 1;
-
-
-    temp_ind1(0,0) = 1;
-    temp_ind2(0,0) = 1;
-    temp_ind3(0,0) = 1;
-
-    VectorXd temp1(c);
-    VectorXd temp2(c);
-    VectorXd temp3(c);
+    cost.add_column(0, 0, 0);
+    cost.at(0,0) = 0;
+    index(0) = 1;
 
     int sliding_rate = floor(c_i/r_i);
     int uni=floor(c_i/sliding_rate);
@@ -2177,8 +2194,7 @@ void dp_optimal_point_sampling_Single(std::vector<double> *point_curve1,std::vec
 
     if(type==0)
     uni=uni-1;
-    double uni_rate[uni];
-    //MatrixXd cost3=MatrixXd::Constant(c,r,inf);
+    std::vector<double> uni_rate((c + sliding_rate - 1) / sliding_rate);
    // cout<<uni<<endl;
     Vector3d gps_point;
     Vector3d laser_point;
@@ -2215,10 +2231,10 @@ void dp_optimal_point_sampling_Single(std::vector<double> *point_curve1,std::vec
 
 #ifndef POINT3D                                //平面，二维
          // area based constraint for planar curved shapes
-    Curve_area(point_curve2,sliding_rate,uni_rate,type);
+    Curve_area(point_curve2,sliding_rate,uni_rate.data(),type);
 #else
          // length based constraint for curved shapes in > 2 dimensional space
-    Curve_length(point_curve2,sliding_rate,uni_rate,type);
+    Curve_length(point_curve2,sliding_rate,uni_rate.data(),type);
 #endif
 
     cout<<"start to process second curve using optimal sampling solution"<<endl;
@@ -2233,25 +2249,45 @@ void dp_optimal_point_sampling_Single(std::vector<double> *point_curve1,std::vec
     if(i==0)
        pre=1;
 
+    cost.add_column(i+1, start-1, las-1);
+    temp_ind.add_column(i+1, start-1, las-1);
+
+    MatrixXd fix =Curves::gpspoints[i]->transformation1;
+
+    // every row j-1 of column i+1 only depends on column i, so the rows of
+    // the window are computed in parallel
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
     for( int j=start;j<=las;j++) {
 
-      for( int m=0;m<c;m++) {
+     Matrix<double,DIMENSIONS,DIMENSIONS> rot;
+     Matrix<double,DIMENSIONS,1> trans;
+     Matrix<double,DIMENSIONS+1,DIMENSIONS+1> pose;
 
-        temp1(m)=inf;
-        temp2(m)=inf;
-        temp3(m)=inf;
-      }
+     // closing deformation cost, the same for all k
+     double closing = 0.0;
+     if ((i== (uni-2))&&(type==1)) {
+
+        Curves::Rel_Trans(Curves::laserpoints[j-1]->points2,Curves::laserpoints[0]->points2,rot,trans,pose);
 
-     MatrixXd fix =Curves::gpspoints[i]->transformation1;
+        MatrixXd pose_laserr=pose;
+        MatrixXd pose_gpss=Curves::gpspoints[i+1]->transformation1;
+        closing = alpha*pow(geo_dist_SE(pose_gpss,pose_laserr),2);
+     }
 
-   for( int k=pre-1;k<=(j-2);k++) {
+     // minimum of cost(m,i) + temp(m) over all rows m, where temp(m) is
+     // infinite outside of pre-1..j-2. Like minCoeff() the first row with
+     // the minimal value wins and row 0 is taken if all are infinite.
+     int k0 = pre-1;
+     double min3 = cost.get(0,i) + inf;
+     int minRow = 0;
 
-     Curves* c_point = Curves::laserpoints[k];
-     Curves* n_point = Curves::laserpoints[j-1];
+   for( int k=k0;k<=(j-2);k++) {
 
-     c_point->Trans_Mat(c_point,n_point);
+     Curves::Rel_Trans(Curves::laserpoints[k]->points2,Curves::laserpoints[j-1]->points2,rot,trans,pose);
 
-     MatrixXd pose_laser=c_point->transformation2;
+     MatrixXd pose_laser=pose;
 
 #ifndef POINT3D
 
@@ -2262,7 +2298,6 @@ void dp_optimal_point_sampling_Single(std::vector<double> *point_curve1,std::vec
     // and the lowest possible value is zero.
 
     double constraint = fabs(fabs(uni_rate[i]) - fabs(dx*dy));
-  //  cout<<"dx"<<" "<<dx<<" "<<"dy"<<" "<<dy<<" "<<"constraint"<<" "<<constraint<<endl;
     // closing constraint
     if ((i== (uni-2))&&(type==1)) {
 
@@ -2279,74 +2314,51 @@ void dp_optimal_point_sampling_Single(std::vector<double> *point_curve1,std::vec
 
 #endif
 
-    temp1(k) =  alpha*pow(geo_dist_SE(fix,pose_laser),2);
-    temp2(k) =  beta*constraint;
+    double temp1 =  alpha*pow(geo_dist_SE(fix,pose_laser),2);
+    double temp2 =  beta*constraint;
 
-     // closing deformation cost
      if ((i== (uni-2))&&(type==1)) {
-
-        Curves* cc_point = Curves::laserpoints[j-1];
-        Curves* nn_point = Curves::laserpoints[0];
-
-        cc_point->Trans_Mat(cc_point,nn_point);
-
-        MatrixXd pose_laserr=cc_point->transformation2;
-        MatrixXd pose_gpss=Curves::gpspoints[i+1]->transformation1;
-        temp1(k) = temp1(k) + alpha*pow(geo_dist_SE(pose_gpss,pose_laserr),2);
+        temp1 = temp1 + closing;
      }
 
-
-    temp3(k) =  temp1(k) + temp2(k);
+    double value = cost.get(k,i) + (temp1 + temp2);
+    if (k == 0) {
+      min3 = value;
+    } else if (value < min3) {
+      min3 = value;
+      minRow = k;
+    }
    }
 
-
-        MatrixXd::Index minRow, minCol;
-
-        double  min1 = (cost1.col(i) + temp1).minCoeff(&minRow, &minCol);
-        cost1(j-1,i+1)=min1;
-        temp_ind1(j-1,i+1)=minRow;
-
-        double  min2 = (cost2.col(i) + temp2).minCoeff(&minRow, &minCol);
-        cost2(j-1,i+1)=min2;
-        temp_ind2(j-1,i+1)=minRow;
-
-        double  min3 = (cost3.col(i) + temp3).minCoeff(&minRow, &minCol);
-        cost3(j-1,i+1)=min3;
-        temp_ind3(j-1,i+1)=minRow;
-        //cout<<min3<<" "<< minRow<<endl;
-
-        cout<<"the"<<" "<<i <<"th loop;"<<" "<<"the window size loop:"<<" "<<j<<endl;
+        cost.at(j-1,i+1)=min3;
+        temp_ind.at(j-1,i+1)=minRow;
 
      }
 
-
+        cout<<"the"<<" "<<i <<"th loop;"<<" "<<"the window size loop:"<<" "<<start<<" to "<<las<<endl;
 
    }
 
 
      // Work backwards to get the optimal sampling solution
-      MatrixXd::Index minRow,minCol;
-      double a=(cost1.col(r-1)).minCoeff(&minRow, &minCol);
-      index1(r-1) =minRow;
-      a=(cost2.col(r-1)).minCoeff(&minRow, &minCol);
-      index2(r-1) =minRow;
-      a=(cost3.col(r-1)).minCoeff(&minRow, &minCol);
-      index3(r-1) =minRow;
-
+      double a = cost.get(0,r-1);
+      index(r-1) = 0;
+      for (int m = MAX(1, cost.rows_begin(r-1)); m < cost.rows_end(r-1); m++) {
+        if (cost.get(m,r-1) < a) {
+          a = cost.get(m,r-1);
+          index(r-1) = m;
+        }
+      }
 
 
      for( int h=r-1;h>=1;h--) {
-        // cost of deformation
-        index1(h-1) = temp_ind1(index1(h),h);
-        // cost of the area
-        index2(h-1) = temp_ind2(index2(h),h);
         // cost of constrained objective functional
-        index3(h-1) = temp_ind3(index3(h),h);
+        index(h-1) = temp_ind.get(index(h),h);
       }
 
 
      for( int j=0;j<r;j++)
-     opt_index[j]=index3(j);
+     opt_index[j]=index(j);
      cout<<"Point correspondence calculation completed"<<endl;
 
 }
@@ -2361,11 +2373,11 @@ void Optimal_correspondence(std::vector<double> *point_curve1,std::vector<double
   double alpha = 1.0;
 
 
-  unsigned int opt_index[sample_points];
+  std::vector<unsigned int> opt_index(sample_points);
 
   //if(type==1) {
 
-   dp_optimal_point_sampling_Single(point_curve1,point_curve2,opt_index,alpha,beta,window_size,type);
+   dp_optimal_point_sampling_Single(point_curve1,point_curve2,opt_index.data(),alpha,beta,window_size,type);
 
    for(unsigned int i=0;i<=point_curve1[0].size()-1;i++) {
 
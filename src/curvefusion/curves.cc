@@ -88,168 +88,93 @@ void Curves::Trans_Mat(Curves* CurrentPoint,Curves* NextPoint)
 {
   //computer transformation matrix from current point to next point.
 
-   MatrixXd traj_point1(2,DIMENSIONS);
-   MatrixXd traj_mean1(2,DIMENSIONS);
-   MatrixXd H1(2,DIMENSIONS);
+  //trajectory 1
+   Rel_Trans(CurrentPoint->points1,NextPoint->points1,rot1,trans1,transformation1);
 
+  //trajectory 2
+   Rel_Trans(CurrentPoint->points2,NextPoint->points2,rot2,trans2,transformation2);
+}
 
-   VectorXd colpoint1_1(DIMENSIONS),colpoint1_2(DIMENSIONS);
-   VectorXd col_vec1_1(DIMENSIONS), col_vec1_2(DIMENSIONS);
+void Curves::Rel_Trans(const Vector3d &current, const Vector3d &next,
+                       Matrix<double,DIMENSIONS,DIMENSIONS> &rot,
+                       Matrix<double,DIMENSIONS,1> &trans,
+                       Matrix<double,DIMENSIONS+1,DIMENSIONS+1> &transformation)
+{
+   MatrixXd traj_point(2,DIMENSIONS);
+   MatrixXd traj_mean(2,DIMENSIONS);
+   MatrixXd H(2,DIMENSIONS);
 
-  //trajectory 1
+
+   VectorXd colpoint_1(DIMENSIONS),colpoint_2(DIMENSIONS);
+   VectorXd col_vec_1(DIMENSIONS), col_vec_2(DIMENSIONS);
 
 
    for(int i=0;i<DIMENSIONS;i++){
-   traj_point1(0,i)=(CurrentPoint->points1(i));
-   col_vec1_1(i)=traj_point1(0,i);
+   traj_point(0,i)=(current(i));
+   col_vec_1(i)=traj_point(0,i);
    }
 
    for(int j=0;j<DIMENSIONS ;j++){
-   traj_point1(1,j)=(NextPoint->points1(j));
-   col_vec1_2(j)=traj_point1(1,j);
+   traj_point(1,j)=(next(j));
+   col_vec_2(j)=traj_point(1,j);
    }
 
   //caculate mean of currentpoint and nextpoint
-   traj_mean1(0,0)=(traj_point1(0,0)+traj_point1(1,0))*0.5;
-   traj_mean1(0,1)=(traj_point1(0,1)+traj_point1(1,1))*0.5;
+   traj_mean(0,0)=(traj_point(0,0)+traj_point(1,0))*0.5;
+   traj_mean(0,1)=(traj_point(0,1)+traj_point(1,1))*0.5;
 
 #ifdef POINT3D
-   traj_mean1(0,2)=(traj_point1(0,2)+traj_point1(1,2))*0.5;
+   traj_mean(0,2)=(traj_point(0,2)+traj_point(1,2))*0.5;
 #endif
 
-   //traj_mean1(1,3)=(traj_point1(1,3)+traj_point1(2,3))/2;
    for(int i=0;i<DIMENSIONS;i++)
-   traj_mean1(1,i)=traj_mean1(0,i);
+   traj_mean(1,i)=traj_mean(0,i);
 
   //subtract the mean of trajecotry points
    for(int j = 0; j < 2; j++){
     for(int k = 0; k < DIMENSIONS; k++){
-     H1(j, k) =(traj_point1(j, k)-traj_mean1(j, k)) ;
+     H(j, k) =(traj_point(j, k)-traj_mean(j, k)) ;
     }
    }
 
 
-   JacobiSVD<MatrixXd>svd1(H1, ComputeFullU | ComputeFullV);
-   MatrixXd U1 = svd1.matrixU();
+   JacobiSVD<MatrixXd>svd(H, ComputeFullU | ComputeFullV);
 
-   MatrixXd V1 = svd1.matrixV();
+   MatrixXd V = svd.matrixV();
 
-  // colpoint1_2=(V1.transpose())*col_vec1_2;
-   colpoint1_1=(V1.transpose())*col_vec1_1;
-   colpoint1_2=(V1.transpose())*col_vec1_2;
-   MatrixXd R1=Opt_rot(colpoint1_1,colpoint1_2);
+   colpoint_1=(V.transpose())*col_vec_1;
+   colpoint_2=(V.transpose())*col_vec_2;
+   MatrixXd R=Opt_rot(colpoint_1,colpoint_2);
 
-  // IdentityMatrix E1(2);
-   MatrixXd E1= MatrixXd::Identity(DIMENSIONS,DIMENSIONS);
+   MatrixXd E= MatrixXd::Identity(DIMENSIONS,DIMENSIONS);
 
    for(int i = 0; i < 2; i++){
     for(int j = 0; j < 2; j++){
-     E1(i, j) =R1(i,j);
+     E(i, j) =R(i,j);
     }
    }
 
-   rot1=E1;
-   rot1 = V1*rot1*(V1.transpose());
+   rot=E;
+   rot = V*rot*(V.transpose());
 
 
-   trans1 = col_vec1_2 - rot1*col_vec1_1;
+   trans = col_vec_2 - rot*col_vec_1;
 
 
     for(int j = 0; j < DIMENSIONS; j++){
     for(int k = 0; k < DIMENSIONS; k++){
-     transformation1(j, k) =rot1(j, k);
+     transformation(j, k) =rot(j, k);
     }
    }
 
    for(int j = 0; j < DIMENSIONS; j++){
-   transformation1(j, DIMENSIONS)=trans1(j);
+   transformation(j, DIMENSIONS)=trans(j);
    }
 
    for(int k = 0; k < DIMENSIONS; k++)
-   transformation1(DIMENSIONS, k)=0;
-
-   transformation1(DIMENSIONS, DIMENSIONS)=1.0;
-
-
-  //trajectory 2
-   MatrixXd traj_point2(2,DIMENSIONS);
-   MatrixXd traj_mean2(2,DIMENSIONS);
-   MatrixXd H2(2,DIMENSIONS);
-   VectorXd colpoint2_1(DIMENSIONS),colpoint2_2(DIMENSIONS);
-   VectorXd col_vec2_1(DIMENSIONS), col_vec2_2(DIMENSIONS);
-
-
-   for(int i=0;i<DIMENSIONS;i++){
-   traj_point2(0,i)=(CurrentPoint->points2(i));
-   col_vec2_1(i)=traj_point2(0,i);
-   }
-
-   for(int j=0;j<DIMENSIONS;j++){
-   traj_point2(1,j)=(NextPoint->points2(j));
-   col_vec2_2(j)=traj_point2(1,j);
-   }
-
-  //caculate mean of currentpoint and nextpoint
-   traj_mean2(0,0)=(traj_point2(0,0)+traj_point2(1,0))*0.5;
-   traj_mean2(0,1)=(traj_point2(0,1)+traj_point2(1,1))*0.5;
-
-#ifdef POINT3D
-   traj_mean2(0,2)=(traj_point2(0,2)+traj_point2(1,2))*0.5;
-#endif
-
-   for(int i=0;i<DIMENSIONS;i++)
-   traj_mean2(1,i)=traj_mean2(0,i);
-
-  //subtract the mean of trajecotry points
-   for(int j = 0; j < 2; j++){
-    for(int k = 0; k < DIMENSIONS; k++){
-     H2(j, k) =(traj_point2(j, k)-traj_mean2(j, k)) ;
-    }
-   }
-
-   // Make SVD
-   JacobiSVD<MatrixXd> svd2(H2, ComputeFullU | ComputeFullV);
-   Matrix2d U2 = svd2.matrixU();
-
-
-   MatrixXd V2 = svd2.matrixV();
-
-  // Matrix2d V2 = svd2.matrixV();
-   colpoint2_1=(V2.transpose())*col_vec2_1;
-   colpoint2_2=(V2.transpose())*col_vec2_2;
-
-   MatrixXd R2=Opt_rot(colpoint2_1,colpoint2_2);
-
-   MatrixXd E2= MatrixXd::Identity(DIMENSIONS,DIMENSIONS);
-
-   for(int i = 0; i < 2; i++){
-    for(int j = 0; j < 2; j++){
-     E2(i, j) =R2(i,j);
-    }
-   }
-
-   rot2=E2;
-   rot2 = V2*rot2*(V2.transpose());
-
-  // IdentityMatrix E1(2);
-  // rot2 = V2*R2*(V2.transpose());
-   trans2 = col_vec2_2 - rot2*col_vec2_1;
-    for(int j = 0; j < DIMENSIONS; j++){
-    for(int k = 0; k < DIMENSIONS; k++){
-     transformation2(j, k) =rot2(j, k);
-    }
-   }
-
-   for(int j = 0; j < DIMENSIONS; j++){
-   transformation2(j, DIMENSIONS)=trans2(j);
-   }
-
-   for(int k = 0; k < DIMENSIONS; k++)
-   transformation2(DIMENSIONS, k)=0;
-
-   transformation2(DIMENSIONS, DIMENSIONS)=1.0;
+   transformation(DIMENSIONS, k)=0;
 
-   //return 0;
+   transformation(DIMENSIONS, DIMENSIONS)=1.0;
 }
 
 
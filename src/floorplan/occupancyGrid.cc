@@ -0,0 +1,156 @@
+/**
+ * @file occupancyGrid.cc
+ *
+ * Sparse, bit-packed 3D occupancy grid.
+ *
+ */
+
+//==============================================================================
+//  Includes.
+//==============================================================================
+#include "floorplan/occupancyGrid.h"
+
+// C++ includes.
+#include <stdexcept>
+#include <cstring>
+using namespace std;
+
+//==============================================================================
+//  Helper functions.
+//==============================================================================
+static inline int popcount64(uint64_t word) {
+#if defined(__GNUC__)
+    return __builtin_popcountll(word);
+#else
+    int count = 0;
+    for (; word; word &= word - 1) {
+        count++;
+    }
+    return count;
+#endif
+}
+
+static inline int lowestBit(uint64_t word) {
+#if defined(__GNUC__)
+    return __builtin_ctzll(word);
+#else
+    int bit = 0;
+    while (!(word & 1)) {
+        word >>= 1;
+        bit++;
+    }
+    return bit;
+#endif
+}
+
+//==============================================================================
+//  Implementation.
+//==============================================================================
+floorplan::OccupancyGrid::OccupancyGrid(const int& xCount, const int& yCount, const int& zCount) :
+    xCount(xCount), yCount(yCount), zCount(zCount)
+{
+    // The brick coordinates are packed into 21 bits each.
+    if (xCount < 0 || yCount < 0 || zCount < 0
+            || (xCount >> BRICK_BITS) >= (1 << 21)
+            || (yCount >> BRICK_BITS) >= (1 << 21)
+            || (zCount >> BRICK_BITS) >= (1 << 21))
+    {
+        throw runtime_error("invalid occupancy grid dimensions");
+    }
+}
+
+void floorplan::OccupancyGrid::set(const int& x, const int& y, const int& z) {
+    if (x < 0 || x >= xCount || y < 0 || y >= yCount || z < 0 || z >= zCount) {
+        return;
+    }
+
+    uint64_t k = key(x >> BRICK_BITS, y >> BRICK_BITS, z >> BRICK_BITS);
+    BrickMap::iterator it = this->bricks.find(k);
+    if (it == this->bricks.end()) {
+        Brick empty;
+        memset(empty.layers, 0, sizeof(empty.layers));
+        it = this->bricks.insert(make_pair(k, empty)).first;
+    }
+
+    int lx = x & (BRICK_SIZE - 1);
+    int ly = y & (BRICK_SIZE - 1);
+    int lz = z & (BRICK_SIZE - 1);
+    it->second.layers[ly] |= (uint64_t) 1 << (lx + BRICK_SIZE * lz);
+}
+
+bool floorplan::OccupancyGrid::get(const int& x, const int& y, const int& z) const {
+    if (x < 0 || x >= xCount || y < 0 || y >= yCount || z < 0 || z >= zCount) {
+        return false;
+    }
+
+    BrickMap::const_iterator it = this->bricks.find(key(x >> BRICK_BITS, y >> BRICK_BITS, z >> BRICK_BITS));
+    if (it == this->bricks.end()) {
+        return false;
+    }
+
+    int lx = x & (BRICK_SIZE - 1);
+    int ly = y & (BRICK_SIZE - 1);
+    int lz = z & (BRICK_SIZE - 1);
+    return (it->second.layers[ly] >> (lx + BRICK_SIZE * lz)) & 1;
+}
+
+void floorplan::OccupancyGrid::merge(const OccupancyGrid& other) {
+    if (other.xCount != xCount || other.yCount != yCount || other.zCount != zCount) {
+        throw runtime_error("cannot merge occupancy grids of different size");
+    }
+
+    for (BrickMap::const_iterator it = other.bricks.begin(); it != other.bricks.end(); ++it) {
+        pair<BrickMap::iterator, bool> res = this->bricks.insert(*it);
+        if (!res.second) {
+            for (int ly = 0; ly < BRICK_SIZE; ++ly) {
+                res.first->second.layers[ly] |= it->second.layers[ly];
+            }
+        }
+    }
+}
+
+size_t floorplan::OccupancyGrid::count() const {
+    size_t result = 0;
+    for (BrickMap::const_iterator it = this->bricks.begin(); it != this->bricks.end(); ++it) {
+        for (int ly = 0; ly < BRICK_SIZE; ++ly) {
+            result += popcount64(it->second.layers[ly]);
+        }
+    }
+    return result;
+}
+
+vector<int> floorplan::OccupancyGrid::layerCounts() const {
+    vector<int> hist(yCount, 0);
+    for (BrickMap::const_iterator it = this->bricks.begin(); it != this->bricks.end(); ++it) {
+        int y0 = ((it->first >> 21) & ((1 << 21) - 1)) << BRICK_BITS;
+        for (int ly = 0; ly < BRICK_SIZE; ++ly) {
+            if (it->second.layers[ly] != 0) {
+                hist[y0 + ly] += popcount64(it->second.layers[ly]);
+            }
+        }
+    }
+    return hist;
+}
+
+vector<vector<int> > floorplan::OccupancyGrid::columnCounts(const vector<bool>& useLayer) const {
+    vector<vector<int> > hMap(xCount, vector<int>(zCount, 0));
+    for (BrickMap::const_iterator it = this->bricks.begin(); it != this->bricks.end(); ++it) {
+        int x0 = (it->first >> 42) << BRICK_BITS;
+        int y0 = ((it->first >> 21) & ((1 << 21) - 1)) << BRICK_BITS;
+        int z0 = (it->first & ((1 << 21) - 1)) << BRICK_BITS;
+
+        for (int ly = 0; ly < BRICK_SIZE; ++ly) {
+            size_t y = y0 + ly;
+            if (y >= useLayer.size() || !useLayer[y]) {
+                continue;
+            }
+
+            // Visit the set bits only.
+            for (uint64_t word = it->second.layers[ly]; word; word &= word - 1) {
+                int bit = lowestBit(word);
+                hMap[x0 + (bit & (BRICK_SIZE - 1))][z0 + (bit >> BRICK_BITS)]++;
+            }
+        }
+    }
+    return hMap;
+}
@@ -51,7 +51,7 @@ struct PairComp {
 //==============================================================================
 //  Implementation.
 //==============================================================================
-vector<vector<vector<bool> > >
+floorplan::OccupancyGrid
 floorplan::Scene::compute3DOccGrid(const double& voxDimInCm,
         const double& minHeight, const double& maxHeight)
 {
@@ -74,38 +74,42 @@ floorplan::Scene::compute3DOccGrid(const double& voxDimInCm,
     int yCount = (abs(xtrY.second - xtrY.first) / voxDimInCm) + 1;
     int zCount = (abs(xtrZ.second - xtrZ.first) / voxDimInCm) + 1;
 
-    vector<vector<vector<bool> > > occVox;
-    occVox.resize(xCount);
+    OccupancyGrid occVox(xCount, yCount, zCount);
 
-    for (size_t it = 0; it < occVox.size(); ++it) {
-        occVox[it].resize(yCount);
+    // Fill in the voxels, every thread into its own grid.
+    long nrPoints = this->points.size();
+#pragma omp parallel
+    {
+        OccupancyGrid local(xCount, yCount, zCount);
+
+#pragma omp for schedule(static) nowait
+        for (long it = 0; it < nrPoints; ++it) {
+            double currX = this->points[it].x;
+            double currY = this->points[it].y;
+            double currZ = this->points[it].z;
+
+            // Since we may assign new extremities, check if current point falls into limits.
+            if (currX < xtrX.first || currX > xtrX.second
+                    || currY < xtrY.first || currY > xtrY.second
+                    || currZ < xtrZ.first || currZ > xtrZ.second)
+            {
+                continue;
+            }
 
-        for (size_t jt = 0; jt < occVox[it].size(); ++jt) {
-            occVox[it][jt].assign(zCount, false);
-        }
-    }
+            int xVox = floor((currX - xtrX.first) / voxDimInCm);
+            int yVox = floor((currY - xtrY.first) / voxDimInCm);
+            int zVox = floor((currZ - xtrZ.first) / voxDimInCm);
 
-    // Fill in the voxels.
-    for (size_t it = 0; it < this->points.size(); ++it) {
-        double currX = this->points[it].x;
-        double currY = this->points[it].y;
-        double currZ = this->points[it].z;
-
-        // Since we may assign new extremities, check if current point falls into limits.
-        if (currX < xtrX.first || currX > xtrX.second
-                || currY < xtrY.first || currY > xtrY.second
-                || currZ < xtrZ.first || currZ > xtrZ.second)
-        {
-            continue;
+            local.set(xVox, yVox, zVox);
         }
 
-        int xVox = floor((currX - xtrX.first) / voxDimInCm);
-        int yVox = floor((currY - xtrY.first) / voxDimInCm);
-        int zVox = floor((currZ - xtrZ.first) / voxDimInCm);
-
-        occVox[xVox][yVox][zVox] = true;
+#pragma omp critical
+        occVox.merge(local);
     }
 
+    if (!quiet) cout << endl << "== Occupancy grid of " << xCount << "x" << yCount << "x" << zCount
+            << " voxels with " << occVox.count() << " occupied in " << occVox.brickCount() << " bricks..." << endl;
+
     return occVox;
 }
 
@@ -292,25 +296,10 @@ void floorplan::Scene::findExtremities(pair<double, double>& xtrX, pair<double,
 
 vector<int> floorplan::Scene::computeVerticalHist(const double& bucketHeighInCm)
 {
-    vector<int> hist;
     if (!quiet) cout << endl << "== Computing vertical histogram..." << endl;
 
-    // Get a 3D occupancy grid.
-    vector<vector<vector<bool> > > occVox = this->compute3DOccGrid(bucketHeighInCm);
-
-    // Fill in the histogram.
-    hist.assign(occVox.front().size(), 0);
-    for (size_t it = 0; it < occVox.size(); ++it) {
-        for (size_t jt = 0; jt < occVox[it].size(); ++jt) {
-            for (size_t kt = 0; kt < occVox[it][jt].size(); ++kt) {
-                if (occVox[it][jt][kt] == true) {
-                    hist[jt]++;
-                }
-            }
-        }
-    }
-
-    return hist;
+    // Get a 3D occupancy grid and count the occupied voxels of each layer.
+    return this->compute3DOccGrid(bucketHeighInCm).layerCounts();
 }
 
 cv::Mat floorplan::Scene::computeHorizontalHist(const double& voxDimInCm,
@@ -345,78 +334,49 @@ cv::Mat floorplan::Scene::computeHorizontalHist(const double& voxDimInCm,
     double ceilLimit = ceilIdx * voxDimInCm;
 
     // Compute a 3D histogram excluding points contained in the floor and ceiling slice.
-    vector<vector<vector<bool> > > occVox = this->compute3DOccGrid(voxDimInCm, floorLimit, ceilLimit);
+    OccupancyGrid occVox = this->compute3DOccGrid(voxDimInCm, floorLimit, ceilLimit);
 
-    // Create a 2D histogram.
-    vector<vector<int> > hMap;
-    hMap.resize(occVox.size());
-    for (size_t it = 0; it < hMap.size(); ++it) {
-        hMap[it].assign(occVox.front().front().size(), 0);
-    }
-
-    // Maximum value in the histogram.
-    int maxVal = numeric_limits<int>::min();
+    // The horizontal layers to project.
+    vector<bool> useLayer(occVox.sizeY(), false);
 
     // Using the minimum occupied layers for computing the 2D histogram.
     if (useBest) {
         int n = round(MIN_CROSS_SECTION_COUNT * 10.0 / voxDimInCm);
         if (!quiet) cout << endl << "== Using smallest " << n << "cross sections..." << endl;
 
-        vector<pair<int, int> > pairHist(occVox.front().size());
+        vector<int> layerHist = occVox.layerCounts();
+        vector<pair<int, int> > pairHist(layerHist.size());
         for (size_t it = 0; it < pairHist.size(); ++it) {
-            pairHist[it].first = 0;
+            pairHist[it].first = layerHist[it];
             pairHist[it].second = it;
         }
 
-        for (size_t it = 0; it < occVox.size(); ++it) {
-            for (size_t jt = 0; jt < occVox[it].size(); ++jt) {
-                for (size_t kt = 0; kt < occVox[it][jt].size(); ++kt) {
-                    if (occVox[it][jt][kt] == true) {
-                        pairHist[jt].first++;
-                    }
-                }
-            }
-        }
-
         sort(pairHist.begin(), pairHist.end(), pairComparer);
 
-        for (size_t it = 0; it < occVox.size(); ++it) {
-
-            for (int i = 0; i < n; ++i) {
-                size_t jt = pairHist[i].second;
-
-                for (size_t kt = 0; kt < occVox[it][jt].size(); ++kt) {
-                    if (occVox[it][jt][kt] == true) {
-                        hMap[it][kt]++;
-                        if (maxVal < hMap[it][kt]) {
-                            maxVal = hMap[it][kt];
-                        }
-                    }
-                }
-            }
+        for (int i = 0; i < n && i < (int) pairHist.size(); ++i) {
+            useLayer[pairHist[i].second] = true;
         }
-
-
-
     } else {
         if (!quiet) cout << endl << "== Using all cross sections..." << endl;
 
-        for (size_t it = 0; it < occVox.size(); ++it) {
-            for (size_t jt = 0; jt < occVox[it].size(); ++jt) {
-                for (size_t kt = 0; kt < occVox[it][jt].size(); ++kt) {
-                    if (occVox[it][jt][kt] == true) {
-                        hMap[it][kt]++;
-                        if (maxVal < hMap[it][kt]) {
-                            maxVal = hMap[it][kt];
-                        }
-                    }
-                }
+        useLayer.assign(occVox.sizeY(), true);
+    }
+
+    // Create a 2D histogram.
+    vector<vector<int> > hMap = occVox.columnCounts(useLayer);
+
+    // Maximum value in the histogram.
+    int maxVal = numeric_limits<int>::min();
+    for (size_t it = 0; it < hMap.size(); ++it) {
+        for (size_t jt = 0; jt < hMap[it].size(); ++jt) {
+            if (hMap[it][jt] > 0 && maxVal < hMap[it][jt]) {
+                maxVal = hMap[it][jt];
             }
         }
     }
 
     // Gray image.
-    cv::Mat gray(occVox.size(), occVox.front().front().size(), CV_32FC1);
+    cv::Mat gray(occVox.sizeX(), occVox.sizeZ(), CV_32FC1);
     for (size_t it = 0; it < hMap.size(); ++it) {
         for (size_t jt = 0; jt < hMap[it].size(); ++jt) {
             gray.at<float>(it, jt) = (float) hMap[it][jt] / maxVal;
@@ -45,7 +45,6 @@ using namespace std;
 //==============================================================================
 //  Static fields initialization
 //==============================================================================
-const double model::Scene::PRECISION    = 0.0;
 const double model::Scene::RAY_DIST     = 2.5;
 const double model::Scene::PATCH_DIST   = 1.0;
 const double model::Scene::WALL_DIST    = 10.0; // must be bigger than RAY_DIST
@@ -476,21 +475,26 @@ void model::Scene::detectWalls() {
 bool model::Scene::castRay(const Point3d& src, const Point3d& dest, const double& extraDist,
         Point3d& ptHit)
 {
-    // put the Bresenham line in here, we need some extra distance in case the points are close
-    // but after the detected wall, therefore we need to go a bit further than the wall to check
-    vector<Point3d> line;
-    GraphicsAlg::getDiscreteLine(src, dest, PRECISION, extraDist, line);
-
-    // loop through all the points in the Bresenham line and decide if it hits something
-    for (vector<Point3d>::iterator it = line.begin(); it != line.end(); ++it) {
-        if (this->isOccupied(*it, RAY_DIST)) {
-            ptHit = *it;
-            return true;
-        }
+    // we need some extra distance in case the points are close but after the
+    // detected wall, therefore we need to go a bit further than the wall to check
+    double origin[] = {src.x, src.y, src.z};
+    double dir[] = {dest.x - src.x, dest.y - src.y, dest.z - src.z};
+    double len = src.distance(dest);
+    if (len == 0.0) {
+        return false;
+    }
+
+    // a point hits the ray if it is within RAY_DIST / 2 of it
+    double t;
+    if (this->octTree->FirstHit(origin, dir, RAY_DIST / 2.0, len + extraDist, &t) == NULL) {
+        // no occlusion took place
+        return false;
     }
 
-    // no occlusion took place
-    return false;
+    ptHit = Point3d(src.x + dir[0] * t / len,
+            src.y + dir[1] * t / len,
+            src.z + dir[2] * t / len);
+    return true;
 }
 
 void model::Scene::applyLabels(LabeledPlane3d& surf) {
@@ -521,33 +525,64 @@ void model::Scene::applyLabels(LabeledPlane3d& surf) {
 
     if (!quiet) cout << endl << "== Performing ray casting for surface centered at " << surf.pt << endl;
 
+    // a patch is occupied if the ray through the wall hits something, this
+    // does not depend on the pose
+    for (unsigned int i = 0; i < surf.patches.size(); ++i) {
+        for (unsigned int j = 0; j <  surf.patches[i].size(); ++j) {
+            // prepare two points for ray casting through wall
+            Point3d ptOnWall  = surf.patches[i][j].first;
+            Point3d src(surf.normal.x + ptOnWall.x,
+                    surf.normal.y + ptOnWall.y,
+                    surf.normal.z + ptOnWall.z);
+
+            double len = ptOnWall.distance(src);
+            double temp = (len + WALL_DIST) / len;
+            src.x = ptOnWall.x + (src.x - ptOnWall.x) * temp;
+            src.y = ptOnWall.y + (src.y - ptOnWall.y) * temp;
+            src.z = ptOnWall.z + (src.z - ptOnWall.z) * temp;
+
+            // remember the point we hit when ray casting
+            Point3d ptHit;
+
+            if (insideHull(surf.patches[i][j].first, surf.hull) && castRay(src, ptOnWall, WALL_DIST, ptHit)) {
+                surf.patches[i][j].second = OCCUPIED;
+                surf.depthMap[i][j] = maxDist - src.distance(ptHit);
+            }
+        }
+    }
+
+    // every other patch is empty if it can be seen from any of the poses
     for (vector<Pose6d>::iterator srcPose = this->poses.begin(); srcPose != this->poses.end(); ++srcPose) {
+        vector<pair<unsigned int, unsigned int> > idx;
+        vector<double> targets;
         for (unsigned int i = 0; i < surf.patches.size(); ++i) {
             for (unsigned int j = 0; j <  surf.patches[i].size(); ++j) {
-                // prepare two points for ray casting through wall
-                Point3d ptOnWall  = surf.patches[i][j].first;
-                Point3d src(surf.normal.x + ptOnWall.x,
-                        surf.normal.y + ptOnWall.y,
-                        surf.normal.z + ptOnWall.z);
-
-                double len = ptOnWall.distance(src);
-                double temp = (len + WALL_DIST) / len;
-                src.x = ptOnWall.x + (src.x - ptOnWall.x) * temp;
-                src.y = ptOnWall.y + (src.y - ptOnWall.y) * temp;
-                src.z = ptOnWall.z + (src.z - ptOnWall.z) * temp;
-
-                // remember the point we hit when ray casting
-                Point3d ptHit;
-
-                if (insideHull(surf.patches[i][j].first, surf.hull) && castRay(src, ptOnWall, WALL_DIST, ptHit)) {
-                    surf.patches[i][j].second = OCCUPIED;
-                    surf.depthMap[i][j] = maxDist - src.distance(ptHit);
-                } else if (!castRay(srcPose->first, surf.patches[i][j].first, 0, ptHit)) {
-                    surf.patches[i][j].second = EMPTY;
-                    surf.depthMap[i][j] = 0.0;
+                if (surf.patches[i][j].second == OCCLUDED) {
+                    const Point3d& pt = surf.patches[i][j].first;
+                    idx.push_back(make_pair(i, j));
+                    targets.push_back(pt.x);
+                    targets.push_back(pt.y);
+                    targets.push_back(pt.z);
                 }
             }
         }
+        if (idx.empty()) break;
+
+        // cast the rays from the pose to all these patches at once
+        vector<const double*> targetPtrs(idx.size());
+        for (size_t k = 0; k < idx.size(); ++k) {
+            targetPtrs[k] = &targets[3 * k];
+        }
+        vector<double*> hits(idx.size());
+        double origin[] = {srcPose->first.x, srcPose->first.y, srcPose->first.z};
+        this->octTree->FirstHits(origin, &targetPtrs[0], idx.size(), RAY_DIST / 2.0, 0.0, &hits[0]);
+
+        for (size_t k = 0; k < idx.size(); ++k) {
+            if (hits[k] == NULL) {
+                surf.patches[idx[k].first][idx[k].second].second = EMPTY;
+                surf.depthMap[idx[k].first][idx[k].second] = 0.0;
+            }
+        }
     }
 
     // create the OpenCV depth image
@@ -1507,27 +1542,3 @@ void model::Scene::flood(LabeledPlane3d& surf,
         }
     }
 }
-
-bool model::Scene::isOccupied(const Point3d& center, const double& width) {
-    // look for a close point
-    double pt[] = {center.x, center.y, center.z};
-    double* closest = this->octTree->FindClosest(pt, pow(sqrt(3) * (width / 2.0), 2.0), 0);
-
-    // bounding box limits
-    double xUppLim = center.x + width / 2.0;
-    double xLowLim = center.x - width / 2.0;
-    double yUppLim = center.y + width / 2.0;
-    double yLowLim = center.y - width / 2.0;
-    double zUppLim = center.z + width / 2.0;
-    double zLowLim = center.z - width / 2.0;
-
-    if (closest != NULL &&
-            (closest[0] > xLowLim && closest[0] < xUppLim) &&
-            (closest[1] > yLowLim && closest[1] < yUppLim) &&
-            (closest[2] > zLowLim && closest[2] < zUppLim))
-    {
-        return true;
-    }
-
-    return false;
-}
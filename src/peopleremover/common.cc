@@ -1,5 +1,7 @@
 #include <peopleremover/common.h>
 
+#include <algorithm>
+
 /*
  * define a hash function for struct voxel
  */
@@ -53,18 +55,266 @@ struct voxel voxel_of_point(const double *p, double voxel_size)
 			py_div(p[2], voxel_size));
 }
 
+const int32_t VoxelOccupancy::empty_block =
+	std::numeric_limits<int32_t>::min();
+
+VoxelOccupancy::VoxelOccupancy() : num_voxels(0) {}
+
+VoxelOccupancy::key VoxelOccupancy::make_key(const struct voxel &v)
+{
+	key k = {(int32_t)v.x, (int32_t)v.y, (int32_t)v.z};
+	return k;
+}
+
+uint64_t VoxelOccupancy::hash(const key &k)
+{
+	uint64_t h = (uint64_t)(uint32_t)k.x * 0x9E3779B97F4A7C15ULL;
+	h ^= (uint64_t)(uint32_t)k.y * 0xC2B2AE3D27D4EB4FULL;
+	h ^= (uint64_t)(uint32_t)k.z * 0x165667B19E3779F9ULL;
+	h ^= h >> 29;
+	h *= 0xBF58476D1CE4E5B9ULL;
+	h ^= h >> 32;
+	return h;
+}
+
+size_t VoxelOccupancy::probe(const shard &s, const key &k, uint64_t h,
+			     bool &found)
+{
+	size_t mask = s.table.size() - 1;
+	size_t slot = (h >> shard_bits) & mask;
+	// linear probing, the table is never more than half full
+	while (s.table[slot] != 0) {
+		if (s.voxels[s.table[slot] - 1] == k) {
+			found = true;
+			return slot;
+		}
+		slot = (slot + 1) & mask;
+	}
+	found = false;
+	return slot;
+}
+
+void VoxelOccupancy::rehash(shard &s, size_t capacity)
+{
+	size_t size = 16;
+	while (size < 2 * capacity) {
+		size *= 2;
+	}
+	s.table.assign(size, 0);
+	for (size_t i = 0; i < s.voxels.size(); ++i) {
+		bool found;
+		size_t slot = probe(s, s.voxels[i], hash(s.voxels[i]), found);
+		s.table[slot] = i + 1;
+	}
+}
+
+void VoxelOccupancy::build(
+    const std::unordered_map<size_t, DataXYZ> &points_by_slice,
+    double voxel_size, int jobs)
+{
+	std::vector<size_t> ids;
+	for (const std::pair<const size_t, DataXYZ> &el : points_by_slice) {
+		ids.push_back(el.first);
+	}
+	// filling the shards in ascending slice order keeps the slice ids
+	// of every voxel sorted
+	std::sort(ids.begin(), ids.end());
+	if (!ids.empty() && ids.back() > std::numeric_limits<slice_t>::max()) {
+		throw std::runtime_error("too many scan slices");
+	}
+
+	// the distinct voxels of every slice, split by shard
+	std::vector<std::vector<std::vector<key>>> by_slice(
+	    ids.size(), std::vector<std::vector<key>>(num_shards));
+	bool overflow = false;
+#ifdef _OPENMP
+	omp_set_num_threads(jobs);
+#pragma omp parallel for schedule(dynamic) reduction(||:overflow)
+#endif
+	for (long k = 0; k < (long)ids.size(); ++k) {
+		const DataXYZ &xyz = points_by_slice.at(ids[k]);
+		std::vector<struct voxel> voxels;
+		voxels.reserve(xyz.size());
+		for (size_t i = 0; i < xyz.size(); ++i) {
+			voxels.push_back(voxel_of_point(xyz[i], voxel_size));
+		}
+		std::sort(voxels.begin(), voxels.end());
+		voxels.erase(std::unique(voxels.begin(), voxels.end()),
+			     voxels.end());
+		for (const struct voxel &v : voxels) {
+			if (v.x != (int32_t)v.x || v.y != (int32_t)v.y ||
+			    v.z != (int32_t)v.z) {
+				overflow = true;
+			}
+			key kv = make_key(v);
+			by_slice[k][hash(kv) & (num_shards - 1)].push_back(kv);
+		}
+	}
+	if (overflow) {
+		throw std::runtime_error(
+		    "voxel coordinates exceed 32 bit, increase the voxel size");
+	}
+
+	shards.assign(num_shards, shard());
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+	for (long n = 0; n < (long)num_shards; ++n) {
+		shard &s = shards[n];
+		size_t bound = 0;
+		for (size_t k = 0; k < ids.size(); ++k) {
+			bound += by_slice[k][n].size();
+		}
+		rehash(s, bound);
+
+		// collect the voxels of this shard and count their slices
+		std::vector<uint32_t> counts;
+		for (size_t k = 0; k < ids.size(); ++k) {
+			for (const key &kv : by_slice[k][n]) {
+				bool found;
+				size_t slot = probe(s, kv, hash(kv), found);
+				if (!found) {
+					s.table[slot] = s.voxels.size() + 1;
+					s.voxels.push_back(kv);
+					counts.push_back(0);
+				}
+				counts[s.table[slot] - 1] += 1;
+			}
+		}
+		s.voxels.shrink_to_fit();
+		rehash(s, s.voxels.size());
+
+		// a shard holds less than 2^32 (voxel, slice) pairs as long as
+		// there are less than 2^38 in total
+		s.offsets.resize(s.voxels.size() + 1);
+		s.offsets[0] = 0;
+		for (size_t i = 0; i < counts.size(); ++i) {
+			s.offsets[i + 1] = s.offsets[i] + counts[i];
+		}
+		s.slices.resize(s.offsets.back());
+		std::vector<uint32_t> pos(s.offsets.begin(), s.offsets.end() - 1);
+		for (size_t k = 0; k < ids.size(); ++k) {
+			for (const key &kv : by_slice[k][n]) {
+				bool found;
+				size_t slot = probe(s, kv, hash(kv), found);
+				s.slices[pos[s.table[slot] - 1]++] = ids[k];
+			}
+			std::vector<key>().swap(by_slice[k][n]);
+		}
+	}
+
+	num_voxels = 0;
+	std::vector<key> occupied_blocks;
+	for (const shard &s : shards) {
+		num_voxels += s.voxels.size();
+		for (const key &kv : s.voxels) {
+			key b = {kv.x >> block_bits, kv.y >> block_bits,
+				 kv.z >> block_bits};
+			occupied_blocks.push_back(b);
+		}
+	}
+	std::sort(occupied_blocks.begin(), occupied_blocks.end());
+	occupied_blocks.erase(
+	    std::unique(occupied_blocks.begin(), occupied_blocks.end()),
+	    occupied_blocks.end());
+
+	// the block table is kept at most a quarter full for short probes
+	size_t size = 16;
+	while (size < 4 * occupied_blocks.size()) {
+		size *= 2;
+	}
+	key empty = {empty_block, 0, 0};
+	blocks.assign(size, empty);
+	block_masks.assign(size, 0);
+	for (const shard &s : shards) {
+		for (const key &kv : s.voxels) {
+			key b = {kv.x >> block_bits, kv.y >> block_bits,
+				 kv.z >> block_bits};
+			size_t slot = hash(b) & (size - 1);
+			while (blocks[slot].x != empty_block &&
+			       !(blocks[slot] == b)) {
+				slot = (slot + 1) & (size - 1);
+			}
+			blocks[slot] = b;
+			block_masks[slot] |= cell_bit_of(voxel(kv.x, kv.y, kv.z));
+		}
+	}
+}
+
+VoxelOccupancy::slices VoxelOccupancy::find(const struct voxel &v) const
+{
+	slices result = {0, 0};
+	if (shards.empty() || v.x != (int32_t)v.x || v.y != (int32_t)v.y ||
+	    v.z != (int32_t)v.z) {
+		return result;
+	}
+	key kv = make_key(v);
+	uint64_t h = hash(kv);
+	const shard &s = shards[h & (num_shards - 1)];
+	bool found;
+	size_t slot = probe(s, kv, h, found);
+	if (found) {
+		size_t i = s.table[slot] - 1;
+		result.first = s.slices.data() + s.offsets[i];
+		result.last = s.slices.data() + s.offsets[i + 1];
+	}
+	return result;
+}
+
+uint64_t VoxelOccupancy::block_mask(const struct voxel &block) const
+{
+	if (blocks.empty() || block.x != (int32_t)block.x ||
+	    block.y != (int32_t)block.y || block.z != (int32_t)block.z) {
+		return 0;
+	}
+	key b = make_key(block);
+	size_t mask = blocks.size() - 1;
+	size_t slot = hash(b) & mask;
+	while (blocks[slot].x != empty_block) {
+		if (blocks[slot] == b) {
+			return block_masks[slot];
+		}
+		slot = (slot + 1) & mask;
+	}
+	return 0;
+}
+
+std::vector<struct voxel> VoxelOccupancy::voxels() const
+{
+	std::vector<struct voxel> result;
+	result.reserve(num_voxels);
+	for (const shard &s : shards) {
+		for (const key &kv : s.voxels) {
+			result.push_back(voxel(kv.x, kv.y, kv.z));
+		}
+	}
+	return result;
+}
+
+size_t VoxelOccupancy::memory() const
+{
+	size_t bytes = 0;
+	for (const shard &s : shards) {
+		bytes += s.table.capacity() * sizeof(uint32_t);
+		bytes += s.voxels.capacity() * sizeof(key);
+		bytes += s.offsets.capacity() * sizeof(uint32_t);
+		bytes += s.slices.capacity() * sizeof(slice_t);
+	}
+	bytes += blocks.capacity() * sizeof(key);
+	bytes += block_masks.capacity() * sizeof(uint64_t);
+	return bytes;
+}
 
 bool visitor(struct voxel voxel, void *data)
 {
 	struct visitor_args *args = (struct visitor_args *)data;
-	std::unordered_map<struct voxel, std::set<size_t>>::const_iterator scanslices_it =
+	VoxelOccupancy::slices scanslices =
 		args->voxel_occupied_by_slice->find(voxel);
 	// if voxel has no points at all, continue searching without marking
 	// the current voxel as free as it had no points to begin with
-	if (scanslices_it == args->voxel_occupied_by_slice->end()) {
+	if (scanslices.empty()) {
 		return true;
 	}
-	std::set<size_t> scanslices = scanslices_it->second;
 	/*
 	 * The following implements a sliding window within which voxels
 	 * that also contain points with a similar index as the current
@@ -80,7 +330,8 @@ bool visitor(struct voxel voxel, void *data)
 	 */
 	if (args->diff == 0) {
 		// if the voxel contains the current slice, abort the search
-		if (scanslices.find(args->current_slice) != scanslices.end()) {
+		if (std::binary_search(scanslices.begin(), scanslices.end(),
+				       args->current_slice)) {
 			return false;
 		}
 	} else {
@@ -91,7 +342,8 @@ bool visitor(struct voxel voxel, void *data)
 			window_start = 0;
 		}
 		// first element that is equivalent or goes after value
-		std::set<size_t>::iterator lower_bound = scanslices.lower_bound(window_start);
+		const VoxelOccupancy::slice_t *lower_bound = std::lower_bound(
+			scanslices.begin(), scanslices.end(), window_start);
 		// if elements in the set are found around the neighborhood of the
 		// current slice, abort the search
 		if (lower_bound != scanslices.end() && *lower_bound <= args->current_slice + args->diff) {
@@ -102,13 +354,6 @@ bool visitor(struct voxel voxel, void *data)
 	return true;
 }
 
-/*
- * walk voxels as described in
- *   Fast Voxel Traversal Algorithm for Ray Tracing
- *   by John Amanatides, Andrew Woo
- *   Eurographics ’87
- *   http://www.cs.yorku.ca/~amana/research/grid.pdf
- */
 void walk_voxels(
 		const double * const start_pos,
 		const double * const end_pos,
@@ -117,192 +362,10 @@ void walk_voxels(
 		void *data
 		)
 {
-	double *direction = new double[3];
-	direction[0] = end_pos[0] - start_pos[0];
-	direction[1] = end_pos[1] - start_pos[1];
-	direction[2] = end_pos[2] - start_pos[2];
-	if (direction[0] == 0 && direction[1] == 0 && direction[2] == 0) {
-		// FIXME: should we really abort here? Should we not at least call
-		// visitor() on the start_voxel?
-		return;
-	}
-	const struct voxel start_voxel = voxel_of_point(start_pos,voxel_size);
-	struct voxel cur_voxel = voxel(start_voxel);
-	const struct voxel end_voxel = voxel_of_point(end_pos,voxel_size);
-	visitor(start_voxel, data);
-	if (start_voxel.x == end_voxel.x && start_voxel.y == end_voxel.y && start_voxel.z == end_voxel.z) {
-		return;
-	}
-	double tDeltaX, tMaxX, maxMultX;
-	double tDeltaY, tMaxY, maxMultY;
-	double tDeltaZ, tMaxZ, maxMultZ;
-	signed char stepX, stepY, stepZ;
-	/*
-	 * tMax*: value t at which the segment crosses the first voxel boundary in the given direction
-	 * stepX: in which direction to increase the voxel count (1 or -1)
-	 * tDelta*: value t needed to span the voxel size in the given direction up to the target
-	 */
-	if (direction[0] == 0) {
-		tDeltaX = 0;
-		stepX = 0;
-		tMaxX = std::numeric_limits<double>::infinity();
-		maxMultX = std::numeric_limits<double>::infinity();
-	} else {
-		stepX = direction[0] > 0 ? 1 : -1;
-		tDeltaX = stepX*voxel_size/direction[0];
-		tMaxX = tDeltaX * (1.0 - py_mod(stepX*(start_pos[0]/voxel_size), 1.0));
-		maxMultX = (end_voxel.x - start_voxel.x)*stepX;
-		if (stepX == -1 && tMaxX == tDeltaX && start_voxel.x != end_voxel.x) {
-			cur_voxel.x -= 1;
-			start_voxel.x -= 1;
-			maxMultX -= 1;
-		}
-	}
-	if (direction[1] == 0) {
-		tDeltaY = 0;
-		stepY = 0;
-		tMaxY = std::numeric_limits<double>::infinity();
-		maxMultY = std::numeric_limits<double>::infinity();
-	} else {
-		stepY = direction[1] > 0 ? 1 : -1;
-		tDeltaY = stepY*voxel_size/direction[1];
-		tMaxY = tDeltaY * (1.0 - py_mod(stepY*(start_pos[1]/voxel_size), 1.0));
-		maxMultY = (end_voxel.y - start_voxel.y)*stepY;
-		if (stepY == -1 && tMaxY == tDeltaY && start_voxel.y != end_voxel.y) {
-			cur_voxel.y -= 1;
-			start_voxel.y -= 1;
-			maxMultY -= 1;
-		}
-	}
-	if (direction[2] == 0) {
-		tDeltaZ = 0;
-		stepZ = 0;
-		tMaxZ = std::numeric_limits<double>::infinity();
-		maxMultZ = std::numeric_limits<double>::infinity();
-	} else {
-		stepZ = direction[2] > 0 ? 1 : -1;
-		tDeltaZ = stepZ*voxel_size/direction[2];
-		tMaxZ = tDeltaZ * (1.0 - py_mod(stepZ*(start_pos[2]/voxel_size), 1.0));
-		maxMultZ = (end_voxel.z - start_voxel.z)*stepZ;
-		if (stepZ == -1 && tMaxZ == tDeltaZ && start_voxel.z != end_voxel.z) {
-			cur_voxel.z -= 1;
-			start_voxel.z -= 1;
-			maxMultZ -= 1;
-		}
-	}
-	// FIXME: don't call visitor() unconditionally but only if cur_voxel
-	// unequal start_voxel
-	visitor(cur_voxel, data);
-	if (cur_voxel.x == end_voxel.x && cur_voxel.y == end_voxel.y && cur_voxel.z == end_voxel.z) {
-		return;
-	}
-	/*
-	 * in contrast to the original algorithm by John Amanatides and Andrew Woo
-	 * we increment a counter and multiply the step size instead of adding up
-	 * the steps. Doing the latter might introduce errors because due to
-	 * floating point precision errors, 0.1+0.1+0.1 is unequal 3*0.1.
-	 */
-	size_t multX = 0, multY = 0, multZ = 0;
-	double tMaxXStart = tMaxX;
-	double tMaxYStart = tMaxY;
-	double tMaxZStart = tMaxZ;
-	/*
-	 * iterate until either:
-	 *  - the final voxel is reached
-	 *  - tMax is reached by all tMax-coordinates
-	 *  - the current voxel contains points of (or around) the current scan
-	 */
-	while (1) {
-		double minVal = std::min(std::min(tMaxX, tMaxY), tMaxZ);
-		bool steppedX = false, steppedY = false, steppedZ = false;
-		if (minVal == tMaxX) {
-			multX += 1;
-			cur_voxel.x = start_voxel.x + multX*stepX;
-			tMaxX = tMaxXStart + multX*tDeltaX;
-			steppedX = true;
-		}
-		if (minVal == tMaxY) {
-			multY += 1;
-			cur_voxel.y = start_voxel.y + multY*stepY;
-			tMaxY = tMaxYStart + multY*tDeltaY;
-			steppedY = true;
-		}
-		if (minVal == tMaxZ) {
-			multZ += 1;
-			cur_voxel.z = start_voxel.z + multZ*stepZ;
-			tMaxZ = tMaxZStart + multZ*tDeltaZ;
-			steppedZ = true;
-		}
-		/*
-		 * If we end up stepping in more than one direction at the same time,
-		 * then we must also assess if we have to add the voxel that we just
-		 * "graced" in the process.
-		 * An additional voxel must only be added in six of the eight different
-		 * directions that we can step into. If we step in all positive or
-		 * in all negative directions, then no additional voxel is added.
-		 */
-		if (((steppedX && steppedY) || (steppedY && steppedZ) || (steppedX && steppedZ))
-		&& (stepX == 1 || stepY == 1 || stepZ == 1) && (stepX == -1 || stepY == -1 || stepZ == -1)) {
-			struct voxel add_voxel(cur_voxel);
-			/*
-			 * a voxel was only possibly missed if we stepped into a
-			 * negative direction and if that step was actually carried
-			 * out in this iteration
-			 */
-			if (steppedX) {
-				if (stepX < 0) {
-					if (multX > maxMultX + 1) {
-						break;
-					}
-					add_voxel.x += 1;
-				} else if (multX > maxMultX) {
-					break;
-				}
-			}
-			if (steppedY) {
-				if (stepY < 0) {
-					if (multY > maxMultY + 1) {
-						break;
-					}
-					add_voxel.y += 1;
-				} else if (multY > maxMultY) {
-					break;
-				}
-			}
-			if (steppedZ) {
-				if (stepZ < 0) {
-					if (multZ > maxMultZ + 1) {
-						break;
-					}
-					add_voxel.z += 1;
-				} else if (multZ > maxMultZ) {
-					break;
-				}
-			}
-			// FIXME: only call visitor if add_voxel unequal cur_voxel
-			if (!visitor(add_voxel, data)) {
-				break;
-			}
-		}
-		/*
-		 * non-exact versions of this algorithm might never reach the end voxel,
-		 * so we abort early using a different criterion
-		 */
-		if (steppedX && multX > maxMultX) {
-			break;
-		}
-		if (steppedY && multY > maxMultY) {
-			break;
-		}
-		if (steppedZ && multZ > maxMultZ) {
-			break;
-		}
-		if (!visitor(cur_voxel, data)) {
-			break;
-		}
-	}
-	delete[] direction;
-	return;
+	auto visit = [visitor, data](const struct voxel &v) {
+		return visitor(v, data);
+	};
+	walk_voxels(start_pos, end_pos, voxel_size, visit);
 }
 
 void validate(boost::any& v, const std::vector<std::string>& values,
@@ -173,23 +173,8 @@ int main(int argc, char *argv[])
 #ifndef _MSC_VER
 	clock_gettime(CLOCK_MONOTONIC, &before);
 #endif
-	std::unordered_map<struct voxel, std::set<size_t>>
-	    voxel_occupied_by_slice;
-	std::cerr << "0 %\r";
-	std::cerr.flush();
-	size_t done = 0;
-	for (std::pair<size_t, DataXYZ> element : points_by_slice) {
-		for (size_t i = 0; i < element.second.size(); ++i) {
-			voxel_occupied_by_slice
-			    [voxel_of_point(element.second[i], voxel_size)]
-				.insert(element.first);
-		}
-		std::cerr << ((done + 1) * 100.0f / points_by_slice.size())
-			  << " %\r";
-		std::cerr.flush();
-		done += 1;
-	}
-	std::cerr << std::endl;
+	VoxelOccupancy voxel_occupied_by_slice;
+	voxel_occupied_by_slice.build(points_by_slice, voxel_size, jobs);
 #ifndef _MSC_VER
 	clock_gettime(CLOCK_MONOTONIC, &after);
 	elapsed = (after.tv_sec - before.tv_sec);
@@ -203,6 +188,8 @@ int main(int argc, char *argv[])
 	}
 
 	std::cerr << "occupied voxels: " << voxel_occupied_by_slice.size()
+		  << " (index size: "
+		  << voxel_occupied_by_slice.memory() / 1024 / 1024 << " MiB)"
 		  << std::endl;
 
 	if (maxrange_method != NONE) {
@@ -226,7 +213,7 @@ int main(int argc, char *argv[])
 	 * done because they are not done in order when execution happens in
 	 * parallel
 	 */
-	done = 0;
+	size_t done = 0;
 #ifdef _OPENMP
 	omp_set_num_threads(jobs);
 #pragma omp parallel for schedule(dynamic)
@@ -284,6 +271,7 @@ int main(int argc, char *argv[])
 		}
 
 		std::set<struct voxel> free;
+		FreeSpaceCarver carver(voxel_occupied_by_slice, free, i, diff);
 		std::cerr << "shooting rays to " << reduced.size() << " points"
 			  << std::endl;
 		for (size_t j : reduced) {
@@ -300,13 +288,8 @@ int main(int argc, char *argv[])
 				p[2] = orig_points_by_slice[i][j][2] * factor;
 				transform3(std::get<2>(trajectory[i]), p);
 			}
-			struct visitor_args data = {};
-			data.empty_voxels = &free;
-			data.voxel_occupied_by_slice = &voxel_occupied_by_slice;
-			data.current_slice = i;
-			data.diff = diff;
 			walk_voxels(std::get<0>(trajectory[i]), p, voxel_size,
-				    visitor, &data);
+				    carver);
 		}
 #ifdef _OPENMP
 #pragma omp critical
@@ -441,15 +424,13 @@ int main(int argc, char *argv[])
 						    free_voxels.end()) {
 							continue;
 						}
-						if (voxel_occupied_by_slice
-							.find(neighbor) ==
-						    voxel_occupied_by_slice
-							.end()) {
+						if (!voxel_occupied_by_slice
+							 .contains(neighbor)) {
 							continue;
 						}
 						for (size_t num :
 						     voxel_occupied_by_slice
-							 [v]) {
+							 .find(v)) {
 							half_voxels[neighbor]
 							    .insert(num);
 						}
@@ -482,12 +463,13 @@ int main(int argc, char *argv[])
 		 * identifiers from a lower id to a higher id to a set
 		 */
 		std::map<std::pair<size_t, size_t>, size_t> result;
-		for (std::pair<struct voxel, std::set<size_t>> el : voxel_occupied_by_slice) {
+		for (const struct voxel &v : voxel_occupied_by_slice.voxels()) {
 			/*
-			 * the elements of std::set are sorted in ascending order, thus we
+			 * the slices of a voxel are sorted in ascending order, thus we
 			 * do not need to sort them ourselves
 			 */
-			std::vector<size_t> slices(el.second.begin(), el.second.end());
+			VoxelOccupancy::slices el = voxel_occupied_by_slice.find(v);
+			std::vector<size_t> slices(el.begin(), el.end());
 			for (size_t i = 0; i < slices.size(); ++i) {
 				for (size_t j = i+1; j < slices.size(); ++j) {
 					result[std::make_pair(slices[i], slices[j])] += 1;
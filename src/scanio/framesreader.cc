@@ -1,10 +1,62 @@
 #include "scanio/framesreader.h"
 #include "slam6d/scan.h"
+#include "slam6d/framesFile.h"
 #include "slam6d/globals.icc"
 
+#include <cstring>
+
+/**
+ * Read the pose of the given frame (the last one for -1) directly from a
+ * binary frames file. Returns false if the file is no binary frames file.
+ */
+static bool readBinaryFrame(const std::string &frameFileName, int frame, double *transMat)
+{
+  if (!FramesFile::isBinary(frameFileName)) return false;
+  FramesFile file(frameFileName);
+  if (file.size() == 0) return false;
+  size_t i = file.size() - 1;
+  if (frame != -1 && (size_t)frame < file.size()) i = frame;
+  Frame f;
+  file.get(i, f);
+  memcpy(transMat, f.transformation, sizeof(f.transformation));
+  return true;
+}
+
+/**
+ * Read the pose of the given frame (the last one for -1) of the binary or
+ * ASCII frames file frameFileName into transMat. Returns false if there is
+ * no such file.
+ */
+static bool readFramePose(const std::string &frameFileName, int frame, double *transMat)
+{
+  if (readBinaryFrame(frameFileName, frame, transMat)) {
+    std::cout << "Reading Frames for 3D Scan " << frameFileName << "..." << std::endl;
+    return true;
+  }
+
+  std::ifstream frame_in(frameFileName.c_str());
+  if (!frame_in.good()) return false;
+
+  std::cout << "Reading Frames for 3D Scan " << frameFileName << "..." << std::endl;
+
+  int algoTypeInt;
+
+  int frameCounter = 0;
+  while (frame_in.good()) {
+    if (frame != -1 && frameCounter > frame) break;
+    frameCounter++;
+    try {
+      frame_in >> transMat >> algoTypeInt;
+    }
+    catch (const std::exception &e) {
+      break;
+    }
+  }
+  return true;
+}
+
 void readFramesAndTransform(std::string dir, int start, int end, int frame, bool use_pose, bool reduced)
 {
-  std::ifstream frame_in;
   int  fileCounter = start;
   std::string frameFileName;
   if((int)(start + Scan::allScans.size() - 1) > end) end = start + Scan::allScans.size() - 1;
@@ -19,27 +71,10 @@ void readFramesAndTransform(std::string dir, int start, int end, int frame, bool
 
     if(!use_pose) {
 
-      frame_in.open(frameFileName.c_str());
+      double transMat[16];
 
       // read 3D scan
-      if (!frame_in.good()) break; // no more files in the directory
-
-      std::cout << "Reading Frames for 3D Scan " << frameFileName << "..." << std::endl;
-
-      double transMat[16];
-      int algoTypeInt;
-
-      int frameCounter = 0;
-      while (frame_in.good()) {
-        if (frame != -1 && frameCounter > frame) break;
-        frameCounter++;
-        try {
-          frame_in >> transMat >> algoTypeInt;
-        }
-        catch (const std::exception &e) {
-          break;
-        }
-      }
+      if (!readFramePose(frameFileName, frame, transMat)) break; // no more files in the directory
 
       // calculate RELATIVE transformation
       double tfin[16];
@@ -61,9 +96,32 @@ void readFramesAndTransform(std::string dir, int start, int end, int frame, bool
         Scan::allScans[fileCounter - start - 1]->transformAll(transMatOrig);
       }
     }
-    frame_in.close();
-    frame_in.clear();
   }
 }
 
 
+
+void readFrames(std::string dir, int start, int end, int frame, bool use_pose)
+{
+  // the scans already carry the pose from the .pose files
+  if (use_pose) return;
+
+  int  fileCounter = start;
+  std::string frameFileName;
+
+  if((int)(start + Scan::allScans.size() - 1) > end) end = start + Scan::allScans.size() - 1;
+  for (;;) {
+    if (end > -1 && fileCounter > end) break; // 'nuf read
+    frameFileName = dir + "scan" + to_string(fileCounter++,3) + ".frames";
+    Scan *scan = Scan::allScans[fileCounter - start - 1];
+
+    double transMat[16];
+    if (!readFramePose(frameFileName, frame, transMat)) break; // no more files in the directory
+
+    // calculate RELATIVE transformation
+    double tinv[16], tfin[16];
+    M4inv(scan->get_transMatOrg(), tinv);
+    MMult(transMat, tinv, tfin);
+    scan->transformMatrix(tfin);
+  }
+}
@@ -577,9 +577,11 @@ std::function<bool (std::istream &data_file)> open_uos_file(
 /* used by readASCII to read a single line
  *
  * splitting this function out of readASCII became necessary to facilitate the
- * check against the optional first line */
+ * check against the optional first line
+ *
+ * the point is appended unfiltered, readASCII filters blocks of points */
 bool handle_line(char *pos, std::streamsize linelen, unsigned int linenr, IODataType *currspec,
-ScanDataTransform& transform, PointFilter& filter, std::vector<double>* xyz, std::vector<unsigned
+ScanDataTransform& transform, std::vector<double>* xyz, std::vector<unsigned
         char>* rgb, std::vector<float>* refl, std::vector<float>* temp,
         std::vector<float>* ampl, std::vector<int>* type, std::vector<float>*
         devi, std::vector<double>* n)
@@ -659,8 +661,7 @@ ScanDataTransform& transform, PointFilter& filter, std::vector<double>* xyz, std
     //
     // FIXME: instead of using a different datastructure, another idea would
     //        be to use mmap-ed file(s) with the respective data inside
-    if (transform.transform(xyz_tmp, rgb_tmp, &refl_tmp, &temp_tmp, &ampl_tmp, &type_tmp, &devi_tmp, n_tmp)
-            && (xyz == 0 || filter.check(xyz_tmp)) ) {
+    if (transform.transform(xyz_tmp, rgb_tmp, &refl_tmp, &temp_tmp, &ampl_tmp, &type_tmp, &devi_tmp, n_tmp)) {
             if (xyz != 0)
                 for (int i = 0; i < 3; ++i) {
                     try {
@@ -732,7 +733,8 @@ bool readASCII(std::istream& infile, IODataType* spec, ScanDataTransform& transf
         PointFilter& filter, std::vector<double>* xyz, std::vector<unsigned
         char>* rgb, std::vector<float>* refl, std::vector<float>* temp,
         std::vector<float>* ampl, std::vector<int>* type, std::vector<float>*
-        devi, std::vector<double>* n, std::streamsize bufsize)
+        devi, std::vector<double>* n, std::streamsize bufsize,
+        size_t chunk_size, std::function<bool ()> chunk_done)
 {
     /*
      * there seems to be no sane and fast way to read a file with multiple
@@ -761,6 +763,29 @@ bool readASCII(std::istream& infile, IODataType* spec, ScanDataTransform& transf
     unsigned int linenr = 1;
     char *buffer = (char *)malloc(bufsize);
 
+    // the points are filtered in blocks with the batch check of the filter
+    // instead of one by one, unfiltered is the first point not checked yet
+    const size_t filter_block = 4096;
+    size_t unfiltered = xyz != 0 ? xyz->size() / 3 : 0;
+    std::vector<unsigned char> keep;
+    std::function<void ()> filter_pending = [&]() {
+        if (xyz == 0) return;
+        size_t nr = xyz->size() / 3 - unfiltered;
+        if (nr == 0) return;
+        keep.resize(nr);
+        if (filter.check(&(*xyz)[3 * unfiltered], nr, keep.data()) != nr) {
+            compact_channel(xyz, unfiltered, 3, keep.data(), nr);
+            compact_channel(rgb, unfiltered, 3, keep.data(), nr);
+            compact_channel(refl, unfiltered, 1, keep.data(), nr);
+            compact_channel(temp, unfiltered, 1, keep.data(), nr);
+            compact_channel(ampl, unfiltered, 1, keep.data(), nr);
+            compact_channel(type, unfiltered, 1, keep.data(), nr);
+            compact_channel(devi, unfiltered, 1, keep.data(), nr);
+            compact_channel(n, unfiltered, 3, keep.data(), nr);
+        }
+        unfiltered = xyz->size() / 3;
+    };
+
     // if garbage is found at the top of the file, then we are liberal and
     // just skip over it. We allow up to 10 lines of garbage at the file top
     // to abort early and not print potentially millions of read errors.
@@ -808,7 +833,7 @@ bool readASCII(std::istream& infile, IODataType* spec, ScanDataTransform& transf
             linelen--;
         }
 
-        if (!handle_line(buffer, linelen, linenr, spec, transform, filter, xyz, rgb, refl, temp, ampl, type, devi, n)) {
+        if (!handle_line(buffer, linelen, linenr, spec, transform, xyz, rgb, refl, temp, ampl, type, devi, n)) {
             std::cerr << "unable to parse line " << linenr << std::endl;
             // A line contained an error, so we decrement the header variable
             header -= 1;
@@ -821,15 +846,31 @@ bool readASCII(std::istream& infile, IODataType* spec, ScanDataTransform& transf
             // no more errors must follow.
             header = -1;
         }
+
+        if (xyz != 0 && xyz->size() >= 3 * (unfiltered + filter_block))
+            filter_pending();
+
+        // hand out full chunks to the caller when reading incrementally
+        if (chunk_size != 0 && chunk_done && xyz != 0 &&
+                xyz->size() >= 3 * chunk_size) {
+            filter_pending();
+            if (xyz->size() >= 3 * chunk_size) {
+                bool go_on = chunk_done();
+                unfiltered = xyz->size() / 3;
+                if (!go_on) break;
+            }
+        }
     }
 
     if (infile.bad() && !infile.eof()) {
         perror("error while reading file");
         goto fail;
     }
+    filter_pending();
     free(buffer);
     return true;
 fail:
+    filter_pending();
     free(buffer);
     return false;
 }
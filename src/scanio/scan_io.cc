@@ -14,6 +14,7 @@ using std::pair;
 using std::string;
 #include <stdexcept>
 using std::runtime_error;
+#include <algorithm>
 #include <iostream>
 using std::cout;
 using std::cerr;
@@ -217,6 +218,84 @@ void ScanIO::readScan(const char* dir_path, const char* identifier, PointFilter&
 }
 }
 
+template <typename T>
+static void copy_slice(const std::vector<T>& from, std::vector<T>& to,
+                       size_t nr_points, size_t begin, size_t end,
+                       size_t width)
+{
+  // channels that were not filled for every point are left out
+  if (from.size() != nr_points * width) return;
+  to.assign(from.begin() + begin * width, from.begin() + end * width);
+}
+
+void ScanIO::readScanChunked(const char* dir_path, const char* identifier, PointFilter& filter, size_t chunk_size, ScanChunkHandler handler)
+{
+  ScanChunk all;
+  readScan(dir_path, identifier, filter, &all.xyz, &all.rgb, &all.reflectance,
+           &all.temperature, &all.amplitude, &all.type, &all.deviation,
+           &all.normal);
+
+  size_t nr_points = all.size();
+  if (nr_points == 0) return;
+  if (chunk_size == 0 || nr_points <= chunk_size) {
+    handler(all);
+    return;
+  }
+
+  ScanChunk chunk;
+  for (size_t begin = 0; begin < nr_points; begin += chunk_size) {
+    size_t end = std::min(nr_points, begin + chunk_size);
+    chunk.clear();
+    copy_slice(all.xyz, chunk.xyz, nr_points, begin, end, 3);
+    copy_slice(all.rgb, chunk.rgb, nr_points, begin, end, 3);
+    copy_slice(all.reflectance, chunk.reflectance, nr_points, begin, end, 1);
+    copy_slice(all.temperature, chunk.temperature, nr_points, begin, end, 1);
+    copy_slice(all.amplitude, chunk.amplitude, nr_points, begin, end, 1);
+    copy_slice(all.type, chunk.type, nr_points, begin, end, 1);
+    copy_slice(all.deviation, chunk.deviation, nr_points, begin, end, 1);
+    copy_slice(all.normal, chunk.normal, nr_points, begin, end, 3);
+    if (!handler(chunk)) return;
+  }
+}
+
+void ScanIO_ascii::readScanChunked(const char* dir_path, const char* identifier, PointFilter& filter, size_t chunk_size, ScanChunkHandler handler)
+{
+  std::string subscan_id(identifier);
+  // merged multi scans need their relative poses, read them in one go
+  if (subscan_id.find_first_of(':') != std::string::npos) {
+    ScanIO::readScanChunked(dir_path, identifier, filter, chunk_size, handler);
+    return;
+  }
+
+  ScanChunk chunk;
+  std::vector<double>* xyz = supports(DATA_XYZ) ? &chunk.xyz : 0;
+  std::vector<unsigned char>* rgb = supports(DATA_RGB) ? &chunk.rgb : 0;
+  std::vector<float>* reflectance = supports(DATA_REFLECTANCE) ? &chunk.reflectance : 0;
+  std::vector<float>* temperature = supports(DATA_TEMPERATURE) ? &chunk.temperature : 0;
+  std::vector<float>* amplitude = supports(DATA_AMPLITUDE) ? &chunk.amplitude : 0;
+  std::vector<int>* type = supports(DATA_TYPE) ? &chunk.type : 0;
+  std::vector<float>* deviation = supports(DATA_DEVIATION) ? &chunk.deviation : 0;
+  std::vector<double>* normal = supports(DATA_NORMAL) ? &chunk.normal : 0;
+
+  bool stopped = false;
+  std::function<bool ()> chunk_done = [&]() -> bool {
+    stopped = !handler(chunk);
+    chunk.clear();
+    return !stopped;
+  };
+
+  path data_path(dir_path);
+  data_path /= path(std::string(dataPrefix()) + subscan_id + dataSuffix());
+  if (!open_path(data_path, [&](std::istream &data_file) -> bool {
+        return readASCII(data_file, getSpec(), getTransform(), filter, xyz,
+                         rgb, reflectance, temperature, amplitude, type,
+                         deviation, normal, 128, chunk_size, chunk_done);
+      }))
+    throw std::runtime_error(std::string("There is no scan file for [") + identifier + "] in [" + dir_path + "]");
+
+  if (!stopped && chunk.size() > 0) handler(chunk);
+}
+
 bool ScanIO::supports(IODataType type)
 {
   unsigned int supported = 0U;
@@ -70,17 +70,15 @@ bool ScanIO_laz::supports(IODataType type)
   return !!(type & (DATA_XYZ | DATA_REFLECTANCE | DATA_RGB));
 }
 
-void ScanIO_laz::readScan(const char* dir_path,
-			  const char* identifier,
-			  PointFilter& filter,
-			  std::vector<double>* xyz,
-			  std::vector<unsigned char>* rgb,
-			  std::vector<float>* reflectance,
-			  std::vector<float>* temperature,
-			  std::vector<float>* amplitude,
-			  std::vector<int>* type,
-        std::vector<float>* deviation,
-        std::vector<double>* normal)
+/**
+ * Opens the las/laz file of a scan. Options given in a scanXXX.options file
+ * are passed on to the LASreadOpener.
+ *
+ * @param has_options set to whether an options file was found
+ */
+static LASreader* open_las(const char* dir_path,
+			   const char* identifier,
+			   bool* has_options = 0)
 {
   // error handling
   path data_path(dir_path);
@@ -101,6 +99,7 @@ void ScanIO_laz::readScan(const char* dir_path,
   path options_path(dir_path);
   options_path /= path(std::string(DATA_PATH_PREFIX) + identifier + LAS_OPTIONS);
 
+  if (has_options != 0) *has_options = exists(options_path);
   if(exists(options_path)) {
 
     std::ifstream opt_in;
@@ -122,27 +121,45 @@ void ScanIO_laz::readScan(const char* dir_path,
   }
 
   LASreader* lasreader = lasreadopener.open();
+  if (lasreader == 0)
+    throw std::runtime_error(std::string("Could not open scan file ")
+			     + data_path.string());
+  return lasreader;
+}
 
-  while (lasreader->read_point()) {
+/**
+ * Reads points until max_points of them passed the filter, or until the end
+ * of the file if max_points is 0. Reflectance and color are only stored for
+ * points that passed the filter so that all channels stay aligned.
+ *
+ * @return false if the end of the file has been reached
+ */
+static bool read_las_points(LASreader* lasreader,
+			    PointFilter& filter,
+			    size_t max_points,
+			    std::vector<double>* xyz,
+			    std::vector<unsigned char>* rgb,
+			    std::vector<float>* reflectance)
+{
+  size_t accepted = 0;
+  while (max_points == 0 || accepted < max_points) {
+    if (!lasreader->read_point()) return false;
+
+    //las and laz are usually in pts coordiante system (x is left to right, y is bottom to up, z is front to back)
+    //otherwise use options (e.g. "-switch_y_z")
     double point[3] = { lasreader->point.get_x(),
 			lasreader->point.get_y(),
-			lasreader->point.get_z() };
-    double point_tmp[3];
+			-1 * lasreader->point.get_z() };
+
+    // apply filter
+    if (!filter.check(point)) continue;
+    ++accepted;
 
     if(xyz != 0) {
-      //las and laz are usually in pts coordiante system (x is left to right, y is bottom to up, z is front to back)
-      //otherwise use options (e.g. "-switch_y_z")
-      point_tmp[0] = point[0];
-      point_tmp[1] = point[1];
-      point_tmp[2] = -1 * point[2];
-
-      // apply filter
-      if (filter.check(point_tmp)) {
-	// push point
-	xyz->push_back(point_tmp[0]);
-	xyz->push_back(point_tmp[1]);
-	xyz->push_back(point_tmp[2]);
-      }
+      // push point
+      xyz->push_back(point[0]);
+      xyz->push_back(point[1]);
+      xyz->push_back(point[2]);
     }
     if (reflectance != 0) {
       /// if intensity doesn't exist, it's automatically set to 0.
@@ -160,9 +177,80 @@ void ScanIO_laz::readScan(const char* dir_path,
       }
     }
   }
+  return true;
+}
+
+void ScanIO_laz::readScan(const char* dir_path,
+			  const char* identifier,
+			  PointFilter& filter,
+			  std::vector<double>* xyz,
+			  std::vector<unsigned char>* rgb,
+			  std::vector<float>* reflectance,
+			  std::vector<float>* temperature,
+			  std::vector<float>* amplitude,
+			  std::vector<int>* type,
+        std::vector<float>* deviation,
+        std::vector<double>* normal)
+{
+  LASreader* lasreader = open_las(dir_path, identifier);
+
+  read_las_points(lasreader, filter, 0, xyz, rgb, reflectance);
+
+  lasreader->close();
+  delete lasreader;
+}
+
+void ScanIO_laz::readScanChunked(const char* dir_path,
+				 const char* identifier,
+				 PointFilter& filter,
+				 size_t chunk_size,
+				 ScanChunkHandler handler)
+{
+  LASreader* lasreader = open_las(dir_path, identifier);
+
+  ScanChunk chunk;
+  try {
+    bool more = true;
+    while (more) {
+      chunk.clear();
+      more = read_las_points(lasreader, filter, chunk_size,
+			     &chunk.xyz, &chunk.rgb, &chunk.reflectance);
+      if (chunk.size() > 0 && !handler(chunk)) break;
+    }
+  } catch (...) {
+    lasreader->close();
+    delete lasreader;
+    throw;
+  }
+
+  lasreader->close();
+  delete lasreader;
+}
+
+bool ScanIO_laz::readScanHeader(const char* dir_path,
+				const char* identifier,
+				ScanHeader& header)
+{
+  bool has_options;
+  LASreader* lasreader = open_las(dir_path, identifier, &has_options);
+
+  header.nr_points = lasreader->npoints;
+  // options like -switch_y_z or -scale modify the points after reading,
+  // so the stored bounding box only applies to plain files
+  header.has_bbox = !has_options;
+  if (header.has_bbox) {
+    // same conversion as for the points, z is mirrored
+    header.min[0] = lasreader->get_min_x();
+    header.min[1] = lasreader->get_min_y();
+    header.min[2] = -lasreader->get_max_z();
+    header.max[0] = lasreader->get_max_x();
+    header.max[1] = lasreader->get_max_y();
+    header.max[2] = -lasreader->get_min_z();
+  }
 
   lasreader->close();
   delete lasreader;
+  return true;
 }
 
 
@@ -28,6 +28,15 @@ using std::endl;
 #include <vector>
 #include <string.h>
 #include <map>
+#include <fstream>
+#include <sstream>
+
+#ifdef WITH_MMAP_SCAN
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 #ifdef _MSC_VER
 #include <windows.h>
@@ -75,6 +84,210 @@ int rgb_cb(p_ply_argument argument) {
 	return 1;
 }
 
+/**
+ * Layout of a vertex element in a binary little endian ply file where all
+ * properties are scalars, so that every vertex has the same size
+ */
+struct PlyFixedLayout {
+  size_t count;           ///< number of vertices
+  size_t stride;          ///< size of one vertex in bytes
+  size_t body;            ///< file offset of the first vertex
+  e_ply_type xyz_type[3];
+  size_t xyz_offset[3];
+  size_t rgb_offset[3];   ///< colors are always uchar
+};
+
+/**
+ * Maps a ply type name onto the rply type, PLY_LIST for unknown names
+ */
+static e_ply_type ply_type_from_name(const std::string& name)
+{
+  const char* names[] = { "int8", "uint8", "int16", "uint16",
+                          "int32", "uint32", "float32", "float64",
+                          "char", "uchar", "short", "ushort",
+                          "int", "uint", "float", "double" };
+  for (int i = 0; i < PLY_LIST; ++i)
+    if (name == names[i])
+      return (e_ply_type)i;
+  return PLY_LIST;
+}
+
+static size_t ply_type_size(e_ply_type type)
+{
+  switch (type) {
+    case PLY_INT8: case PLY_UINT8: case PLY_CHAR: case PLY_UCHAR:
+      return 1;
+    case PLY_INT16: case PLY_UINT16: case PLY_SHORT: case PLY_USHORT:
+      return 2;
+    case PLY_INT32: case PLY_UIN32: case PLY_INT: case PLY_UINT:
+    case PLY_FLOAT32: case PLY_FLOAT:
+      return 4;
+    case PLY_FLOAT64: case PLY_DOUBLE:
+      return 8;
+    default:
+      return 0;
+  }
+}
+
+template <typename T>
+static inline double ply_load(const unsigned char* p)
+{
+  T value;
+  memcpy(&value, p, sizeof(T));
+  return value;
+}
+
+static inline double ply_scalar(e_ply_type type, const unsigned char* p)
+{
+  switch (type) {
+    case PLY_FLOAT32: case PLY_FLOAT: return ply_load<float>(p);
+    case PLY_FLOAT64: case PLY_DOUBLE: return ply_load<double>(p);
+    case PLY_INT8: case PLY_CHAR: return ply_load<int8_t>(p);
+    case PLY_UINT8: case PLY_UCHAR: return ply_load<uint8_t>(p);
+    case PLY_INT16: case PLY_SHORT: return ply_load<int16_t>(p);
+    case PLY_UINT16: case PLY_USHORT: return ply_load<uint16_t>(p);
+    case PLY_INT32: case PLY_INT: return ply_load<int32_t>(p);
+    default: return ply_load<uint32_t>(p);
+  }
+}
+
+/**
+ * Parses the ply header and checks whether the file can be read without
+ * rply. This is the case for a binary little endian file (on a little
+ * endian host) whose only element is the vertex element with scalar
+ * properties x, y, z and uchar colors. Everything else, including all
+ * malformed files, is left to rply and its error handling.
+ */
+static bool ply_fixed_layout(const path& data_path, PlyFixedLayout& layout)
+{
+  const uint16_t one = 1;
+  if (*(const unsigned char*)&one != 1)
+    return false;
+
+  std::ifstream file(data_path.string().c_str(), std::ios::binary);
+  std::string line;
+  if (!std::getline(file, line) || line.compare(0, 3, "ply") != 0)
+    return false;
+
+  bool binary_le = false;
+  int nr_elements = 0;
+  std::map<std::string, std::pair<e_ply_type, size_t> > properties;
+  layout.stride = 0;
+  layout.count = 0;
+  while (std::getline(file, line)) {
+    if (!line.empty() && line[line.size()-1] == '\r')
+      line.erase(line.size()-1);
+    std::istringstream iss(line);
+    std::string keyword;
+    iss >> keyword;
+    if (keyword == "format") {
+      std::string format;
+      iss >> format;
+      binary_le = (format == "binary_little_endian");
+    } else if (keyword == "element") {
+      std::string name;
+      iss >> name >> layout.count;
+      if (++nr_elements > 1 || name != "vertex")
+        return false;
+    } else if (keyword == "property") {
+      std::string type_name, name;
+      iss >> type_name >> name;
+      e_ply_type type = ply_type_from_name(type_name);
+      size_t size = ply_type_size(type);
+      // list properties make the vertex size variable
+      if (size == 0)
+        return false;
+      properties[name] = std::make_pair(type, layout.stride);
+      layout.stride += size;
+    } else if (keyword == "end_header") {
+      break;
+    }
+  }
+  if (!file.good() || !binary_le || nr_elements != 1 || layout.stride == 0)
+    return false;
+  layout.body = file.tellg();
+
+  const char* xyz_names[3] = { "x", "y", "z" };
+  for (int i = 0; i < 3; ++i) {
+    if (properties.find(xyz_names[i]) == properties.end())
+      return false;
+    layout.xyz_type[i] = properties[xyz_names[i]].first;
+    layout.xyz_offset[i] = properties[xyz_names[i]].second;
+  }
+
+  // same color lookup as in the rply code path
+  const char* rgb_names[2][3] = { { "red", "green", "blue" },
+                                  { "diffuse_red", "diffuse_green", "diffuse_blue" } };
+  for (int c = 0; c < 2; ++c) {
+    bool found = true;
+    for (int i = 0; i < 3; ++i)
+      found = found && properties.find(rgb_names[c][i]) != properties.end();
+    if (!found)
+      continue;
+    for (int i = 0; i < 3; ++i) {
+      if (properties[rgb_names[c][i]].first != PLY_UCHAR)
+        return false;
+      layout.rgb_offset[i] = properties[rgb_names[c][i]].second;
+    }
+    return file_size(data_path) >= layout.body + layout.count * layout.stride;
+  }
+  return false;
+}
+
+/**
+ * Converts all vertices of a fixed layout binary ply file in one go
+ */
+static void ply_read_fixed(const path& data_path, const PlyFixedLayout& layout,
+                           std::vector<double>* xyz,
+                           std::vector<unsigned char>* rgb)
+{
+  size_t size = layout.body + layout.count * layout.stride;
+  const unsigned char* data;
+#ifdef WITH_MMAP_SCAN
+  int fd = open(data_path.string().c_str(), O_RDONLY);
+  if (fd == -1)
+    throw std::runtime_error("cannot open " + data_path.string());
+  void* map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED)
+    throw std::runtime_error("cannot mmap " + data_path.string());
+  madvise(map, size, MADV_SEQUENTIAL);
+  data = (const unsigned char*)map;
+#else
+  std::vector<unsigned char> buffer(size);
+  std::ifstream file(data_path.string().c_str(), std::ios::binary);
+  file.read((char*)buffer.data(), size);
+  data = buffer.data();
+#endif
+
+  const unsigned char* vertices = data + layout.body;
+  size_t xyz_start = 0, rgb_start = 0;
+  if (xyz != 0) {
+    xyz_start = xyz->size();
+    xyz->resize(xyz_start + 3 * layout.count);
+  }
+  if (rgb != 0) {
+    rgb_start = rgb->size();
+    rgb->resize(rgb_start + 3 * layout.count);
+  }
+
+  // every vertex is independent, convert them in parallel chunks
+#pragma omp parallel for schedule(static)
+  for (long i = 0; i < (long)layout.count; ++i) {
+    const unsigned char* v = vertices + i * layout.stride;
+    for (int j = 0; j < 3; ++j) {
+      if (xyz != 0)
+        (*xyz)[xyz_start + 3*i + j] = ply_scalar(layout.xyz_type[j], v + layout.xyz_offset[j]);
+      if (rgb != 0)
+        (*rgb)[rgb_start + 3*i + j] = v[layout.rgb_offset[j]];
+    }
+  }
+
+#ifdef WITH_MMAP_SCAN
+  munmap(map, size);
+#endif
+}
+
 void ScanIO_ply::readScan(const char* dir_path,
 					 const char* identifier,
 					 PointFilter& filter,
@@ -95,6 +308,14 @@ void ScanIO_ply::readScan(const char* dir_path,
     throw std::runtime_error(std::string("There is no scan file for [")
 					    + identifier + "] in [" + dir_path + "]");
 
+  // fast path for fixed size binary vertices, bypassing the per value
+  // callbacks of rply
+  PlyFixedLayout layout;
+  if (ply_fixed_layout(data_path, layout)) {
+    ply_read_fixed(data_path, layout, xyz, rgb);
+    return;
+  }
+
   p_ply ply = ply_open(data_path.string().c_str(), NULL, 0, NULL);
   if (!ply) {
 	  throw std::runtime_error("ply_open failed");
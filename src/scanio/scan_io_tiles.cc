@@ -0,0 +1,180 @@
+/*
+ * scan_io_tiles implementation
+ *
+ * Released under the GPL version 3.
+ *
+ */
+
+/**
+ * @file
+ * @brief IO of the levels of detail of a tile tree as scans
+ */
+
+#include "scanio/scan_io_tiles.h"
+#include "scanio/tile_tree.h"
+
+#include <fstream>
+#include <stdexcept>
+#include <cstdlib>
+#include <algorithm>
+
+#include <boost/filesystem/operations.hpp>
+using namespace boost::filesystem;
+
+#include "slam6d/globals.icc"
+
+#define REGION_SUFFIX ".region"
+
+/**
+ * Reads the box of scanNNN.region if it exists.
+ *
+ * @return false if the whole tree is to be read
+ */
+static bool read_region(const char* dir_path, const char* identifier,
+                        double* min, double* max)
+{
+  path region_path(dir_path);
+  region_path /= path(std::string("scan") + identifier + REGION_SUFFIX);
+  if (!exists(region_path)) return false;
+
+  std::ifstream in(region_path.string().c_str());
+  in >> min[0] >> min[1] >> min[2] >> max[0] >> max[1] >> max[2];
+  if (in.fail())
+    throw std::runtime_error("Could not read region " + region_path.string());
+  return true;
+}
+
+std::list<std::string> ScanIO_tiles::readDirectory(const char* dir_path,
+                                                   unsigned int start,
+                                                   unsigned int end)
+{
+  std::list<std::string> identifiers;
+  if (!exists(path(dir_path) / TileTree::index_name)) {
+    std::cerr << "No tile tree found in " << dir_path << "!" << std::endl;
+    return identifiers;
+  }
+  TileTree tree(dir_path);
+  unsigned int depth = tree.getDepth();
+  for (unsigned int i = start; i <= std::min(end, depth); i++) {
+    identifiers.push_back(to_string(i, 3));
+  }
+  return identifiers;
+}
+
+std::list<std::string> ScanIO_tiles::readDirectory(dataset_settings& dss)
+{
+  return readDirectory(dss.data_source.c_str(), dss.scan_numbers.min,
+                       dss.scan_numbers.max);
+}
+
+void ScanIO_tiles::readPose(const char* dir_path,
+                            const char* identifier,
+                            double* pose)
+{
+  for (unsigned int i = 0; i < 6; ++i) pose[i] = 0.0;
+}
+
+time_t ScanIO_tiles::lastModified(const char* dir_path, const char* identifier)
+{
+  return last_write_time(path(dir_path) / TileTree::index_name);
+}
+
+bool ScanIO_tiles::supports(IODataType type)
+{
+  return !!(type & (DATA_XYZ | DATA_REFLECTANCE | DATA_RGB));
+}
+
+void ScanIO_tiles::readScan(const char* dir_path,
+                            const char* identifier,
+                            PointFilter& filter,
+                            std::vector<double>* xyz,
+                            std::vector<unsigned char>* rgb,
+                            std::vector<float>* reflectance,
+                            std::vector<float>* temperature,
+                            std::vector<float>* amplitude,
+                            std::vector<int>* type,
+                            std::vector<float>* deviation,
+                            std::vector<double>* normal)
+{
+  readScanChunked(dir_path, identifier, filter, 1 << 20,
+                  [&](ScanChunk& chunk) -> bool {
+    if (xyz != 0) xyz->insert(xyz->end(), chunk.xyz.begin(), chunk.xyz.end());
+    if (rgb != 0) rgb->insert(rgb->end(), chunk.rgb.begin(), chunk.rgb.end());
+    if (reflectance != 0)
+      reflectance->insert(reflectance->end(), chunk.reflectance.begin(),
+                          chunk.reflectance.end());
+    return true;
+  });
+}
+
+void ScanIO_tiles::readScanChunked(const char* dir_path,
+                                   const char* identifier,
+                                   PointFilter& filter,
+                                   size_t chunk_size,
+                                   ScanChunkHandler handler)
+{
+  TileTree tree(dir_path);
+  double min[3], max[3];
+  bool has_region = read_region(dir_path, identifier, min, max);
+  tree.read(atoi(identifier), has_region ? min : 0, has_region ? max : 0,
+            chunk_size, [&](ScanChunk& chunk) -> bool {
+    chunk.filter(filter);
+    return chunk.size() == 0 || handler(chunk);
+  });
+}
+
+bool ScanIO_tiles::readScanHeader(const char* dir_path,
+                                  const char* identifier,
+                                  ScanHeader& header)
+{
+  TileTree tree(dir_path);
+  header.nr_points = tree.countPoints(atoi(identifier));
+  header.has_bbox = true;
+  tree.getBounds(header.min, header.max);
+
+  double min[3], max[3];
+  if (read_region(dir_path, identifier, min, max)) {
+    for (int k = 0; k < 3; k++) {
+      header.min[k] = std::max(header.min[k], min[k]);
+      header.max[k] = std::min(header.max[k], max[k]);
+    }
+  }
+  return true;
+}
+
+
+/**
+ * class factory for object construction
+ *
+ * @return Pointer to new object
+ */
+#ifdef _MSC_VER
+extern "C" __declspec(dllexport) ScanIO* create()
+#else
+extern "C" ScanIO* create()
+#endif
+{
+  return new ScanIO_tiles;
+}
+
+
+/**
+ * class factory for object construction
+ *
+ * @return Pointer to new object
+ */
+#ifdef _MSC_VER
+extern "C" __declspec(dllexport) void destroy(ScanIO *sio)
+#else
+extern "C" void destroy(ScanIO *sio)
+#endif
+{
+  delete sio;
+}
+
+#ifdef _MSC_VER
+BOOL APIENTRY DllMain(HANDLE hModule, DWORD dwReason, LPVOID lpReserved)
+{
+    return TRUE;
+}
+#endif
@@ -34,6 +34,13 @@ using std::swap;
 #include<cmath>
 #include<cstring>
 #include <errno.h>
+#include <stdint.h>
+
+#ifdef WITH_MMAP_SCAN
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 using namespace std;
 
@@ -53,6 +60,9 @@ const char* ScanIO_velodyne::data_suffix = ".bin";
 #define VELODYNE_NUM_LASERS 64
 #define CircleBufferSize CIRCLELENGTH*32*12
 #define CIRCLEROUND CIRCLELENGTH*6
+#define PACKET_STRIDE (BLOCK_SIZE+BLOCK_OFFSET)
+#define POINTS_PER_PACKET (12*32)
+#define PCAP_HEADER_SIZE 24
 
 #define RADIANS_PER_LSB 0.0174532925
 #define METERS_PER_LSB 0.002
@@ -169,6 +179,12 @@ double vertoffsetCorrection[VELODYNE_NUM_LASERS];
 double horizdffsetCorrection[VELODYNE_NUM_LASERS];
 double enabled[VELODYNE_NUM_LASERS];	//New variable to change enabling and disabling of data.
 
+// sin and cos of the angular corrections of each laser
+static double sin_vert[VELODYNE_NUM_LASERS], cos_vert[VELODYNE_NUM_LASERS];
+static double sin_rot[VELODYNE_NUM_LASERS], cos_rot[VELODYNE_NUM_LASERS];
+// sin and cos of the mirrored azimuth for each raw azimuth value of a block
+static double sin_azimuth[65536], cos_azimuth[65536];
+
 int physical2logical[VELODYNE_NUM_LASERS];
 int logical2physical[VELODYNE_NUM_LASERS];
 
@@ -247,6 +263,22 @@ int velodyne_calib_precompute()
         vertoffsetCorrection[i] = velodyne_calibrated[i][3] * METERS_PER_CM;
         horizdffsetCorrection[i] = velodyne_calibrated[i][4] * METERS_PER_CM;
 	enabled[i] = velodyne_calibrated[i][5];
+
+        sin_vert[i] = sin ( vertCorrection[i] );
+        cos_vert[i] = cos ( vertCorrection[i] );
+        sin_rot[i] = sin ( rotCorrection[i] );
+        cos_rot[i] = cos ( rotCorrection[i] );
+    }
+
+    // the azimuth is stored in 1/100 degrees, tabulate every possible value
+    for ( i = 0; i < 65536; i++ )
+    {
+        float rotational = ( ( float ) i ) / 100.0;
+        double ctheta = 2 * M_PI - rotational * RADIANS_PER_LSB;
+        if ( ctheta == 2*M_PI )
+            ctheta = 0;
+        sin_azimuth[i] = sin ( ctheta );
+        cos_azimuth[i] = cos ( ctheta );
     }
 
     return 0;
@@ -314,155 +346,104 @@ int calibrate(string filename)
 }
 
 
-int read_one_packet (
-    FILE *fp,
-    PointFilter& filter,
-    std::vector<double>* xyz,
-    std::vector<unsigned char>* rgb,
-    std::vector<float>* reflectance,
-    std::vector<float>* amplitude,
-    std::vector<int>* type,
-    std::vector<float>* deviation)
+static inline unsigned short read_ushort(const BYTE *p)
 {
+    unsigned short v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
 
-	int  c, i, j;
-    unsigned char Head;
-    BYTE buf[BLOCK_SIZE];
-    Point point;
-    BYTE *p;
-    unsigned short *ps;
-    unsigned short *pt;
-    unsigned short *pshort;
-
-    double ctheta;
-    double theta, phi;
-
-    double sin_ctheta, cos_ctheta;
-    double sin_theta, cos_theta;
-    double sin_phi, cos_phi;
-
-    unsigned short physicalNO;
-    unsigned short logicalNO;
-
-    float rotational;
-    float distance;
-    float corredistance;
-    int intensity;
-    int size;
-
-    unsigned short rot;
-    double x, y, z;
+/**
+ * Decodes the 12 blocks of 32 lasers of one packet into pts and flags the
+ * points of enabled lasers within the valid distance range in keep.
+ * Returns the number of blocks up to the first one with a broken header.
+ */
+static int decode_packet(const BYTE *buf, double *pts, unsigned char *keep)
+{
+    for ( int i = 0; i < 12; i++ )
+    {
+        const BYTE *p = buf + i * 100;
+
+        //Each frame start with 0xEEFF || 0xDDFF
+        int Head;
+        unsigned short header = read_ushort(p);
+        if ( header == 0xEEFF )
+            Head = 0;
+        else if ( header == 0xDDFF )
+            Head = 32;
+        else
+            return i;
+
+        unsigned short azimuth = read_ushort(p + 2);
+        double sin_ctheta = sin_azimuth[azimuth];
+        double cos_ctheta = cos_azimuth[azimuth];
+
+        double *out = pts + i * 32 * 3;
+        unsigned char *flags = keep + i * 32;
+
+        // no trigonometry and no branches, every laser is decoded
+        for ( int j = 0; j < 32; j++ )
+        {
+            int n = j + Head;
+            float distance = absf ( read_ushort(p + 4 + j * 3) * 0.002 );
+            float corredistance = ( distance + distCorrection[n] );
+
+            // theta = ctheta + rotCorrection by the angle sum identities
+            double sin_theta = sin_ctheta * cos_rot[n] + cos_ctheta * sin_rot[n];
+            double cos_theta = cos_ctheta * cos_rot[n] - sin_ctheta * sin_rot[n];
+
+            double x = corredistance * cos_theta * cos_vert[n];
+            double y = corredistance * sin_theta * cos_vert[n];
+            double z = corredistance * sin_vert[n] + vertoffsetCorrection[n] * cos_vert[n];
+
+            x -= horizdffsetCorrection[n] * cos_ctheta;
+            y -= horizdffsetCorrection[n] * sin_ctheta;
+
+            out[3*j] = x * 100;
+            out[3*j + 1] = z * 100;
+            out[3*j + 2] = -y * 100;
+            flags[j] = distance < 120 && distance > 2.2 && enabled[n] == 1;
+        }
+    }
+    return 12;
+}
 
-    int circle_col = 0;
-    int circle_row = 0;
+/**
+ * Decodes the given number of consecutive packets of one frame, each
+ * preceded by the pcap and UDP headers. The packets are independent and
+ * decoded in parallel, the points are appended in packet order up to the
+ * first broken block like a sequential read would.
+ */
+static void decode_frame(const BYTE *data, size_t packets, PointFilter& filter,
+                         std::vector<double>* xyz)
+{
+    std::vector<double> pts(packets * POINTS_PER_PACKET * 3);
+    std::vector<unsigned char> keep(packets * POINTS_PER_PACKET);
+    std::vector<int> blocks(packets);
 
-	for ( c = 0 ; c < CIRCLELENGTH; c++ )
-	{
-#ifdef _MSC_VER
-		fseek(fp , BLOCK_OFFSET, SEEK_CUR);
-#else
-#ifdef __CYGWIN__
-		fseek(fp , BLOCK_OFFSET, SEEK_CUR);
-#else
-		fseeko(fp , BLOCK_OFFSET, SEEK_CUR);
-#endif
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
 #endif
-		size=fread ( buf, 1, BLOCK_SIZE, fp );
-
-		if(size<BLOCK_SIZE)
-			return -1;
-
-		ps = ( unsigned short * ) buf;
-		p = buf;
-		physicalNO = 0;
-
-		for ( i = 0; i < 12; i++ )
-		{
-			//Each frame start with 0xEEFF || 0xDDFF
-			if ( *ps == 0xEEFF )
-				Head = 0;
-			else if ( *ps == 0xDDFF )
-				Head = 32;
-			else
-				return -1;
-
-			pshort = ( unsigned short * ) ( p + 2 );
-			rot = ( ( unsigned short ) ( *pshort ) / 100.0 );
-
-			circle_col =  c * 6 + i / 2;
-			rotational = ( ( float ) ( *pshort ) ) / 100.0;
+    for ( long c = 0; c < (long)packets; c++ )
+    {
+        blocks[c] = decode_packet(data + c * PACKET_STRIDE + BLOCK_OFFSET,
+                                  &pts[c * POINTS_PER_PACKET * 3],
+                                  &keep[c * POINTS_PER_PACKET]);
+    }
 
-			for ( j = 0; j < 32; j++ )
-			{
-				physicalNO  = j + Head;
-				logicalNO = velodyne_physical_to_logical ( physicalNO );
-
-				circle_col =  c * 6 + i / 2;
-				circle_row =  logicalNO;
-
-				pt = ( unsigned short * ) ( p + 4 + j * 3 );
-				distance = absf ( ( *pt ) * 0.002 );
-
-				if( distance < 120   &&	   distance > 2.2 )
-				{
-					BYTE *inty = ( BYTE * ) ( p + 4 + j * 3 + 2 );
-					intensity = *inty;
-
-					ctheta = 2 * M_PI - rotational * RADIANS_PER_LSB;
-					if ( ctheta == 2*M_PI )
-						ctheta = 0;
-
-					sin_ctheta = sin ( ctheta );
-					cos_ctheta = cos ( ctheta );
-
-					//vertCorrection  rotCorrection  distCorrection  vertOffsetCorrection  horizOffsetCorrection
-					//                corredistance = ( distance + distCorrection[physicalNO] ) * ( 1.0 + vertoffsetCorrection[physicalNO] );
-					corredistance = ( distance + distCorrection[physicalNO] ) ;
-					theta     = mod2pi_ref ( M_PI, ctheta + rotCorrection[physicalNO] ); /////////????////////
-					phi    = vertCorrection[physicalNO];  ////////?????/////////////////
-
-					sin_theta = sin ( theta );
-					cos_theta = cos ( theta );
-					sin_phi = sin ( phi );
-					cos_phi = cos ( phi );
-
-					/////////////////////?a???/////////////////////
-					x = corredistance * cos_theta * cos_phi;
-					y = corredistance * sin_theta * cos_phi;
-					z = corredistance * sin_phi +vertoffsetCorrection[physicalNO]*cos_phi;
-
-					x -= horizdffsetCorrection[physicalNO] * cos_ctheta;
-					y -= horizdffsetCorrection[physicalNO] * sin_ctheta;
-
-					point.rad  = sqrt(  x*x 	+  y*y );
-					point.tan_theta  = y/x;
-
-					point.type = POINT_TYPE_GROUND;
-					point.x=x*100;
-					point.y=z*100;
-					point.z=-y*100;
-
-				        double p[3];
-				        p[0] = point.x;
-				        p[1] = point.y;
-				        p[2] = point.z;
-
-					//Enable Check. Could be moved earlier to remove all the unnecessary calculations.
-					//Here to simplify the implementation
-			                if(filter.check(p) && (enabled[physicalNO]==1))
-   					{
-						 for(int ii = 0; ii < 3; ++ii) xyz->push_back(p[ii]);
-					}
-				}
-			}
-            p = p + 100;
-            ps = ( unsigned short * ) p;
+    // the filter is not thread safe, apply it in order
+    for ( size_t c = 0; c < packets; c++ )
+    {
+        size_t first = c * POINTS_PER_PACKET;
+        size_t last = first + blocks[c] * 32;
+        for ( size_t k = first; k < last; k++ )
+        {
+            if ( keep[k] && filter.check(&pts[3*k]) )
+                xyz->insert(xyz->end(), &pts[3*k], &pts[3*k] + 3);
         }
-
-
+        if ( blocks[c] < 12 )
+            break;
     }
-
-    return 0;
 }
 
 std::list<std::string> ScanIO_velodyne::readDirectory(const char* dir_path, unsigned int start, unsigned int end)
@@ -517,34 +498,11 @@ void ScanIO_velodyne::readScan(
     std::vector<float>* deviation,
     std::vector<double>* normal)
 {
-    FILE *scan_in;
-
     path data_path(dir_path);
     data_path /= path(std::string(dataPrefix()) + dataSuffix());
     if(!exists(data_path))
         throw std::runtime_error(std::string("There is no scan file for [") + identifier + "] in [" + dir_path + "]");
 
-	char filename[256];
-	sprintf(filename, "%s%s%s",dir_path , dataPrefix(), dataSuffix());
-
-#ifdef _MSC_VER
-    scan_in = fopen(filename,"rb");
-#else
-#ifdef __CYGWIN__
-    scan_in = fopen(filename,"rb");
-#else
-    scan_in = fopen64(filename,"rb");
-#endif
-#endif
-
-    if(scan_in == NULL)
-    {
-      cerr<<data_path <<endl;
-      cerr << "ERROR: Missing file " << data_path <<" "<<strerror(errno)<< endl;
-      exit(1);
-      return;
-    }
-
     cout << "Processing Scan " << data_path;
     cout.flush();
 
@@ -552,34 +510,43 @@ void ScanIO_velodyne::readScan(
 
 	fileCounter=  atoi(identifier);
 
-#ifdef _MSC_VER
-    fseek(scan_in, 24, SEEK_SET);
-    fseek(scan_in, (BLOCK_SIZE+BLOCK_OFFSET)*CIRCLELENGTH*fileCounter, SEEK_CUR);
-#else
-#ifdef __CYGWIN__
-    fseek(scan_in, 24, SEEK_SET);
-    fseek(scan_in, (BLOCK_SIZE+BLOCK_OFFSET)*CIRCLELENGTH*fileCounter, SEEK_CUR);
+    // all frames have the same size and follow the pcap header back to back,
+    // a truncated last frame yields only its complete packets
+    uint64_t frame_start = PCAP_HEADER_SIZE + (uint64_t)PACKET_STRIDE * CIRCLELENGTH * fileCounter;
+    uint64_t length = file_size(data_path);
+    size_t packets = 0;
+    if ( length > frame_start )
+        packets = std::min<uint64_t>(( length - frame_start ) / PACKET_STRIDE, CIRCLELENGTH);
+
+    if ( packets > 0 )
+    {
+#ifdef WITH_MMAP_SCAN
+        int fd = open(data_path.string().c_str(), O_RDONLY);
+        if (fd == -1)
+            throw std::runtime_error("cannot open " + data_path.string());
+        // map only the frame, starting at the page boundary before it
+        uint64_t map_start = frame_start - frame_start % sysconf(_SC_PAGESIZE);
+        size_t map_size = frame_start - map_start + packets * PACKET_STRIDE;
+        void* map = mmap(NULL, map_size, PROT_READ, MAP_PRIVATE, fd, (off_t)map_start);
+        close(fd);
+        if (map == MAP_FAILED)
+            throw std::runtime_error("cannot mmap " + data_path.string());
+        madvise(map, map_size, MADV_WILLNEED);
+        decode_frame((const BYTE*)map + (frame_start - map_start), packets, filter, xyz);
+        munmap(map, map_size);
 #else
-    fseeko(scan_in, 24, SEEK_SET);
-    fseeko(scan_in, (BLOCK_SIZE+BLOCK_OFFSET)*CIRCLELENGTH*fileCounter, SEEK_CUR);
+        std::vector<BYTE> buffer(packets * PACKET_STRIDE);
+        std::ifstream file(data_path.string().c_str(), std::ios::binary);
+        file.seekg(frame_start);
+        file.read((char*)buffer.data(), buffer.size());
+        if ((size_t)file.gcount() != buffer.size())
+            throw std::runtime_error("cannot read frame " + std::to_string(fileCounter) + " of " + data_path.string());
+        decode_frame(buffer.data(), packets, filter, xyz);
 #endif
-#endif
-
-    read_one_packet(
-                scan_in,
-                filter,
-                xyz,
-                rgb,
-                reflectance,
-                amplitude,
-                type,
-                deviation);
+    }
 
     cout << " with " << xyz->size() << " Points";
     cout << " done " << fileCounter<<endl;
-
-    fclose(scan_in);
-    // process next frames
 }
 
 /**
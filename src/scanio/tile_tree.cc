@@ -0,0 +1,667 @@
+/*
+ * tile_tree implementation
+ *
+ * Released under the GPL version 3.
+ *
+ */
+
+/**
+ * @file
+ * @brief Out-of-core multi-resolution tiling of registered point clouds
+ */
+
+#include "scanio/tile_tree.h"
+
+#include <stdexcept>
+#include <fstream>
+#include <iomanip>
+#include <algorithm>
+#include <unordered_map>
+#include <cstdio>
+#include <cmath>
+#include <cfloat>
+
+#include <boost/filesystem/operations.hpp>
+namespace fs = boost::filesystem;
+
+const char* TileTree::index_name = "tiles.idx";
+
+//! cells per axis of the grid a tile is subsampled with
+static const int64_t tile_grid = 128;
+
+//! largest level of the grid the points are counted in
+static const int max_grid_level = 7;
+
+static const char* index_magic = "3DTK_TILES";
+static const int index_version = 1;
+
+void TileTree::readTile(const std::string& path, std::vector<TilePoint>& pts)
+{
+  pts.clear();
+  FILE* f = fopen(path.c_str(), "rb");
+  if (f == 0) throw std::runtime_error("Could not open tile " + path);
+  fseek(f, 0, SEEK_END);
+  long bytes = ftell(f);
+  fseek(f, 0, SEEK_SET);
+  pts.resize(bytes / sizeof(TilePoint));
+  size_t n = pts.empty() ? 0 : fread(pts.data(), sizeof(TilePoint), pts.size(), f);
+  fclose(f);
+  if (n != pts.size()) throw std::runtime_error("Could not read tile " + path);
+}
+
+void TileTree::writeTile(const std::string& path,
+                         const std::vector<TilePoint>& pts)
+{
+  FILE* f = fopen(path.c_str(), "wb");
+  if (f == 0) throw std::runtime_error("Could not write tile " + path);
+  size_t n = pts.empty() ? 0 : fwrite(pts.data(), sizeof(TilePoint), pts.size(), f);
+  fclose(f);
+  if (n != pts.size()) throw std::runtime_error("Could not write tile " + path);
+}
+
+/**
+ * Marks one point per cell of a grid of tile_grid^3 cells over the cube of
+ * edge length size at origin, the one closest to the center of the cell.
+ * Ties keep the earlier point, so the result only depends on the order of
+ * the points.
+ */
+static void sample(const std::vector<TilePoint>& pts, const int64_t* origin,
+                   int64_t size, std::vector<char>& keep)
+{
+  int64_t cell = std::max<int64_t>(size / tile_grid, 1);
+  int64_t cells = size / cell;
+  // cell -> (point, doubled squared distance to the center)
+  std::unordered_map<uint64_t, std::pair<size_t, int64_t> > best;
+  best.reserve(pts.size());
+  for (size_t i = 0; i < pts.size(); i++) {
+    const int32_t* p = &pts[i].x;
+    int64_t c[3], d2 = 0;
+    for (int k = 0; k < 3; k++) {
+      int64_t rel = p[k] - origin[k];
+      c[k] = rel / cell;
+      int64_t d = 2 * (rel - c[k] * cell) - (cell - 1);
+      d2 += d * d;
+    }
+    uint64_t key = ((uint64_t)c[0] * cells + c[1]) * cells + c[2];
+    std::pair<std::unordered_map<uint64_t, std::pair<size_t, int64_t> >::iterator,
+              bool> ins = best.insert(std::make_pair(key, std::make_pair(i, d2)));
+    if (!ins.second && d2 < ins.first->second.second) {
+      ins.first->second = std::make_pair(i, d2);
+    }
+  }
+  keep.assign(pts.size(), 0);
+  for (std::unordered_map<uint64_t, std::pair<size_t, int64_t> >::const_iterator
+         it = best.begin(); it != best.end(); ++it) {
+    keep[it->second.first] = 1;
+  }
+}
+
+static int octantOf(const TilePoint& p, const int64_t* origin, int64_t half)
+{
+  return (p.x - origin[0] >= half ? 4 : 0) | (p.y - origin[1] >= half ? 2 : 0)
+    | (p.z - origin[2] >= half ? 1 : 0);
+}
+
+TileTree::TileTree(const std::string& dir)
+  : dir(dir), depth(0)
+{
+  fs::path index_path = fs::path(dir) / index_name;
+  std::ifstream in(index_path.string().c_str());
+  if (!in.good())
+    throw std::runtime_error("Could not open tile index " + index_path.string());
+
+  std::string magic, key;
+  int version;
+  size_t nr_nodes;
+  in >> magic >> version;
+  if (magic != index_magic || version != index_version)
+    throw std::runtime_error("Unknown tile index format in " + index_path.string());
+  in >> key >> scale
+     >> key >> origin[0] >> origin[1] >> origin[2]
+     >> key >> size
+     >> key >> bounds_min[0] >> bounds_min[1] >> bounds_min[2]
+            >> bounds_max[0] >> bounds_max[1] >> bounds_max[2]
+     >> key >> nr_nodes;
+  for (size_t i = 0; i < nr_nodes && in.good(); i++) {
+    TileNode node;
+    in >> node.name >> node.level >> node.nr_points;
+    nodes[node.name] = node;
+    depth = std::max(depth, node.level);
+  }
+  if (!in.good() || nodes.size() != nr_nodes)
+    throw std::runtime_error("Truncated tile index " + index_path.string());
+}
+
+void TileTree::getBounds(double* min, double* max) const
+{
+  for (int k = 0; k < 3; k++) {
+    min[k] = bounds_min[k];
+    max[k] = bounds_max[k];
+  }
+}
+
+uint64_t TileTree::countPoints(int max_level) const
+{
+  uint64_t count = 0;
+  for (std::map<std::string, TileNode>::const_iterator it = nodes.begin();
+       it != nodes.end(); ++it) {
+    if (it->second.level <= max_level) count += it->second.nr_points;
+  }
+  return count;
+}
+
+void TileTree::read(int max_level, const double* min, const double* max,
+                    size_t chunk_size, ScanChunkHandler handler) const
+{
+  if (nodes.empty()) return;
+  if (chunk_size == 0) chunk_size = 1;
+  ScanChunk chunk;
+  int64_t root[3] = { 0, 0, 0 };
+  if (readNode("r", 0, root, max_level, min, max, chunk_size, chunk, handler)
+      && chunk.size() > 0) {
+    handler(chunk);
+  }
+}
+
+bool TileTree::readNode(const std::string& name, int level,
+                        const int64_t* tile_origin, int max_level,
+                        const double* min, const double* max,
+                        size_t chunk_size, ScanChunk& chunk,
+                        ScanChunkHandler& handler) const
+{
+  if (level > max_level) return true;
+  std::map<std::string, TileNode>::const_iterator it = nodes.find(name);
+  if (it == nodes.end()) return true;
+
+  int64_t tile_size = size >> level;
+  if (min && max) {
+    for (int k = 0; k < 3; k++) {
+      double lo = origin[k] + tile_origin[k] * scale;
+      double hi = origin[k] + (tile_origin[k] + tile_size) * scale;
+      if (hi < min[k] || lo > max[k]) return true;
+    }
+  }
+
+  std::vector<TilePoint> pts;
+  readTile((fs::path(dir) / (name + ".bin")).string(), pts);
+  for (size_t i = 0; i < pts.size(); i++) {
+    double p[3] = { origin[0] + pts[i].x * scale,
+                    origin[1] + pts[i].y * scale,
+                    origin[2] + pts[i].z * scale };
+    if (min && max
+        && (p[0] < min[0] || p[0] > max[0] || p[1] < min[1] || p[1] > max[1]
+            || p[2] < min[2] || p[2] > max[2])) {
+      continue;
+    }
+    chunk.xyz.insert(chunk.xyz.end(), p, p + 3);
+    chunk.reflectance.push_back(pts[i].reflectance);
+    chunk.rgb.insert(chunk.rgb.end(), pts[i].rgb, pts[i].rgb + 3);
+    if (chunk.size() >= chunk_size) {
+      if (!handler(chunk)) return false;
+      chunk.clear();
+    }
+  }
+
+  int64_t half = tile_size / 2;
+  for (int octant = 0; octant < 8 && half > 0; octant++) {
+    int64_t child[3] = { tile_origin[0] + (octant & 4 ? half : 0),
+                         tile_origin[1] + (octant & 2 ? half : 0),
+                         tile_origin[2] + (octant & 1 ? half : 0) };
+    if (!readNode(name + (char)('0' + octant), level + 1, child, max_level,
+                  min, max, chunk_size, chunk, handler)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+TileTreeWriter::TileTreeWriter(const std::string& dir, double scale,
+                               size_t max_node_points,
+                               size_t max_chunk_points, size_t buffer_points)
+  : dir(dir), scale(scale), max_node_points(max_node_points),
+    max_chunk_points(max_chunk_points), buffer_points(buffer_points),
+    has_bounds(false), log2size(0), size(1), grid_level(0), largest_chunk(0)
+{
+  if (!(scale > 0.0))
+    throw std::runtime_error("The scale of a tile tree must be positive");
+  if (max_node_points == 0 || max_chunk_points == 0)
+    throw std::runtime_error("Tiles and chunks must hold at least one point");
+}
+
+void TileTreeWriter::setBounds(const double* min, const double* max)
+{
+  for (int k = 0; k < 3; k++) {
+    bounds_min[k] = min[k];
+    bounds_max[k] = max[k];
+  }
+  has_bounds = true;
+}
+
+std::string TileTreeWriter::tilePath(const std::string& name) const
+{
+  return (fs::path(dir) / (name + ".bin")).string();
+}
+
+std::string TileTreeWriter::chunkPath(const std::string& name) const
+{
+  return (fs::path(dir) / "tmp" / (name + ".bin")).string();
+}
+
+/**
+ * Quantizes p relative to the lower corner of the bounding box, points
+ * outside of a given bounding box are clamped to it.
+ */
+bool TileTreeWriter::quantize(const double* p, TilePoint& tp) const
+{
+  int32_t* q = &tp.x;
+  for (int k = 0; k < 3; k++) {
+    double v = floor((p[k] - bounds_min[k]) / scale + 0.5);
+    if (!(v == v)) return false;
+    q[k] = (int32_t)std::min(std::max(v, 0.0), (double)(size - 1));
+  }
+  return true;
+}
+
+void TileTreeWriter::partition(const std::vector<std::vector<uint64_t> >& counts,
+                               int level, int64_t x, int64_t y, int64_t z,
+                               const std::string& name)
+{
+  int64_t cells = (int64_t)1 << level;
+  uint64_t count = counts[level][(x * cells + y) * cells + z];
+  if (count == 0) return;
+
+  int64_t tile_size = size >> level;
+  Cube cube;
+  cube.name = name;
+  cube.level = level;
+  cube.origin[0] = x * tile_size;
+  cube.origin[1] = y * tile_size;
+  cube.origin[2] = z * tile_size;
+
+  if (count <= max_chunk_points || level == grid_level) {
+    // all cells of the counting grid inside of the cube go to this chunk,
+    // a dense cell is split by splitChunks()
+    int shift = grid_level - level;
+    int64_t grid_cells = (int64_t)1 << grid_level;
+    for (int64_t gx = x << shift; gx < (x + 1) << shift; gx++) {
+      for (int64_t gy = y << shift; gy < (y + 1) << shift; gy++) {
+        for (int64_t gz = z << shift; gz < (z + 1) << shift; gz++) {
+          chunk_of_cell[(gx * grid_cells + gy) * grid_cells + gz] = chunks.size();
+        }
+      }
+    }
+    chunks.push_back(cube);
+    return;
+  }
+
+  upper.push_back(cube);
+  for (int octant = 0; octant < 8; octant++) {
+    partition(counts, level + 1, 2 * x + (octant >> 2 & 1),
+              2 * y + (octant >> 1 & 1), 2 * z + (octant & 1),
+              name + (char)('0' + octant));
+  }
+}
+
+void TileTreeWriter::appendChunk(const std::string& name,
+                                 std::vector<TilePoint>& pts) const
+{
+  if (pts.empty()) return;
+  std::string path = chunkPath(name);
+  FILE* f = fopen(path.c_str(), "ab");
+  if (f == 0) throw std::runtime_error("Could not write chunk " + path);
+  size_t n = fwrite(pts.data(), sizeof(TilePoint), pts.size(), f);
+  fclose(f);
+  if (n != pts.size()) throw std::runtime_error("Could not write chunk " + path);
+  pts.clear();
+}
+
+void TileTreeWriter::flushBuffers(std::vector<std::vector<TilePoint> >& buffers)
+{
+  for (size_t c = 0; c < buffers.size(); c++) {
+    appendChunk(chunks[c].name, buffers[c]);
+  }
+}
+
+/**
+ * Streams the chunk files with more than max_chunk_points points into the
+ * files of their octants, max_chunk_points points at a time, until every
+ * chunk fits. The split chunks become tiles above the chunks. Only a chunk
+ * of a single quantization step may stay larger, its points are equal.
+ */
+void TileTreeWriter::splitChunks()
+{
+  std::vector<Cube> todo;
+  todo.swap(chunks);
+  largest_chunk = 0;
+  while (!todo.empty()) {
+    Cube cube = todo.back();
+    todo.pop_back();
+    std::string path = chunkPath(cube.name);
+    size_t nr_points = fs::exists(path) ? fs::file_size(path) / sizeof(TilePoint) : 0;
+    int64_t tile_size = size >> cube.level;
+    // the scans did not stream the same points as while counting
+    if (nr_points == 0) continue;
+    if (nr_points <= max_chunk_points || tile_size <= 1) {
+      chunks.push_back(cube);
+      largest_chunk = std::max(largest_chunk, nr_points);
+      continue;
+    }
+
+    int64_t half = tile_size / 2;
+    FILE* f = fopen(path.c_str(), "rb");
+    if (f == 0) throw std::runtime_error("Could not open chunk " + path);
+    std::vector<TilePoint> pts(max_chunk_points), children[8];
+    size_t n;
+    while ((n = fread(pts.data(), sizeof(TilePoint), pts.size(), f)) > 0) {
+      for (size_t i = 0; i < n; i++) {
+        children[octantOf(pts[i], cube.origin, half)].push_back(pts[i]);
+      }
+      for (int octant = 0; octant < 8; octant++) {
+        appendChunk(cube.name + (char)('0' + octant), children[octant]);
+      }
+    }
+    bool failed = ferror(f) != 0;
+    fclose(f);
+    if (failed) throw std::runtime_error("Could not read chunk " + path);
+    fs::remove(path);
+
+    upper.push_back(cube);
+    for (int octant = 0; octant < 8; octant++) {
+      Cube child;
+      child.name = cube.name + (char)('0' + octant);
+      if (!fs::exists(chunkPath(child.name))) continue;
+      child.level = cube.level + 1;
+      child.origin[0] = cube.origin[0] + (octant & 4 ? half : 0);
+      child.origin[1] = cube.origin[1] + (octant & 2 ? half : 0);
+      child.origin[2] = cube.origin[2] + (octant & 1 ? half : 0);
+      todo.push_back(child);
+    }
+  }
+}
+
+/**
+ * Keeps a subsample of the points of a tile and hands the rest to its
+ * children until the tiles are small enough.
+ */
+void TileTreeWriter::splitTile(std::vector<TilePoint>& pts, const Cube& cube,
+                               std::vector<TileNode>& result) const
+{
+  int64_t tile_size = size >> cube.level;
+  TileNode node;
+  node.name = cube.name;
+  node.level = cube.level;
+
+  if (pts.size() <= max_node_points || tile_size <= 1) {
+    TileTree::writeTile(tilePath(cube.name), pts);
+    node.nr_points = pts.size();
+    result.push_back(node);
+    return;
+  }
+
+  std::vector<char> keep;
+  sample(pts, cube.origin, tile_size, keep);
+  std::vector<TilePoint> kept, children[8];
+  int64_t half = tile_size / 2;
+  for (size_t i = 0; i < pts.size(); i++) {
+    if (keep[i]) kept.push_back(pts[i]);
+    else children[octantOf(pts[i], cube.origin, half)].push_back(pts[i]);
+  }
+  std::vector<TilePoint>().swap(pts);
+
+  TileTree::writeTile(tilePath(cube.name), kept);
+  node.nr_points = kept.size();
+  result.push_back(node);
+
+  for (int octant = 0; octant < 8; octant++) {
+    if (children[octant].empty()) continue;
+    Cube child;
+    child.name = cube.name + (char)('0' + octant);
+    child.level = cube.level + 1;
+    child.origin[0] = cube.origin[0] + (octant & 4 ? half : 0);
+    child.origin[1] = cube.origin[1] + (octant & 2 ? half : 0);
+    child.origin[2] = cube.origin[2] + (octant & 1 ? half : 0);
+    splitTile(children[octant], child, result);
+  }
+}
+
+/**
+ * Fills a tile above the chunks with a subsample of the root tiles of its
+ * children, the points taken are removed from the children.
+ */
+void TileTreeWriter::moveUp(const Cube& cube,
+                            std::map<std::string, TileNode>& result) const
+{
+  std::vector<TilePoint> pts, child_pts;
+  std::vector<int> from;
+  for (int octant = 0; octant < 8; octant++) {
+    std::string child = cube.name + (char)('0' + octant);
+    if (result.find(child) == result.end()) continue;
+    TileTree::readTile(tilePath(child), child_pts);
+    pts.insert(pts.end(), child_pts.begin(), child_pts.end());
+    from.insert(from.end(), child_pts.size(), octant);
+  }
+
+  std::vector<char> keep;
+  sample(pts, cube.origin, size >> cube.level, keep);
+  std::vector<TilePoint> kept, rest[8];
+  for (size_t i = 0; i < pts.size(); i++) {
+    if (keep[i]) kept.push_back(pts[i]);
+    else rest[from[i]].push_back(pts[i]);
+  }
+
+  // the entries exist already, so the threads only modify them
+  TileTree::writeTile(tilePath(cube.name), kept);
+  result.find(cube.name)->second.nr_points = kept.size();
+  for (int octant = 0; octant < 8; octant++) {
+    std::string child = cube.name + (char)('0' + octant);
+    std::map<std::string, TileNode>::iterator it = result.find(child);
+    if (it == result.end()) continue;
+    TileTree::writeTile(tilePath(child), rest[octant]);
+    it->second.nr_points = rest[octant].size();
+  }
+}
+
+void TileTreeWriter::writeIndex(const std::map<std::string, TileNode>& result) const
+{
+  std::string path = (fs::path(dir) / TileTree::index_name).string();
+  std::ofstream out(path.c_str());
+  if (!out.good()) throw std::runtime_error("Could not write tile index " + path);
+  out << std::setprecision(17)
+      << index_magic << " " << index_version << std::endl
+      << "scale " << scale << std::endl
+      << "origin " << bounds_min[0] << " " << bounds_min[1] << " "
+      << bounds_min[2] << std::endl
+      << "size " << size << std::endl
+      << "bounds " << bounds_min[0] << " " << bounds_min[1] << " "
+      << bounds_min[2] << " " << bounds_max[0] << " " << bounds_max[1] << " "
+      << bounds_max[2] << std::endl
+      << "nodes " << result.size() << std::endl;
+  for (std::map<std::string, TileNode>::const_iterator it = result.begin();
+       it != result.end(); ++it) {
+    out << it->second.name << " " << it->second.level << " "
+        << it->second.nr_points << std::endl;
+  }
+  if (!out.good()) throw std::runtime_error("Could not write tile index " + path);
+}
+
+void TileTreeWriter::build(size_t nr_scans, ScanStream stream)
+{
+  // the chunk files are appended to, leftovers of an aborted run would
+  // end up in the tiles
+  fs::remove_all(fs::path(dir) / "tmp");
+  fs::create_directories(fs::path(dir) / "tmp");
+  chunks.clear();
+  upper.clear();
+
+  // pass 1: bounding box
+  if (!has_bounds) {
+    for (int k = 0; k < 3; k++) {
+      bounds_min[k] = DBL_MAX;
+      bounds_max[k] = -DBL_MAX;
+    }
+    for (size_t s = 0; s < nr_scans; s++) {
+      stream(s, [&](ScanChunk& chunk) -> bool {
+        for (size_t i = 0; i < chunk.xyz.size(); i += 3) {
+          for (int k = 0; k < 3; k++) {
+            bounds_min[k] = std::min(bounds_min[k], chunk.xyz[i + k]);
+            bounds_max[k] = std::max(bounds_max[k], chunk.xyz[i + k]);
+          }
+        }
+        return true;
+      });
+    }
+    if (bounds_min[0] > bounds_max[0]) {
+      for (int k = 0; k < 3; k++) bounds_min[k] = bounds_max[k] = 0.0;
+    }
+  }
+
+  // the cube is a power of two quantization steps large, so the borders of
+  // all tiles are integers
+  double extent = std::max(std::max(bounds_max[0] - bounds_min[0],
+                                     bounds_max[1] - bounds_min[1]),
+                           bounds_max[2] - bounds_min[2]);
+  double steps = extent / scale + 1.0;
+  for (log2size = 0; (double)((int64_t)1 << log2size) < steps; log2size++) {
+    if (log2size == 30)
+      throw std::runtime_error("The points extend over more than 2^30 steps "
+                               "of the tile tree scale, use a larger scale");
+  }
+  size = (int64_t)1 << log2size;
+  grid_level = std::min(max_grid_level, log2size);
+
+  // pass 2: count the points per cell of the grid and in the levels above
+  int64_t grid_cells = (int64_t)1 << grid_level;
+  int shift = log2size - grid_level;
+  std::vector<std::vector<uint64_t> > counts(grid_level + 1);
+  counts[grid_level].assign(grid_cells * grid_cells * grid_cells, 0);
+  for (size_t s = 0; s < nr_scans; s++) {
+    stream(s, [&](ScanChunk& chunk) -> bool {
+      TilePoint tp;
+      for (size_t i = 0; i < chunk.xyz.size(); i += 3) {
+        if (!quantize(&chunk.xyz[i], tp)) continue;
+        counts[grid_level][((int64_t)(tp.x >> shift) * grid_cells
+                            + (tp.y >> shift)) * grid_cells + (tp.z >> shift)]++;
+      }
+      return true;
+    });
+  }
+  for (int level = grid_level - 1; level >= 0; level--) {
+    int64_t cells = (int64_t)1 << level;
+    counts[level].assign(cells * cells * cells, 0);
+    for (int64_t x = 0; x < 2 * cells; x++) {
+      for (int64_t y = 0; y < 2 * cells; y++) {
+        for (int64_t z = 0; z < 2 * cells; z++) {
+          counts[level][((x / 2) * cells + y / 2) * cells + z / 2] +=
+            counts[level + 1][(x * 2 * cells + y) * 2 * cells + z];
+        }
+      }
+    }
+  }
+  chunk_of_cell.assign(grid_cells * grid_cells * grid_cells, -1);
+  partition(counts, 0, 0, 0, 0, "r");
+  counts.clear();
+
+  // pass 3: distribute the points to the chunk files
+  std::vector<std::vector<TilePoint> > buffers(chunks.size());
+  size_t buffered = 0;
+  for (size_t s = 0; s < nr_scans; s++) {
+    stream(s, [&](ScanChunk& chunk) -> bool {
+      size_t n = chunk.xyz.size() / 3;
+      bool has_reflectance = chunk.reflectance.size() == n;
+      bool has_rgb = chunk.rgb.size() == 3 * n;
+      TilePoint tp;
+      tp.pad = 0;
+      for (size_t i = 0; i < n; i++) {
+        if (!quantize(&chunk.xyz[3 * i], tp)) continue;
+        tp.reflectance = has_reflectance ? chunk.reflectance[i] : 0.0f;
+        for (int k = 0; k < 3; k++) tp.rgb[k] = has_rgb ? chunk.rgb[3 * i + k] : 0;
+        int32_t c = chunk_of_cell[((int64_t)(tp.x >> shift) * grid_cells
+                                   + (tp.y >> shift)) * grid_cells + (tp.z >> shift)];
+        // the scans did not stream the same points as while counting
+        if (c < 0) continue;
+        buffers[c].push_back(tp);
+        if (++buffered >= buffer_points) {
+          flushBuffers(buffers);
+          buffered = 0;
+        }
+      }
+      return true;
+    });
+  }
+  flushBuffers(buffers);
+  buffers.clear();
+  std::vector<int32_t>().swap(chunk_of_cell);
+  splitChunks();
+
+  // split the chunks into tiles
+  std::vector<std::vector<TileNode> > chunk_nodes(chunks.size());
+  int nr_chunks = chunks.size();
+  bool failed = false;
+  std::string error;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+  for (int c = 0; c < nr_chunks; c++) {
+    try {
+      std::vector<TilePoint> pts;
+      TileTree::readTile(chunkPath(chunks[c].name), pts);
+      fs::remove(chunkPath(chunks[c].name));
+      splitTile(pts, chunks[c], chunk_nodes[c]);
+    } catch (std::exception& e) {
+#ifdef _OPENMP
+#pragma omp critical
+#endif
+      {
+        failed = true;
+        error = e.what();
+      }
+    }
+  }
+  if (failed) throw std::runtime_error(error);
+  fs::remove_all(fs::path(dir) / "tmp");
+
+  std::map<std::string, TileNode> result;
+  for (size_t c = 0; c < chunk_nodes.size(); c++) {
+    for (size_t i = 0; i < chunk_nodes[c].size(); i++) {
+      result[chunk_nodes[c][i].name] = chunk_nodes[c][i];
+    }
+  }
+  int upper_depth = -1;
+  for (size_t u = 0; u < upper.size(); u++) {
+    TileNode node;
+    node.name = upper[u].name;
+    node.level = upper[u].level;
+    node.nr_points = 0;
+    result[node.name] = node;
+    upper_depth = std::max(upper_depth, upper[u].level);
+  }
+
+  // fill the tiles above the chunks level by level from the bottom, the
+  // tiles of one level have distinct children
+  for (int level = upper_depth; level >= 0; level--) {
+    std::vector<int> tiles;
+    for (size_t u = 0; u < upper.size(); u++) {
+      if (upper[u].level == level) tiles.push_back(u);
+    }
+    int nr_tiles = tiles.size();
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+    for (int t = 0; t < nr_tiles; t++) {
+      try {
+        moveUp(upper[tiles[t]], result);
+      } catch (std::exception& e) {
+#ifdef _OPENMP
+#pragma omp critical
+#endif
+        {
+          failed = true;
+          error = e.what();
+        }
+      }
+    }
+    if (failed) throw std::runtime_error(error);
+  }
+
+  writeIndex(result);
+}
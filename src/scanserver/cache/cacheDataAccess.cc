@@ -16,7 +16,7 @@ CacheDataAccess::Lock::Lock(ip::interprocess_upgradable_mutex& mutex) :
 {
 }
 
-CacheDataAccess::CacheDataAccess(ip::interprocess_upgradable_mutex& mutex, unsigned int& size, unsigned char* data) :
+CacheDataAccess::CacheDataAccess(ip::interprocess_upgradable_mutex& mutex, std::size_t size, unsigned char* data) :
   DataPointer(data, size, new Lock(mutex))
 {
 }
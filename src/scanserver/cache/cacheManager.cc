@@ -85,7 +85,7 @@ bool CacheManager::loadCacheObject(CacheObject* obj)
   }
 }
 
-unsigned char* CacheManager::allocateCacheObject(CacheObject* obj, unsigned int size)
+unsigned char* CacheManager::allocateCacheObject(CacheObject* obj, std::size_t size)
 {
   // remove old data if this isn't a cache miss call but a direct allocate call
   if(obj->m_handle != 0) {
@@ -145,7 +145,7 @@ void CacheManager::invalidateCacheObject(CacheObject* obj)
   obj->m_handler->invalidate();
 }
 
-unsigned char* CacheManager::load(CacheObject* obj, unsigned int size)
+unsigned char* CacheManager::load(CacheObject* obj, std::size_t size)
 {
   // INFO
   //cout << " CM::load (" << size << ")" << endl;
@@ -51,7 +51,7 @@ CacheIO::IDType CacheIO::getId()
   return ss.str();
 }
 
-unsigned int CacheIO::check(CacheIO::IDType& id)
+std::size_t CacheIO::check(CacheIO::IDType& id)
 {
   if(exists(path+id))
     return file_size(path+id);
@@ -72,7 +72,7 @@ void CacheIO::read(CacheIO::IDType& id, char* data)
 #endif //WITH_METRICS
 }
 
-void CacheIO::write(CacheIO::IDType& id, char* data, unsigned int size)
+void CacheIO::write(CacheIO::IDType& id, char* data, std::size_t size)
 {
 #ifdef WITH_METRICS
   Timer t = ServerMetric::cacheio_write_time.start();
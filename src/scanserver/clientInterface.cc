@@ -93,7 +93,7 @@ bool ClientInterface::loadCacheObject(CacheObject* obj)
   return success;
 }
 
-void ClientInterface::allocateCacheObject(CacheObject* obj, unsigned int size)
+void ClientInterface::allocateCacheObject(CacheObject* obj, std::size_t size)
 {
   // aquire client mutex for uninterrupted work
   scoped_lock<interprocess_mutex> lock(m_mutex_client);
@@ -103,7 +103,7 @@ void ClientInterface::allocateCacheObject(CacheObject* obj, unsigned int size)
 #endif //WITH_METRICS
 
   m_cacheobject_ptr = obj;
-  m_arg_uint_1 = size;
+  m_arg_size_t = size;
   sendMessage(MESSAGE_ALLOCATE_CACHE_OBJECT);
 
 #ifdef WITH_METRICS
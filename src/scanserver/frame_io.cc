@@ -8,6 +8,7 @@
  */
 
 #include "scanserver/frame_io.h"
+#include "slam6d/framesFile.h"
 
 #include <vector>
 #include <sstream>
@@ -28,6 +29,14 @@ void FrameIO::loadFile(const char* dir, const char* identifier, FrameVector& fra
   frames_path /= (std::string(FRAMES_PATH_PREFIX) + identifier + FRAMES_PATH_SUFFIX);
   if(!exists(frames_path)) return;
 
+  if(FramesFile::isBinary(frames_path.string())) {
+    FramesFile file(frames_path.string());
+    frames.resize(file.size());
+    for(size_t i = 0; i < file.size(); ++i)
+      file.get(i, frames[i]);
+    return;
+  }
+
   // read the file
   ifstream frames_file(frames_path);
   std::string line;
@@ -58,12 +67,18 @@ void FrameIO::loadFile(const char* dir, const char* identifier, FrameVector& fra
     frames[i].set(&(transformations[i*16]), types[i]);
 }
 
-void FrameIO::saveFile(const char* dir, const char* identifier, const FrameVector& frames, bool append)
+void FrameIO::saveFile(const char* dir, const char* identifier, const FrameVector& frames, bool append, FramesFormat format)
 {
   // assemble path
   path frames_path(dir);
   frames_path /= (std::string(FRAMES_PATH_PREFIX) + identifier + FRAMES_PATH_SUFFIX);
 
+  if(format != FRAMES_TEXT) {
+    std::vector<Frame> copy(frames.begin(), frames.end());
+    FramesFile::write(frames_path.string(), copy.data(), copy.size(), format, append);
+    return;
+  }
+
   // write into the file
   std::ios_base::openmode open_mode = append ? std::ios_base::app : std::ios_base::out;
   ofstream frames_file(frames_path, open_mode);
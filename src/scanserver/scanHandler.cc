@@ -42,7 +42,7 @@ class PrefetchVectorBase {
 public:
   virtual bool prefetch() = 0;
   virtual void create() = 0;
-  virtual unsigned int size() const = 0;
+  virtual std::size_t size() const = 0;
   virtual void write(void* data_ptr) = 0;
 };
 
@@ -91,14 +91,14 @@ public:
   }
 
   //! Size of vector contents in bytes
-  virtual unsigned int size() const {
+  virtual std::size_t size() const {
     return m_vector->size()*sizeof(T);
   }
 
   //! Write vector contents into the cache object via \a data_ptr and clean up the vector
   virtual void write(void* data_ptr) {
     // write vector contents
-    for(unsigned int i = 0; i < m_vector->size(); ++i) {
+    for(std::size_t i = 0; i < m_vector->size(); ++i) {
       reinterpret_cast<T*>(data_ptr)[i] = (*m_vector)[i];
     }
     // remove so it won't get saved for prefetches
@@ -215,7 +215,7 @@ bool ScanHandler::load()
   }
 
   // after successful loading, allocate enough cache space
-  unsigned int size = vec->size();
+  std::size_t size = vec->size();
   void* data_ptr;
   try {
     data_ptr = m_manager->allocateCacheObject(m_object, size);
@@ -247,7 +247,7 @@ bool ScanHandler::load()
   return true;
 }
 
-void ScanHandler::save(unsigned char* data, unsigned int size)
+void ScanHandler::save(unsigned char* data, std::size_t size)
 {
   // INFO
   //cout << "[" << m_scan->getIdentifier() << "][" << m_data << "] ScanHandler::save" << endl;
@@ -122,10 +122,10 @@ void parseArgs(int argc, char** argv, std::size_t& cache_size, std::size_t& data
   while((c = getopt_long(argc, argv, "c:d:t:b:k?", longopts, 0)) != -1) {
     switch(c) {
       case 'c':
-        cache_size = atoi(optarg);
+        cache_size = strtoull(optarg, 0, 10);
         break;
       case 'd':
-        data_size = atoi(optarg);
+        data_size = strtoull(optarg, 0, 10);
         break;
       case 't':
         temporary_path = optarg;
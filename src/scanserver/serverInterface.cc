@@ -88,7 +88,7 @@ bool ServerInterface::loadCacheObject(CacheObject* obj)
   return m_manager.loadCacheObject(obj);
 }
 
-void ServerInterface::allocateCacheObject(CacheObject* obj, unsigned int size)
+void ServerInterface::allocateCacheObject(CacheObject* obj, std::size_t size)
 {
   // INFO
   //cout << "ServerInterface::allocateCacheObject (" << size << ")" << endl;
@@ -132,7 +132,7 @@ void ServerInterface::loadFramesFile(SharedScan* scan)
 
 void ServerInterface::saveFramesFile(SharedScan* scan, bool append)
 {
-  FrameIO::saveFile(scan->getDirPath(), scan->getIdentifier(), static_cast<ServerScan*>(scan)->getFrames(), append);
+  FrameIO::saveFile(scan->getDirPath(), scan->getIdentifier(), static_cast<ServerScan*>(scan)->getFrames(), append, scan->getFramesFormat());
 }
 
 void ServerInterface::clearFrames(SharedScan* scan)
@@ -266,7 +266,7 @@ void ServerInterface::run()
         m_arg_uint_1 = (loadCacheObject(m_cacheobject_ptr.get()) == true? 1: 0);
       } else
       if(m_message == MESSAGE_ALLOCATE_CACHE_OBJECT) {
-        allocateCacheObject(m_cacheobject_ptr.get(), m_arg_uint_1);
+        allocateCacheObject(m_cacheobject_ptr.get(), m_arg_size_t);
       } else
       if(m_message == MESSAGE_INVALIDATE_CACHE_OBJECT) {
         invalidateCacheObject(m_cacheobject_ptr.get());
@@ -37,6 +37,7 @@ SharedScan::SharedScan(const ip::allocator<void, SegmentManager> & allocator,
   m_show_parameters(allocator),
   m_octtree_parameters(allocator),
   m_load_frames_file(true),
+  m_frames_format(FRAMES_TEXT),
   m_frames(allocator)
 {
   // until boost-1.47 ipc-strings can do garbage with g++-4.4 -O2 and higher (optimizations and versions)
@@ -218,8 +219,9 @@ const FrameVector& SharedScan::getFrames()
   return m_frames;
 }
 
-void SharedScan::saveFrames(bool append)
+void SharedScan::saveFrames(bool append, FramesFormat format)
 {
+  m_frames_format = format;
   ClientInterface* client = ClientInterface::getInstance();
   client->saveFramesFile(this, append);
   // we just saved the file, no need to read it
@@ -267,13 +269,13 @@ DataXYZ SharedScan::getXYZReduced() {
   return m_xyz_reduced->getCacheData<SharedScan::onCacheMiss>();
 }
 
-DataXYZ SharedScan::createXYZReduced(unsigned int size) {
+DataXYZ SharedScan::createXYZReduced(std::size_t size) {
   // size is in units of double[3], scale to bytes
   return m_xyz_reduced->createCacheData<SharedScan::onAllocation>(size*3*sizeof(double));
 }
 
 
-DataReflectance SharedScan::createReflectance(unsigned int size) {
+DataReflectance SharedScan::createReflectance(std::size_t size) {
   // size is in units of double[1], scale to bytes
   return m_reflectance->createCacheData<SharedScan::onAllocation>(size*1*sizeof(double));
 }
@@ -283,7 +285,7 @@ DataXYZ SharedScan::getXYZReducedOriginal() {
   return m_xyz_reduced_original->getCacheData<SharedScan::onCacheMiss>();
 }
 
-DataXYZ SharedScan::createXYZReducedOriginal(unsigned int size) {
+DataXYZ SharedScan::createXYZReducedOriginal(std::size_t size) {
   // size is in units of double[3], scale to bytes
   return m_xyz_reduced_original->createCacheData<SharedScan::onAllocation>(size*3*sizeof(double));
 }
@@ -292,7 +294,7 @@ TripleArray<float> SharedScan::getXYZReducedShow() {
   return m_show_reduced->getCacheData<SharedScan::onCacheMiss>();
 }
 
-TripleArray<float> SharedScan::createXYZReducedShow(unsigned int size) {
+TripleArray<float> SharedScan::createXYZReducedShow(std::size_t size) {
   return m_show_reduced->createCacheData<SharedScan::onAllocation>(size*3*sizeof(float));
 }
 
@@ -300,7 +302,7 @@ DataPointer SharedScan::getOcttree() {
   return m_octtree->getCacheData<SharedScan::onCacheMiss>();
 }
 
-DataPointer SharedScan::createOcttree(unsigned int size) {
+DataPointer SharedScan::createOcttree(std::size_t size) {
   return m_octtree->createCacheData<SharedScan::onAllocation>(size);
 }
 
@@ -310,7 +312,7 @@ void SharedScan::onCacheMiss(CacheObject* obj)
   client->loadCacheObject(obj);
 }
 
-void SharedScan::onAllocation(CacheObject* obj, unsigned int size)
+void SharedScan::onAllocation(CacheObject* obj, std::size_t size)
 {
   ClientInterface* client = ClientInterface::getInstance();
   client->allocateCacheObject(obj, size);
@@ -31,7 +31,7 @@ bool TemporaryHandler::load()
   //cout << "[" << m_scan->getIdentifier() << "][" << m_id << "] TemporaryHandler::load";
 
   // if the file was not written (equals invalidated) or file doesn't exist we can't load anything
-  unsigned int size = 0;
+  std::size_t size = 0;
   if(!m_written || (size = CacheIO::check(m_id)) == 0) {
     // INFO
     //cout << ", no file found" << endl;
@@ -63,7 +63,7 @@ bool TemporaryHandler::load()
   return true;
 }
 
-void TemporaryHandler::save(unsigned char* data, unsigned int size)
+void TemporaryHandler::save(unsigned char* data, std::size_t size)
 {
   // INFO
   //cout << "[" << m_scan->getIdentifier() << "][" << m_id << "] TemporaryHandler::save";
@@ -9,16 +9,23 @@
   */
 
 #include <segmentation/FHGraph.h>
+#include <slam6d/kdIndexed.h>
 #include <map>
-#include <omp.h>
 #include <algorithm>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 using namespace std;
 
-
+template<typename T>
+void vectorFree(T& t) {
+    T tmp;
+    t.swap(tmp);
+}
 
 FHGraph::FHGraph(vector<Point> *ps,
-			  double weight(Point, Point),
+			  double weight(const Point&, const Point&),
 			  double sigma,
 			  double eps,
 			  int neighbors,
@@ -27,7 +34,7 @@ FHGraph::FHGraph(vector<Point> *ps,
 {
   pts = ps;
     /*
-     * 1. create adjency list using a map<int, vector<half_edge> >
+     * 1. create the neighbourhood graph in CSR layout (offsets, adjacency)
      * 2. use get_neighbors(e, max_dist) to get all the edges e'
      *    that are at a distance smaller than max_dist than e
      * 3. using all these edges, compute the gaussian smoothed weight
@@ -44,113 +51,138 @@ FHGraph::FHGraph(vector<Point> *ps,
 	 without_gauss();
     }
 
-    adjency_list.clear();
+    vectorFree(offsets);
+    vectorFree(adjacency);
 }
 
-void FHGraph::compute_neighbors(double weight(Point, Point), double eps)
+/**
+ * Computes the neighbours of every point and stores them in CSR layout.
+ *
+ * The points are processed in blocks of BLOCK_SIZE. Every block collects
+ * its half edges in a buffer of its own, the buffers are concatenated in
+ * block order afterwards, so the resulting graph is independent of the
+ * number of threads. With eps == 0 the exact search of KDtreeIndexed is
+ * used, otherwise the approximate search of ANN. Both can be queried from
+ * all threads.
+ */
+void FHGraph::compute_neighbors(double weight(const Point&, const Point&),
+                                double eps)
 {
-    adjency_list.reserve(pts->size());
-    adjency_list.resize(pts->size());
+    const int BLOCK_SIZE = 4096;
 
-    ANNpointArray pa = annAllocPts(pts->size(), 3);
-    for (size_t i = 0; i < pts->size(); ++i)
+    // ANNpointArray is a double** backed by a contiguous array
+    ANNpointArray pa = annAllocPts(V, 3);
+    for (int i = 0; i < V; ++i)
     {
-        pa[i] = new ANNcoord[3];
         pa[i][0] = (*pts)[i].x;
         pa[i][1] = (*pts)[i].y;
         pa[i][2] = (*pts)[i].z;
     }
 
-    ANNkd_tree t(pa, pts->size(), 3);
-
-    if ( radius < 0 ) // Using knn search
-    {
-        nr_neighbors++;
-        ANNidxArray n = new ANNidx[nr_neighbors];
-        ANNdistArray d = new ANNdist[nr_neighbors];
-
-        for (size_t i = 0; i < pts->size(); ++i)
-        {
-            ANNpoint p = pa[i];
-
-            t.annkSearch(p, nr_neighbors, n, d, eps);
-
-            for (int j=0; j<nr_neighbors; ++j)
-            {
-                if ( n[j] == (int)i ) continue;
-
-                he e;
-                e.x = n[j];
-                e.w = weight(Point((*pts)[i]), Point((*pts)[n[j]]));
-
-                adjency_list[i].push_back(e);
-            }
-
-        }
-
-        delete[] n;
-        delete[] d;
+    bool approximate = eps > 0.0;
+    ANNkd_tree *ann = 0;
+    KDtreeIndexed *kd = 0;
+    if (approximate) {
+        ann = new ANNkd_tree(pa, V, 3);
+    } else {
+        kd = new KDtreeIndexed(pa, V);
     }
-    else // Using radius search
-    {
-        float sqradius = radius*radius;
-
 
-        ANNidxArray n;
-        ANNdistArray d;
-        int nret;
-        int total = 0;
+    // in kNN mode the query point itself is part of the result
+    bool knn = radius < 0;
+    if (knn) nr_neighbors++;
+    double sqradius = (double)radius * radius;
 
-        const int MOD = 1000;
-        int TMP = MOD;
+    int nr_blocks = (V + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    vector< vector<he> > blocks(nr_blocks);
+    offsets.assign(V + 1, 0);
 
-        for (size_t i = 0; i < pts->size(); ++i)
+    // the k-d tree keeps per thread state for OPENMP_NUM_THREADS threads
+#ifdef _OPENMP
+    omp_set_num_threads(OPENMP_NUM_THREADS);
+#endif
+#pragma omp parallel
+    {
+        int thread_num = 0;
+#ifdef _OPENMP
+        thread_num = omp_get_thread_num();
+#endif
+        // scratch buffers for ANN, reused for all queries
+        vector<ANNidx> n(knn ? nr_neighbors : 0);
+        vector<ANNdist> d(knn ? nr_neighbors : 0);
+        vector<size_t> found;
+
+#pragma omp for schedule(dynamic)
+        for (int b = 0; b < nr_blocks; ++b)
         {
-            ANNpoint p = pa[i];
+            vector<he> &block = blocks[b];
+            int end = std::min(V, (b + 1) * BLOCK_SIZE);
+            if (knn) block.reserve((size_t)(end - b * BLOCK_SIZE) * (nr_neighbors - 1));
 
-            nret = t.annkFRSearch(p, sqradius, 0, NULL, NULL, eps);
-            total += nret;
-
-            n = new ANNidx[nret];
-            d = new ANNdist[nret];
-            t.annkFRSearch(p, sqradius, nret, n, d, eps);
-
-		  /*
-            if ( nr_neighbors > 0 && nr_neighbors < nret )
+            for (int i = b * BLOCK_SIZE; i < end; ++i)
             {
-                random_shuffle(n, n+nret);
-                nret = nr_neighbors;
+                size_t nret;
+                if (approximate) {
+                    if (knn) {
+                        ann->annkSearch(pa[i], nr_neighbors, n.data(), d.data(), eps);
+                        nret = nr_neighbors;
+                    } else {
+                        nret = ann->annkFRSearch(pa[i], sqradius, 0, NULL, NULL, eps);
+                        if (nret > n.size()) {
+                            n.resize(nret);
+                            d.resize(nret);
+                        }
+                        ann->annkFRSearch(pa[i], sqradius, nret, n.data(), d.data(), eps);
+                    }
+                } else {
+                    if (knn) {
+                        found = kd->kNearestNeighbors(pa[i], nr_neighbors, thread_num);
+                    } else {
+                        found = kd->fixedRangeSearch(pa[i], sqradius, thread_num);
+                    }
+                    nret = found.size();
+                }
+
+                for (size_t j = 0; j < nret; ++j)
+                {
+                    int nb = approximate ? n[j] : (int)found[j];
+                    if ( nb == i ) continue;
+
+                    he e;
+                    e.x = nb;
+                    e.w = weight((*pts)[i], (*pts)[nb]);
+
+                    block.push_back(e);
+                }
+                offsets[i + 1] = block.size();
             }
-		  */
-
-            for (int j=0; j<nret; ++j)
-            {
-                if ( n[j] == (int)i ) continue;
-
-                he e;
-                e.x = n[j];
-                e.w = weight(Point((*pts)[i]), Point((*pts)[n[j]]));
+        }
+    }
 
-                adjency_list[i].push_back(e);
-            }
+    // turn the per block counts into global offsets and concatenate
+    size_t total = 0;
+    for (int b = 0; b < nr_blocks; ++b) {
+        int end = std::min(V, (b + 1) * BLOCK_SIZE);
+        for (int i = b * BLOCK_SIZE; i < end; ++i)
+            offsets[i + 1] += total;
+        total += blocks[b].size();
+    }
+    adjacency.resize(total);
+#pragma omp parallel for schedule(dynamic)
+    for (int b = 0; b < nr_blocks; ++b) {
+        std::copy(blocks[b].begin(), blocks[b].end(),
+                  adjacency.begin() + offsets[b * BLOCK_SIZE]);
+        vectorFree(blocks[b]);
+    }
 
-            delete[] n;
-            delete[] d;
-            if ( TMP==0 )
-            {
-                TMP = MOD;
-                cout << "Point " << i << "/" << V << ", or "
-				 << (i*100.0 / V) << "%\r";
-			 cout.flush();
-            }
-            TMP --;
-        }
+    if (!knn) {
         cout << "Average nr of neighbors: "
-		   << (float) total / pts->size()
-		   << endl;
-
+             << (float) total / V
+             << endl;
     }
 
+    delete ann;
+    delete kd;
     annDeallocPts(pa);
 }
 
@@ -178,64 +210,47 @@ string tostr(int x)
 
 void FHGraph::do_gauss(double sigma)
 {
-    edges.reserve( V * nr_neighbors);
-    list<he>::iterator k, j;
-    vector<double> gauss_weight, edge_weight;
-    edge e;
-#pragma omp parallel for private(j, k, e, gauss_weight, edge_weight) schedule(dynamic)
+    // edge j of the CSR adjacency becomes edges[j]
+    edges.resize(adjacency.size());
+#pragma omp parallel for schedule(dynamic, 1024)
     for (int i=0; i<V; ++i)
     {
-        for (j=adjency_list[i].begin();
-             j!=adjency_list[i].end();
-             j++)
+        for (size_t j=offsets[i]; j<offsets[i+1]; ++j)
         {
+            const he &h = adjacency[j];
 
-            gauss_weight.clear();
-            edge_weight.clear();
-
-            for (k=adjency_list[i].begin();
-                 k!=adjency_list[i].end();
-                 ++k)
+            // normalized gaussian weighting of the edges around i and h.x
+            double gauss_sum = 0, weighted_sum = 0;
+            for (size_t k=offsets[i]; k<offsets[i+1]; ++k)
             {
-                gauss_weight.push_back(gauss(k->w, j->w, sigma));
-                edge_weight.push_back(k->w);
+                double g = gauss(adjacency[k].w, h.w, sigma);
+                gauss_sum += g;
+                weighted_sum += g * adjacency[k].w;
             }
-            for (k=adjency_list[j->x].begin();
-                 k!=adjency_list[j->x].end();
-                 ++k)
+            for (size_t k=offsets[h.x]; k<offsets[h.x+1]; ++k)
             {
-                gauss_weight.push_back(gauss(k->w, j->w, sigma));
-                edge_weight.push_back(k->w);
+                double g = gauss(adjacency[k].w, h.w, sigma);
+                gauss_sum += g;
+                weighted_sum += g * adjacency[k].w;
             }
-            normalize(gauss_weight);
-
-            e.a = i; e.b = j->x;
-            e.w = 0;
-            for (size_t k=0; k<edge_weight.size(); ++k)
-                e.w += gauss_weight[k] * edge_weight[k];
 
-#pragma omp critical
-            {
-                edges.push_back(e);
-            }
+            edge &e = edges[j];
+            e.a = i; e.b = h.x;
+            e.w = weighted_sum / gauss_sum;
         }
     }
 }
 
 void FHGraph::without_gauss()
 {
-    edges.reserve( V * nr_neighbors);
-    list<he>::iterator j;
-    edge e;
-
+    edges.resize(adjacency.size());
+#pragma omp parallel for schedule(dynamic, 1024)
     for (int i=0; i<V; ++i)
     {
-        for (j=adjency_list[i].begin();
-             j!=adjency_list[i].end();
-             j++)
+        for (size_t j=offsets[i]; j<offsets[i+1]; ++j)
         {
-            e.a = i; e.b = j->x; e.w = j->w;
-            edges.push_back(e);
+            edge &e = edges[j];
+            e.a = i; e.b = adjacency[j].x; e.w = adjacency[j].w;
         }
     }
 }
@@ -243,8 +258,7 @@ void FHGraph::without_gauss()
 edge* FHGraph::getGraph()
 {
     edge* ret = new edge[edges.size()];
-    for (size_t i=0; i<edges.size(); ++i)
-        ret[i] = edges[i];
+    std::copy(edges.begin(), edges.end(), ret);
     return ret;
 }
 
@@ -263,15 +277,10 @@ int FHGraph::getNumEdges()
     return edges.size();
 }
 
-template<typename T>
-void vectorFree(T& t) {
-    T tmp;
-    t.swap(tmp);
-}
-
 void FHGraph::dispose() {
     vectorFree(edges);
     //    vectorFree(points);
-    vectorFree(adjency_list);
+    vectorFree(offsets);
+    vectorFree(adjacency);
 }
 
@@ -132,12 +132,12 @@ void parse_options(int argc, char **argv, int &start, int &end,
 }
 
 /// distance measures
-double weight1(Point a, Point b)
+double weight1(const Point &a, const Point &b)
 {
   return a.distance(b);
 }
 
-double weight2(Point a, Point b)
+double weight2(const Point &a, const Point &b)
 {
   //return 0;
   return (1 -(a.nx * b.nx + a.ny * b.ny + a.nz * b.nz));
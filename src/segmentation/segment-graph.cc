@@ -10,14 +10,93 @@
 
 #include <segmentation/segment-graph.h>
 
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 bool operator<(const edge &a, const edge &b) {
     return a.w < b.w;
 }
 
+// maps a float onto an unsigned integer with the same ordering
+static inline uint32_t radix_key(float w) {
+    uint32_t u;
+    std::memcpy(&u, &w, sizeof(u));
+    return (u & 0x80000000u) ? ~u : (u | 0x80000000u);
+}
+
+void sort_edges(int num_edges, edge *edges) {
+    const int RADIX_BITS = 8;
+    const int RADIX = 1 << RADIX_BITS;
+
+    // the radix sort only pays off for large graphs
+    if (num_edges < 4096) {
+        std::stable_sort(edges, edges + num_edges);
+        return;
+    }
+
+    int nr_threads = 1;
+#ifdef _OPENMP
+    nr_threads = omp_get_max_threads();
+#endif
+    std::vector<edge> buffer(num_edges);
+    // count[t * RADIX + r]: number of keys with digit r in chunk t
+    std::vector<size_t> count(nr_threads * RADIX);
+    edge *src = edges;
+    edge *dst = buffer.data();
+
+    for (int shift = 0; shift < 32; shift += RADIX_BITS) {
+        bool skip = false;
+#pragma omp parallel num_threads(nr_threads)
+        {
+            int t = 0, n = 1;
+#ifdef _OPENMP
+            t = omp_get_thread_num();
+            n = omp_get_num_threads();
+#endif
+            // every thread works on a contiguous chunk to keep the sort stable
+            size_t begin = (size_t)num_edges * t / n;
+            size_t end = (size_t)num_edges * (t + 1) / n;
+            size_t *c = &count[t * RADIX];
+            std::fill(c, c + RADIX, 0);
+            for (size_t i = begin; i < end; ++i)
+                c[(radix_key(src[i].w) >> shift) & (RADIX - 1)]++;
+
+#pragma omp barrier
+#pragma omp single
+            {
+                // exclusive prefix sum in digit major, chunk minor order
+                size_t sum = 0;
+                for (int r = 0; r < RADIX; ++r) {
+                    for (int k = 0; k < n; ++k) {
+                        size_t tmp = count[k * RADIX + r];
+                        if (tmp == (size_t)num_edges) skip = true;
+                        count[k * RADIX + r] = sum;
+                        sum += tmp;
+                    }
+                }
+            }
+
+            // all keys share this digit, the pass would only copy
+            if (!skip) {
+                for (size_t i = begin; i < end; ++i)
+                    dst[c[(radix_key(src[i].w) >> shift) & (RADIX - 1)]++] = src[i];
+            }
+        }
+        if (!skip) std::swap(src, dst);
+    }
+
+    if (src != edges)
+        std::copy(src, src + num_edges, edges);
+}
+
 universe *segment_graph(int num_vertices, int num_edges, edge *edges,
                         float c) {
     // sort edges by weight
-    std::sort(edges, edges + num_edges);
+    sort_edges(num_edges, edges);
 
     // make a disjoint-set forest
     universe *u = new universe(num_vertices);
@@ -45,6 +124,6 @@ universe *segment_graph(int num_vertices, int num_edges, edge *edges,
     }
 
     // free up
-    delete threshold;
+    delete[] threshold;
     return u;
 }
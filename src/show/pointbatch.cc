@@ -0,0 +1,140 @@
+/*
+ * pointbatch implementation
+ *
+ * Released under the GPL version 3.
+ *
+ */
+
+#ifdef WITH_GLEE
+#include "GLee.h"
+#endif
+
+#include "show/pointbatch.h"
+
+PointBatch::PointBatch() :
+  colorManager(0), colorVersion(0), visible(0),
+  uploaded(false), colorsUploaded(false)
+{
+  buffers[0] = buffers[1] = 0;
+}
+
+PointBatch::~PointBatch()
+{
+#ifdef WITH_GLEE
+  if (buffers[0]) glDeleteBuffersARB(2, buffers);
+#endif
+}
+
+void PointBatch::clear()
+{
+  xyz.clear();
+  texcoords.clear();
+  rgb.clear();
+  colorManager = 0;
+  ranges.clear();
+  visible = 0;
+  uploaded = colorsUploaded = false;
+}
+
+bool PointBatch::colorsValid(ColorManager *cm) const
+{
+  return cm == colorManager && cm->getVersion() == colorVersion;
+}
+
+float* PointBatch::texCoordsFor(ColorManager *cm)
+{
+  rgb.clear();
+  texcoords.resize(size());
+  colorManager = cm;
+  colorVersion = cm->getVersion();
+  colorsUploaded = false;
+  return texcoords.data();
+}
+
+unsigned char* PointBatch::rgbFor(ColorManager *cm)
+{
+  texcoords.clear();
+  rgb.resize(3 * size());
+  colorManager = cm;
+  colorVersion = cm->getVersion();
+  colorsUploaded = false;
+  return rgb.data();
+}
+
+void PointBatch::draw(ColorManager *cm)
+{
+  if (ranges.empty()) return;
+
+  // colour arrays are only used if they belong to the active manager
+  bool useRGB = cm && cm == colorManager && !rgb.empty();
+  bool useTex = cm && cm == colorManager && !texcoords.empty();
+
+  const GLvoid *vertexPtr = xyz.data();
+  const GLvoid *colorPtr = useRGB ? (const GLvoid*)rgb.data()
+                                  : (const GLvoid*)texcoords.data();
+#ifdef WITH_GLEE
+  bool vbo = GLEE_ARB_vertex_buffer_object;
+  if (vbo) {
+    if (!buffers[0]) glGenBuffersARB(2, buffers);
+    glBindBufferARB(GL_ARRAY_BUFFER_ARB, buffers[0]);
+    if (!uploaded) {
+      glBufferDataARB(GL_ARRAY_BUFFER_ARB, xyz.size() * sizeof(float),
+                      xyz.data(), GL_STATIC_DRAW_ARB);
+      uploaded = true;
+    }
+    vertexPtr = 0;
+  }
+#endif
+  glEnableClientState(GL_VERTEX_ARRAY);
+  glVertexPointer(3, GL_FLOAT, 0, vertexPtr);
+
+#ifdef WITH_GLEE
+  if (vbo && (useRGB || useTex)) {
+    glBindBufferARB(GL_ARRAY_BUFFER_ARB, buffers[1]);
+    if (!colorsUploaded) {
+      if (useRGB)
+        glBufferDataARB(GL_ARRAY_BUFFER_ARB, rgb.size(),
+                        rgb.data(), GL_STATIC_DRAW_ARB);
+      else
+        glBufferDataARB(GL_ARRAY_BUFFER_ARB, texcoords.size() * sizeof(float),
+                        texcoords.data(), GL_STATIC_DRAW_ARB);
+      colorsUploaded = true;
+    }
+    colorPtr = 0;
+  }
+#endif
+  if (useRGB) {
+    glEnableClientState(GL_COLOR_ARRAY);
+    glColorPointer(3, GL_UNSIGNED_BYTE, 0, colorPtr);
+  } else if (useTex) {
+    glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+    glTexCoordPointer(1, GL_FLOAT, 0, colorPtr);
+  }
+
+  for (size_t i = 0; i < ranges.size(); i++) {
+    glDrawArrays(GL_POINTS, (GLint)ranges[i].first, (GLsizei)ranges[i].count);
+  }
+
+  if (useRGB) glDisableClientState(GL_COLOR_ARRAY);
+  if (useTex) glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+  glDisableClientState(GL_VERTEX_ARRAY);
+#ifdef WITH_GLEE
+  if (vbo) glBindBufferARB(GL_ARRAY_BUFFER_ARB, 0);
+#endif
+}
+
+void PointBatch::spreadOrder(unsigned int n, std::vector<unsigned int> &order)
+{
+  order.clear();
+  unsigned int bits = 0;
+  while ((1u << bits) < n) bits++;
+
+  // bit reversed counting visits the points in ever finer strides
+  for (unsigned int i = 0; i < (1u << bits); i++) {
+    unsigned int r = 0;
+    for (unsigned int b = 0; b < bits; b++) {
+      if (i & (1u << b)) r |= 1u << (bits - 1 - b);
+    }
+    if (r < n) order.push_back(r);
+  }
+}
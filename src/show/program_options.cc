@@ -25,7 +25,7 @@ void parse_args(int argc, char **argv, dataset_settings& dss, window_settings& w
 		    no_points, no_cameras, no_path, no_poses,
 		    no_fog, ds.fog.type, ds.fog.density,
 		    ds.camera.position, ds.camera.rotation, ds.pzoom, ds.pointsize,
-		    ds.hide_classLabels,
+		    ds.hide_classLabels, ds.batch_points,
         display_options);
 
   options_description color_options("Point coloring");
@@ -303,7 +303,7 @@ void setDisplayOptions(double& scale, GLfloat& fov, int& viewmode,
 		       bool& noFog, int& fogType, GLfloat& fogDensity,
 		       Position& position, Quaternion& rotation,
 		       float& pzoom, int& pointsize,
-           bool& hide_classLabels,
+           bool& hide_classLabels, bool& batchPoints,
 		       options_description& display_options)
 {
   display_options.add_options()
@@ -348,6 +348,9 @@ void setDisplayOptions(double& scale, GLfloat& fov, int& viewmode,
      "Size of each point in pixels.")
     ("hideClassLabels", bool_switch(&hide_classLabels),
      "Hide legend with class labels when using coloring by point type")
+    ("batch-points", bool_switch(&batchPoints),
+     "Draw points from vertex arrays instead of immediate mode. Faster, "
+     "but keeps a second copy of all points in memory.")
     ;
 }
 
@@ -0,0 +1,279 @@
+/*
+ * show_benchmark implementation
+ *
+ * Released under the GPL version 3.
+ *
+ */
+
+/**
+ * @file
+ * @brief Headless timing of the culling and draw list building of show
+ *
+ * Builds the octrees of show for a range of scans and moves a virtual camera
+ * around each of them. For every frame the frustum is extracted from the
+ * camera matrices instead of a GL context and the time the tree traversal
+ * takes to build the draw list is reported together with the number of draw
+ * calls and points that would be sent to the GPU.
+ */
+
+#include "show/show_Boctree.h"
+#include "show/viewcull.h"
+#include "slam6d/scan.h"
+#include "slam6d/io_types.h"
+#include "slam6d/globals.icc"
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <stdexcept>
+#include <cmath>
+#include <chrono>
+
+#include <boost/program_options.hpp>
+namespace po = boost::program_options;
+
+using std::cout;
+using std::cerr;
+using std::endl;
+using std::string;
+
+/// validate IO types
+void validate(boost::any& v, const std::vector<std::string>& values,
+              IOType*, int) {
+  if (values.size() == 0)
+    throw std::runtime_error("Invalid model specification");
+  string arg = values.at(0);
+  try {
+    v = formatname_to_io_type(arg.c_str());
+  } catch (...) { // runtime_error
+    throw std::runtime_error("Format " + arg + " unknown.");
+  }
+}
+
+void parse_options(int argc, char **argv, string &dir, IOType &iotype,
+                   int &start, int &end, double &voxelSize, int &frames,
+                   int &lod_mode, float &ratio, int &width, int &height,
+                   double &fov, bool &verbose)
+{
+  po::options_description generic("Generic options");
+  generic.add_options()
+    ("help,h", "output this help message");
+
+  po::options_description input("Input options");
+  input.add_options()
+    ("format,f", po::value<IOType>(&iotype)->default_value(UOS),
+     "using shared library <arg> for input. (chose F from {uos, uos_map, "
+     "uos_rgb, uos_frames, uos_map_frames, old, rts, rts_map, ifp, "
+     "riegl_txt, riegl_rgb, riegl_bin, zahn, ply})")
+    ("start,s", po::value<int>(&start)->default_value(0),
+     "start at scan <arg> (i.e., neglects the first <arg> scans) "
+     "[ATTENTION: counting naturally starts with 0]")
+    ("end,e", po::value<int>(&end)->default_value(-1),
+     "end after scan <arg>")
+    ("reduce,r", po::value<double>(&voxelSize)->default_value(0.0),
+     "voxel size of the octree, 0 for the size show uses for unreduced scans");
+
+  po::options_description bench("Benchmark options");
+  bench.add_options()
+    ("frames,n", po::value<int>(&frames)->default_value(100),
+     "number of frames of the camera orbit around each scan")
+    ("lod,l", po::value<int>(&lod_mode)->default_value(-1),
+     "LOD mode of the draw list, -1 draws all points in the frustum, "
+     "0 and 1 are the LOD modes of show")
+    ("ratio", po::value<float>(&ratio)->default_value(1.0),
+     "LOD ratio, show lowers it while moving")
+    ("width", po::value<int>(&width)->default_value(960),
+     "width of the virtual viewport")
+    ("height", po::value<int>(&height)->default_value(540),
+     "height of the virtual viewport")
+    ("fov", po::value<double>(&fov)->default_value(60.0),
+     "vertical field of view in degrees")
+    ("verbose,v", po::bool_switch(&verbose)->default_value(false),
+     "print the timing of every frame");
+
+  po::options_description hidden("Hidden options");
+  hidden.add_options()
+    ("input-dir", po::value<string>(&dir), "input dir");
+
+  po::options_description all;
+  all.add(generic).add(input).add(bench).add(hidden);
+
+  po::options_description cmdline_options;
+  cmdline_options.add(generic).add(input).add(bench);
+
+  po::positional_options_description pd;
+  pd.add("input-dir", 1);
+
+  po::variables_map vm;
+  po::store(po::command_line_parser(argc, argv).
+            options(all).positional(pd).run(), vm);
+
+  if (vm.count("help") || !vm.count("input-dir")) {
+    cout << cmdline_options;
+    cout << endl
+         << "Example usage:" << endl
+         << "\t./bin/show_benchmark -s 0 -e 0 -n 200 -l 0 dat" << endl;
+    exit(0);
+  }
+  po::notify(vm);
+
+#ifndef _MSC_VER
+  if (dir[dir.length()-1] != '/') dir = dir + "/";
+#else
+  if (dir[dir.length()-1] != '\\') dir = dir + "\\";
+#endif
+}
+
+/**
+ * Column major modelview matrix of a camera at eye looking at center,
+ * like gluLookAt
+ */
+static void lookAt(const double eye[3], const double center[3],
+                   const double up[3], double M[16])
+{
+  double f[3] = { center[0] - eye[0], center[1] - eye[1], center[2] - eye[2] };
+  Normalize3(f);
+  double s[3], u[3];
+  Cross(f, up, s);
+  Normalize3(s);
+  Cross(s, f, u);
+
+  M[0] = s[0]; M[4] = s[1]; M[ 8] = s[2];
+  M[1] = u[0]; M[5] = u[1]; M[ 9] = u[2];
+  M[2] = -f[0]; M[6] = -f[1]; M[10] = -f[2];
+  M[3] = 0.0; M[7] = 0.0; M[11] = 0.0;
+  M[12] = -Dot(s, eye);
+  M[13] = -Dot(u, eye);
+  M[14] = Dot(f, eye);
+  M[15] = 1.0;
+}
+
+/**
+ * Column major projection matrix, like gluPerspective
+ */
+static void perspective(double fovy, double aspect, double znear, double zfar,
+                        double P[16])
+{
+  double f = 1.0 / tan(rad(fovy) / 2.0);
+  for (int i = 0; i < 16; i++) P[i] = 0.0;
+  P[0] = f / aspect;
+  P[5] = f;
+  P[10] = (zfar + znear) / (znear - zfar);
+  P[11] = -1.0;
+  P[14] = 2.0 * zfar * znear / (znear - zfar);
+}
+
+int main(int argc, char **argv)
+{
+  string dir;
+  IOType iotype;
+  int start, end, frames, lod_mode, width, height;
+  double voxelSize, fov;
+  float ratio;
+  bool verbose;
+  parse_options(argc, argv, dir, iotype, start, end, voxelSize, frames,
+                lod_mode, ratio, width, height, fov, verbose);
+
+  Scan::openDirectory(false, dir, iotype, start, end);
+  if (Scan::allScans.size() == 0) {
+    cerr << "No scans found. Did you use the correct format?" << endl;
+    exit(-1);
+  }
+
+  // same default as show for unreduced scans
+  if (voxelSize <= 0.0) voxelSize = 0.2;
+
+  int viewport[4] = { 0, 0, width, height };
+  double total_ms = 0.0, max_ms = 0.0;
+  size_t total_calls = 0, total_points = 0;
+  int total_frames = 0;
+
+  for (size_t s = 0; s < Scan::allScans.size(); s++) {
+    Scan *scan = Scan::allScans[s];
+    DataXYZ xyz(scan->get("xyz"));
+    if (xyz.size() == 0) continue;
+
+    std::vector<sfloat*> pts(xyz.size());
+    std::vector<sfloat> buf(3 * xyz.size());
+    for (size_t i = 0; i < xyz.size(); i++) {
+      pts[i] = &buf[3*i];
+      for (int j = 0; j < 3; j++) buf[3*i + j] = xyz[i][j];
+    }
+
+    Show_BOctTree<sfloat> tree(pts.data(), (int)pts.size(), (sfloat)voxelSize);
+
+    double center[3];
+    tree.getCenter(center);
+    double size = tree.getTree()->getSize();
+    double radius = 2.5 * size;
+
+    double proj[16];
+    perspective(fov, (double)width / height, 0.01 * size, 10.0 * size, proj);
+
+    // the first call builds the vertex arrays of the tree
+    double modl[16];
+    double eye[3] = { center[0] + radius, center[1] + 0.3 * radius, center[2] };
+    double up[3] = { 0.0, 1.0, 0.0 };
+    lookAt(eye, center, up, modl);
+    ExtractFrustum(modl, proj, viewport, 0);
+    unsigned long t0 = GetCurrentTimeInMilliSec();
+    tree.buildDrawList(lod_mode, ratio);
+    unsigned long batch_ms = GetCurrentTimeInMilliSec() - t0;
+
+    cout << "Scan " << scan->getIdentifier() << ": " << xyz.size()
+         << " points, batch built in " << batch_ms << " ms" << endl;
+
+    double scan_ms = 0.0;
+    size_t scan_calls = 0, scan_points = 0;
+    for (int f = 0; f < frames; f++) {
+      double angle = 2.0 * M_PI * f / frames;
+      // orbit in and out of the tree to vary the visible part
+      double r = radius * (0.2 + 0.8 * (0.5 + 0.5 * cos(3.0 * angle)));
+      eye[0] = center[0] + r * cos(angle);
+      eye[1] = center[1] + 0.3 * r;
+      eye[2] = center[2] + r * sin(angle);
+      lookAt(eye, center, up, modl);
+
+      std::chrono::steady_clock::time_point f0 = std::chrono::steady_clock::now();
+      ExtractFrustum(modl, proj, viewport, 0);
+      tree.buildDrawList(lod_mode, ratio);
+      double ms = std::chrono::duration<double, std::milli>(
+          std::chrono::steady_clock::now() - f0).count();
+
+      const PointBatch &batch = tree.getBatch();
+      if (verbose) {
+        cout << "  frame " << std::setw(5) << f
+             << " " << std::fixed << std::setprecision(3) << ms << " ms, "
+             << batch.drawCalls() << " draw calls, "
+             << batch.visiblePoints() << " points" << endl;
+      }
+      scan_ms += ms;
+      scan_calls += batch.drawCalls();
+      scan_points += batch.visiblePoints();
+      if (ms > max_ms) max_ms = ms;
+    }
+
+    if (frames > 0) {
+      cout << "  mean " << std::fixed << std::setprecision(3)
+           << scan_ms / frames << " ms/frame, "
+           << scan_calls / frames << " draw calls, "
+           << scan_points / frames << " points" << endl;
+    }
+    total_ms += scan_ms;
+    total_calls += scan_calls;
+    total_points += scan_points;
+    total_frames += frames;
+  }
+
+  if (total_frames > 0) {
+    cout << "Total " << total_frames << " frames: mean "
+         << std::fixed << std::setprecision(3) << total_ms / total_frames
+         << " ms/frame, max " << max_ms << " ms/frame, "
+         << total_calls / total_frames << " draw calls, "
+         << total_points / total_frames << " points" << endl;
+  }
+
+  Scan::closeDirectory();
+  return 0;
+}
@@ -668,6 +668,7 @@ void copy_settings_to_globals(
 
   hide_label = ds.hide_label;
   hide_classLabels = ds.hide_classLabels;
+  Show_BOctTree<sfloat>::setBatched(ds.batch_points);
 
   // Start in RGB mode if the user requests it or they request no other coloring
   if (dss.coloring.explicit_coloring || (dss.coloring.colorval == -1 && dss.coloring.ptype.hasColor())) {
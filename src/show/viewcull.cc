@@ -94,6 +94,11 @@ void remViewport() {
   glGetDoublev(GL_PROJECTION_MATRIX,projMatrix);
   glGetIntegerv(GL_VIEWPORT,viewport);
 
+  remViewport(modelMatrix, projMatrix, viewport);
+}
+
+void remViewport(const double *modelMatrix, const double *projMatrix,
+                 const int *viewport) {
   MMult( projMatrix, modelMatrix, matrix );
   VP[0] = 0.5*viewport[2];
   VP[1] = 0.5*viewport[2] + viewport[0];
@@ -106,22 +111,16 @@ void remViewport() {
   right[2] = modelMatrix[8];
 }
 
-void ExtractFrustum(short detail)
+/**
+ * Computes the frustum planes from the given modelview and projection
+ * matrices
+ */
+template <class T>
+static void extractPlanes(const T *modl, const T *proj)
 {
-   DETAIL = detail + 1;
-   remViewport();
-
-   float   proj[16];
-   float   modl[16];
    float   clip[16];
    float   t;
 
-   /* Get the current PROJECTION matrix from OpenGL */
-   glGetFloatv( GL_PROJECTION_MATRIX, proj );
-
-   /* Get the current MODELVIEW matrix from OpenGL */
-   glGetFloatv( GL_MODELVIEW_MATRIX, modl );
-
    /* Combine the two matrices (multiply projection by modelview) */
    clip[ 0] = modl[ 0] * proj[ 0] + modl[ 1] * proj[ 4] + modl[ 2] * proj[ 8] + modl[ 3] * proj[12];
    clip[ 1] = modl[ 0] * proj[ 1] + modl[ 1] * proj[ 5] + modl[ 2] * proj[ 9] + modl[ 3] * proj[13];
@@ -223,6 +222,31 @@ void ExtractFrustum(short detail)
 
 }
 
+void ExtractFrustum(short detail)
+{
+   DETAIL = detail + 1;
+   remViewport();
+
+   float   proj[16];
+   float   modl[16];
+
+   /* Get the current PROJECTION matrix from OpenGL */
+   glGetFloatv( GL_PROJECTION_MATRIX, proj );
+
+   /* Get the current MODELVIEW matrix from OpenGL */
+   glGetFloatv( GL_MODELVIEW_MATRIX, modl );
+
+   extractPlanes(modl, proj);
+}
+
+void ExtractFrustum(const double *modl, const double *proj,
+                    const int *viewport, short detail)
+{
+   DETAIL = detail + 1;
+   remViewport(modl, proj, viewport);
+   extractPlanes(modl, proj);
+}
+
 
 void ExtractFrustum(float *frust[6])
 {
@@ -99,6 +99,35 @@ int main(int argc, char **argv)
         exit(-1);
     }
 
+    // condense wrote the source scans of every MetaScan while streaming,
+    // so the association is known exactly and no points have to be read
+    std::vector<std::string> identifiers;
+    if (readProvenance(cond_dir, 0, identifiers)) {
+        std::map<std::string, Scan*> scans;
+        for (size_t i = 0; i < Scan::allScans.size(); ++i)
+            scans[Scan::allScans[i]->getIdentifier()] = Scan::allScans[i];
+
+        double transMat[16], transMatPose[16];
+        double tPoseInv[16], transMatRel[16];
+        for (int seq = 0; readProvenance(cond_dir, seq, identifiers); ++seq) {
+            readTransformFromFrames(cond_dir, seq, transMat);
+            readTransformFromPose(cond_dir, seq, transMatPose);
+            M4inv(transMatPose, tPoseInv);
+            MMult(transMat, tPoseInv, transMatRel);
+            for (size_t j = 0; j < identifiers.size(); ++j) {
+                std::map<std::string, Scan*>::iterator it = scans.find(identifiers[j]);
+                if (it == scans.end()) {
+                    cout << "scan" << identifiers[j] << " is not in " << orig_dir << ". Skipping..." << endl;
+                    continue;
+                }
+                double transMatOut[16];
+                MMult(transMatRel, it->second->get_transMatOrg(), transMatOut);
+                writeFrame(orig_dir, identifiers[j].c_str(), transMatOut);
+            }
+        }
+        return 0;
+    }
+
     // Check which PointTypes the IOType supports
     unsigned int types = PointType::USE_NONE;
     if(supportsReflectance(iotype)) types |= PointType::USE_REFLECTANCE;
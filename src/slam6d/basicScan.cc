@@ -14,6 +14,9 @@
 #include "slam6d/Boctree.h"
 #include "slam6d/ann_kd.h"
 #include "slam6d/BruteForceNotATree.h"
+#include "slam6d/uniformGrid.h"
+#include "slam6d/profiler.h"
+#include "slam6d/framesFile.h"
 
 
 #ifdef WITH_METRICS
@@ -391,6 +394,8 @@ void BasicScan::get(IODataType types)
 	  return;
   }
 
+  ProfileScope profile(PROFILE_SCAN_LOAD, scanNr);
+
   std::vector<double> xyz;
   std::vector<unsigned char> rgb;
   std::vector<float> reflectance;
@@ -431,6 +436,7 @@ void BasicScan::get(IODataType types)
                 &deviation,
                 &normal);
   } while ((pos = identifiers.find_first_of(';')) != std::string::npos || !identifiers.empty() );
+  Profiler::addCount(PROFILE_SCAN_LOAD, scanNr, xyz.size() / 3);
 
   // for each requested and filled data vector,
   // allocate and write contents to their new data fields
@@ -532,10 +538,9 @@ void BasicScan::get(IODataType types)
 DataPointer BasicScan::get(const std::string& identifier)
 {
   // try to get data
-  std::map<std::string, std::pair<unsigned char*, size_t>>::iterator
-    it = m_data.find(identifier);
+  std::pair<unsigned char*, size_t> field;
   // create data fields
-  if (it == m_data.end()) {
+  if (!findData(identifier, field)) {
     // load from file
     if (identifier == "xyz") get(DATA_XYZ);
     else
@@ -578,29 +583,79 @@ DataPointer BasicScan::get(const std::string& identifier)
                       // manipulate in showing the same entry
                       if (identifier == "xyz reduced show") {
                         calcReducedPoints();
+                        boost::lock_guard<boost::mutex> lock(m_mutex_data);
                         m_data["xyz reduced show"] = m_data["xyz reduced"];
                       } else
                         if(identifier == "octtree") {
                           createOcttree();
                         } else
 			  std::cerr << identifier << " could not be found!" << std::endl;
-    it = m_data.find(identifier);
+    // if nothing can be loaded, return an empty pointer
+    if (!findData(identifier, field))
+      return DataPointer(0, 0);
   }
 
-  // if nothing can be loaded, return an empty pointer
-  if(it == m_data.end())
-    return DataPointer(0, 0);
-  else
-    return DataPointer(it->second.first, it->second.second);
+  return DataPointer(field.first, field.second);
+}
+
+DataPointer BasicScan::get(FieldId id)
+{
+  if (id < max_field_slots) {
+    const std::pair<unsigned char*, size_t>* field =
+      m_field_slots[id].load(std::memory_order_acquire);
+    if (field) return DataPointer(field->first, field->second);
+  }
+
+  std::string identifier = fieldName(id);
+  DataPointer data = get(identifier);
+
+  // fields computed on demand are only answered without locking once the
+  // computation is done, until then another thread may still fill them
+  bool complete = true;
+  if (id == FIELD_XYZ_REDUCED || id == FIELD_XYZ_REDUCED_ORIGINAL)
+    complete = m_reduced_once.done();
+  else if (id == FIELD_NORMAL_REDUCED ||
+           (id == FIELD_NORMAL && !supportsNormals(m_type)))
+    complete = m_normals_once.done();
+
+  if (id < max_field_slots && complete) {
+    boost::lock_guard<boost::mutex> lock(m_mutex_data);
+    std::map<std::string, std::pair<unsigned char*, size_t>>::iterator
+      it = m_data.find(identifier);
+    if (it != m_data.end())
+      m_field_slots[id].store(&it->second, std::memory_order_release);
+  }
+  return data;
+}
+
+bool BasicScan::findData(const std::string& identifier,
+                         std::pair<unsigned char*, size_t>& field)
+{
+  boost::lock_guard<boost::mutex> lock(m_mutex_data);
+  std::map<std::string, std::pair<unsigned char*, size_t>>::iterator
+    it = m_data.find(identifier);
+  if (it == m_data.end()) return false;
+  field = it->second;
+  return true;
+}
+
+void BasicScan::unpublishField(const std::pair<unsigned char*, size_t>* field)
+{
+  for (FieldId id = 0; id < max_field_slots; ++id) {
+    if (m_field_slots[id].load(std::memory_order_relaxed) == field)
+      m_field_slots[id].store(0, std::memory_order_relaxed);
+  }
 }
 
 DataPointer BasicScan::create(const std::string& identifier,
                               size_t size)
 {
+  boost::lock_guard<boost::mutex> lock(m_mutex_data);
   std::map<std::string, std::pair<unsigned char*, size_t>>::iterator
     it = m_data.find(identifier);
 
   if(it != m_data.end() && it->second.second != size) {
+    unpublishField(&it->second);
 #ifdef WITH_MMAP_SCAN
     // depending on whether the data was backed by an mmap-ed file or by
     // memory on the heap, delete the right thing
@@ -669,9 +724,11 @@ DataPointer BasicScan::create(const std::string& identifier,
 
 void BasicScan::clear(const std::string& identifier)
 {
+  boost::lock_guard<boost::mutex> lock(m_mutex_data);
   std::map<std::string, std::pair<unsigned char*, size_t>>::iterator
     it = m_data.find(identifier);
   if(it != m_data.end()) {
+    unpublishField(&it->second);
 #ifdef WITH_MMAP_SCAN
     std::map<std::string, int>::iterator it2 = m_mmap_fds.find(identifier);
     if (it2 != m_mmap_fds.end()) {
@@ -720,6 +777,9 @@ void BasicScan::createSearchTreePrivate()
     case BruteForce:
         kd = new BruteForceNotATree(ar.get(),xyz_orig.size());
         break;
+    case UniformGrid:
+      kd = new UniformGridSearch(ar.get(), xyz_orig.size());
+      break;
     case -1:
       throw std::runtime_error("Cannot create a SearchTree without setting a type.");
     default:
@@ -782,6 +842,7 @@ void BasicScan::createOcttree()
   if (octtree_loadOct && exists(scanFileName) &&
      (!octtree_autoOct || getLastModified() < boost::filesystem::last_write_time(octpath))) {
         btree = new BOctTree<float>(scanFileName);
+        boost::lock_guard<boost::mutex> lock(m_mutex_data);
         m_data.insert(std::make_pair("octtree",
                  std::make_pair(reinterpret_cast<unsigned char*>(btree),
                  0 // or memorySize()?
@@ -818,6 +879,7 @@ void BasicScan::createOcttree()
     btree->serialize(scanFileName);
   }
 
+  boost::lock_guard<boost::mutex> lock(m_mutex_data);
   m_data.insert(std::make_pair("octtree",
            std::make_pair(reinterpret_cast<unsigned char*>(btree),
                           0 // or memorySize()?
@@ -875,10 +937,14 @@ size_t BasicScan::readFrames()
   std::string first_line_identifier = m_identifier.substr(0, pos);
 
   std::string filename = m_path + "scan" + first_line_identifier + ".frames";
-  std::string line;
-  std::ifstream file(filename.c_str());
   // clear frame vector here to allow reloading without (old) duplicates
   m_frames.clear();
+  if (FramesFile::isBinary(filename)) {
+    FramesFile(filename).getAll(m_frames);
+    return m_frames.size();
+  }
+  std::string line;
+  std::ifstream file(filename.c_str());
   while(getline(file, line)) {
           // ignore empty lines
           if(line.length() == 0) continue;
@@ -902,18 +968,8 @@ size_t BasicScan::readFrames()
 void BasicScan::saveFrames(bool append)
 {
   std::string filename = m_path + "scan" + m_identifier + ".frames";
-  std::ios_base::openmode open_mode;
-
-  if(append) open_mode = std::ios_base::app;
-  else open_mode = std::ios_base::out;
-  std::ofstream file(filename.c_str(), open_mode);
-  for(std::vector<Frame>::iterator it = m_frames.begin();
-      it != m_frames.end();
-      ++it) {
-    file << it->transformation << it->type << '\n';
-  }
-  file << std::flush;
-  file.close();
+  FramesFile::write(filename, m_frames.data(), m_frames.size(),
+                    frames_format, append);
 }
 
 size_t BasicScan::getFrameCount()
@@ -0,0 +1,267 @@
+/*
+ * bench_generate implementation
+ *
+ * Released under the GPL version 3.
+ *
+ */
+
+/**
+ * @file
+ * @brief Deterministic synthetic scans for the registration benchmark
+ *
+ * Simulates a scanner driving along a closed corridor around a building
+ * block. The corridor has a floor, a ceiling and pillars along its outer
+ * walls, consecutive scans overlap and the last scans close the loop to the
+ * first ones. The scans are written in the uos format, the poses are the
+ * true poses disturbed by odometry like noise.
+ *
+ * The output only depends on the options: the random numbers are drawn from
+ * std::mt19937 and converted without the implementation defined standard
+ * distributions, so every platform generates the same files.
+ */
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <random>
+
+#include <boost/filesystem.hpp>
+#include <boost/program_options.hpp>
+namespace po = boost::program_options;
+
+#include "slam6d/globals.icc"
+
+using std::cout;
+using std::cerr;
+using std::endl;
+using std::string;
+
+// all lengths in cm, like the uos scans
+static const double corridor_width = 1000.0;
+static const double corridor_height = 400.0;
+static const double inner_x = 4000.0, inner_z = 2000.0;
+static const double outer_x = inner_x + 2.0 * corridor_width;
+static const double outer_z = inner_z + 2.0 * corridor_width;
+
+/// axis aligned box
+struct Box {
+  double min[3], max[3];
+};
+
+/// uniform in [0, 1) from 32 random bits
+static inline double uniform(std::mt19937 &rng)
+{
+  return rng() * (1.0 / 4294967296.0);
+}
+
+/// standard normal distribution by the Box-Muller transform
+static inline double gaussian(std::mt19937 &rng)
+{
+  double u1 = 1.0 - uniform(rng);
+  double u2 = uniform(rng);
+  return sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
+}
+
+/**
+ * Distance along the ray from o in direction d to the first hit of the
+ * inside of the hall or the outside of one of the solid boxes, or a negative
+ * value if nothing is hit
+ */
+static double castRay(const double o[3], const double d[3],
+                      const Box &hall, const std::vector<Box> &solids)
+{
+  // leaving the hall, the ray starts inside of it
+  double t = 1e30;
+  for (int k = 0; k < 3; k++) {
+    if (d[k] > 0.0) t = std::min(t, (hall.max[k] - o[k]) / d[k]);
+    else if (d[k] < 0.0) t = std::min(t, (hall.min[k] - o[k]) / d[k]);
+  }
+  for (size_t i = 0; i < solids.size(); i++) {
+    double tmin = 0.0, tmax = t;
+    bool hit = true;
+    for (int k = 0; k < 3 && hit; k++) {
+      if (d[k] == 0.0) {
+        hit = o[k] > solids[i].min[k] && o[k] < solids[i].max[k];
+        continue;
+      }
+      double t0 = (solids[i].min[k] - o[k]) / d[k];
+      double t1 = (solids[i].max[k] - o[k]) / d[k];
+      if (t0 > t1) std::swap(t0, t1);
+      tmin = std::max(tmin, t0);
+      tmax = std::min(tmax, t1);
+      hit = tmin <= tmax;
+    }
+    if (hit && tmin > 0.0) t = tmin;
+  }
+  return t < 1e30 ? t : -1.0;
+}
+
+/// point on the corridor centre line at arc length s, and its heading
+static void trajectory(double s, double pos[3], double &heading)
+{
+  const double a = inner_x + corridor_width, b = inner_z + corridor_width;
+  const double x0 = 0.5 * corridor_width, z0 = 0.5 * corridor_width;
+  s = fmod(s, 2.0 * (a + b));
+  pos[1] = 0.5 * corridor_height;
+  if (s < a) {
+    pos[0] = x0 + s; pos[2] = z0; heading = 90.0;
+  } else if (s < a + b) {
+    pos[0] = x0 + a; pos[2] = z0 + (s - a); heading = 0.0;
+  } else if (s < 2.0 * a + b) {
+    pos[0] = x0 + a - (s - a - b); pos[2] = z0 + b; heading = -90.0;
+  } else {
+    pos[0] = x0; pos[2] = z0 + b - (s - 2.0 * a - b); heading = 180.0;
+  }
+}
+
+int main(int argc, char **argv)
+{
+  string dir;
+  int scans, points;
+  unsigned int seed;
+  double overlap, range, noise, pose_noise;
+
+  po::options_description generic("Generic options");
+  generic.add_options()
+    ("help,h", "output this help message");
+
+  po::options_description gen("Dataset options");
+  gen.add_options()
+    ("scans,n", po::value<int>(&scans)->default_value(20),
+     "number of scans")
+    ("points,p", po::value<int>(&points)->default_value(100000),
+     "number of points per scan")
+    ("overlap,o", po::value<double>(&overlap)->default_value(0.8),
+     "overlap of consecutive scans, the scanner moves (1 - <arg>) times "
+     "the range between two scans")
+    ("range,r", po::value<double>(&range)->default_value(3000.0),
+     "maximal range of the scanner in cm")
+    ("noise", po::value<double>(&noise)->default_value(1.0),
+     "standard deviation of the range noise in cm")
+    ("pose-noise", po::value<double>(&pose_noise)->default_value(10.0),
+     "standard deviation of the pose error in cm, the rotation error is "
+     "<arg> / 10 degrees")
+    ("seed", po::value<unsigned int>(&seed)->default_value(1),
+     "seed of the random numbers");
+
+  po::options_description hidden("Hidden options");
+  hidden.add_options()
+    ("output-dir", po::value<string>(&dir), "output dir");
+
+  po::options_description all;
+  all.add(generic).add(gen).add(hidden);
+
+  po::options_description cmdline_options;
+  cmdline_options.add(generic).add(gen);
+
+  po::positional_options_description pd;
+  pd.add("output-dir", 1);
+
+  po::variables_map vm;
+  po::store(po::command_line_parser(argc, argv).
+            options(all).positional(pd).run(), vm);
+
+  if (vm.count("help") || !vm.count("output-dir")) {
+    cout << cmdline_options;
+    cout << endl
+         << "Example usage:" << endl
+         << "\t./bin/bench_generate -n 30 -p 200000 -o 0.9 bench" << endl;
+    exit(0);
+  }
+  po::notify(vm);
+
+  if (scans < 1 || points < 1 || range <= 0.0 || overlap < 0.0 || overlap >= 1.0) {
+    cerr << "Invalid dataset options" << endl;
+    exit(-1);
+  }
+  boost::filesystem::create_directories(dir);
+
+  Box hall = { { 0.0, 0.0, 0.0 }, { outer_x, corridor_height, outer_z } };
+  std::vector<Box> solids;
+  Box inner = { { corridor_width, 0.0, corridor_width },
+                { corridor_width + inner_x, corridor_height, corridor_width + inner_z } };
+  solids.push_back(inner);
+
+  // pillars along the outer walls in randomised distances
+  std::mt19937 scene_rng(seed);
+  for (int side = 0; side < 2; side++) {
+    for (double s = 300.0; s < outer_x - 300.0; s += 500.0 + 500.0 * uniform(scene_rng)) {
+      double w = 40.0 + 60.0 * uniform(scene_rng);
+      double z = side ? outer_z - 50.0 - w : 50.0;
+      Box p = { { s, 0.0, z }, { s + w, corridor_height, z + w } };
+      solids.push_back(p);
+    }
+    for (double s = 300.0; s < outer_z - 300.0; s += 500.0 + 500.0 * uniform(scene_rng)) {
+      double w = 40.0 + 60.0 * uniform(scene_rng);
+      double x = side ? outer_x - 50.0 - w : 50.0;
+      Box p = { { x, 0.0, s }, { x + w, corridor_height, s + w } };
+      solids.push_back(p);
+    }
+  }
+
+  double step = (1.0 - overlap) * range;
+  for (int i = 0; i < scans; i++) {
+    // every scan has its own stream, so the scans do not depend on each other
+    std::mt19937 rng(seed + 7919u * (i + 1));
+
+    double pos[3], heading;
+    trajectory(i * step, pos, heading);
+    double theta[3] = { 0.0, rad(heading), 0.0 };
+    double transMat[16];
+    EulerToMatrix4(pos, theta, transMat);
+
+    std::ostringstream name;
+    name << dir << "/scan" << std::setw(3) << std::setfill('0') << i;
+
+    std::ofstream out((name.str() + ".3d").c_str());
+    if (!out.good()) {
+      cerr << "Cannot write " << name.str() << ".3d" << endl;
+      exit(-1);
+    }
+    out << std::fixed << std::setprecision(3);
+    int written = 0;
+    while (written < points) {
+      // uniform direction in scanner coordinates
+      double y = 2.0 * uniform(rng) - 1.0;
+      double phi = 2.0 * M_PI * uniform(rng);
+      double r = sqrt(1.0 - y * y);
+      double local[3] = { r * cos(phi), y, r * sin(phi) };
+      double d[3] = {
+        transMat[0] * local[0] + transMat[4] * local[1] + transMat[8] * local[2],
+        transMat[1] * local[0] + transMat[5] * local[1] + transMat[9] * local[2],
+        transMat[2] * local[0] + transMat[6] * local[1] + transMat[10] * local[2]
+      };
+      double t = castRay(pos, d, hall, solids);
+      double n = noise * gaussian(rng);
+      if (t < 0.0 || t > range) continue;
+      t += n;
+      out << t * local[0] << " " << t * local[1] << " " << t * local[2] << "\n";
+      written++;
+    }
+    out.close();
+
+    // the first pose is exact, it defines the coordinate system
+    double epos[3] = { pos[0], pos[1], pos[2] };
+    double etheta[3] = { 0.0, heading, 0.0 };
+    if (i > 0) {
+      for (int k = 0; k < 3; k++) {
+        epos[k] += pose_noise * gaussian(rng);
+        etheta[k] += 0.1 * pose_noise * gaussian(rng);
+      }
+    }
+    std::ofstream pose((name.str() + ".pose").c_str());
+    pose << std::fixed << std::setprecision(6)
+         << epos[0] << " " << epos[1] << " " << epos[2] << endl
+         << etheta[0] << " " << etheta[1] << " " << etheta[2] << endl;
+    pose.close();
+  }
+
+  cout << "Generated " << scans << " scans with " << points
+       << " points in " << dir << ", " << step << " cm between the scans"
+       << endl;
+  return 0;
+}
@@ -0,0 +1,509 @@
+/*
+ * bench_slam6d implementation
+ *
+ * Released under the GPL version 3.
+ *
+ */
+
+/**
+ * @file
+ * @brief Throughput of the stages of the registration pipeline
+ *
+ * Runs the stages of slam6D one after the other on a directory of scans,
+ * e.g. one written by bench_generate, and times each of them separately:
+ * parsing, reduction, building and querying each type of search tree,
+ * a complete ICP of every pair of consecutive scans with each type of search
+ * tree, the correspondence search, one ICP iteration of every point to point
+ * minimizer, one iteration of LUM, the normal estimation and the export of
+ * the points. The ICP results of the search trees are compared to the one
+ * with the k-d tree.
+ * The whole pipeline is repeated --runs times on freshly loaded scans and
+ * the fastest and the mean time of every stage are written to a JSON file,
+ * together with the build options, so results of different builds and
+ * versions can be compared.
+ */
+
+#include "slam6d/scan.h"
+#include "slam6d/kd.h"
+#include "slam6d/ann_kd.h"
+#include "slam6d/Boctree.h"
+#include "slam6d/uniformGrid.h"
+#include "slam6d/normals.h"
+#include "slam6d/graph.h"
+#include "slam6d/lum6Deuler.h"
+#include "slam6d/icp6Dapx.h"
+#include "slam6d/icp6Dsvd.h"
+#include "slam6d/icp6Dquat.h"
+#include "slam6d/icp6Dortho.h"
+#include "slam6d/icp6Dhelix.h"
+#include "slam6d/icp6Ddual.h"
+#include "slam6d/icp6Dlumeuler.h"
+#include "slam6d/icp6Dlumquat.h"
+#include "slam6d/icp6Dquatscale.h"
+#include "slam6d/globals.icc"
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <stdexcept>
+#include <chrono>
+#include <cstring>
+
+#ifdef _MSC_VER
+#if !defined _OPENMP && defined OPENMP
+#define _OPENMP
+#endif
+#endif
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <boost/program_options.hpp>
+namespace po = boost::program_options;
+
+using std::cout;
+using std::cerr;
+using std::endl;
+using std::string;
+using std::vector;
+
+/// validate IO types
+void validate(boost::any& v, const std::vector<std::string>& values,
+              IOType*, int) {
+  if (values.size() == 0)
+    throw std::runtime_error("Invalid model specification");
+  string arg = values.at(0);
+  try {
+    v = formatname_to_io_type(arg.c_str());
+  } catch (...) { // runtime_error
+    throw std::runtime_error("Format " + arg + " unknown.");
+  }
+}
+
+void parse_options(int argc, char **argv, string &dir, IOType &iotype,
+                   int &start, int &end, double &red, int &octree,
+                   double &mdm, int &bucketSize, int &icpIterations,
+                   int &k, int &runs,
+                   string &output, string &exportFile)
+{
+  po::options_description generic("Generic options");
+  generic.add_options()
+    ("help,h", "output this help message");
+
+  po::options_description input("Input options");
+  input.add_options()
+    ("format,f", po::value<IOType>(&iotype)->default_value(UOS),
+     "using shared library <arg> for input. (chose F from {uos, uos_map, "
+     "uos_rgb, uos_frames, uos_map_frames, old, rts, rts_map, ifp, "
+     "riegl_txt, riegl_rgb, riegl_bin, zahn, ply})")
+    ("start,s", po::value<int>(&start)->default_value(0),
+     "start at scan <arg> (i.e., neglects the first <arg> scans) "
+     "[ATTENTION: counting naturally starts with 0]")
+    ("end,e", po::value<int>(&end)->default_value(-1),
+     "end after scan <arg>");
+
+  po::options_description bench("Benchmark options");
+  bench.add_options()
+    ("reduce,r", po::value<double>(&red)->default_value(10.0),
+     "voxel size of the reduction")
+    ("octree,O", po::value<int>(&octree)->default_value(1),
+     "number of random points kept per voxel, 0 for the voxel centre")
+    ("dist,d", po::value<double>(&mdm)->default_value(25.0),
+     "maximal distance of the nearest neighbour queries and point pairs")
+    ("bucketsize", po::value<int>(&bucketSize)->default_value(20),
+     "bucket size of the k-d trees")
+    ("iter,i", po::value<int>(&icpIterations)->default_value(50),
+     "number of iterations of the ICP with each search tree")
+    ("k", po::value<int>(&k)->default_value(20),
+     "number of neighbours of the normal estimation")
+    ("runs,n", po::value<int>(&runs)->default_value(3),
+     "number of repetitions of the whole pipeline")
+    ("output,o", po::value<string>(&output)->default_value("bench.json"),
+     "write the results as JSON to file <arg>")
+    ("export", po::value<string>(&exportFile)->default_value("bench_points.pts"),
+     "file the export stage writes the reduced points to");
+
+  po::options_description hidden("Hidden options");
+  hidden.add_options()
+    ("input-dir", po::value<string>(&dir), "input dir");
+
+  po::options_description all;
+  all.add(generic).add(input).add(bench).add(hidden);
+
+  po::options_description cmdline_options;
+  cmdline_options.add(generic).add(input).add(bench);
+
+  po::positional_options_description pd;
+  pd.add("input-dir", 1);
+
+  po::variables_map vm;
+  po::store(po::command_line_parser(argc, argv).
+            options(all).positional(pd).run(), vm);
+
+  if (vm.count("help") || !vm.count("input-dir")) {
+    cout << cmdline_options;
+    cout << endl
+         << "Example usage:" << endl
+         << "\t./bin/bench_generate bench && ./bin/bench_slam6d -o bench.json bench"
+         << endl;
+    exit(0);
+  }
+  po::notify(vm);
+
+#ifndef _MSC_VER
+  if (dir[dir.length()-1] != '/') dir = dir + "/";
+#else
+  if (dir[dir.length()-1] != '\\') dir = dir + "\\";
+#endif
+}
+
+/// measured times of a stage over all runs
+struct StageResult {
+  string name;
+  vector<double> seconds;
+  size_t items;
+};
+
+/// collects the stage times in the order the stages ran first
+class Stages {
+public:
+  void add(const string &name, double seconds, size_t items) {
+    for (size_t i = 0; i < results.size(); i++) {
+      if (results[i].name == name) {
+        results[i].seconds.push_back(seconds);
+        results[i].items = items;
+        return;
+      }
+    }
+    StageResult r;
+    r.name = name;
+    r.seconds.push_back(seconds);
+    r.items = items;
+    results.push_back(r);
+  }
+
+  vector<StageResult> results;
+};
+
+static inline double since(std::chrono::steady_clock::time_point t0)
+{
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+static void writeJSON(std::ostream &out, const string &dir, size_t scans,
+                      size_t points, int runs, const Stages &stages)
+{
+  out << "{" << endl;
+  out << "  \"dataset\": {\"dir\": \"" << dir << "\", \"scans\": " << scans
+      << ", \"points\": " << points << "}," << endl;
+  out << "  \"build\": {";
+#ifdef _OPENMP
+  out << "\"openmp\": true, \"threads\": " << OPENMP_NUM_THREADS;
+#else
+  out << "\"openmp\": false, \"threads\": 1";
+#endif
+#ifdef WITH_OPENMP_KD
+  out << ", \"openmp_kd\": true";
+#else
+  out << ", \"openmp_kd\": false";
+#endif
+#ifdef WITH_MMAP_SCAN
+  out << ", \"mmap_scan\": true";
+#else
+  out << ", \"mmap_scan\": false";
+#endif
+#ifdef WITH_METRICS
+  out << ", \"metrics\": true";
+#else
+  out << ", \"metrics\": false";
+#endif
+#ifdef NDEBUG
+  out << ", \"ndebug\": true";
+#else
+  out << ", \"ndebug\": false";
+#endif
+#ifdef __VERSION__
+  out << ", \"compiler\": \"" << __VERSION__ << "\"";
+#endif
+  out << "}," << endl;
+  out << "  \"runs\": " << runs << "," << endl;
+  out << "  \"stages\": {" << endl;
+  std::streamsize precision = out.precision(9);
+  for (size_t i = 0; i < stages.results.size(); i++) {
+    const StageResult &r = stages.results[i];
+    double min = r.seconds[0], sum = 0.0;
+    for (size_t j = 0; j < r.seconds.size(); j++) {
+      min = std::min(min, r.seconds[j]);
+      sum += r.seconds[j];
+    }
+    out << "    \"" << r.name << "\": {\"min\": " << min
+        << ", \"mean\": " << sum / r.seconds.size()
+        << ", \"items\": " << r.items << "}"
+        << (i + 1 < stages.results.size() ? "," : "") << endl;
+  }
+  out.precision(precision);
+  out << "  }" << endl;
+  out << "}" << endl;
+}
+
+int main(int argc, char **argv)
+{
+  string dir, output, exportFile;
+  IOType iotype;
+  int start, end, octree, bucketSize, icpIterations, k, runs;
+  double red, mdm;
+  parse_options(argc, argv, dir, iotype, start, end, red, octree, mdm,
+                bucketSize, icpIterations, k, runs, output, exportFile);
+  double mdm2 = sqr(mdm);
+
+  // icp6D_NAPX is left out, it needs pairs with normals
+  const char *minimizer_names[] = { "quat", "svd", "ortho", "dual", "helix",
+                                    "apx", "lumeuler", "lumquat",
+                                    "quat_scale" };
+  vector<icp6Dminimizer*> minimizers;
+  minimizers.push_back(new icp6D_QUAT(true));
+  minimizers.push_back(new icp6D_SVD(true));
+  minimizers.push_back(new icp6D_ORTHO(true));
+  minimizers.push_back(new icp6D_DUAL(true));
+  minimizers.push_back(new icp6D_HELIX(true));
+  minimizers.push_back(new icp6D_APX(true));
+  minimizers.push_back(new icp6D_LUMEULER(true));
+  minimizers.push_back(new icp6D_LUMQUAT(true));
+  minimizers.push_back(new icp6D_QUAT_SCALE(true));
+
+  Stages stages;
+  size_t nscans = 0, npoints = 0;
+  for (int run = 0; run < runs; run++) {
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    Scan::openDirectory(false, dir, iotype, start, end);
+    if (Scan::allScans.size() < 2) {
+      cerr << "At least two scans are needed. Did you use the correct format?" << endl;
+      exit(-1);
+    }
+    nscans = Scan::allScans.size();
+    npoints = 0;
+    for (size_t i = 0; i < nscans; i++) {
+      npoints += Scan::allScans[i]->size<DataXYZ>("xyz");
+    }
+    stages.add("parse", since(t0), npoints);
+
+    t0 = std::chrono::steady_clock::now();
+    size_t nreduced = 0;
+    for (size_t i = 0; i < nscans; i++) {
+      Scan *scan = Scan::allScans[i];
+      scan->setReductionParameter(red, octree);
+      scan->setSearchTreeParameter(simpleKD, bucketSize);
+      nreduced += scan->size<DataXYZ>(Scan::FIELD_XYZ_REDUCED);
+    }
+    stages.add("reduction", since(t0), nreduced);
+
+    // each tree is queried with the points of the following scan
+    const int tree_types[] = { simpleKD, ANNTree, BOCTree, UniformGrid };
+    const char *tree_names[] = { "kd", "ann", "boctree", "grid" };
+    // the ICP results with the k-d tree the other trees are compared to
+    vector<double> kd_alignxf(16 * (nscans - 1));
+    for (int t = 0; t < 4; t++) {
+      vector<SearchTree*> trees(nscans - 1);
+      t0 = std::chrono::steady_clock::now();
+      for (size_t i = 0; i + 1 < nscans; i++) {
+        DataXYZ xyz(Scan::allScans[i]->get(Scan::FIELD_XYZ_REDUCED_ORIGINAL));
+        PointerArray<double> ar(xyz);
+        switch (tree_types[t]) {
+        case simpleKD:
+          trees[i] = new KDtree(ar.get(), xyz.size(), bucketSize);
+          break;
+        case ANNTree:
+          trees[i] = new ANNtree(ar, xyz.size());
+          break;
+        case BOCTree:
+          trees[i] = new BOctTree<double>(ar.get(), xyz.size(), 10.0,
+                                          PointType(), true);
+          break;
+        case UniformGrid:
+          trees[i] = new UniformGridSearch(ar.get(), xyz.size());
+          break;
+        }
+      }
+      stages.add(string("tree_build_") + tree_names[t], since(t0), nreduced);
+
+      t0 = std::chrono::steady_clock::now();
+      size_t queries = 0, found = 0;
+      for (size_t i = 0; i + 1 < nscans; i++) {
+        DataXYZ xyz(Scan::allScans[i + 1]->get(Scan::FIELD_XYZ_REDUCED_ORIGINAL));
+        for (size_t j = 0; j < xyz.size(); j++) {
+          double p[3] = { xyz[j][0], xyz[j][1], xyz[j][2] };
+          if (trees[i]->FindClosest(p, mdm2, 0)) found++;
+        }
+        queries += xyz.size();
+      }
+      stages.add(string("nn_") + tree_names[t], since(t0), queries);
+      if (run == 0) {
+        cout << tree_names[t] << ": " << found << " of " << queries
+             << " queries found a neighbour" << endl;
+      }
+
+      // ICP of scan i + 1 against scan i, the correspondences are searched
+      // in parallel like in icp6D
+      t0 = std::chrono::steady_clock::now();
+      size_t icp_pairs = 0;
+      double max_deviation = 0.0;
+      for (size_t i = 0; i + 1 < nscans; i++) {
+        DataXYZ xyz(Scan::allScans[i + 1]->get(Scan::FIELD_XYZ_REDUCED_ORIGINAL));
+        vector<double> points(3 * xyz.size());
+        vector<double*> ptrs(xyz.size());
+        for (size_t j = 0; j < xyz.size(); j++) {
+          for (int c = 0; c < 3; c++) points[3 * j + c] = xyz[j][c];
+          ptrs[j] = &points[3 * j];
+        }
+        double id[16], xf[16];
+        M4identity(id);
+        M4identity(xf);
+        for (int iter = 0; iter < icpIterations; iter++) {
+          vector<PtPair> pairs;
+          double centroid_m[3] = { 0.0, 0.0, 0.0 };
+          double centroid_d[3] = { 0.0, 0.0, 0.0 };
+#ifdef _OPENMP
+          omp_set_num_threads(OPENMP_NUM_THREADS);
+          int step = ceil(xyz.size() / (double)OPENMP_NUM_THREADS);
+#pragma omp parallel
+          {
+            int thread_num = omp_get_thread_num();
+            size_t begin = std::min(xyz.size(), (size_t)thread_num * step);
+            size_t end = std::min(xyz.size(), begin + step);
+#else
+          {
+            int thread_num = 0;
+            size_t begin = 0, end = xyz.size();
+#endif
+            vector<PtPair> local;
+            double sum = 0.0, cm[3] = { 0.0, 0.0, 0.0 }, cd[3] = { 0.0, 0.0, 0.0 };
+            trees[i]->getPtPairs(&local, id, &ptrs[0], begin, end, thread_num,
+                                 1, mdm2, sum, cm, cd);
+#pragma omp critical
+            {
+              pairs.insert(pairs.end(), local.begin(), local.end());
+              for (int c = 0; c < 3; c++) {
+                centroid_m[c] += cm[c];
+                centroid_d[c] += cd[c];
+              }
+            }
+          }
+          icp_pairs += pairs.size();
+          if (pairs.size() <= 3) break;
+          for (int c = 0; c < 3; c++) {
+            centroid_m[c] /= pairs.size();
+            centroid_d[c] /= pairs.size();
+          }
+
+          double alignxf[16], tmp[16];
+          minimizers[0]->Align(pairs, alignxf, centroid_m, centroid_d);
+          for (size_t j = 0; j < xyz.size(); j++) transform3(alignxf, ptrs[j]);
+          MMult(alignxf, xf, tmp);
+          memcpy(xf, tmp, sizeof(xf));
+        }
+
+        if (t == 0) {
+          memcpy(&kd_alignxf[16 * i], xf, sizeof(xf));
+        } else {
+          for (int c = 0; c < 16; c++) {
+            max_deviation = std::max(max_deviation,
+                                     fabs(xf[c] - kd_alignxf[16 * i + c]));
+          }
+        }
+      }
+      stages.add(string("icp_full_") + tree_names[t], since(t0), icp_pairs);
+      if (run == 0 && t > 0) {
+        cout << tree_names[t] << ": ICP deviates from the k-d tree result by "
+             << max_deviation << endl;
+      }
+
+      for (size_t i = 0; i + 1 < nscans; i++) delete trees[i];
+    }
+
+    // point pairs of consecutive scans with the search trees of the scans
+    for (size_t i = 0; i < nscans; i++) Scan::allScans[i]->createSearchTree();
+    vector< vector<PtPair> > pairs(nscans - 1);
+    vector<double> centroids(6 * (nscans - 1));
+    size_t npairs = 0;
+    t0 = std::chrono::steady_clock::now();
+    for (size_t i = 0; i + 1 < nscans; i++) {
+      double sum;
+      Scan::getPtPairs(&pairs[i], Scan::allScans[i], Scan::allScans[i + 1],
+                       0, 1, mdm2, sum, &centroids[6 * i], &centroids[6 * i + 3]);
+      npairs += pairs[i].size();
+    }
+    stages.add("correspondences", since(t0), npairs);
+
+    for (size_t m = 0; m < minimizers.size(); m++) {
+      t0 = std::chrono::steady_clock::now();
+      for (size_t i = 0; i + 1 < nscans; i++) {
+        if (pairs[i].size() <= 3) continue;
+        // the LUM based minimizers start from the current pose, like in icp6D
+        double alignxf[16];
+        memcpy(alignxf, Scan::allScans[i + 1]->get_transMat(), sizeof(alignxf));
+        minimizers[m]->Align(pairs[i], alignxf,
+                             &centroids[6 * i], &centroids[6 * i + 3]);
+      }
+      stages.add(string("icp_") + minimizer_names[m], since(t0), npairs);
+    }
+
+    // one iteration of LUM on the closed loop of all scans
+    t0 = std::chrono::steady_clock::now();
+    lum6DEuler lum(minimizers[0], mdm, mdm, 1, true, false, 1, false, -1,
+                   0.0000001, simpleKD, 0.5);
+    lum.doGraphSlam6D(Graph(nscans, true), Scan::allScans, 1);
+    stages.add("lum", since(t0), nscans);
+
+    t0 = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < nscans; i++) {
+      Scan *scan = Scan::allScans[i];
+      DataXYZ xyz(scan->get(Scan::FIELD_XYZ_REDUCED_ORIGINAL));
+      vector<Point> points, normals;
+      points.reserve(xyz.size());
+      for (size_t j = 0; j < xyz.size(); j++) {
+        points.push_back(Point(xyz[j][0], xyz[j][1], xyz[j][2]));
+      }
+      calculateNormalsKNN(normals, points, k, scan->get_rPos());
+    }
+    stages.add("normals", since(t0), nreduced);
+
+    t0 = std::chrono::steady_clock::now();
+    std::ofstream redptsout(exportFile.c_str());
+    for (size_t i = 0; i < nscans; i++) {
+      DataXYZ xyz(Scan::allScans[i]->get(Scan::FIELD_XYZ_REDUCED));
+      for (size_t j = 0; j < xyz.size(); j++) {
+        redptsout << xyz[j][0] << ' ' << xyz[j][1] << ' ' << xyz[j][2] << '\n';
+      }
+    }
+    redptsout.close();
+    stages.add("export", since(t0), nreduced);
+
+    Scan::closeDirectory();
+  }
+
+  for (size_t m = 0; m < minimizers.size(); m++) delete minimizers[m];
+
+  for (size_t i = 0; i < stages.results.size(); i++) {
+    const StageResult &r = stages.results[i];
+    double min = r.seconds[0];
+    for (size_t j = 1; j < r.seconds.size(); j++) min = std::min(min, r.seconds[j]);
+    cout << std::left << std::setw(20) << r.name << std::right
+         << std::fixed << std::setprecision(3) << std::setw(10)
+         << 1000.0 * min << " ms " << std::setw(12) << r.items << " items"
+         << endl;
+  }
+
+  std::ofstream out(output.c_str());
+  if (!out.good()) {
+    cerr << "Cannot write " << output << endl;
+    exit(-1);
+  }
+  writeJSON(out, dir, nscans, npoints, runs, stages);
+  out.close();
+  cout << "Results written to " << output << endl;
+
+  return 0;
+}
@@ -0,0 +1,262 @@
+/*
+ * buildTiles implementation
+ *
+ * Released under the GPL version 3.
+ *
+ */
+
+/**
+ * @file
+ * @brief Builds an out-of-core tile tree with levels of detail from
+ * registered scans
+ *
+ * The scans are streamed several times and transformed with their poses
+ * from the .frames or .pose files, so neither the scans nor the result have
+ * to fit into memory. The tree can be read back with the "tiles" format.
+ */
+
+#include <string>
+#include <iostream>
+#include <stdexcept>
+#include <algorithm>
+#include <cfloat>
+
+#include "slam6d/scan.h"
+#include "scanio/scan_io.h"
+#include "scanio/tile_tree.h"
+#include "scanio/framesreader.h"
+#include "slam6d/globals.icc"
+
+#include <boost/program_options.hpp>
+namespace po = boost::program_options;
+
+
+void validate(boost::any& v, const std::vector<std::string>& values,
+              IOType*, int) {
+  if (values.size() == 0)
+    throw std::runtime_error("Invalid model specification");
+  std::string arg = values.at(0);
+  try {
+    v = formatname_to_io_type(arg.c_str());
+  } catch (...) { // runtime_error
+    throw std::runtime_error("Format " + arg + " unknown.");
+  }
+}
+
+int parse_options(int argc, char **argv, std::string &dir, std::string &outdir,
+                  int &start, int &end, IOType &type, bool &use_pose,
+                  int &frame, int &maxDist, int &minDist,
+                  std::string &customFilter, double &step,
+                  size_t &node_points, size_t &chunk_points,
+                  size_t &buffer_points, size_t &stream_chunk)
+{
+  po::options_description generic("Generic options");
+  generic.add_options()
+    ("help,h", "output this help message");
+
+  po::options_description input("Input options");
+  input.add_options()
+    ("format,f", po::value<IOType>(&type)->default_value(UOS, "uos"),
+     "using shared library <arg> for input. (chose F from {uos, uos_map, "
+     "uos_rgb, uos_frames, uos_map_frames, old, rts, rts_map, ifp, "
+     "riegl_txt, riegl_rgb, riegl_bin, zahn, ply, las})")
+    ("start,s", po::value<int>(&start)->default_value(0),
+     "start at scan <arg> (i.e., neglects the first <arg> scans) "
+     "[ATTENTION: counting naturally starts with 0]")
+    ("end,e", po::value<int>(&end)->default_value(-1),
+     "end after scan <arg>")
+    ("trustpose,p", po::bool_switch(&use_pose)->default_value(false),
+     "Trust the pose file, do not use the transformation from the .frames files.")
+    ("frame,n", po::value<int>(&frame)->default_value(-1),
+     "uses frame NR for the poses")
+    ("min,M", po::value<int>(&minDist)->default_value(-1),
+     "neglegt all data points with a distance smaller than NR 'units'")
+    ("max,m", po::value<int>(&maxDist)->default_value(-1),
+     "neglegt all data points with a distance larger than NR 'units'")
+    ("customFilter,u", po::value<std::string>(&customFilter),
+     "Apply a custom filter. Filter mode and data are specified as a "
+     "semicolon-seperated string: {filterMode};{nrOfParams}[;param1][;param2][...]")
+    ("stream", po::value<size_t>(&stream_chunk)->default_value(1000000),
+     "read the scans in chunks of <arg> points");
+
+  po::options_description output("Output options");
+  output.add_options()
+    ("output,o", po::value<std::string>(&outdir)->required(),
+     "directory of the tile tree")
+    ("step", po::value<double>(&step)->default_value(0.1),
+     "quantization step of the coordinates in the units of the scans")
+    ("node-points", po::value<size_t>(&node_points)->default_value(50000),
+     "tiles with more points are split")
+    ("chunk-points", po::value<size_t>(&chunk_points)->default_value(5000000),
+     "number of points every thread holds in memory while splitting tiles")
+    ("buffer-points", po::value<size_t>(&buffer_points)->default_value(10000000),
+     "number of points buffered before they are written to disk");
+
+  po::options_description hidden("Hidden options");
+  hidden.add_options()
+    ("input-dir", po::value<std::string>(&dir), "input dir");
+
+  // all options
+  po::options_description all;
+  all.add(generic).add(input).add(output).add(hidden);
+
+  // options visible with --help
+  po::options_description cmdline_options;
+  cmdline_options.add(generic).add(input).add(output);
+
+  // positional argument
+  po::positional_options_description pd;
+  pd.add("input-dir", 1);
+
+  // process options
+  po::variables_map vm;
+  po::store(po::command_line_parser(argc, argv).
+            options(all).positional(pd).run(), vm);
+
+  // display help
+  if (vm.count("help")) {
+    std::cout << cmdline_options;
+    std::cout << std::endl
+         << "Example usage:" << std::endl
+         << "\t./bin/buildTiles -s 0 -e 1 -o /Your/tiles /Your/directory" << std::endl
+         << "\t./bin/show -f tiles -s 3 -e 3 /Your/tiles" << std::endl;
+    exit(0);
+  }
+  po::notify(vm);
+
+#ifndef _MSC_VER
+  if (dir[dir.length()-1] != '/') dir = dir + "/";
+#else
+  if (dir[dir.length()-1] != '\\') dir = dir + "\\";
+#endif
+
+  return 0;
+}
+
+/**
+ * The bounding box of all scans in global coordinates from the headers of
+ * the scan files, false if a format does not store one.
+ */
+bool header_bounds(IOType iotype, double *min, double *max)
+{
+  ScanIO* sio = ScanIO::getScanIO(iotype);
+  for (int k = 0; k < 3; k++) {
+    min[k] = DBL_MAX;
+    max[k] = -DBL_MAX;
+  }
+  for (size_t i = 0; i < Scan::allScans.size(); i++) {
+    Scan *scan = Scan::allScans[i];
+    std::string identifiers = scan->getIdentifier();
+    size_t pos;
+    do {
+      pos = identifiers.find_first_of(';');
+      std::string current_identifier = identifiers.substr(0, pos);
+      if (pos != std::string::npos) identifiers = identifiers.substr(pos + 1);
+
+      ScanHeader header;
+      if (!sio->readScanHeader(scan->getPath().c_str(),
+                               current_identifier.c_str(), header)
+          || !header.has_bbox) {
+        return false;
+      }
+      // the box around the transformed corners
+      for (int c = 0; c < 8; c++) {
+        double p[3] = { c & 4 ? header.max[0] : header.min[0],
+                        c & 2 ? header.max[1] : header.min[1],
+                        c & 1 ? header.max[2] : header.min[2] };
+        transform3(scan->get_transMat(), p);
+        for (int k = 0; k < 3; k++) {
+          min[k] = std::min(min[k], p[k]);
+          max[k] = std::max(max[k], p[k]);
+        }
+      }
+    } while (pos != std::string::npos);
+  }
+  return true;
+}
+
+/**
+ * Streams the points of a scan in global coordinates.
+ */
+void stream_scan(size_t i, IOType iotype, PointFilter &filter,
+                 size_t chunk_size, ScanChunkHandler handler)
+{
+  ScanIO* sio = ScanIO::getScanIO(iotype);
+  Scan *scan = Scan::allScans[i];
+  const double *transMat = scan->get_transMat();
+
+  std::string identifiers = scan->getIdentifier();
+  size_t pos;
+  do {
+    pos = identifiers.find_first_of(';');
+    std::string current_identifier = identifiers.substr(0, pos);
+    if (pos != std::string::npos) identifiers = identifiers.substr(pos + 1);
+
+    sio->readScanChunked(scan->getPath().c_str(), current_identifier.c_str(),
+        filter, chunk_size, [&](ScanChunk &chunk) -> bool {
+      size_t n = chunk.size();
+      transform3points(transMat, chunk.xyz.data(), n);
+      return handler(chunk);
+    });
+  } while (pos != std::string::npos);
+}
+
+int main(int argc, char **argv)
+{
+  std::string dir, outdir;
+  int start = 0, end = -1;
+  IOType iotype = UOS;
+  bool uP = false;
+  int frame = -1;
+  int maxDist = -1, minDist = -1;
+  std::string customFilter;
+  double step = 0.1;
+  size_t node_points, chunk_points, buffer_points, stream_chunk;
+
+  try {
+    parse_options(argc, argv, dir, outdir, start, end, iotype, uP, frame,
+                  maxDist, minDist, customFilter, step, node_points,
+                  chunk_points, buffer_points, stream_chunk);
+  } catch (std::exception& e) {
+    std::cerr << "Error while parsing settings: " << e.what() << std::endl;
+    exit(1);
+  }
+
+  Scan::openDirectory(false, dir, iotype, start, end);
+  if(Scan::allScans.size() == 0) {
+    std::cerr << "No scans found. Did you use the correct format?" << std::endl;
+    exit(-1);
+  }
+  // points are transformed while they are streamed
+  readFrames(dir, start, end, frame, uP);
+
+  PointFilter filter;
+  if (minDist > 0 || maxDist > 0) filter.setRange(maxDist, minDist);
+  if (customFilter.find_first_of(";") != std::string::npos)
+    filter.setCustom(customFilter);
+
+  try {
+    TileTreeWriter writer(outdir, step, node_points, chunk_points,
+                          buffer_points);
+    double min[3], max[3];
+    // the filters only drop points, so the boxes in the headers still hold
+    if (header_bounds(iotype, min, max)) {
+      writer.setBounds(min, max);
+    }
+    writer.build(Scan::allScans.size(),
+                 [&](size_t i, ScanChunkHandler handler) {
+      std::cout << "Streaming Scan No. " << i << std::endl;
+      stream_scan(i, iotype, filter, stream_chunk, handler);
+    });
+  } catch (std::exception& e) {
+    std::cerr << "Error while building the tile tree: " << e.what() << std::endl;
+    exit(1);
+  }
+
+  TileTree tree(outdir);
+  std::cout << "Wrote " << tree.countPoints(tree.getDepth()) << " points in "
+            << tree.getDepth() + 1 << " levels to " << outdir << std::endl;
+
+  Scan::closeDirectory();
+  return 0;
+}
@@ -22,6 +22,120 @@
 
 #include "slam6d/condense.h"
 
+/**
+ * Streaming variant of the loop in main. Every scan is read in chunks,
+ * transformed into the frame of the first scan of its MetaScan and merged
+ * into a voxel grid that is written and cleared once split scans are
+ * complete. Only one voxel grid is held in memory at a time, independent
+ * of the number and size of the scans.
+ */
+int condenseStream(const std::string &dir, IOType iotype, int minDist,
+                   int maxDist, const std::string &customFilter, double red,
+                   int octree, bool rm_scatter, int split, bool global,
+                   bool skip_empty, size_t stream_chunk, bool use_reflectance,
+                   bool use_xyz, bool use_color, bool hexfloat,
+                   bool high_precision, unsigned int types, double scaleFac)
+{
+  PointFilter filter;
+  if (minDist > 0 || maxDist > 0) filter.setRange(maxDist, minDist);
+  if (!customFilter.empty()) filter.setCustom(customFilter);
+
+  std::string save_dir = dir + "cond/";
+  if ( !existsDir( save_dir.c_str() ) )
+  {
+   boost::filesystem::create_directory(save_dir);
+   std::cout << "Creating \"" << save_dir << "\"." << std::endl;
+  } else std::cout << save_dir << " exists allready." << std::endl;
+
+  VoxelReducer reducer(red, octree, (rm_scatter && octree > 0) ? octree : 0);
+  std::vector<double> pts;
+  std::vector<float> refls;
+  std::vector<unsigned char> rgbs;
+  std::vector<int> point_source;
+
+  int k = 0; // count subscans
+  int seq = 0; // count subfiles
+  vector<std::string> sources; // all scans of the current MetaScan, also skipped ones
+  double ref[16], tinv[16], toRef[16];
+
+  // writes the current MetaScan and starts the next one
+  auto flush = [&]() {
+    std::string basename = save_dir + "scan" + to_string(seq, 3);
+    cout << "Creating scanfile " << basename << ".3d with "
+         << reducer.size() << " voxels" << endl;
+    reducer.getPoints(pts, &refls, &rgbs, &point_source);
+
+    std::ofstream ptsout((basename + ".3d").c_str(), std::ofstream::out | std::ofstream::trunc);
+    writeStreamedMetaScan(ptsout, pts, refls, rgbs, use_reflectance, use_xyz,
+        use_color, hexfloat, high_precision, types, scaleFac);
+    ptsout.close();
+
+    double rPos[3] = { 0.0, 0.0, 0.0 }, rPosTheta[3] = { 0.0, 0.0, 0.0 };
+    if (!global) Matrix4ToEuler(ref, rPosTheta, rPos);
+    std::ofstream poseout((basename + ".pose").c_str(), std::ofstream::out | std::ofstream::trunc);
+    if(use_xyz) {
+      writeXYZPose(poseout, rPos, rPosTheta, 0.01);
+    } else {
+      writeUOSPose(poseout, rPos, rPosTheta);
+    }
+    poseout.close();
+
+    std::ofstream srcout((basename + ".src").c_str(), std::ofstream::out | std::ofstream::trunc);
+    writeProvenance(srcout, sources, point_source);
+    srcout.close();
+
+    k = 0;
+    seq++;
+    sources.clear();
+    reducer.clear();
+    pts.clear();
+    refls.clear();
+    rgbs.clear();
+    point_source.clear();
+  };
+
+  for(unsigned int i = 0; i < Scan::allScans.size(); i++)
+  {
+    Scan *source = Scan::allScans[i];
+
+    // the first scan with points defines the frame of the MetaScan
+    if (k == 0) {
+      memcpy(ref, source->get_transMat(), sizeof(ref));
+      M4inv(ref, tinv);
+    }
+    if (global) {
+      memcpy(toRef, source->get_transMat(), sizeof(toRef));
+    } else {
+      MMult(tinv, source->get_transMat(), toRef);
+    }
+
+    std::cout << "Streaming scan" << source->getIdentifier() << ".3d" << std::endl;
+    size_t nr_points = streamScan(source, iotype, filter, stream_chunk, toRef,
+                                  reducer, sources.size());
+    sources.push_back(source->getIdentifier());
+    if (nr_points == 0 && skip_empty) {
+      std::cout << "scan" << source->getIdentifier() << " has no points. Skipping..." << std::endl;
+      continue;
+    }
+
+    if (++k == split) flush();
+  }
+
+  // Flush the rest.
+  if (k > 0) {
+    flush();
+  } else if (!sources.empty() && seq > 0) {
+    // only skipped scans are left, like atomize without provenance does it,
+    // they get the transformation of the last MetaScan
+    std::string srcpath = save_dir + "scan" + to_string(seq - 1, 3) + ".src";
+    std::ofstream srcout(srcpath.c_str(), std::ofstream::out | std::ofstream::app);
+    writeProvenance(srcout, sources, point_source);
+    srcout.close();
+  }
+
+  return 0;
+}
+
 int main(int argc, char **argv)
 {
   // parsing the command line parameters
@@ -51,11 +165,13 @@ int main(int argc, char **argv)
   bool global = false;
   bool rm_scatter = false;
   bool skip_empty = false;
+  size_t stream_chunk = 0;
 
   try {
     parse_options(argc, argv, dir, red, rand, start, end,
       maxDist, minDist, trustpose, use_xyz, use_reflectance, use_type, use_color, octree, iotype, customFilter, scaleFac,
-      hexfloat, high_precision, frame, use_normals, split, global, rm_scatter, skip_empty);
+      hexfloat, high_precision, frame, use_normals, split, global, rm_scatter, skip_empty,
+      stream_chunk);
   } catch (std::exception& e) {
     std::cerr << "Error while parsing settings: " << e.what() << std::endl;
     exit(1);
@@ -130,6 +246,21 @@ int main(int argc, char **argv)
   if(supportsColor(iotype)) types |= PointType::USE_COLOR;
   if(supportsType(iotype)) types |= PointType::USE_TYPE;
 
+  if (stream_chunk > 0) {
+    if (red <= 0) {
+      std::cerr << "Streaming needs a voxel size, use -r <arg>." << std::endl;
+      exit(1);
+    }
+    if (use_type || use_normals) {
+      std::cerr << "WARNING Types and normals are not exported while streaming" << std::endl;
+      use_type = use_normals = false;
+    }
+    return condenseStream(dir, iotype, minDist, maxDist, customFilterActive ?
+        customFilter : "", red, octree, rm_scatter, split, global, skip_empty,
+        stream_chunk, use_reflectance, use_xyz, use_color, hexfloat,
+        high_precision, types, scaleFac);
+  }
+
   // if specified, filter scans
   for (size_t i = 0; i < Scan::allScans.size(); i++)  {
      if(rangeFilterActive) Scan::allScans[i]->setRangeFilter(maxDist, minDist);
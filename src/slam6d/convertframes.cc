@@ -0,0 +1,57 @@
+/*
+ * convertframes implementation
+ *
+ * Released under the GPL version 3.
+ *
+ */
+
+/**
+ * @file
+ * @brief Converts .frames files between the text and the binary formats
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <cstring>
+using std::cout;
+using std::cerr;
+using std::endl;
+
+#include "slam6d/framesFile.h"
+
+void usage(char** argv)
+{
+  cout << "Usage: " << argv[0] << " [-f text|binary|delta] input output" << endl << endl;
+  cout << "  -f format  format of the output file, defaults to text" << endl << endl;
+  cout << "Reads a text or binary .frames file and writes its frames to output in the" << endl
+       << "given format. Input and output may be the same file." << endl;
+  exit(1);
+}
+
+int main(int argc, char** argv)
+{
+  FramesFormat format = FRAMES_TEXT;
+  int arg = 1;
+  if (argc > 2 && strcmp(argv[1], "-f") == 0) {
+    std::string name(argv[2]);
+    if (name == "text") format = FRAMES_TEXT;
+    else if (name == "binary") format = FRAMES_BINARY;
+    else if (name == "delta") format = FRAMES_BINARY_DELTA;
+    else usage(argv);
+    arg = 3;
+  }
+  if (argc - arg != 2) usage(argv);
+
+  try {
+    std::vector<Frame> frames;
+    FramesFile::read(argv[arg], frames);
+    FramesFile::write(argv[arg + 1], frames.data(), frames.size(), format);
+    cout << "Converted " << frames.size() << " frames" << endl;
+  } catch (const std::exception& e) {
+    cerr << e.what() << endl;
+    return 1;
+  }
+  return 0;
+}
@@ -24,6 +24,8 @@ using std::string;
 
 #include "slam6d/point.h"
 #include "slam6d/scan.h"
+#include "slam6d/voxelReducer.h"
+#include "scanio/scan_io.h"
 #include "scanio/writer.h"
 #include "scanio/framesreader.h"
 #include "slam6d/globals.icc"
@@ -54,7 +56,8 @@ void validate(boost::any& v, const std::vector<std::string>& values,
 int parse_options(int argc, char **argv, std::string &dir, double &red, int &rand,
             int &start, int &end, int &maxDist, int &minDist, bool &use_pose,
             bool &use_xyz, bool &use_reflectance, bool &use_type, bool &use_color, int &octree, IOType &type, std::string& customFilter, double &scaleFac,
-	    bool &hexfloat, bool &high_precision, int &frame, bool &use_normals)
+	    bool &hexfloat, bool &high_precision, int &frame, bool &use_normals,
+	    unsigned int &stream_chunk)
 {
 po::options_description generic("Generic options");
   generic.add_options()
@@ -104,7 +107,11 @@ po::options_description generic("Generic options");
     ("highprecision,H", po::bool_switch(&high_precision)->default_value(false),
      "export points with full double precision")
     ("frame,n", po::value<int>(&frame)->default_value(-1),
-     "uses frame NR for export");
+     "uses frame NR for export")
+    ("stream", po::value<unsigned int>(&stream_chunk)->default_value(0),
+     "read and export the scans in chunks of <arg> points instead of loading "
+     "them completely (0 = off). With --reduce, a voxel grid replaces the "
+     "octree and only reflectance and color are kept.");
 
   po::options_description hidden("Hidden options");
   hidden.add_options()
@@ -146,6 +153,127 @@ po::options_description generic("Generic options");
   return 0;
 }
 
+void write_trajectories(std::ofstream &posesout, std::ofstream &matricesout,
+                        const double *transMat, bool use_xyz, double scaleFac)
+{
+  if(use_xyz) {
+    writeTrajectoryXYZ(posesout, transMat, false, scaleFac);
+    writeTrajectoryXYZ(matricesout, transMat, true, scaleFac);
+  } else {
+    writeTrajectoryUOS(posesout, transMat, false, scaleFac*100.0);
+    writeTrajectoryUOS(matricesout, transMat, true, scaleFac*100.0);
+  }
+}
+
+/**
+ * writes the points of one chunk with the same channel selection as the
+ * export of whole scans, missing channels are filled with defaults
+ */
+void write_chunk(ScanChunk &chunk, FILE *redptsout, bool use_xyz,
+                 bool use_reflectance, bool use_type, bool use_color,
+                 bool use_normals, double scaleFac, bool hexfloat,
+                 bool high_precision)
+{
+  size_t n = chunk.size();
+  DataXYZ xyz(DataPointer((unsigned char*)chunk.xyz.data(),
+                          sizeof(double)*chunk.xyz.size()));
+
+  if(use_reflectance) {
+    if (chunk.reflectance.size() != n) chunk.reflectance.assign(n, 255);
+    DataReflectance xyz_reflectance(DataPointer(
+        (unsigned char*)chunk.reflectance.data(), sizeof(float)*n));
+    if(use_xyz) {
+      write_xyzr(xyz, xyz_reflectance, redptsout, scaleFac, hexfloat, high_precision);
+    } else {
+      write_uosr(xyz, xyz_reflectance, redptsout, scaleFac*100.0 , hexfloat, high_precision);
+    }
+  } else if(use_type) {
+    if (chunk.type.size() != n) chunk.type.assign(n, 0);
+    DataType xyz_type(DataPointer(
+        (unsigned char*)chunk.type.data(), sizeof(int)*n));
+    if(use_xyz) {
+      write_xyzc(xyz, xyz_type, redptsout, scaleFac, hexfloat, high_precision);
+    } else {
+      write_uosc(xyz, xyz_type, redptsout, scaleFac*100.0 , hexfloat, high_precision);
+    }
+  } else if(use_color) {
+    if (chunk.rgb.size() != 3*n) chunk.rgb.assign(3*n, 0);
+    DataRGB xyz_color(DataPointer(chunk.rgb.data(), 3*n));
+    if(use_xyz) {
+      write_xyz_rgb(xyz, xyz_color, redptsout, scaleFac, hexfloat, high_precision);
+    } else {
+      write_uos_rgb(xyz, xyz_color, redptsout, scaleFac*100.0, hexfloat, high_precision);
+    }
+  } else if(use_normals) {
+    if (chunk.normal.size() != 3*n) chunk.normal.assign(3*n, 0.0);
+    DataNormal normals(DataPointer(
+        (unsigned char*)chunk.normal.data(), sizeof(double)*3*n));
+    if(use_xyz) {
+      write_xyz_normal(xyz, normals, redptsout, scaleFac, hexfloat, high_precision);
+    } else {
+      write_uos_normal(xyz, normals, redptsout, scaleFac*100.0, hexfloat, high_precision);
+    }
+  } else {
+    if(use_xyz) {
+      write_xyz(xyz, redptsout, scaleFac, hexfloat, high_precision);
+    } else {
+      write_uos(xyz, redptsout, scaleFac*100.0, hexfloat, high_precision);
+    }
+  }
+}
+
+/**
+ * exports a scan without loading it into memory as a whole, the chunks are
+ * transformed with the scan's pose and written right away or fed into a
+ * voxel grid if a reduction is requested
+ */
+void export_scan_stream(Scan *source, const std::string &dir, IOType iotype,
+                        PointFilter &filter,
+                        size_t chunk_size, double red, int octree,
+                        FILE *redptsout, bool use_xyz, bool use_reflectance,
+                        bool use_type, bool use_color, bool use_normals,
+                        double scaleFac, bool hexfloat, bool high_precision)
+{
+  ScanIO* sio = ScanIO::getScanIO(iotype);
+  const double *transMat = source->get_transMat();
+  VoxelReducer reducer(red, octree);
+
+  std::string identifiers = source->getIdentifier();
+  size_t pos;
+  do {
+    pos = identifiers.find_first_of(';');
+    std::string current_identifier = identifiers.substr(0, pos);
+    if (pos != std::string::npos) identifiers = identifiers.substr(pos + 1);
+
+    sio->readScanChunked(dir.c_str(), current_identifier.c_str(),
+        filter, chunk_size, [&](ScanChunk &chunk) -> bool {
+      size_t n = chunk.size();
+      if (red > 0) {
+        // reduce in the local coordinate system like the octree does
+        reducer.add(chunk.xyz.data(),
+                    chunk.reflectance.size() == n ? chunk.reflectance.data() : 0,
+                    chunk.rgb.size() == 3*n ? chunk.rgb.data() : 0,
+                    n);
+        return true;
+      }
+      transform3points(transMat, chunk.xyz.data(), n);
+      write_chunk(chunk, redptsout, use_xyz, use_reflectance, use_type,
+                  use_color, use_normals, scaleFac, hexfloat, high_precision);
+      return true;
+    });
+  } while (pos != std::string::npos);
+
+  if (red > 0) {
+    ScanChunk reduced;
+    reducer.getPoints(reduced.xyz,
+        sio->supports(DATA_REFLECTANCE) ? &reduced.reflectance : 0,
+        sio->supports(DATA_RGB) ? &reduced.rgb : 0);
+    transform3points(transMat, reduced.xyz.data(), reduced.size());
+    write_chunk(reduced, redptsout, use_xyz, use_reflectance, use_type,
+                use_color, use_normals, scaleFac, hexfloat, high_precision);
+  }
+}
+
 /**
  * program for point export
  * Usage: bin/exportPoints 'dir',
@@ -177,11 +305,12 @@ int main(int argc, char **argv)
   bool hexfloat = false;
   bool high_precision = false;
   int frame = -1;
+  unsigned int stream_chunk = 0;
 
   try {
     parse_options(argc, argv, dir, red, rand, start, end,
       maxDist, minDist, uP, use_xyz, use_reflectance, use_type, use_color, octree, iotype, customFilter, scaleFac,
-      hexfloat, high_precision, frame, use_normals);
+      hexfloat, high_precision, frame, use_normals, stream_chunk);
   } catch (std::exception& e) {
     std::cerr << "Error while parsing settings: " << e.what() << std::endl;
     exit(1);
@@ -254,7 +383,7 @@ int main(int argc, char **argv)
   }
 
 //
-  int end_reduction = (int)Scan::allScans.size();
+  int end_reduction = stream_chunk > 0 ? 0 : (int)Scan::allScans.size();
 #ifdef _OPENMP
 #pragma omp parallel for schedule(dynamic)
 #endif
@@ -270,7 +399,12 @@ int main(int argc, char **argv)
     // reduction filter for current scan!
   }
 
-  readFramesAndTransform(dir, start, end, frame, uP, red > -1);
+  if (stream_chunk > 0) {
+    // points are transformed while they are streamed
+    readFrames(dir, start, end, frame, uP);
+  } else {
+    readFramesAndTransform(dir, start, end, frame, uP, red > -1);
+  }
 
  std::cout << "Export all 3D Points to file \"points.pts\"" << std::endl;
  std::cout << "Export all 6DoF poses to file \"positions.txt\"" << std::endl;
@@ -283,6 +417,19 @@ int main(int argc, char **argv)
     Scan *source = Scan::allScans[i];
     std::string red_string = red > 0 ? " reduced" : "";
 
+    if (stream_chunk > 0) {
+      PointFilter filter;
+      if(rangeFilterActive) filter.setRange(maxDist, minDist);
+      if(customFilterActive) filter.setCustom(customFilter);
+      std::cout << "Streaming Scan No. " << i << std::endl;
+      export_scan_stream(source, dir, iotype, filter, stream_chunk, red, octree,
+          redptsout, use_xyz, use_reflectance, use_type, use_color,
+          use_normals, scaleFac, hexfloat, high_precision);
+      write_trajectories(posesout, matricesout, source->get_transMat(),
+          use_xyz, scaleFac);
+      continue;
+    }
+
     DataXYZ xyz  = source->get("xyz" + red_string);
 
     if(use_reflectance) {
@@ -356,13 +503,8 @@ int main(int argc, char **argv)
       }
 
     }
-    if(use_xyz) {
-      writeTrajectoryXYZ(posesout, source->get_transMat(), false, scaleFac);
-      writeTrajectoryXYZ(matricesout, source->get_transMat(), true, scaleFac);
-    } else {
-      writeTrajectoryUOS(posesout, source->get_transMat(), false, scaleFac*100.0);
-      writeTrajectoryUOS(matricesout, source->get_transMat(), true, scaleFac*100.0);
-    }
+    write_trajectories(posesout, matricesout, source->get_transMat(),
+        use_xyz, scaleFac);
 
   }
 
@@ -0,0 +1,358 @@
+/*
+ * framesFile implementation
+ *
+ * Released under the GPL version 3.
+ *
+ */
+
+#include "slam6d/framesFile.h"
+#include "slam6d/globals.icc"
+
+#include <fstream>
+#include <sstream>
+#include <iterator>
+#include <stdexcept>
+#include <cstring>
+#include <cmath>
+#include <stdint.h>
+
+#ifdef WITH_MMAP_SCAN
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+static const char frames_magic[8] = { '3', 'D', 'T', 'K', 'F', 'R', 'M', 'S' };
+static const uint32_t frames_version = 1;
+
+struct FramesHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t key_interval;
+  uint64_t frames;
+  uint64_t records;
+  uint64_t index_offset;
+  uint64_t index_entries;
+};
+
+struct RecordHeader {
+  uint32_t kind;
+  uint32_t type;
+  uint64_t count;
+};
+
+struct IndexEntry {
+  uint64_t frame;
+  uint64_t offset;
+};
+
+enum RecordKind {
+  RECORD_MATRIX,
+  RECORD_REPEAT,
+  RECORD_DELTA
+};
+
+static size_t payloadSize(uint32_t kind)
+{
+  switch (kind) {
+  case RECORD_MATRIX: return 16 * sizeof(double);
+  case RECORD_REPEAT: return 0;
+  case RECORD_DELTA: return 7 * sizeof(double);
+  default: throw std::runtime_error("Unknown record in frames file");
+  }
+}
+
+/// apply a record to the pose of the previous frame
+static void applyRecord(uint32_t kind, const char* payload, double matrix[16])
+{
+  if (kind == RECORD_MATRIX) {
+    memcpy(matrix, payload, 16 * sizeof(double));
+  } else if (kind == RECORD_DELTA) {
+    double qt[7], delta[16], tmp[16];
+    memcpy(qt, payload, sizeof(qt));
+    QuatToMatrix4(qt, qt + 4, delta);
+    MMult(delta, matrix, tmp);
+    memcpy(matrix, tmp, sizeof(tmp));
+  }
+}
+
+FramesFile::FramesFile(const std::string& filename) :
+  m_data(0), m_size(0), m_frames(0), m_index_offset(0), m_index_entries(0)
+{
+#ifdef WITH_MMAP_SCAN
+  int fd = open(filename.c_str(), O_RDONLY);
+  if (fd == -1)
+    throw std::runtime_error("Cannot open " + filename);
+  struct stat st;
+  if (fstat(fd, &st) == -1) {
+    close(fd);
+    throw std::runtime_error("Cannot stat " + filename);
+  }
+  m_size = st.st_size;
+  if (m_size > 0) {
+    void* map = mmap(NULL, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED) {
+      close(fd);
+      throw std::runtime_error("Cannot mmap " + filename);
+    }
+    m_data = (const char*)map;
+  }
+  close(fd);
+#else
+  std::ifstream file(filename.c_str(), std::ios::binary);
+  if (!file.good())
+    throw std::runtime_error("Cannot open " + filename);
+  m_buffer.assign(std::istreambuf_iterator<char>(file),
+                  std::istreambuf_iterator<char>());
+  m_data = m_buffer.data();
+  m_size = m_buffer.size();
+#endif
+
+  FramesHeader header;
+  bool valid = m_size >= sizeof(header);
+  if (valid) {
+    memcpy(&header, m_data, sizeof(header));
+    valid = memcmp(header.magic, frames_magic, sizeof(frames_magic)) == 0
+      && header.version == frames_version
+      && header.index_offset >= sizeof(header)
+      && header.index_offset <= m_size
+      && header.index_entries <= (m_size - header.index_offset) / sizeof(IndexEntry)
+      && (header.frames == 0 || header.index_entries > 0);
+  }
+  if (!valid) {
+#ifdef WITH_MMAP_SCAN
+    if (m_data) munmap((void*)m_data, m_size);
+#endif
+    throw std::runtime_error(filename + " is no binary frames file");
+  }
+  m_frames = header.frames;
+  m_index_offset = header.index_offset;
+  m_index_entries = header.index_entries;
+}
+
+FramesFile::~FramesFile()
+{
+#ifdef WITH_MMAP_SCAN
+  if (m_data) munmap((void*)m_data, m_size);
+#endif
+}
+
+const char* FramesFile::record(size_t offset) const
+{
+  if (offset + sizeof(RecordHeader) > m_index_offset)
+    throw std::runtime_error("Truncated frames file");
+  return m_data + offset;
+}
+
+void FramesFile::get(size_t i, Frame& frame) const
+{
+  if (i >= m_frames)
+    throw std::runtime_error("Frame index out of range");
+
+  // last key frame at or before frame i
+  const char* index = m_data + m_index_offset;
+  size_t lo = 0, hi = m_index_entries;
+  while (hi - lo > 1) {
+    size_t mid = (lo + hi) / 2;
+    IndexEntry entry;
+    memcpy(&entry, index + mid * sizeof(IndexEntry), sizeof(entry));
+    if (entry.frame <= i) lo = mid;
+    else hi = mid;
+  }
+  IndexEntry key;
+  memcpy(&key, index + lo * sizeof(IndexEntry), sizeof(key));
+
+  double matrix[16];
+  size_t first = key.frame, offset = key.offset;
+  for (;;) {
+    RecordHeader rh;
+    memcpy(&rh, record(offset), sizeof(rh));
+    size_t payload = payloadSize(rh.kind);
+    if (offset + sizeof(rh) + payload > m_index_offset)
+      throw std::runtime_error("Truncated frames file");
+    applyRecord(rh.kind, m_data + offset + sizeof(rh), matrix);
+    if (i < first + rh.count) {
+      frame.set(matrix, rh.type);
+      return;
+    }
+    first += rh.count;
+    offset += sizeof(rh) + payload;
+  }
+}
+
+void FramesFile::getAll(std::vector<Frame>& frames) const
+{
+  frames.reserve(frames.size() + m_frames);
+  double matrix[16];
+  size_t offset = sizeof(FramesHeader);
+  while (offset < m_index_offset) {
+    RecordHeader rh;
+    memcpy(&rh, record(offset), sizeof(rh));
+    size_t payload = payloadSize(rh.kind);
+    if (offset + sizeof(rh) + payload > m_index_offset)
+      throw std::runtime_error("Truncated frames file");
+    applyRecord(rh.kind, m_data + offset + sizeof(rh), matrix);
+    for (uint64_t j = 0; j < rh.count; j++)
+      frames.push_back(Frame(matrix, rh.type));
+    offset += sizeof(rh) + payload;
+  }
+}
+
+bool FramesFile::isBinary(const std::string& filename)
+{
+  std::ifstream file(filename.c_str(), std::ios::binary);
+  char magic[sizeof(frames_magic)];
+  if (!file.read(magic, sizeof(magic))) return false;
+  return memcmp(magic, frames_magic, sizeof(magic)) == 0;
+}
+
+void FramesFile::read(const std::string& filename, std::vector<Frame>& frames)
+{
+  if (isBinary(filename)) {
+    FramesFile(filename).getAll(frames);
+    return;
+  }
+  std::ifstream file(filename.c_str());
+  std::string line;
+  while (getline(file, line)) {
+    // ignore empty and comment lines
+    if (line.length() == 0 || line[0] == '#') continue;
+    std::istringstream line_stream(line);
+    double transformation[16];
+    unsigned int type;
+    if (!(line_stream >> transformation >> type)) break;
+    frames.push_back(Frame(transformation, type));
+  }
+}
+
+/// append raw bytes to the output buffer
+static void put(std::vector<char>& out, const void* data, size_t size)
+{
+  const char* c = (const char*)data;
+  out.insert(out.end(), c, c + size);
+}
+
+/// whether the decoded pose matches the original one
+static bool closeEnough(const double* decoded, const double* original)
+{
+  for (int k = 0; k < 16; k++) {
+    if (!(fabs(decoded[k] - original[k]) <= 1e-9 * (1.0 + fabs(original[k]))))
+      return false;
+  }
+  return true;
+}
+
+static void encode(const Frame* frames, size_t n, bool delta,
+                   std::vector<char>& out)
+{
+  FramesHeader header;
+  memcpy(header.magic, frames_magic, sizeof(frames_magic));
+  header.version = frames_version;
+  header.key_interval = FramesFile::key_interval;
+  header.frames = n;
+  header.records = 0;
+  out.resize(sizeof(header));
+
+  std::vector<IndexEntry> index;
+  // the decoded pose the next delta refers to, may differ from the original
+  double decoded[16];
+  size_t last_record = 0, since_key = 0;
+  for (size_t i = 0; i < n; i++) {
+    const Frame& f = frames[i];
+    if (i > 0 && memcmp(f.transformation, frames[i - 1].transformation,
+                        sizeof(f.transformation)) == 0) {
+      if (f.type == frames[i - 1].type) {
+        // extend the run of the last record
+        RecordHeader rh;
+        memcpy(&rh, &out[last_record], sizeof(rh));
+        rh.count++;
+        memcpy(&out[last_record], &rh, sizeof(rh));
+        continue;
+      }
+      // repetitions count towards the key frame distance as well
+      if (since_key < FramesFile::key_interval) {
+        RecordHeader rh = { RECORD_REPEAT, f.type, 1 };
+        last_record = out.size();
+        put(out, &rh, sizeof(rh));
+        header.records++;
+        since_key++;
+        continue;
+      }
+    }
+
+    if (delta && i > 0 && since_key < FramesFile::key_interval) {
+      double inv[16], d[16], qt[7], dq[16], rec[16];
+      if (fabs(M4det(decoded)) > 1e-12) {
+        M4inv(decoded, inv);
+        MMult(f.transformation, inv, d);
+        Matrix4ToQuat(d, qt, qt + 4);
+        QuatToMatrix4(qt, qt + 4, dq);
+        MMult(dq, decoded, rec);
+        if (closeEnough(rec, f.transformation)) {
+          RecordHeader rh = { RECORD_DELTA, f.type, 1 };
+          last_record = out.size();
+          put(out, &rh, sizeof(rh));
+          put(out, qt, sizeof(qt));
+          header.records++;
+          since_key++;
+          memcpy(decoded, rec, sizeof(rec));
+          continue;
+        }
+      }
+    }
+
+    // key frame
+    IndexEntry entry = { i, out.size() };
+    index.push_back(entry);
+    RecordHeader rh = { RECORD_MATRIX, f.type, 1 };
+    last_record = out.size();
+    put(out, &rh, sizeof(rh));
+    put(out, f.transformation, sizeof(f.transformation));
+    header.records++;
+    since_key = 0;
+    memcpy(decoded, f.transformation, sizeof(decoded));
+  }
+
+  header.index_offset = out.size();
+  header.index_entries = index.size();
+  if (!index.empty()) put(out, &index[0], index.size() * sizeof(IndexEntry));
+  memcpy(&out[0], &header, sizeof(header));
+}
+
+void FramesFile::write(const std::string& filename, const Frame* frames,
+                       size_t n, FramesFormat format, bool append)
+{
+  // appending text to a binary file would corrupt it
+  if (format == FRAMES_TEXT && append && isBinary(filename))
+    format = FRAMES_BINARY;
+
+  if (format == FRAMES_TEXT) {
+    std::ofstream file(filename.c_str(),
+                       append ? std::ios_base::app : std::ios_base::out);
+    for (size_t i = 0; i < n; i++) {
+      file << frames[i].transformation << frames[i].type << '\n';
+    }
+    file << std::flush;
+    if (!file.good())
+      throw std::runtime_error("Cannot write " + filename);
+    return;
+  }
+
+  std::vector<char> out;
+  std::ifstream exists(filename.c_str());
+  if (append && exists.good()) {
+    exists.close();
+    std::vector<Frame> all;
+    read(filename, all);
+    all.insert(all.end(), frames, frames + n);
+    encode(all.data(), all.size(), format == FRAMES_BINARY_DELTA, out);
+  } else {
+    encode(frames, n, format == FRAMES_BINARY_DELTA, out);
+  }
+
+  std::ofstream file(filename.c_str(), std::ios_base::out | std::ios_base::binary);
+  file.write(out.data(), out.size());
+  if (!file.good())
+    throw std::runtime_error("Cannot write " + filename);
+}
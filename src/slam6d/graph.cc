@@ -19,6 +19,8 @@
 #include "slam6d/graph.h"
 
 #include "slam6d/scan.h"
+#include "slam6d/poseIndex.h"
+#include "slam6d/profiler.h"
 #include "slam6d/globals.icc"
 
 #include <fstream>
@@ -107,6 +109,7 @@ Graph::Graph(int nScans, bool loop)
 
 Graph::Graph(int nodes, double cldist2, int loopsize)
 {
+  ProfileScope profile(PROFILE_LOOP_DETECTION);
   // nodes + 1
   start = 0;
   nrScans = nodes;
@@ -117,16 +120,23 @@ Graph::Graph(int nodes, double cldist2, int loopsize)
     to.push_back(i + 1);
   }
 
-  // nodes
+  // link every scan to the later ones close to it, the scans are all
+  // part of the chain above already
+  PoseIndex index(sqrt(cldist2));
   for (int j = 0; j < nodes; j++) {
-    for (int k = j + 1; k < nodes; k++) {
-      if ((abs(k-j) > loopsize) &&
-          (Dist2(Scan::allScans[j]->get_rPos(),
-                 Scan::allScans[k]->get_rPos()) < cldist2)) {
-        addLink(j, k);
+    index.insert(j);
+  }
+  std::vector<int> close;
+  for (int j = 0; j < nodes; j++) {
+    index.radiusSearch(Scan::allScans[j]->get_rPos(), cldist2, close);
+    for (size_t i = 0; i < close.size(); i++) {
+      if (close[i] > j && close[i] - j > loopsize) {
+        from.push_back(j);
+        to.push_back(close[i]);
       }
     }
   }
+  Profiler::addCount(PROFILE_LOOP_DETECTION, -1, from.size() - nrLinks);
 }
 
 
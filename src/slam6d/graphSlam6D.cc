@@ -24,6 +24,7 @@
 #endif
 
 #include "slam6d/graphSlam6D.h"
+#include "slam6d/profiler.h"
 
 #include <cfloat>
 #include <fstream>
@@ -97,6 +98,9 @@ void graphSlam6D::matchGraph6Dautomatic(vector <Scan *> allScans,
     if (gr) delete gr;
     gr = new Graph(0, false);
     int j, maxj = (int)allScans.size();
+    // the links found for every scan, added to the graph in the order of
+    // the scans so it does not depend on the scheduling of the threads
+    vector<vector<int> > links(maxj);
 #ifdef _OPENMP
     omp_set_num_threads(OPENMP_NUM_THREADS);
 #pragma omp parallel for schedule(dynamic)
@@ -119,13 +123,15 @@ void graphSlam6D::matchGraph6Dautomatic(vector <Scan *> allScans,
             my_icp->get_rnd(), max_dist_match2_LUM, sum_dummy,
             centroid_m, centroid_d);
         if ((int)temp.size() > clpairs) {
-#ifdef _OPENMP
-#pragma omp critical
-#endif
-          gr->addLink(j, k);
+          links[j].push_back(k);
         }
       }
     }
+    for (j = 0; j < maxj; j++) {
+      for (size_t l = 0; l < links[j].size(); l++) {
+        gr->addLink(j, links[j][l]);
+      }
+    }
     cout << "done" << endl;
   } while ((doGraphSlam6D(*gr, allScans, 1) > 0.001) && (i < nrIt));
 
@@ -146,6 +152,9 @@ Graph *graphSlam6D::computeGraph6Dautomatic(vector <Scan *> allScans,
   i++;
   Graph *gr = new Graph(0, false);
   int j, maxj = (int)allScans.size();
+  // the links found for every scan, added to the graph in the order of the
+  // scans so it does not depend on the scheduling of the threads
+  vector<vector<int> > links(maxj);
 #ifdef _OPENMP
   omp_set_num_threads(OPENMP_NUM_THREADS);
 #pragma omp parallel for schedule(dynamic)
@@ -156,6 +165,7 @@ Graph *graphSlam6D::computeGraph6Dautomatic(vector <Scan *> allScans,
 #else
     int thread_num = 0;
 #endif
+    ProfileScope profile(PROFILE_LOOP_DETECTION, allScans[j]->scanNr);
     for (int k = 0; k < (int)allScans.size(); k++) {
       if (j == k) continue;
       Scan * FirstScan  = allScans[j];
@@ -168,13 +178,16 @@ Graph *graphSlam6D::computeGraph6Dautomatic(vector <Scan *> allScans,
           my_icp->get_rnd(), max_dist_match2_LUM, sum_dummy,
           centroid_m, centroid_d);
       if ((int)temp.size() > clpairs) {
-#ifdef _OPENMP
-#pragma omp critical
-#endif
-        gr->addLink(j, k);
+        links[j].push_back(k);
+        Profiler::addCount(PROFILE_LOOP_DETECTION, allScans[j]->scanNr, 1);
       }
     }
   }
+  for (j = 0; j < maxj; j++) {
+    for (size_t l = 0; l < links[j].size(); l++) {
+      gr->addLink(j, links[j][l]);
+    }
+  }
   cout << "done" << endl;
 
   return gr;
@@ -304,12 +317,14 @@ ColumnVector graphSlam6D::solveSparseCholesky(const Matrix &G,
 {
 
   long starttime = GetCurrentTimeInMilliSec();
+  ProfileScope profile(PROFILE_GRAPH_SOLVE);
 
 #ifdef WRITE_MATRIX_PGM
   writeMatrixPGM(G);
 #endif
 
   int n = G.Ncols();
+  Profiler::addCount(PROFILE_GRAPH_SOLVE, -1, n);
 
   // ------------------------------
   // Sparse Cholsekey decomposition
@@ -347,8 +362,10 @@ ColumnVector graphSlam6D::solveSparseCholesky(GraphMatrix *G,
 {
 
   long starttime = GetCurrentTimeInMilliSec();
+  ProfileScope profile(PROFILE_GRAPH_SOLVE);
 
   int n = B.Nrows();
+  Profiler::addCount(PROFILE_GRAPH_SOLVE, -1, n);
   ColumnVector X(n);
 
   // ------------------------------
@@ -18,6 +18,7 @@
 #include "slam6d/icp6D.h"
 
 #include "slam6d/metaScan.h"
+#include "slam6d/profiler.h"
 #include "slam6d/globals.icc"
 
 #include <iomanip>
@@ -90,6 +91,7 @@ icp6D::icp6D(icp6Dminimizer *my_icp6Dminimizer, double max_dist_match,
   this->cad_matching = cad_matching;
 
   this->max_num_metascans = max_num_metascans;
+  this->deferred_transform = false;
 
   //set the number of point pairs to zero
   nr_pointPair = 0;
@@ -113,6 +115,8 @@ int icp6D::match(Scan* PreviousScan, Scan* CurrentScan,
     return 0;
   }
 
+  if (deferred_transform) CurrentScan->deferReducedTransform();
+
   // icp main loop
   double ret = 0.0, prev_ret = 0.0, prev_prev_ret = 0.0;
   int iter = 0;
@@ -159,6 +163,7 @@ int icp6D::match(Scan* PreviousScan, Scan* CurrentScan,
 #pragma omp parallel
     {
       int thread_num = omp_get_thread_num();
+      ProfileScope profile(PROFILE_CORRESPONDENCES, CurrentScan->scanNr);
 
       Scan::getPtPairsParallel(pairs, PreviousScan, CurrentScan,
 			       thread_num, step,
@@ -198,8 +203,10 @@ int icp6D::match(Scan* PreviousScan, Scan* CurrentScan,
     }
     //add the number of point pair
     nr_pointPair = pairssize;
+    Profiler::addCount(PROFILE_CORRESPONDENCES, CurrentScan->scanNr, pairssize);
 
     if (pairssize > 3) {
+      ProfileScope profile(PROFILE_MINIMIZATION, CurrentScan->scanNr);
       if ((my_icp6Dminimizer->getAlgorithmID() == 1) ||
           (my_icp6Dminimizer->getAlgorithmID() == 2) ) {
         ret = my_icp6Dminimizer->Align_Parallel(OPENMP_NUM_THREADS,
@@ -226,14 +233,19 @@ int icp6D::match(Scan* PreviousScan, Scan* CurrentScan,
     double centroid_d[3] = {0.0, 0.0, 0.0};
     vector<PtPair> pairs;
 
-    Scan::getPtPairs(&pairs, PreviousScan, CurrentScan, 0, rnd,
-		     max_dist_match2, ret, centroid_m, centroid_d, pairing_mode);
+    {
+      ProfileScope profile(PROFILE_CORRESPONDENCES, CurrentScan->scanNr);
+      Scan::getPtPairs(&pairs, PreviousScan, CurrentScan, 0, rnd,
+                       max_dist_match2, ret, centroid_m, centroid_d, pairing_mode);
+    }
 
     //set the number of point paira
     nr_pointPair = pairs.size();
+    Profiler::addCount(PROFILE_CORRESPONDENCES, CurrentScan->scanNr, pairs.size());
 
     // do we have enough point pairs?
     if (pairs.size() > 3) {
+      ProfileScope profile(PROFILE_MINIMIZATION, CurrentScan->scanNr);
       if (my_icp6Dminimizer->getAlgorithmID() == 3 ||
 	  my_icp6Dminimizer->getAlgorithmID() == 8 ) {
         memcpy(alignxf, CurrentScan->get_transMat(), sizeof(alignxf));
@@ -279,6 +291,8 @@ int icp6D::match(Scan* PreviousScan, Scan* CurrentScan,
     }
   }
 
+  if (deferred_transform) CurrentScan->applyReducedTransform();
+
   long endtime = GetCurrentTimeInMilliSec() - time;
   cout << "TIME  " << endtime << "   ITER " << iter <<  endl;
   return iter;
@@ -78,6 +78,7 @@ IOType formatname_to_io_type(const char * string)
   else if (strcasecmp(string, "uos_normal") == 0) return UOS_NORMAL;
   else if (strcasecmp(string, "xyzc") == 0) return XYZC;
   else if (strcasecmp(string, "uosc") == 0) return UOSC;
+  else if (strcasecmp(string, "tiles") == 0) return TILES;
   else throw std::runtime_error(std::string("Io type ") + string + std::string(" is unknown"));
 }
 
@@ -192,6 +193,8 @@ const char * io_type_to_libname(IOType  type)
     return "scan_io_xyzc";
   case UOSC:
     return "scan_io_uosc";
+  case TILES:
+    return "scan_io_tiles";
   default:
     throw std::runtime_error(std::string("Io type ") + to_string(type) + std::string(" could not be matched to a library name"));
   }
@@ -211,6 +214,7 @@ bool supportsReflectance(const IOType iotype) {
     case XYZ_RRGB:
     case FARO_XYZ_RGBR:
     case LEICA_XYZR:
+    case TILES:
       return true;
       break;
     default:
@@ -228,6 +232,7 @@ bool supportsColor(const IOType iotype) {
     case XYZ_RGB:
     case KS_RGB:
     case PLY:
+    case TILES:
       return true;
       break;
     default:
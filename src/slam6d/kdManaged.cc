@@ -38,9 +38,9 @@ KDParams<PointType> KDTreeImpl<PointData, AccessorData, AccessorFunc, PointType,
 KDtreeManaged::KDtreeManaged(Scan* scan) :
   m_scan(scan), m_data(0), m_count_locking(0)
 {
-  create(scan->get("xyz reduced original"),
-         prepareTempIndices(scan->size<DataXYZ>("xyz reduced original")),
-         scan->size<DataXYZ>("xyz reduced original"),
+  create(scan->get(Scan::FIELD_XYZ_REDUCED_ORIGINAL),
+         prepareTempIndices(scan->size<DataXYZ>(Scan::FIELD_XYZ_REDUCED_ORIGINAL)),
+         scan->size<DataXYZ>(Scan::FIELD_XYZ_REDUCED_ORIGINAL),
          scan->getBucketSize());
   // allocate in prepareTempIndices, deleted here
   delete[] m_temp_indices;
@@ -84,7 +84,7 @@ void KDtreeManaged::lock()
   ++m_count_locking;
   if(m_data == 0) {
     // aquire an array lock from the scan and hold it while the tree is in use
-    m_data = new DataXYZ(m_scan->get("xyz reduced original"));
+    m_data = new DataXYZ(m_scan->get(Scan::FIELD_XYZ_REDUCED_ORIGINAL));
   }
 }
 
@@ -62,7 +62,7 @@ Index* KDtreeMetaManaged::prepareTempIndices(const std::vector<Scan*>& scans)
 
   m_temp_indices = new Index[n];
   unsigned int s = 0, j = 0;
-  unsigned int scansize = scans[s]->size<DataXYZ>("xyz reduced");
+  unsigned int scansize = scans[s]->size<DataXYZ>(Scan::FIELD_XYZ_REDUCED);
   for(unsigned int i = 0; i < n; ++i) {
     m_temp_indices[i].set(s, j++);
     // switch to next scan
@@ -70,7 +70,7 @@ Index* KDtreeMetaManaged::prepareTempIndices(const std::vector<Scan*>& scans)
       ++s;
       j = 0;
       if(s < scans.size())
-        scansize = scans[s]->size<DataXYZ>("xyz reduced");
+        scansize = scans[s]->size<DataXYZ>(Scan::FIELD_XYZ_REDUCED);
     }
   }
   return m_temp_indices;
@@ -80,7 +80,7 @@ unsigned int KDtreeMetaManaged::getPointsSize(const std::vector<Scan*>& scans)
 {
   unsigned int n = 0;
   for(std::vector<Scan*>::const_iterator it = scans.begin(); it != scans.end(); ++it) {
-    n += (*it)->size<DataXYZ>("xyz reduced");
+    n += (*it)->size<DataXYZ>(Scan::FIELD_XYZ_REDUCED);
   }
   return n;
 }
@@ -115,7 +115,7 @@ void KDtreeMetaManaged::lock()
   if(m_count_locking == 0) {
     // lock all the contained scans, metascan uses the transformed points
     for(unsigned int i = 0; i < m_size; ++i) {
-      m_data[i] = new DataXYZ(m_scans[i]->get("xyz reduced"));
+      m_data[i] = new DataXYZ(m_scans[i]->get(Scan::FIELD_XYZ_REDUCED));
     }
   }
   ++m_count_locking;
@@ -267,36 +267,42 @@ void lum6DEuler::FillGB3D(Graph *gr,
                           ColumnVector* B,
                           vector<Scan *> allScans )
 {
+  int nrLinks = gr->getNrLinks();
+
+  // the blocks of the links are computed in parallel and added to G and B
+  // in the order of the links afterwards, so the system of equations does
+  // not depend on the scheduling of the threads
+  vector<Matrix> C(nrLinks);
+  vector<ColumnVector> CD(nrLinks);
 #ifdef _OPENMP
 #pragma omp parallel for schedule(dynamic)
 #endif
-  for(int i = 0; i < gr->getNrLinks(); i++){
-    int a = gr->getLink(i,0) - 1;
-    int b = gr->getLink(i,1) - 1;
+  for(int i = 0; i < nrLinks; i++){
     Scan *FirstScan  = allScans[gr->getLink(i,0)];
     Scan *SecondScan = allScans[gr->getLink(i,1)];
 
-    Matrix Cab(6,6);
-    ColumnVector CDab(6);
+    C[i].ReSize(6,6);
+    CD[i].ReSize(6);
     covarianceEuler(FirstScan, SecondScan,
                     nns_method, (int)my_icp->get_rnd(),
-                    max_dist_match2_LUM, &Cab, &CDab);
+                    max_dist_match2_LUM, &C[i], &CD[i]);
+  }
 
-#pragma omp critical
-    {
-      if(a >= 0){
-        B->Rows(a*6+1,a*6+6) += CDab;
-        G->add(a, a, Cab);
-      }
-      if(b >= 0){
-        B->Rows(b*6+1,b*6+6) -= CDab;
-        G->add(b, b, Cab);
-      }
-      if(a >= 0 && b >= 0) {
-        G->subtract(a, b, Cab);
-        G->subtract(b, a, Cab);
-      }
+  for(int i = 0; i < nrLinks; i++){
+    int a = gr->getLink(i,0) - 1;
+    int b = gr->getLink(i,1) - 1;
 
+    if(a >= 0){
+      B->Rows(a*6+1,a*6+6) += CD[i];
+      G->add(a, a, C[i]);
+    }
+    if(b >= 0){
+      B->Rows(b*6+1,b*6+6) -= CD[i];
+      G->add(b, b, C[i]);
+    }
+    if(a >= 0 && b >= 0) {
+      G->subtract(a, b, C[i]);
+      G->subtract(b, a, C[i]);
     }
   }
   //  G->print();
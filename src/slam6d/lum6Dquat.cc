@@ -246,31 +246,41 @@ void lum6DQuat::covarianceQuat(Scan *first, Scan *second,
 void lum6DQuat::FillGB3D(Graph *gr,Matrix* G,
                          ColumnVector* B, vector<Scan *> allScans)
 {
+  int nrLinks = gr->getNrLinks();
+
+  // the blocks of the links are computed in parallel and written to G and B
+  // in the order of the links afterwards, the threads must not modify G and
+  // B at the same time
+  vector<Matrix> C(nrLinks);
+  vector<ColumnVector> CD(nrLinks);
 #ifdef _OPENMP
-#pragma omp parallel for
+#pragma omp parallel for schedule(dynamic)
 #endif
-  for(int i = 0; i < gr->getNrLinks(); i++){
-    int a = gr->getLink(i,0) - 1;
-    int b = gr->getLink(i,1) - 1;
+  for(int i = 0; i < nrLinks; i++){
     Scan *FirstScan  = allScans[gr->getLink(i,0)];
     Scan *SecondScan = allScans[gr->getLink(i,1)];
 
-    Matrix Cab;
-    ColumnVector CDab;
+    C[i].ReSize(7,7);
+    CD[i].ReSize(7);
     covarianceQuat(FirstScan, SecondScan, nns_method, (int)my_icp->get_rnd(),
-                   max_dist_match2_LUM, &Cab, &CDab);
+                   max_dist_match2_LUM, &C[i], &CD[i]);
+  }
+
+  for(int i = 0; i < nrLinks; i++){
+    int a = gr->getLink(i,0) - 1;
+    int b = gr->getLink(i,1) - 1;
 
     if(a >= 0){
-      B->Rows(a*7+1,a*7+7) += CDab;
-      G->SubMatrix(a*7+1,a*7+7,a*7+1,a*7+7) += Cab;
+      B->Rows(a*7+1,a*7+7) += CD[i];
+      G->SubMatrix(a*7+1,a*7+7,a*7+1,a*7+7) += C[i];
     }
     if(b >= 0){
-      B->Rows(b*7+1,b*7+7) -= CDab;
-      G->SubMatrix(b*7+1,b*7+7,b*7+1,b*7+7) += Cab;
+      B->Rows(b*7+1,b*7+7) -= CD[i];
+      G->SubMatrix(b*7+1,b*7+7,b*7+1,b*7+7) += C[i];
     }
     if(a >= 0 && b >= 0) {
-      G->SubMatrix(a*7+1,a*7+7,b*7+1,b*7+7) = -Cab;
-      G->SubMatrix(b*7+1,b*7+7,a*7+1,a*7+7) = -Cab;
+      G->SubMatrix(a*7+1,a*7+7,b*7+1,b*7+7) = -C[i];
+      G->SubMatrix(b*7+1,b*7+7,a*7+1,a*7+7) = -C[i];
     }
   }
 }
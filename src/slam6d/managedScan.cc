@@ -12,6 +12,7 @@
 #include "scanserver/clientInterface.h"
 #include "slam6d/Boctree.h"
 #include "slam6d/kdManaged.h"
+#include "slam6d/uniformGrid.h"
 
 #ifdef WITH_METRICS
 #include "slam6d/metrics.h"
@@ -293,6 +294,11 @@ void ManagedScan::createSearchTreePrivate()
          size<DataXYZ>("xyz reduced original"),
          10.0, PointType(), true);
       break;
+    case UniformGrid:
+      kd = new UniformGridSearch
+        (PointerArray<double>(get("xyz reduced original")).get(),
+         size<DataXYZ>("xyz reduced original"));
+      break;
     case -1:
       throw std::runtime_error("Cannot create a SearchTree without setting a type.");
     default:
@@ -418,7 +424,7 @@ size_t ManagedScan::readFrames()
 
 void ManagedScan::saveFrames(bool append)
 {
-  m_shared_scan->saveFrames(append);
+  m_shared_scan->saveFrames(append, frames_format);
 }
 
 size_t ManagedScan::getFrameCount()
@@ -21,14 +21,62 @@
 #include "slam6d/io_types.h"
 #include "slam6d/globals.icc"
 #include "slam6d/kd.h"
-#include "newmat/newmat.h"
-#include "newmat/newmatap.h"
 
 #include "slam6d/normals.h"
 
-using namespace NEWMAT;
+#include <cmath>
+#include <algorithm>
+
 using namespace std;
 
+/**
+ * Mean centered covariance of n points accessed by get(j, p)
+ */
+template <class Get>
+static inline void covariance(size_t n, Get get, double cov[6])
+{
+  double mean[3] = { 0.0, 0.0, 0.0 };
+  double p[3];
+  for (size_t j = 0; j < n; ++j) {
+    get(j, p);
+    mean[0] += p[0];
+    mean[1] += p[1];
+    mean[2] += p[2];
+  }
+  mean[0] /= n;
+  mean[1] /= n;
+  mean[2] /= n;
+
+  for (int j = 0; j < 6; ++j) cov[j] = 0.0;
+  for (size_t j = 0; j < n; ++j) {
+    get(j, p);
+    double dx = p[0] - mean[0];
+    double dy = p[1] - mean[1];
+    double dz = p[2] - mean[2];
+    cov[0] += dx * dx;
+    cov[1] += dx * dy;
+    cov[2] += dx * dz;
+    cov[3] += dy * dy;
+    cov[4] += dy * dz;
+    cov[5] += dz * dz;
+  }
+  for (int j = 0; j < 6; ++j) cov[j] /= n;
+}
+
+/**
+ * Flip the normal n towards the scanner at rPos as seen from point p
+ * and normalize it
+ */
+static inline Point orientNormal(const double n[3], const double p[3],
+                                 const double rPos[3])
+{
+  double v[3] = { p[0] - rPos[0], p[1] - rPos[1], p[2] - rPos[2] };
+  double sign = (n[0] * v[0] + n[1] * v[1] + n[2] * v[2] < 0) ? -1.0 : 1.0;
+  double len = sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+  sign /= len;
+  return Point(sign * n[0], sign * n[1], sign * n[2]);
+}
+
 ///////////////////////////////////////////////////////
 /////////////NORMALS USING AKNN METHOD ////////////////
 ///////////////////////////////////////////////////////
@@ -40,10 +88,6 @@ void calculateNormalsApxKNN(vector<Point> &normals,
 {
   int nr_neighbors = k;
 
-  ColumnVector rPos(3);
-  for (int i = 0; i < 3; ++i)
-    rPos(i + 1) = _rPos[i];
-
   ANNpointArray pa = annAllocPts(points.size(), 3);
   for (size_t i = 0; i < points.size(); ++i) {
     pa[i][0] = points[i].x;
@@ -52,61 +96,54 @@ void calculateNormalsApxKNN(vector<Point> &normals,
 
   }
   ANNkd_tree t(pa, points.size(), 3);
-  ANNidxArray nidx = new ANNidx[nr_neighbors];
-  ANNdistArray d = new ANNdist[nr_neighbors];
 
-  for (size_t i = 0; i < points.size(); ++i) {
-    ANNpoint p = pa[i];
-    // ANN search for k nearest neighbors
-    // indexes of the neighbors along with the query point
-    // stored in the array n
-    t.annkSearch(p, nr_neighbors, nidx, d, eps);
-    Point mean(0.0, 0.0, 0.0);
-    Matrix X(nr_neighbors, 3);
-    SymmetricMatrix A(3);
-    Matrix U(3, 3);
-    DiagonalMatrix D(3);
-    // calculate mean for all the points
-    for (int j = 0; j < nr_neighbors; ++j) {
-      mean.x += points[nidx[j]].x;
-      mean.y += points[nidx[j]].y;
-      mean.z += points[nidx[j]].z;
-    }
-    mean.x /= nr_neighbors;
-    mean.y /= nr_neighbors;
-    mean.z /= nr_neighbors;
-    // calculate covariance = A for all the points
-    for (int i = 0; i < nr_neighbors; ++i) {
-      X(i + 1, 1) = points[nidx[i]].x - mean.x;
-      X(i + 1, 2) = points[nidx[i]].y - mean.y;
-      X(i + 1, 3) = points[nidx[i]].z - mean.z;
-    }
+  // the covariances of a batch of points are collected first and then
+  // decomposed in one go
+  const size_t batch = 256;
+  long nr_batches = (points.size() + batch - 1) / batch;
+
+  size_t base = normals.size();
+  normals.resize(base + points.size());
+
+#ifdef _OPENMP
+  omp_set_num_threads(OPENMP_NUM_THREADS);
+#endif
+  #pragma omp parallel
+  {
+    // scratch buffers of this thread
+    vector<ANNidx> nidx(nr_neighbors);
+    vector<ANNdist> d(nr_neighbors);
+    vector<double> cov(6 * batch);
+    vector<double> norm(3 * batch);
+    vector<double> eigen(3 * batch);
+
+    #pragma omp for schedule(dynamic)
+    for (long b = 0; b < nr_batches; ++b) {
+      size_t start = b * batch;
+      size_t end = std::min(start + batch, points.size());
+      for (size_t i = start; i < end; ++i) {
+        // ANN search for k nearest neighbors
+        // indexes of the neighbors along with the query point
+        // stored in the array n
+        t.annkSearch(pa[i], nr_neighbors, nidx.data(), d.data(), eps);
+        covariance(nr_neighbors,
+                   [&](size_t j, double *q) {
+                     q[0] = points[nidx[j]].x;
+                     q[1] = points[nidx[j]].y;
+                     q[2] = points[nidx[j]].z;
+                   },
+                   &cov[6 * (i - start)]);
+      }
+
+      calculateNormalsCovariance(end - start, cov.data(), norm.data(),
+                                 eigen.data());
 
-    A << 1.0 / nr_neighbors * X.t() * X;
-
-    EigenValues(A, D, U);
-
-    // normal = eigenvector corresponding to lowest
-    // eigen value that is the 1st column of matrix U
-    ColumnVector n(3);
-    n(1) = U(1, 1);
-    n(2) = U(2, 1);
-    n(3) = U(3, 1);
-    ColumnVector point_vector(3);
-    point_vector(1) = p[0] - rPos(1);
-    point_vector(2) = p[1] - rPos(2);
-    point_vector(3) = p[2] - rPos(3);
-    point_vector = point_vector / point_vector.NormFrobenius();
-    Real angle = (n.t() * point_vector).AsScalar();
-    if (angle < 0) {
-      n *= -1.0;
+      for (size_t i = start; i < end; ++i) {
+        normals[base + i] = orientNormal(&norm[3 * (i - start)], pa[i], _rPos);
+      }
     }
-    n = n / n.NormFrobenius();
-    normals.push_back(Point(n(1), n(2), n(3)));
   }
 
-  delete[] nidx;
-  delete[] d;
   annDeallocPts(pa);
 }
 
@@ -124,11 +161,6 @@ void calculateNormalsAdaptiveApxKNN(vector<Point> &normals,
     throw std::invalid_argument("kmin must not be larger than kmax");
   }
 
-  ColumnVector rPos(3);
-  for (int i = 0; i < 3; ++i)
-    rPos(i + 1) = _rPos[i];
-
-  int nr_neighbors;
   ANNpointArray pa = annAllocPts(points.size(), 3);
   for (size_t i = 0; i < points.size(); ++i) {
     pa[i][0] = points[i].x;
@@ -137,76 +169,47 @@ void calculateNormalsAdaptiveApxKNN(vector<Point> &normals,
   }
   ANNkd_tree t(pa, points.size(), 3);
 
-  Point mean(0.0, 0.0, 0.0);
-  double e1, e2, e3;
+  size_t base = normals.size();
+  normals.resize(base + points.size());
 
-  for (size_t i = 0; i < points.size(); ++i) {
-    Matrix U(3, 3);
-    ANNpoint p = pa[i];
-    for (int kidx = kmin; kidx <= kmax; kidx++) {
-      nr_neighbors = kidx + 1;
-      ANNidxArray nidx = new ANNidx[nr_neighbors];
-      ANNdistArray d = new ANNdist[nr_neighbors];
-      // ANN search for k nearest neighbors
-      // indexes of the neighbors along with the query point
-      // stored in the array n
-      t.annkSearch(p, nr_neighbors, nidx, d, eps);
-      mean.x = 0, mean.y = 0, mean.z = 0;
-      // calculate mean for all the points
-      for (int j = 0; j < nr_neighbors; ++j) {
-        mean.x += points[nidx[j]].x;
-        mean.y += points[nidx[j]].y;
-        mean.z += points[nidx[j]].z;
-      }
-      mean.x /= nr_neighbors;
-      mean.y /= nr_neighbors;
-      mean.z /= nr_neighbors;
-
-      Matrix X(nr_neighbors, 3);
-      SymmetricMatrix A(3);
-      DiagonalMatrix D(3);
-
-      // calculate covariance = A for all the points
-      for (int j = 0; j < nr_neighbors; ++j) {
-        X(j + 1, 1) = points[nidx[j]].x - mean.x;
-        X(j + 1, 2) = points[nidx[j]].y - mean.y;
-        X(j + 1, 3) = points[nidx[j]].z - mean.z;
+#ifdef _OPENMP
+  omp_set_num_threads(OPENMP_NUM_THREADS);
+#endif
+  #pragma omp parallel
+  {
+    // scratch buffers of this thread
+    vector<ANNidx> nidx(kmax + 1);
+    vector<ANNdist> d(kmax + 1);
+    double cov[6], eval[3], evec[9];
+
+    #pragma omp for schedule(dynamic, 64)
+    for (long i = 0; i < (long)points.size(); ++i) {
+      ANNpoint p = pa[i];
+      for (int kidx = kmin; kidx <= kmax; kidx++) {
+        int nr_neighbors = kidx + 1;
+        // ANN search for k nearest neighbors
+        // indexes of the neighbors along with the query point
+        // stored in the array n
+        t.annkSearch(p, nr_neighbors, nidx.data(), d.data(), eps);
+        covariance(nr_neighbors,
+                   [&](size_t j, double *q) {
+                     q[0] = points[nidx[j]].x;
+                     q[1] = points[nidx[j]].y;
+                     q[2] = points[nidx[j]].z;
+                   },
+                   cov);
+
+        eigenSymmetric3x3(cov, eval, evec);
+
+        // We take the particular k if the second maximum eigen value
+        // is at least 25 percent of the maximum eigen value
+        if ((eval[0] > 0.25 * eval[1]) && (fabs(1.0 - eval[1] / eval[2]) < 0.25))
+          break;
       }
 
-      A << 1.0 / nr_neighbors * X.t() * X;
-
-      EigenValues(A, D, U);
-
-      e1 = D(1);
-      e2 = D(2);
-      e3 = D(3);
-
-      delete[] nidx;
-      delete[] d;
-
-      // We take the particular k if the second maximum eigen value
-      // is at least 25 percent of the maximum eigen value
-      if ((e1 > 0.25 * e2) && (fabs(1.0 - (double)e2 / (double)e3) < 0.25))
-        break;
-    }
-
-    // normal = eigenvector corresponding to lowest
-    // eigen value that is the 1rd column of matrix U
-    ColumnVector n(3);
-    n(1) = U(1, 1);
-    n(2) = U(2, 1);
-    n(3) = U(3, 1);
-    ColumnVector point_vector(3);
-    point_vector(1) = p[0] - rPos(1);
-    point_vector(2) = p[1] - rPos(2);
-    point_vector(3) = p[2] - rPos(3);
-    point_vector = point_vector / point_vector.NormFrobenius();
-    Real angle = (n.t() * point_vector).AsScalar();
-    if (angle < 0) {
-      n *= -1.0;
+      // normal = eigenvector corresponding to lowest eigen value
+      normals[base + i] = orientNormal(evec, p, _rPos);
     }
-    n = n / n.NormFrobenius();
-    normals.push_back(Point(n(1), n(2), n(3)));
   }
 
   annDeallocPts(pa);
@@ -224,10 +227,6 @@ void calculateNormalsKNN(vector<Point> &normals,
 {
   int nr_neighbors = k;
 
-  ColumnVector rPos(3);
-  for (int i = 0; i < 3; ++i)
-    rPos(i + 1) = _rPos[i];
-
   double** pa = new double*[points.size()];
   for (size_t i = 0; i < points.size(); ++i) {
     pa[i] = new double[3];
@@ -238,7 +237,8 @@ void calculateNormalsKNN(vector<Point> &normals,
 
   KDtree t(pa, points.size());
 
-  normals.reserve(points.size());
+  size_t base = normals.size();
+  normals.resize(base + points.size());
 
 #ifdef _OPENMP
   omp_set_num_threads(OPENMP_NUM_THREADS);
@@ -269,23 +269,8 @@ void calculateNormalsKNN(vector<Point> &normals,
     double norm[3];
     double eigen[3];
     calculateNormal(temp, norm, eigen);
-    ColumnVector n(3);
-    n(1) = norm[0];
-    n(2) = norm[1];
-    n(3) = norm[2];
-
-    ColumnVector point_vector(3);
-    point_vector(1) = p[0] - rPos(1);
-    point_vector(2) = p[1] - rPos(2);
-    point_vector(3) = p[2] - rPos(3);
-    point_vector = point_vector / point_vector.NormFrobenius();
-    Real angle = (n.t() * point_vector).AsScalar();
-    if (angle < 0) {
-      n *= -1.0;
-    }
-    n = n / n.NormFrobenius();
-    #pragma omp critical
-    normals.push_back(Point(n(1), n(2), n(3)));
+    Point n = orientNormal(norm, p, _rPos);
+    normals[base + i] = n;
   }
 
   for (size_t i = 0; i < points.size(); ++i) {
@@ -295,75 +280,16 @@ void calculateNormalsKNN(vector<Point> &normals,
 }
 
 ///////////////////////////////////////////////////////
-///// USING ONLY SINGLE THREAD TO PRESERVE INDICES ////
+///// NORMALS IN THE ORDER OF THE POINTS ////////////////
 ///////////////////////////////////////////////////////
 void calculateNormalsIndexedKNN(vector<Point> &normals,
                          const vector<Point> &points,
                          const int k,
                          const double _rPos[3])
 {
-  int nr_neighbors = k;
-
-  ColumnVector rPos(3);
-  for (int i = 0; i < 3; ++i)
-    rPos(i + 1) = _rPos[i];
-
-  double** pa = new double*[points.size()];
-  for (size_t i = 0; i < points.size(); ++i) {
-    pa[i] = new double[3];
-    pa[i][0] = points[i].x;
-    pa[i][1] = points[i].y;
-    pa[i][2] = points[i].z;
-  }
-
-  KDtree t(pa, points.size());
-
-  normals.reserve(points.size());
-
-  for (
-#if defined(_MSC_VER) and defined(_OPENMP)
-    // MSVC only supports OpenMP 2.5 where the counter must be signed
-    // There is also no ssize_t on non-POSIX platforms but sizeof(long) == sizeof(void*)
-    long
-#else
-    size_t
-#endif
-    i = 0; i < points.size(); ++i) {
-
-    // Single thread
-    int thread_num = 0;
-
-    double p[3] = { points[i].x, points[i].y, points[i].z };
-
-    vector<Point> temp = t.kNearestNeighbors(p,
-                         nr_neighbors,
-                         thread_num);
-
-    double norm[3];
-    double eigen[3];
-    calculateNormal(temp, norm, eigen);
-    ColumnVector n(3);
-    n(1) = norm[0];
-    n(2) = norm[1];
-    n(3) = norm[2];
-
-    ColumnVector point_vector(3);
-    point_vector(1) = p[0] - rPos(1);
-    point_vector(2) = p[1] - rPos(2);
-    point_vector(3) = p[2] - rPos(3);
-    point_vector = point_vector / point_vector.NormFrobenius();
-    Real angle = (n.t() * point_vector).AsScalar();
-    if (angle < 0) {
-      n *= -1.0;
-    }
-    n = n / n.NormFrobenius();
-    normals.push_back(Point(n(1), n(2), n(3)));
-  }
-
-  for (size_t i = 0; i < points.size(); ++i) {
-    delete[] pa[i];
-  }
-  delete[] pa;
+  // all methods store the normal of points[i] at the same index,
+  // independent of the number of threads
+  calculateNormalsKNN(normals, points, k, _rPos);
 }
 
 void calculateNormalsRange(std::vector<Point> &normals,
@@ -371,9 +297,6 @@ void calculateNormalsRange(std::vector<Point> &normals,
                             const double r2,
                             const double _rPos[3])
 {
-    ColumnVector rPos(3);
-    for (int i = 0; i < 3; ++i)
-        rPos(i + 1) = _rPos[i];
     double** pa = new double*[points.size()];
     for (size_t i = 0; i < points.size(); ++i) {
         pa[i] = new double[3];
@@ -384,7 +307,8 @@ void calculateNormalsRange(std::vector<Point> &normals,
 
     KDtree t(pa, points.size());
 
-    normals.reserve(points.size());
+    size_t base = normals.size();
+    normals.resize(base + points.size());
 
 #ifdef _OPENMP
     omp_set_num_threads(OPENMP_NUM_THREADS);
@@ -413,23 +337,8 @@ void calculateNormalsRange(std::vector<Point> &normals,
     double norm[3];
     double eigen[3];
     calculateNormal(temp, norm, eigen);
-    ColumnVector n(3);
-    n(1) = norm[0];
-    n(2) = norm[1];
-    n(3) = norm[2];
-
-    ColumnVector point_vector(3);
-    point_vector(1) = p[0] - rPos(1);
-    point_vector(2) = p[1] - rPos(2);
-    point_vector(3) = p[2] - rPos(3);
-    point_vector = point_vector / point_vector.NormFrobenius();
-    Real angle = (n.t() * point_vector).AsScalar();
-    if (angle < 0) {
-      n *= -1.0;
-    }
-    n = n / n.NormFrobenius();
-    #pragma omp critical
-    normals.push_back(Point(n(1), n(2), n(3)));
+    Point n = orientNormal(norm, p, _rPos);
+    normals[base + i] = n;
   }
 
   for (size_t i = 0; i < points.size(); ++i) {
@@ -446,10 +355,6 @@ void calculateNormalsKNN(vector<Point> &normals,
 {
   int nr_neighbors = k;
 
-  ColumnVector rPos(3);
-  for (int i = 0; i < 3; ++i)
-    rPos(i + 1) = _rPos[i];
-
   double** pa = new double*[points.size()];
   for (size_t i = 0; i < points.size(); ++i) {
     pa[i] = new double[3];
@@ -459,7 +364,8 @@ void calculateNormalsKNN(vector<Point> &normals,
   }
   KDtree t(pa, points.size(), bucketsize);
 
-  normals.reserve(points.size());
+  size_t base = normals.size();
+  normals.resize(base + points.size());
 
 #ifdef _OPENMP
   omp_set_num_threads(OPENMP_NUM_THREADS);
@@ -490,23 +396,8 @@ void calculateNormalsKNN(vector<Point> &normals,
     double norm[3];
     double eigen[3];
     calculateNormal(temp, norm, eigen);
-    ColumnVector n(3);
-    n(1) = norm[0];
-    n(2) = norm[1];
-    n(3) = norm[2];
-
-    ColumnVector point_vector(3);
-    point_vector(1) = p[0] - rPos(1);
-    point_vector(2) = p[1] - rPos(2);
-    point_vector(3) = p[2] - rPos(3);
-    point_vector = point_vector / point_vector.NormFrobenius();
-    Real angle = (n.t() * point_vector).AsScalar();
-    if (angle < 0) {
-      n *= -1.0;
-    }
-    n = n / n.NormFrobenius();
-    #pragma omp critical
-    normals.push_back(Point(n(1), n(2), n(3)));
+    Point n = orientNormal(norm, p, _rPos);
+    normals[base + i] = n;
   }
 
   for (size_t i = 0; i < points.size(); ++i) {
@@ -515,46 +406,182 @@ void calculateNormalsKNN(vector<Point> &normals,
   delete[] pa;
 }
 
-void calculateNormal(vector<Point> temp, double *norm, double *eigen) {
-  int nr_neighbors = temp.size();
+void covariance3x3(const Point *points, size_t n, double cov[6])
+{
+  covariance(n,
+             [&](size_t j, double *q) {
+               q[0] = points[j].x;
+               q[1] = points[j].y;
+               q[2] = points[j].z;
+             },
+             cov);
+}
 
-  Point mean(0.0, 0.0, 0.0);
-  Matrix X(nr_neighbors, 3);
-  SymmetricMatrix A(3);
-  Matrix U(3, 3);
-  DiagonalMatrix D(3);
+/**
+ * Eigenvector of the eigenvalue eval of A that is well separated from the
+ * other two, as the largest cross product of two rows of A - eval * I
+ */
+static inline void eigenvectorSeparated(const double A[6], double eval,
+                                        double evec[3])
+{
+  double r0[3] = { A[0] - eval, A[1], A[2] };
+  double r1[3] = { A[1], A[3] - eval, A[4] };
+  double r2[3] = { A[2], A[4], A[5] - eval };
+  double c[3][3];
+  Cross(r0, r1, c[0]);
+  Cross(r0, r2, c[1]);
+  Cross(r1, r2, c[2]);
+  double d[3] = { Dot(c[0], c[0]), Dot(c[1], c[1]), Dot(c[2], c[2]) };
+  int imax = 0;
+  if (d[1] > d[imax]) imax = 1;
+  if (d[2] > d[imax]) imax = 2;
+  double inv = 1.0 / sqrt(d[imax]);
+  evec[0] = c[imax][0] * inv;
+  evec[1] = c[imax][1] * inv;
+  evec[2] = c[imax][2] * inv;
+}
 
-  // calculate mean for all the points
-  for (int j = 0; j < nr_neighbors; ++j) {
-    mean.x += temp[j].x;
-    mean.y += temp[j].y;
-    mean.z += temp[j].z;
+/**
+ * Eigenvector of eval of A orthogonal to the known eigenvector w, found by
+ * solving the remaining 2x2 problem in the plane orthogonal to w
+ */
+static inline void eigenvectorOrthogonal(const double A[6], const double w[3],
+                                         double eval, double evec[3])
+{
+  // orthonormal basis u, v of the plane orthogonal to w
+  double u[3], v[3];
+  if (fabs(w[0]) > fabs(w[1])) {
+    double inv = 1.0 / sqrt(w[0] * w[0] + w[2] * w[2]);
+    u[0] = -w[2] * inv; u[1] = 0.0; u[2] = w[0] * inv;
+  } else {
+    double inv = 1.0 / sqrt(w[1] * w[1] + w[2] * w[2]);
+    u[0] = 0.0; u[1] = w[2] * inv; u[2] = -w[1] * inv;
+  }
+  Cross(w, u, v);
+
+  double Au[3] = { A[0] * u[0] + A[1] * u[1] + A[2] * u[2],
+                   A[1] * u[0] + A[3] * u[1] + A[4] * u[2],
+                   A[2] * u[0] + A[4] * u[1] + A[5] * u[2] };
+  double Av[3] = { A[0] * v[0] + A[1] * v[1] + A[2] * v[2],
+                   A[1] * v[0] + A[3] * v[1] + A[4] * v[2],
+                   A[2] * v[0] + A[4] * v[1] + A[5] * v[2] };
+  double m00 = Dot(u, Au) - eval;
+  double m01 = Dot(u, Av);
+  double m11 = Dot(v, Av) - eval;
+  double a00 = fabs(m00), a01 = fabs(m01), a11 = fabs(m11);
+
+  // the null vector (s, t) of the 2x2 matrix gives evec = s * u + t * v,
+  // any vector of the plane if the matrix vanishes
+  double s = 1.0, t = 0.0;
+  if (a00 >= a11) {
+    if (std::max(a00, a01) > 0.0) {
+      if (a00 >= a01) {
+        m01 /= m00; m00 = 1.0 / sqrt(1.0 + m01 * m01); m01 *= m00;
+      } else {
+        m00 /= m01; m01 = 1.0 / sqrt(1.0 + m00 * m00); m00 *= m01;
+      }
+      s = m01; t = -m00;
+    }
+  } else {
+    if (std::max(a11, a01) > 0.0) {
+      if (a11 >= a01) {
+        m01 /= m11; m11 = 1.0 / sqrt(1.0 + m01 * m01); m01 *= m11;
+      } else {
+        m11 /= m01; m01 = 1.0 / sqrt(1.0 + m11 * m11); m11 *= m01;
+      }
+      s = m11; t = -m01;
+    }
+  }
+  for (int j = 0; j < 3; ++j) evec[j] = s * u[j] + t * v[j];
+}
+
+void eigenSymmetric3x3(const double Ain[6], double eval[3], double evec[9])
+{
+  // scale to avoid over- and underflow
+  double scale = 0.0;
+  for (int j = 0; j < 6; ++j) scale = std::max(scale, fabs(Ain[j]));
+  if (scale == 0.0) {
+    eval[0] = eval[1] = eval[2] = 0.0;
+    for (int j = 0; j < 9; ++j) evec[j] = (j % 4 == 0) ? 1.0 : 0.0;
+    return;
+  }
+  double A[6];
+  for (int j = 0; j < 6; ++j) A[j] = Ain[j] / scale;
+
+  double offdiag = A[1] * A[1] + A[2] * A[2] + A[4] * A[4];
+  double q = (A[0] + A[3] + A[5]) / 3.0;
+  double b00 = A[0] - q, b11 = A[3] - q, b22 = A[5] - q;
+  double p = sqrt((b00 * b00 + b11 * b11 + b22 * b22 + 2.0 * offdiag) / 6.0);
+
+  if (p == 0.0) {
+    // multiple of the identity
+    eval[0] = eval[1] = eval[2] = q * scale;
+    for (int j = 0; j < 9; ++j) evec[j] = (j % 4 == 0) ? 1.0 : 0.0;
+    return;
   }
-  mean.x /= nr_neighbors;
-  mean.y /= nr_neighbors;
-  mean.z /= nr_neighbors;
-
-  // calculate covariance = A for all the points
-  for (int i = 0; i < nr_neighbors; ++i) {
-    X(i + 1, 1) = temp[i].x - mean.x;
-    X(i + 1, 2) = temp[i].y - mean.y;
-    X(i + 1, 3) = temp[i].z - mean.z;
+
+  // eigenvalues of B = (A - q * I) / p are 2 * cos(phi + 2k pi / 3)
+  // with cos(3 * phi) = det(B) / 2
+  double c00 = b11 * b22 - A[4] * A[4];
+  double c01 = A[1] * b22 - A[4] * A[2];
+  double c02 = A[1] * A[4] - A[2] * b11;
+  double det = (b00 * c00 - A[1] * c01 + A[2] * c02) / (p * p * p);
+  double halfDet = std::min(std::max(0.5 * det, -1.0), 1.0);
+  double angle = acos(halfDet) / 3.0;
+  double beta2 = 2.0 * cos(angle);
+  double beta0 = 2.0 * cos(angle + 2.0 * M_PI / 3.0);
+  double beta1 = -(beta0 + beta2);
+  eval[0] = q + p * beta0;
+  eval[1] = q + p * beta1;
+  eval[2] = q + p * beta2;
+
+  // start with the eigenvalue farther away from the middle one, the
+  // others follow from the orthogonality to it
+  if (halfDet >= 0.0) {
+    eigenvectorSeparated(A, eval[2], evec + 6);
+    eigenvectorOrthogonal(A, evec + 6, eval[1], evec + 3);
+    Cross(evec + 3, evec + 6, evec);
+  } else {
+    eigenvectorSeparated(A, eval[0], evec);
+    eigenvectorOrthogonal(A, evec, eval[1], evec + 3);
+    Cross(evec, evec + 3, evec + 6);
   }
 
-  A << 1.0 / nr_neighbors * X.t() * X;
+  // the cosine loses half the digits of nearly repeated eigenvalues,
+  // the Rayleigh quotients of the eigenvectors restore them
+  for (int i = 0; i < 3; ++i) {
+    const double *v = evec + 3 * i;
+    eval[i] = A[0] * v[0] * v[0] + A[3] * v[1] * v[1] + A[5] * v[2] * v[2]
+      + 2.0 * (A[1] * v[0] * v[1] + A[2] * v[0] * v[2] + A[4] * v[1] * v[2]);
+  }
+  for (int i = 1; i < 3; ++i) {
+    for (int j = i; j > 0 && eval[j] < eval[j - 1]; --j) {
+      std::swap(eval[j], eval[j - 1]);
+      for (int k = 0; k < 3; ++k) std::swap(evec[3 * j + k], evec[3 * j - 3 + k]);
+    }
+  }
 
-  EigenValues(A, D, U);
+  for (int j = 0; j < 3; ++j) eval[j] *= scale;
+}
 
-  // normal = eigenvector corresponding to lowest
-  // eigen value that is the 1st column of matrix U
-  norm[0] = U(1, 1);
-  norm[1] = U(2, 1);
-  norm[2] = U(3, 1);
+void calculateNormalsCovariance(size_t n, const double *cov,
+                                double *norm, double *eigen)
+{
+  double evec[9];
+  for (size_t i = 0; i < n; ++i) {
+    eigenSymmetric3x3(cov + 6 * i, eigen + 3 * i, evec);
+    // normal = eigenvector corresponding to lowest eigen value
+    norm[3 * i + 0] = evec[0];
+    norm[3 * i + 1] = evec[1];
+    norm[3 * i + 2] = evec[2];
+  }
+}
 
+void calculateNormal(const vector<Point> &temp, double *norm, double *eigen) {
+  double cov[6];
+  covariance3x3(temp.data(), temp.size(), cov);
   // eigen values can be used to check the quality of the normal
-  eigen[0] = D(1);
-  eigen[1] = D(2);
-  eigen[2] = D(3);
+  calculateNormalsCovariance(1, cov, norm, eigen);
 }
 
 ////////////////////////////////////////////////////////////////
@@ -569,10 +596,6 @@ void calculateNormalsAdaptiveKNN(vector<Point> &normals,
   if (kmin > kmax) {
     throw std::invalid_argument("kmin must not be larger than kmax");
   }
-  ColumnVector rPos(3);
-  for (int i = 0; i < 3; ++i)
-    rPos(i + 1) = _rPos[i];
-
   double** pa = new double*[points.size()];
   for (size_t i = 0; i < points.size(); ++i) {
     pa[i] = new double[3];
@@ -583,7 +606,8 @@ void calculateNormalsAdaptiveKNN(vector<Point> &normals,
 
   KDtree t(pa, points.size());
 
-  normals.reserve(points.size());
+  size_t base = normals.size();
+  normals.resize(base + points.size());
 
 #ifdef _OPENMP
   omp_set_num_threads(OPENMP_NUM_THREADS);
@@ -606,8 +630,7 @@ void calculateNormalsAdaptiveKNN(vector<Point> &normals,
 #endif
 
     double p[3] = { points[i].x, points[i].y, points[i].z };
-    Matrix U(3, 3);
-    Point mean(0.0, 0.0, 0.0);
+    double cov[6], eval[3], evec[9];
     int nr_neighbors;
 
     for (int kidx = kmin; kidx <= kmax; kidx++) {
@@ -616,62 +639,18 @@ void calculateNormalsAdaptiveKNN(vector<Point> &normals,
                            nr_neighbors,
                            thread_num);
 
-      nr_neighbors = temp.size();
-
-      mean.x = mean.y = mean.z = 0.0;
-      // calculate mean for all the points
-      for (int j = 0; j < nr_neighbors; j++) {
-        mean.x += temp[j].x;
-        mean.y += temp[j].y;
-        mean.z += temp[j].z;
-      }
-      mean.x /= nr_neighbors;
-      mean.y /= nr_neighbors;
-      mean.z /= nr_neighbors;
-
-      double e1, e2, e3;
-      Matrix X(nr_neighbors, 3);
-      SymmetricMatrix A(3);
-      DiagonalMatrix D(3);
-
-      // calculate covariance = A for all the points
-      for (int j = 0; j < nr_neighbors; ++j) {
-        X(j + 1, 1) = temp[j].x - mean.x;
-        X(j + 1, 2) = temp[j].y - mean.y;
-        X(j + 1, 3) = temp[j].z - mean.z;
-      }
-
-      A << 1.0 / nr_neighbors * X.t() * X;
-      EigenValues(A, D, U);
-
-      e1 = D(1);
-      e2 = D(2);
-      e3 = D(3);
+      covariance3x3(temp.data(), temp.size(), cov);
+      eigenSymmetric3x3(cov, eval, evec);
 
       // We take the particular k if the second maximum eigen value
       // is at least 25 percent of the maximum eigen value
-      if ((e1 > 0.25 * e2) && (fabs(1.0 - (double)e2 / (double)e3) < 0.25))
+      if ((eval[0] > 0.25 * eval[1]) && (fabs(1.0 - eval[1] / eval[2]) < 0.25))
         break;
     }
 
-    // normal = eigenvector corresponding to lowest
-    // eigen value that is the 1rd column of matrix U
-    ColumnVector n(3);
-    n(1) = U(1, 1);
-    n(2) = U(2, 1);
-    n(3) = U(3, 1);
-    ColumnVector point_vector(3);
-    point_vector(1) = p[0] - rPos(1);
-    point_vector(2) = p[1] - rPos(2);
-    point_vector(3) = p[2] - rPos(3);
-    point_vector = point_vector / point_vector.NormFrobenius();
-    Real angle = (n.t() * point_vector).AsScalar();
-    if (angle < 0) {
-      n *= -1.0;
-    }
-    n = n / n.NormFrobenius();
-    #pragma omp critical
-    normals.push_back(Point(n(1), n(2), n(3)));
+    // normal = eigenvector corresponding to lowest eigen value
+    Point n = orientNormal(evec, p, _rPos);
+    normals[base + i] = n;
   }
 
   for (size_t i = 0; i < points.size(); ++i) {
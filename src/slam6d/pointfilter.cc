@@ -31,11 +31,15 @@ bool CheckerCustom::filtersInitialized = false;
 
 
 PointFilter::PointFilter() :
-  m_changed(true), m_checker(0)
+  m_changed(true), m_checker(0),
+  m_has_max(false), m_has_min(false), m_has_top(false), m_has_bottom(false),
+  m_max2(0.0), m_min2(0.0), m_top(0.0), m_bottom(0.0)
 { }
 
 PointFilter::PointFilter(const std::string& params) :
-  m_changed(true), m_checker(0)
+  m_changed(true), m_checker(0),
+  m_has_max(false), m_has_min(false), m_has_top(false), m_has_bottom(false),
+  m_max2(0.0), m_min2(0.0), m_top(0.0), m_bottom(0.0)
 {
   size_t start = 0, end = string::npos;
   while((end = params.find(' ', start)) != string::npos) {
@@ -135,6 +139,70 @@ void PointFilter::createCheckers()
       current = &((*current)->m_next);
     }
   }
+
+  // Split the chain for the batch check. The range and height tests only
+  // read the point, so they can be moved in front of the other checkers as
+  // long as no checker that might change the point comes before them.
+  m_has_max = m_has_min = m_has_top = m_has_bottom = false;
+  m_max2 = m_min2 = m_top = m_bottom = 0.0;
+  m_remaining.clear();
+  bool pure = true;
+  for(Checker* c = m_checker; c; c = c->m_next) {
+    if(pure) {
+      if(CheckerRangeMax* r = dynamic_cast<CheckerRangeMax*>(c)) {
+        m_has_max = true; m_max2 = r->m_max; continue;
+      }
+      if(CheckerRangeMin* r = dynamic_cast<CheckerRangeMin*>(c)) {
+        m_has_min = true; m_min2 = r->m_min; continue;
+      }
+      if(CheckerHeightTop* h = dynamic_cast<CheckerHeightTop*>(c)) {
+        m_has_top = true; m_top = h->m_top; continue;
+      }
+      if(CheckerHeightBottom* h = dynamic_cast<CheckerHeightBottom*>(c)) {
+        m_has_bottom = true; m_bottom = h->m_bottom; continue;
+      }
+      pure = dynamic_cast<CheckerCustom*>(c) != 0;
+    }
+    m_remaining.push_back(c);
+  }
+}
+
+size_t PointFilter::check(double* xyz, size_t n, unsigned char* keep)
+{
+  if(m_changed) {
+    createCheckers();
+    m_changed = false;
+  }
+
+  // fused range and height tests, branch free so that it can be vectorized
+  const bool no_max = !m_has_max, no_min = !m_has_min;
+  const bool no_top = !m_has_top, no_bottom = !m_has_bottom;
+  const double max2 = m_max2, min2 = m_min2, top = m_top, bottom = m_bottom;
+#pragma omp simd
+  for(size_t i = 0; i < n; ++i) {
+    const double* p = xyz + 3*i;
+    double r2 = p[0] * p[0] + p[1] * p[1] + p[2] * p[2];
+    keep[i] = (no_max | (r2 < max2)) & (no_min | (r2 > min2))
+      & (no_top | (p[1] < top)) & (no_bottom | (p[1] > bottom));
+  }
+
+  size_t accepted = 0;
+  if(m_remaining.empty()) {
+#pragma omp simd reduction(+:accepted)
+    for(size_t i = 0; i < n; ++i) accepted += keep[i];
+    return accepted;
+  }
+  for(size_t i = 0; i < n; ++i) {
+    if(!keep[i]) continue;
+    for(size_t j = 0; j < m_remaining.size(); ++j) {
+      if(!m_remaining[j]->test(xyz + 3*i)) {
+        keep[i] = 0;
+        break;
+      }
+    }
+    accepted += keep[i];
+  }
+  return accepted;
 }
 
 Checker::Checker() :
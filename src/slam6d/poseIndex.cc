@@ -0,0 +1,127 @@
+/*
+ * poseIndex implementation
+ *
+ * Released under the GPL version 3.
+ *
+ */
+
+/**
+ * @file
+ * @brief Hash grid over the scan positions for loop closing
+ */
+
+#include "slam6d/poseIndex.h"
+#include "slam6d/scan.h"
+#include "slam6d/globals.icc"
+
+#include <algorithm>
+#include <cmath>
+
+PoseIndex::PoseIndex(double cellSize)
+  : count(0)
+{
+  cell_size = cellSize > 0.0 ? cellSize : 1.0;
+  inv_cell_size = 1.0 / cell_size;
+}
+
+uint64_t PoseIndex::key(int64_t cx, int64_t cy, int64_t cz) const
+{
+  // cells 2^21 apart share a key, radiusSearch checks the distances anyway
+  const uint64_t mask = ((uint64_t)1 << 21) - 1;
+  return (((uint64_t)cx & mask) << 42) | (((uint64_t)cy & mask) << 21)
+    | ((uint64_t)cz & mask);
+}
+
+uint64_t PoseIndex::key(const double *pos) const
+{
+  return key((int64_t)floor(pos[0] * inv_cell_size),
+             (int64_t)floor(pos[1] * inv_cell_size),
+             (int64_t)floor(pos[2] * inv_cell_size));
+}
+
+void PoseIndex::remove(int id)
+{
+  std::unordered_map<uint64_t, std::vector<int> >::iterator it =
+    cells.find(cell_of[id]);
+  std::vector<int> &ids = it->second;
+  ids.erase(std::find(ids.begin(), ids.end(), id));
+  if (ids.empty()) cells.erase(it);
+}
+
+void PoseIndex::insert(int id, const double *pos)
+{
+  if ((size_t)id >= present.size()) {
+    positions.resize(3 * (id + 1));
+    cell_of.resize(id + 1);
+    present.resize(id + 1, false);
+  }
+
+  uint64_t k = key(pos);
+  if (present[id]) {
+    if (cell_of[id] != k) {
+      remove(id);
+      cells[k].push_back(id);
+    }
+  } else {
+    cells[k].push_back(id);
+    present[id] = true;
+    count++;
+  }
+  cell_of[id] = k;
+  positions[3 * id] = pos[0];
+  positions[3 * id + 1] = pos[1];
+  positions[3 * id + 2] = pos[2];
+}
+
+void PoseIndex::insert(int id)
+{
+  insert(id, Scan::allScans[id]->get_rPos());
+}
+
+void PoseIndex::update()
+{
+  for (size_t id = 0; id < present.size(); id++) {
+    if (present[id]) insert(id);
+  }
+}
+
+void PoseIndex::radiusSearch(const double *pos, double radius2,
+                             std::vector<int> &result) const
+{
+  result.clear();
+  if (count == 0) return;
+
+  // a radius spanning more cells than there are occupied ones is answered
+  // by a scan over all positions
+  double ext_cells = ceil(sqrt(radius2) * inv_cell_size);
+  if (pow(2.0 * ext_cells + 1.0, 3) >= (double)cells.size()) {
+    for (size_t id = 0; id < present.size(); id++) {
+      if (present[id] && Dist2(pos, &positions[3 * id]) < radius2) {
+        result.push_back(id);
+      }
+    }
+    return;
+  }
+
+  int64_t ext = (int64_t)ext_cells;
+  int64_t c[3];
+  for (int k = 0; k < 3; k++) {
+    c[k] = (int64_t)floor(pos[k] * inv_cell_size);
+  }
+  for (int64_t cx = c[0] - ext; cx <= c[0] + ext; cx++) {
+    for (int64_t cy = c[1] - ext; cy <= c[1] + ext; cy++) {
+      for (int64_t cz = c[2] - ext; cz <= c[2] + ext; cz++) {
+        std::unordered_map<uint64_t, std::vector<int> >::const_iterator it =
+          cells.find(key(cx, cy, cz));
+        if (it == cells.end()) continue;
+        for (size_t i = 0; i < it->second.size(); i++) {
+          int id = it->second[i];
+          if (Dist2(pos, &positions[3 * id]) < radius2) result.push_back(id);
+        }
+      }
+    }
+  }
+  // several cells may share a key if the radius spans 2^21 cells
+  std::sort(result.begin(), result.end());
+  result.erase(std::unique(result.begin(), result.end()), result.end());
+}
@@ -0,0 +1,219 @@
+/*
+ * profiler implementation
+ *
+ * Released under the GPL version 3.
+ *
+ */
+
+#include "slam6d/profiler.h"
+
+#include <fstream>
+#include <iomanip>
+#include <stdexcept>
+#include <vector>
+
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/locks.hpp>
+
+std::atomic<bool> Profiler::s_enabled(false);
+
+struct ProfileEntry {
+  unsigned long long calls;
+  double seconds;
+  unsigned long long count;
+};
+
+/**
+ * Values of one thread, indexed by (scan + 1) * PROFILE_STAGES + stage.
+ * Only the owning thread writes to it.
+ */
+typedef std::vector<ProfileEntry> ThreadProfile;
+
+static boost::mutex profiles_mutex;
+
+//! Profiles of all threads that ever recorded something, never freed
+static std::vector<ThreadProfile*>& threadProfiles()
+{
+  static std::vector<ThreadProfile*> profiles;
+  return profiles;
+}
+
+static ProfileEntry& localEntry(ProfileStage stage, int scan)
+{
+  static thread_local ThreadProfile* profile = 0;
+  if (profile == 0) {
+    profile = new ThreadProfile();
+    boost::lock_guard<boost::mutex> lock(profiles_mutex);
+    threadProfiles().push_back(profile);
+  }
+  if (scan < -1) scan = -1;
+  size_t index = (size_t)(scan + 1) * PROFILE_STAGES + stage;
+  if (index >= profile->size()) {
+    ProfileEntry zero = { 0, 0.0, 0 };
+    profile->resize(index + PROFILE_STAGES, zero);
+  }
+  return (*profile)[index];
+}
+
+void Profiler::setEnabled(bool enabled)
+{
+  s_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+void Profiler::addTime(ProfileStage stage, int scan, double seconds)
+{
+  ProfileEntry& entry = localEntry(stage, scan);
+  entry.calls++;
+  entry.seconds += seconds;
+}
+
+void Profiler::addCount(ProfileStage stage, int scan, unsigned long long count)
+{
+  if (!enabled()) return;
+  localEntry(stage, scan).count += count;
+}
+
+const char* Profiler::stageName(ProfileStage stage)
+{
+  static const char* names[PROFILE_STAGES] = {
+    "scan_load", "reduction", "tree_build", "correspondences",
+    "minimization", "loop_detection", "graph_solve"
+  };
+  return names[stage];
+}
+
+void Profiler::reset()
+{
+  boost::lock_guard<boost::mutex> lock(profiles_mutex);
+  std::vector<ThreadProfile*>& profiles = threadProfiles();
+  for (size_t t = 0; t < profiles.size(); ++t) {
+    profiles[t]->clear();
+  }
+}
+
+/**
+ * Sum of the values of all threads, indexed like a ThreadProfile, and the
+ * number of threads that recorded something
+ */
+static std::vector<ProfileEntry> mergeProfiles(size_t &threads)
+{
+  boost::lock_guard<boost::mutex> lock(profiles_mutex);
+  std::vector<ThreadProfile*>& profiles = threadProfiles();
+  std::vector<ProfileEntry> merged;
+  threads = 0;
+  for (size_t t = 0; t < profiles.size(); ++t) {
+    const ThreadProfile& profile = *profiles[t];
+    if (profile.empty()) continue;
+    threads++;
+    if (profile.size() > merged.size()) {
+      ProfileEntry zero = { 0, 0.0, 0 };
+      merged.resize(profile.size(), zero);
+    }
+    for (size_t i = 0; i < profile.size(); ++i) {
+      merged[i].calls += profile[i].calls;
+      merged[i].seconds += profile[i].seconds;
+      merged[i].count += profile[i].count;
+    }
+  }
+  return merged;
+}
+
+static bool used(const ProfileEntry& entry)
+{
+  return entry.calls != 0 || entry.count != 0;
+}
+
+static void writeEntryJSON(std::ostream& out, ProfileStage stage,
+                           const ProfileEntry& entry)
+{
+  out << "\"" << Profiler::stageName(stage) << "\": {\"calls\": " << entry.calls
+      << ", \"seconds\": " << entry.seconds
+      << ", \"count\": " << entry.count << "}";
+}
+
+void Profiler::writeJSON(std::ostream& out)
+{
+  size_t threads;
+  std::vector<ProfileEntry> merged = mergeProfiles(threads);
+  size_t scans = merged.size() / PROFILE_STAGES;
+
+  std::vector<ProfileEntry> total(PROFILE_STAGES);
+  for (size_t i = 0; i < merged.size(); ++i) {
+    ProfileEntry& t = total[i % PROFILE_STAGES];
+    t.calls += merged[i].calls;
+    t.seconds += merged[i].seconds;
+    t.count += merged[i].count;
+  }
+
+  std::streamsize precision = out.precision(9);
+  out << "{" << std::endl << "  \"threads\": " << threads << "," << std::endl
+      << "  \"stages\": {";
+  const char* separator = "";
+  for (int s = 0; s < PROFILE_STAGES; ++s) {
+    if (!used(total[s])) continue;
+    out << separator << std::endl << "    ";
+    writeEntryJSON(out, (ProfileStage)s, total[s]);
+    separator = ",";
+  }
+  out << std::endl << "  }," << std::endl << "  \"scans\": [";
+  separator = "";
+  // the first block holds the work not belonging to a single scan
+  for (size_t scan = 1; scan < scans; ++scan) {
+    const ProfileEntry* entries = &merged[scan * PROFILE_STAGES];
+    bool any = false;
+    for (int s = 0; s < PROFILE_STAGES; ++s) any = any || used(entries[s]);
+    if (!any) continue;
+    out << separator << std::endl << "    {\"scan\": " << scan - 1;
+    for (int s = 0; s < PROFILE_STAGES; ++s) {
+      if (!used(entries[s])) continue;
+      out << ", ";
+      writeEntryJSON(out, (ProfileStage)s, entries[s]);
+    }
+    out << "}";
+    separator = ",";
+  }
+  out << std::endl << "  ]" << std::endl << "}" << std::endl;
+  out.precision(precision);
+}
+
+void Profiler::writeCSV(std::ostream& out)
+{
+  size_t threads;
+  std::vector<ProfileEntry> merged = mergeProfiles(threads);
+  size_t scans = merged.size() / PROFILE_STAGES;
+
+  std::streamsize precision = out.precision(9);
+  out << "scan,stage,calls,seconds,count" << std::endl;
+  std::vector<ProfileEntry> total(PROFILE_STAGES);
+  for (size_t scan = 0; scan < scans; ++scan) {
+    for (int s = 0; s < PROFILE_STAGES; ++s) {
+      const ProfileEntry& entry = merged[scan * PROFILE_STAGES + s];
+      total[s].calls += entry.calls;
+      total[s].seconds += entry.seconds;
+      total[s].count += entry.count;
+      if (!used(entry) || scan == 0) continue;
+      out << scan - 1 << "," << stageName((ProfileStage)s) << ","
+          << entry.calls << "," << entry.seconds << "," << entry.count
+          << std::endl;
+    }
+  }
+  for (int s = 0; s < PROFILE_STAGES; ++s) {
+    if (!used(total[s])) continue;
+    out << "total," << stageName((ProfileStage)s) << ","
+        << total[s].calls << "," << total[s].seconds << "," << total[s].count
+        << std::endl;
+  }
+  out.precision(precision);
+}
+
+void Profiler::write(const std::string& filename)
+{
+  std::ofstream out(filename.c_str());
+  if (!out.good())
+    throw std::runtime_error("Cannot open " + filename + " for writing");
+  size_t n = filename.size();
+  if (n >= 5 && filename.compare(n - 5, 5, ".json") == 0)
+    writeJSON(out);
+  else
+    writeCSV(out);
+}
@@ -0,0 +1,45 @@
+/*
+ * provenance implementation
+ *
+ * Released under the GPL version 3.
+ *
+ */
+
+/** @file
+ *  @brief Provenance of the points of condensed MetaScans
+ */
+
+#include "slam6d/provenance.h"
+#include "slam6d/globals.icc"
+
+#include <fstream>
+
+void writeProvenance(std::ostream& out,
+                     const std::vector<std::string>& identifiers,
+                     const std::vector<int>& point_source)
+{
+  std::vector<size_t> counts(identifiers.size(), 0);
+  for (size_t j = 0; j < point_source.size(); j++)
+    if (point_source[j] >= 0) counts[point_source[j]]++;
+  for (size_t j = 0; j < identifiers.size(); j++)
+    out << identifiers[j] << " " << counts[j] << std::endl;
+}
+
+bool readProvenance(const std::string& dir, int fileCounter,
+                    std::vector<std::string>& identifiers,
+                    std::vector<size_t>* counts)
+{
+  std::string srcFileName = dir + "scan" + to_string(fileCounter, 3) + ".src";
+  std::ifstream srcIn(srcFileName.c_str());
+  if (!srcIn.good()) return false;
+
+  identifiers.clear();
+  if (counts) counts->clear();
+  std::string identifier;
+  size_t nr_points;
+  while (srcIn >> identifier >> nr_points) {
+    identifiers.push_back(identifier);
+    if (counts) counts->push_back(nr_points);
+  }
+  return true;
+}
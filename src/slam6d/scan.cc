@@ -28,6 +28,9 @@
 #include "slam6d/globals.icc"
 
 #include "slam6d/normals.h"
+#include "slam6d/profiler.h"
+
+#include <map>
 
 #ifdef WITH_METRICS
 #include "slam6d/metrics.h"
@@ -45,8 +48,55 @@ std::vector<Scan*> Scan::allScans;
 unsigned int Scan::maxScanNr = 0;
 bool Scan::scanserver = false;
 bool Scan::continue_processing = false;
+FramesFormat Scan::frames_format = FRAMES_TEXT;
 std::string Scan::processing_command;
 
+/**
+ * Interned data field identifiers, the handles constants of Scan are
+ * registered first in their order
+ */
+struct FieldRegistry {
+  boost::mutex mutex;
+  std::vector<std::string> names;
+  std::map<std::string, Scan::FieldId> ids;
+
+  FieldRegistry() {
+    const char* predefined[] = { "xyz", "xyz reduced", "xyz reduced original",
+                                 "normal", "normal reduced" };
+    for (size_t i = 0; i < sizeof(predefined) / sizeof(predefined[0]); ++i) {
+      ids[predefined[i]] = (Scan::FieldId)names.size();
+      names.push_back(predefined[i]);
+    }
+  }
+};
+
+static FieldRegistry& fieldRegistry()
+{
+  static FieldRegistry registry;
+  return registry;
+}
+
+Scan::FieldId Scan::fieldId(const std::string& identifier)
+{
+  FieldRegistry& registry = fieldRegistry();
+  boost::lock_guard<boost::mutex> lock(registry.mutex);
+  std::map<std::string, FieldId>::iterator it = registry.ids.find(identifier);
+  if (it != registry.ids.end()) return it->second;
+  FieldId id = (FieldId)registry.names.size();
+  registry.names.push_back(identifier);
+  registry.ids[identifier] = id;
+  return id;
+}
+
+std::string Scan::fieldName(FieldId id)
+{
+  FieldRegistry& registry = fieldRegistry();
+  boost::lock_guard<boost::mutex> lock(registry.mutex);
+  if (id >= registry.names.size())
+    throw std::runtime_error("Unknown data field handle");
+  return registry.names[id];
+}
+
 
 void Scan::openDirectory(bool scanserver,
                          const std::string& path,
@@ -169,6 +219,11 @@ void Scan::continueProcessing(bool continue_processing)
   Scan::continue_processing = continue_processing;
 }
 
+void Scan::setFramesFormat(FramesFormat format)
+{
+  Scan::frames_format = format;
+}
+
 void Scan::setProcessingCommand(int argc, char** argv)
 {
   std::string cmd;
@@ -191,6 +246,8 @@ Scan::Scan()
   M4identity(transMat);
   M4identity(transMatOrg);
   M4identity(dalignxf);
+  M4identity(pendingxf);
+  m_defer_reduced = false;
 
   // trees and reduction methods
   nns_method = -1;
@@ -201,9 +258,6 @@ Scan::Scan()
   reduction_nrpts = 0;
   reduction_pointtype = PointType();
 
-  // flags
-  m_has_reduced = false;
-
   // octtree
   octtree_reduction_voxelSize = 0.0;
   octtree_voxelSize = 0.0;
@@ -268,9 +322,7 @@ void Scan::clear(IODataType types)
 SearchTree* Scan::getSearchTree()
 {
   // if the search tree hasn't been created yet, calculate everything
-  if(kd == 0) {
-    createSearchTree();
-  }
+  createSearchTree();
   return kd;
 }
 
@@ -285,56 +337,52 @@ void Scan::toGlobal() {
 void Scan::createSearchTree()
 {
   // multiple threads will call this function at the same time because they
-  // all work on one pair of Scans, just let the first one
-  // (who sees a null pointer)
-  // do the creation
-  boost::lock_guard<boost::mutex> lock(m_mutex_create_tree);
-  if(kd != 0) return;
+  // all work on one pair of Scans, just let the first one do the creation
+  // and the others wait for it, once created this costs no lock
+  m_search_tree_once.call([this]() {
+    if(kd != 0) return;
 
-  // make sure the original points are created before starting the measurement
-  DataXYZ xyz_orig(get("xyz reduced original"));
+    // make sure the original points are created before starting the measurement
+    DataXYZ xyz_orig(get(FIELD_XYZ_REDUCED_ORIGINAL));
 
 #ifdef WITH_METRICS
-  Timer tc = ClientMetric::create_tree_time.start();
+    Timer tc = ClientMetric::create_tree_time.start();
 #endif //WITH_METRICS
 
-  createSearchTreePrivate();
+    ProfileScope profile(PROFILE_TREE_BUILD, scanNr);
+    createSearchTreePrivate();
+    Profiler::addCount(PROFILE_TREE_BUILD, scanNr, xyz_orig.size());
 
 #ifdef WITH_METRICS
-  ClientMetric::create_tree_time.end(tc);
+    ClientMetric::create_tree_time.end(tc);
 #endif //WITH_METRICS
+  });
 }
 
 void Scan::calcReducedOnDemand()
 {
   // multiple threads will call this function at the same time
   // because they all work on one pair of Scans,
-  // just let the first one (who sees count as zero) do the reduction
-  boost::lock_guard<boost::mutex> lock(m_mutex_reduction);
-  if(m_has_reduced) return;
-
+  // just let the first one do the reduction
+  m_reduced_once.call([this]() {
 #ifdef WITH_METRICS
-  Timer t = ClientMetric::on_demand_reduction_time.start();
+    Timer t = ClientMetric::on_demand_reduction_time.start();
 #endif //WITH_METRICS
 
-  calcReducedOnDemandPrivate();
-
-  m_has_reduced = true;
+    calcReducedOnDemandPrivate();
 
 #ifdef WITH_METRICS
-  ClientMetric::on_demand_reduction_time.end(t);
+    ClientMetric::on_demand_reduction_time.end(t);
 #endif //WITH_METRICS
+  });
 }
 
 void Scan::calcNormalsOnDemand()
 {
   // multiple threads will call this function at the same time
   // because they all work on one pair of Scans,
-  // just let the first one (who sees count as zero) do the reduction
-  boost::lock_guard<boost::mutex> lock(m_mutex_normals);
-  if(m_has_normals) return;
-  calcNormalsOnDemandPrivate();
-  m_has_normals = true;
+  // just let the first one do the computation
+  m_normals_once.call([this]() { calcNormalsOnDemandPrivate(); });
 }
 
 void Scan::copyReducedToOriginal()
@@ -343,7 +391,7 @@ void Scan::copyReducedToOriginal()
   Timer t = ClientMetric::copy_original_time.start();
 #endif //WITH_METRICS
 
-  DataXYZ xyz_reduced(get("xyz reduced"));
+  DataXYZ xyz_reduced(get(FIELD_XYZ_REDUCED));
   // check if we can create a large enough array. The maximum size_t on 32 bit
   // is around 4.2 billion which is too little for scans with more than 179
   // million points
@@ -370,7 +418,7 @@ void Scan::copyOriginalToReduced()
   Timer t = ClientMetric::copy_original_time.start();
 #endif //WITH_METRICS
 
-  DataXYZ xyz_reduced_orig(get("xyz reduced original"));
+  DataXYZ xyz_reduced_orig(get(FIELD_XYZ_REDUCED_ORIGINAL));
   // check if we can create a large enough array. The maximum size_t on 32 bit
   // is around 4.2 billion which is too little for scans with more than 179
   // million points
@@ -483,6 +531,7 @@ void Scan::calcReducedPoints(bool rm_scatter)
     ClientMetric::scan_load_time.end(t);
     Timer tl = ClientMetric::calc_reduced_points_time.start();
 #endif //WITH_METRICS
+  ProfileScope profile(PROFILE_REDUCTION, scanNr);
 
   if(reduction_voxelSize <= 0.0) {
     // copy the points
@@ -680,6 +729,8 @@ void Scan::calcReducedPoints(bool rm_scatter)
     }
     delete[] xyz_in;
   }
+  Profiler::addCount(PROFILE_REDUCTION, scanNr,
+                     size<DataXYZ>(FIELD_XYZ_REDUCED));
 
 #ifdef WITH_METRICS
     ClientMetric::calc_reduced_points_time.end(tl);
@@ -838,11 +889,8 @@ void Scan::mergeCoordinatesWithRoboterPosition(Scan* prevScan)
 void Scan::transformAll(const double alignxf[16])
 {
   DataXYZ xyz(get("xyz"));
-  size_t i=0 ;
-  //  #pragma omp parallel for
-  for(; i < xyz.size(); ++i) {
-    transform3(alignxf, xyz[i]);
-  }
+  if (xyz.size() > 0)
+    transform3points(alignxf, xyz[0], xyz.size());
   // TODO: test for ManagedScan compability,
   // may need a touch("xyz") to mark saving the new values
 }
@@ -854,18 +902,15 @@ void Scan::transformReduced(const double alignxf[16])
   Timer t = ClientMetric::transform_time.start();
 #endif //WITH_METRICS
 
-  DataXYZ xyz_reduced(get("xyz reduced"));
-  size_t i=0;
-  // #pragma omp parallel for
-  for( ; i < xyz_reduced.size(); ++i) {
-    transform3(alignxf, xyz_reduced[i]);
-  }
+  // the points of a DataXYZ are contiguous, transform them in one batch
+  DataXYZ xyz_reduced(get(FIELD_XYZ_REDUCED));
+  if (xyz_reduced.size() > 0)
+    transform3points(alignxf, xyz_reduced[0], xyz_reduced.size());
 
   if (reduction_pointtype.hasNormal()) {
-    DataNormal normal_reduced(get("normal reduced"));
-    for (size_t i = 0; i < normal_reduced.size(); ++i) {
-      transform3normal(alignxf, normal_reduced[i]);
-    }
+    DataNormal normal_reduced(get(FIELD_NORMAL_REDUCED));
+    if (normal_reduced.size() > 0)
+      transform3normals(alignxf, normal_reduced[0], normal_reduced.size());
   }
 
 
@@ -937,7 +982,13 @@ void Scan::transform(const double alignxf[16], const AlgoType type, int islum)
 #endif
 
   // transform points
-  transformReduced(alignxf);
+  if (m_defer_reduced) {
+    double tempxf[16];
+    MMult(alignxf, pendingxf, tempxf);
+    memcpy(pendingxf, tempxf, sizeof(pendingxf));
+  } else {
+    transformReduced(alignxf);
+  }
 
   // update matrices
   transformMatrix(alignxf);
@@ -1008,6 +1059,48 @@ void Scan::transform(const double alignxf[16], const AlgoType type, int islum)
   }
 }
 
+/**
+ * From now on the reduced points of this scan, and of the scans of a meta
+ * scan, are no longer rewritten by every transformation. Used during ICP
+ * to save a pass over all reduced points per iteration.
+ * applyReducedTransform has to be called before the points are read by
+ * anything but getPtPairs and getPtPairsParallel.
+ */
+void Scan::deferReducedTransform()
+{
+  MetaScan* meta = dynamic_cast<MetaScan*>(this);
+  if(meta) {
+    for(size_t i = 0; i < meta->size(); ++i) {
+      meta->getScan(i)->deferReducedTransform();
+    }
+  }
+  m_defer_reduced = true;
+}
+
+/**
+ * Transforms the reduced points by the transformations collected since
+ * deferReducedTransform, in one pass, and returns to transforming them
+ * immediately.
+ */
+void Scan::applyReducedTransform()
+{
+  MetaScan* meta = dynamic_cast<MetaScan*>(this);
+  if(meta) {
+    for(size_t i = 0; i < meta->size(); ++i) {
+      meta->getScan(i)->applyReducedTransform();
+    }
+  }
+  if (!m_defer_reduced) return;
+  m_defer_reduced = false;
+
+  double id[16];
+  M4identity(id);
+  if (memcmp(pendingxf, id, sizeof(id)) != 0) {
+    transformReduced(pendingxf);
+    memcpy(pendingxf, id, sizeof(id));
+  }
+}
+
 /**
  * Transforms the scan by a given transformation and writes a new frame.
  * The idea is to write for every transformation in all files, such that
@@ -1121,10 +1214,10 @@ void Scan::getNoPairsSimple(std::vector <double*> &diff,
                             int thread_num,
                             double max_dist_match2)
 {
-  DataXYZ xyz_reduced(Source->get("xyz reduced"));
+  DataXYZ xyz_reduced(Source->get(FIELD_XYZ_REDUCED));
   KDtree* kd = new KDtree(
-                 PointerArray<double>(Target->get("xyz reduced")).get(),
-                 Target->size<DataXYZ>("xyz reduced"));
+                 PointerArray<double>(Target->get(FIELD_XYZ_REDUCED)).get(),
+                 Target->size<DataXYZ>(FIELD_XYZ_REDUCED));
 
   std::cout << "Max: " << max_dist_match2 << std::endl;
   for (size_t i = 0; i < xyz_reduced.size(); i++) {
@@ -1164,9 +1257,9 @@ void Scan::getPtPairsSimple(std::vector <PtPair> *pairs,
                             double *centroid_m, double *centroid_d)
 {
   KDtree* kd = new KDtree(
-                 PointerArray<double>(Source->get("xyz reduced")).get(),
-                 Source->size<DataXYZ>("xyz reduced"));
-  DataXYZ xyz_reduced(Target->get("xyz reduced"));
+                 PointerArray<double>(Source->get(FIELD_XYZ_REDUCED)).get(),
+                 Source->size<DataXYZ>(FIELD_XYZ_REDUCED));
+  DataXYZ xyz_reduced(Target->get(FIELD_XYZ_REDUCED));
 
   for (size_t i = 0; i < xyz_reduced.size(); i++) {
     // take about 1/rnd-th of the numbers only
@@ -1231,10 +1324,10 @@ void Scan::getPtPairs(std::vector <PtPair> *pairs,
   }
 
   // get point pairs
-  DataXYZ xyz_reduced(Target->get("xyz reduced"));
+  DataXYZ xyz_reduced(Target->get(FIELD_XYZ_REDUCED));
   DataNormal normal_reduced(DataPointer(0, 0));
   if ((pairing_mode == CLOSEST_POINT_ALONG_NORMAL_SIMPLE) || (pairing_mode == CLOSEST_PLANE_SIMPLE)) {
-    DataNormal my_normals(Target->get("normal reduced"));
+    DataNormal my_normals(Target->get(FIELD_NORMAL_REDUCED));
     normal_reduced =  my_normals;
   }
   Source->getSearchTree()->getPtPairs(pairs, Source->dalignxf,
@@ -1247,7 +1340,8 @@ void Scan::getPtPairs(std::vector <PtPair> *pairs,
                                       max_dist_match2,
                                       sum,
                                       centroid_m, centroid_d,
-                                      pairing_mode);
+                                      pairing_mode,
+                                      Target->getPendingTransform());
 
   // normalize centroids
   size_t size = pairs->size();
@@ -1306,10 +1400,10 @@ void Scan::getPtPairsParallel(std::vector <PtPair> *pairs,
   if(meta) {
     for(size_t i = 0; i < meta->size(); ++i) {
       // determine step for each scan individually
-      DataXYZ xyz_reduced(meta->getScan(i)->get("xyz reduced"));
+      DataXYZ xyz_reduced(meta->getScan(i)->get(FIELD_XYZ_REDUCED));
       DataNormal normal_reduced(DataPointer(0, 0));
       if ((pairing_mode == CLOSEST_POINT_ALONG_NORMAL_SIMPLE) || (pairing_mode == CLOSEST_PLANE_SIMPLE)) {
-        DataNormal my_normals(meta->getScan(i)->get("normal reduced"));
+        DataNormal my_normals(meta->getScan(i)->get(FIELD_NORMAL_REDUCED));
         normal_reduced =  my_normals;
       }
 
@@ -1323,13 +1417,14 @@ void Scan::getPtPairsParallel(std::vector <PtPair> *pairs,
                          thread_num,
                          rnd, max_dist_match2, sum[thread_num],
                          centroid_m[thread_num], centroid_d[thread_num],
-                         pairing_mode);
+                         pairing_mode,
+                         meta->getScan(i)->getPendingTransform());
     }
   } else {
-    DataXYZ xyz_reduced(Target->get("xyz reduced"));
+    DataXYZ xyz_reduced(Target->get(FIELD_XYZ_REDUCED));
     DataNormal normal_reduced(DataPointer(0, 0));
     if ((pairing_mode == CLOSEST_POINT_ALONG_NORMAL_SIMPLE) || (pairing_mode == CLOSEST_PLANE_SIMPLE)) {
-      DataNormal my_normals(Target->get("normal reduced"));
+      DataNormal my_normals(Target->get(FIELD_NORMAL_REDUCED));
       normal_reduced =  my_normals;
     }
     size_t endindex = thread_num == (OPENMP_NUM_THREADS - 1) ?  xyz_reduced.size() : step * thread_num + step;
@@ -1339,7 +1434,8 @@ void Scan::getPtPairsParallel(std::vector <PtPair> *pairs,
                        thread_num,
                        rnd, max_dist_match2, sum[thread_num],
                        centroid_m[thread_num], centroid_d[thread_num],
-                       pairing_mode);
+                       pairing_mode,
+                       Target->getPendingTransform());
   }
 
   // normalize centroids
@@ -1358,7 +1454,7 @@ size_t Scan::getMaxCountReduced(ScanVector& scans)
   for(std::vector<Scan*>::iterator it = scans.begin();
       it != scans.end();
       ++it) {
-    size_t count = (*it)->size<DataXYZ>("xyz reduced");
+    size_t count = (*it)->size<DataXYZ>(FIELD_XYZ_REDUCED);
     if(count > max)
       max = count;
   }
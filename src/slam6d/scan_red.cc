@@ -39,12 +39,14 @@
 #include "slam6d/io_utils.h"
 #include "slam6d/scan.h"
 #include "slam6d/Boctree.h"
+#include "slam6d/voxelReducer.h"
 #include "slam6d/fbr/fbr_global.h"
 #include "slam6d/fbr/panorama.h"
 #include "slam6d/fbr/scan_cv.h"
 
 #include "scanserver/clientInterface.h"
 #include "scanio/writer.h"
+#include "scanio/scan_io.h"
 
 #include "slam6d/globals.icc"
 
@@ -215,7 +217,8 @@ void parse_options(int argc, char **argv, int &start, int &end,
                    int &maxDist, int &minDist, std::string &customFilter, reduction_method &rtype, IOType &out_format, double &scale,
                    double &voxel, int &octree, bool &use_reflectance,
 		   int &MIN_ANGLE, int &MAX_ANGLE, int &nImages, double &pParam,
-		   fbr::scanner_type &sType, bool &loadOct, bool &use_color, bool &rm_scatter)
+		   fbr::scanner_type &sType, bool &loadOct, bool &use_color, bool &rm_scatter,
+		   unsigned int &stream_chunk)
 {
   po::options_description generic("Generic options");
   generic.add_options()
@@ -262,6 +265,9 @@ void parse_options(int argc, char **argv, int &start, int &end,
      "voxel size if --reduction OCTREE or maximum circumcircle diameter if --reduction SQTREE")
     ("delete,d", po::bool_switch(&rm_scatter),
      "Deletes voxels if fewer points are contained than given with the OCTREE option")
+    ("stream", po::value<unsigned int>(&stream_chunk),
+     "reduce with --reduction OCTREE while reading the scan in chunks of <arg> points, "
+     "so that the scan never has to fit into memory as a whole")
     ("projection,P", po::value<fbr::projection_method>(&ptype),
      "projection method or panorama image. Following Methods can be used: EQUIRECTANGULAR|CONIC|CYLINDRICAL|MERCATOR|RECTILINEAR|PANNINI|STEREOGRAPHIC|EQUALAREACYLINDRICAL      *Not all Projections may work with RANGE-reduction")
 
@@ -319,6 +325,7 @@ void parse_options(int argc, char **argv, int &start, int &end,
          << "\t./bin/scan_red -s 0 -e 0 -f uos --reduction RANGE --scale 0.5 --projection EQUIRECTANGULAR --width 3600 --height 1000 dat" << std::endl
          << "\t./bin/scan_red -s 0 -e 0 -f uos --reduction INTERPOLATE --scale 0.2 --projection EQUIRECTANGULAR --width 3600 --height 1000 dat" << std::endl
          << "\t./bin/scan_red -s 0 -e 0 -f uosr --reduction RANGE --projection EQUIRECTANGULAR --width 3600 --height 1000 --reflectance -t RIEGL wue_city" << std::endl
+         << "\t./bin/scan_red -s 0 -e 0 -f laz --reduction OCTREE --voxel 10 --octree 0 --stream 1000000 dat" << std::endl
          << "\t./bin/scan_red -s 0 -e 0 -f uos --reduction SQTREE --voxel 0.5 --octree 10 dat" << std::endl
          << "\t./bin/scan_red -s 0 -e 0 -f uos --reduction UPSAMPLING --voxel 50 --scale 2 dat" << std::endl;
     exit(0);
@@ -334,12 +341,14 @@ void parse_options(int argc, char **argv, int &start, int &end,
 
   reduction_option_conflict(vm, RANGE, "voxel");
   reduction_option_conflict(vm, RANGE, "octree");
+  reduction_option_conflict(vm, RANGE, "stream");
   reduction_option_dependency(vm, RANGE, "projection");
   reduction_option_dependency(vm, RANGE, "width");
   reduction_option_dependency(vm, RANGE, "height");
 
   reduction_option_conflict(vm, INTERPOLATE, "voxel");
   reduction_option_conflict(vm, INTERPOLATE, "octree");
+  reduction_option_conflict(vm, INTERPOLATE, "stream");
   reduction_option_dependency(vm, INTERPOLATE, "projection");
   reduction_option_dependency(vm, INTERPOLATE, "width");
   reduction_option_dependency(vm, INTERPOLATE, "height");
@@ -349,12 +358,14 @@ void parse_options(int argc, char **argv, int &start, int &end,
   reduction_option_conflict(vm, SQTREE, "projection");
   reduction_option_conflict(vm, SQTREE, "width");
   reduction_option_conflict(vm, SQTREE, "height");
+  reduction_option_conflict(vm, SQTREE, "stream");
 
   reduction_option_conflict(vm, NO_REDUCTION, "voxel");
   reduction_option_conflict(vm, NO_REDUCTION, "octree");
   reduction_option_conflict(vm, NO_REDUCTION, "projection");
   reduction_option_conflict(vm, NO_REDUCTION, "width");
   reduction_option_conflict(vm, NO_REDUCTION, "height");
+  reduction_option_conflict(vm, NO_REDUCTION, "stream");
 
   reduction_option_dependency(vm, UPSAMPLING, "voxel");
   reduction_option_dependency(vm, UPSAMPLING, "scale");
@@ -362,6 +373,12 @@ void parse_options(int argc, char **argv, int &start, int &end,
   reduction_option_conflict(vm, UPSAMPLING, "projection");
   reduction_option_conflict(vm, UPSAMPLING, "width");
   reduction_option_conflict(vm, UPSAMPLING, "height");
+  reduction_option_conflict(vm, UPSAMPLING, "stream");
+
+  // the scanserver loads whole scans into its shared memory
+  if (scanserver && vm.count("stream")) {
+    throw std::logic_error("--stream cannot be used together with the scanserver");
+  }
 
 #ifndef _MSC_VER
   if (dir[dir.length()-1] != '/') dir = dir + "/";
@@ -469,6 +486,53 @@ void reduce_octree(Scan *scan, std::vector<cv::Vec4f> &reduced_points, std::vect
   }
 }
 
+/*
+ * Same as reduce_octree, but the points are read in chunks of chunk_size
+ * points and fed into a voxel grid, so that memory usage is bounded by the
+ * size of the reduced point cloud instead of the size of the scan.
+ */
+void reduce_octree_stream(Scan *scan, const std::string &dir, IOType iotype, PointFilter &filter,
+                   std::vector<cv::Vec4f> &reduced_points, std::vector<cv::Vec3b> &color,
+                   int octree, double red, bool use_reflectance, bool use_color, bool rm_scatter,
+                   size_t chunk_size)
+{
+  VoxelReducer reducer(red, octree, (rm_scatter && octree > 0) ? octree : 0);
+  ScanIO* sio = ScanIO::getScanIO(iotype);
+
+  std::string identifiers = scan->getIdentifier();
+  size_t pos;
+  do {
+    pos = identifiers.find_first_of(';');
+    std::string current_identifier = identifiers.substr(0, pos);
+    if (pos != std::string::npos) identifiers = identifiers.substr(pos + 1);
+
+    sio->readScanChunked(dir.c_str(), current_identifier.c_str(),
+        filter, chunk_size, [&](ScanChunk &chunk) -> bool {
+      size_t n = chunk.size();
+      reducer.add(chunk.xyz.data(),
+                  chunk.reflectance.size() == n ? chunk.reflectance.data() : 0,
+                  chunk.rgb.size() == 3*n ? chunk.rgb.data() : 0,
+                  n);
+      return true;
+    });
+  } while (pos != std::string::npos);
+
+  std::vector<double> xyz;
+  std::vector<float> reflectance;
+  std::vector<unsigned char> rgb;
+  reducer.getPoints(xyz, &reflectance, &rgb);
+
+  for(size_t j = 0; j < xyz.size() / 3; j++) {
+    reduced_points.push_back(cv::Vec4f(xyz[3*j],
+                                       xyz[3*j+1],
+                                       xyz[3*j+2],
+                                       use_reflectance ? reflectance[j] : 0.0));
+    if (use_color) {
+      color.push_back(cv::Vec3b(rgb[3*j], rgb[3*j+1], rgb[3*j+2]));
+    }
+  }
+}
+
 void reduce_sqtree(Scan *scan, std::vector<cv::Vec4f> &reduced_points, std::vector<cv::Vec3b> &color,
                    int octree, double red, bool use_reflectance, bool use_color)
 {
@@ -660,6 +724,7 @@ int main(int argc, char **argv)
   std::string customFilter;
   bool rangeFilterActive = false;
   bool customFilterActive = false;
+  unsigned int stream_chunk = 0;
 
   //scan
   fbr::scanner_type sType;
@@ -676,7 +741,7 @@ int main(int argc, char **argv)
   parse_options(argc, argv, start, end, scanserver, width, height, ptype,
                 dir, iotype, maxDist, minDist, customFilter, rtype, out_format, scale, voxel, octree,
                 use_reflectance, MIN_ANGLE, MAX_ANGLE, nImages, pParam,
-		sType, loadOct, use_color, rm_scatter);
+		sType, loadOct, use_color, rm_scatter, stream_chunk);
 
   rangeFilterActive = minDist > 0 || maxDist > 0;
   // custom filter set? quick check, needs to contain at least one ';'
@@ -822,14 +887,33 @@ int main(int argc, char **argv)
       if(rangeFilterActive) scan->setRangeFilter(maxDist, minDist);
       if(customFilterActive) scan->setCustomFilter(customFilter);
 
-      reduce_octree(scan,
-          reduced_points,
-          color,
-          octree,
-          voxel,
-          use_reflectance,
-          use_color,
-          rm_scatter);
+      if (stream_chunk > 0) {
+        PointFilter filter;
+        if(rangeFilterActive) filter.setRange(maxDist, minDist);
+        if(customFilterActive) filter.setCustom(customFilter);
+
+        reduce_octree_stream(scan,
+            dir,
+            iotype,
+            filter,
+            reduced_points,
+            color,
+            octree,
+            voxel,
+            use_reflectance,
+            use_color,
+            rm_scatter,
+            stream_chunk);
+      } else {
+        reduce_octree(scan,
+            reduced_points,
+            color,
+            octree,
+            voxel,
+            use_reflectance,
+            use_color,
+            rm_scatter);
+      }
 
       if (use_reflectance)
         write_uosr(reduced_points,
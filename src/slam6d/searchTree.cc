@@ -19,6 +19,7 @@
 #include "slam6d/globals.icc"
 
 #include <stdexcept>
+#include <cstring>
 
 double *SearchTree::FindClosestAlongDir(double *_p,
                                         double *_dir,
@@ -101,7 +102,8 @@ void SearchTree::getPtPairs(std::vector <PtPair> *pairs,
                             double &sum,
                             double *centroid_m,
                             double *centroid_d,
-                            PairingMode pairing_mode)
+                            PairingMode pairing_mode,
+                            const double *target_alignxf)
 {
   // prepare this tree for resource access in FindClosest
   lock();
@@ -109,6 +111,15 @@ void SearchTree::getPtPairs(std::vector <PtPair> *pairs,
   double local_alignxf_inv[16];
   M4inv(source_alignxf, local_alignxf_inv);
 
+  // the target points still have to be moved by target_alignxf, the
+  // query transformation does both steps at once
+  double query_alignxf[16];
+  if (target_alignxf) {
+    MMult(local_alignxf_inv, target_alignxf, query_alignxf);
+  } else {
+    memcpy(query_alignxf, local_alignxf_inv, sizeof(query_alignxf));
+  }
+
   // t is the original point from target,
   // s is the (inverted) query point from target and then
   // the closest point in source
@@ -116,10 +127,14 @@ void SearchTree::getPtPairs(std::vector <PtPair> *pairs,
   for (unsigned int i = startindex; i < endindex; i++) {
     // take about 1/rnd-th of the numbers only
     if (rnd > 1 && rand(rnd) != 0) continue;
-    t[0] = xyz_r[i][0];
-    t[1] = xyz_r[i][1];
-    t[2] = xyz_r[i][2];
-    transform3(local_alignxf_inv, t, s);
+    if (target_alignxf) {
+      transform3(target_alignxf, xyz_r[i], t);
+    } else {
+      t[0] = xyz_r[i][0];
+      t[1] = xyz_r[i][1];
+      t[2] = xyz_r[i][2];
+    }
+    transform3(query_alignxf, xyz_r[i], s);
 
     double *closest;
 
@@ -127,6 +142,7 @@ void SearchTree::getPtPairs(std::vector <PtPair> *pairs,
       normal[0] = normal_r[i][0];
       normal[1] = normal_r[i][1];
       normal[2] = normal_r[i][2];
+      if (target_alignxf) transform3normal(target_alignxf, normal);
       Normalize3(normal);
     }
 
@@ -46,6 +46,8 @@
 #include "slam6d/graphSlam6D.h"
 #include "slam6d/gapx6D.h"
 #include "slam6d/graph.h"
+#include "slam6d/poseIndex.h"
+#include "slam6d/profiler.h"
 #include "slam6d/globals.icc"
 
 #include <csignal>
@@ -123,6 +125,17 @@ void validate(boost::any& v, const std::vector<std::string>& values,
   }
 }
 
+void validate(boost::any& v, const std::vector<std::string>& values,
+              FramesFormat*, int) {
+  if (values.size() == 0)
+    throw std::runtime_error("Invalid frames format specification");
+  std::string arg = values.at(0);
+  if (arg == "text") v = FRAMES_TEXT;
+  else if (arg == "binary") v = FRAMES_BINARY;
+  else if (arg == "delta") v = FRAMES_BINARY_DELTA;
+  else throw std::runtime_error("Frames format " + arg + " unknown.");
+}
+
 
 /** A function that parses the command-line arguments and sets the respective flags.
  * @param argc the number of arguments
@@ -152,6 +165,7 @@ void validate(boost::any& v, const std::vector<std::string>& values,
  * @param lum6DAlgo specifies the used algorithm for global SLAM correction
  * @param loopsize defines the minimal loop size
  * @param bucketSize defines the k-d treeleaf bucket size
+ * @param deferTransform transform the reduced points once after ICP only
  * @return 0, if the parsing was successful. 1 otherwise
  */
 
@@ -163,7 +177,9 @@ int parse_options(int argc, char **argv, string &dir, double &red, int &rand,
               double &epsilonICP, double &epsilonSLAM,  int &nns_method, bool &exportPts, double &distLoop,
               int &iterLoop, double &graphDist, int &octree, IOType &type,
               bool& scanserver, PairingMode &pairing_mode, bool &continue_processing, int &bucketSize,
-              boost::filesystem::path &loopclosefile, int &max_num_metascans)
+              boost::filesystem::path &loopclosefile, int &max_num_metascans,
+              string &profile, FramesFormat &frames_format,
+              bool &deferTransform)
 {
 
 po::options_description generic("Generic options");
@@ -199,7 +215,8 @@ po::options_description generic("Generic options");
     "0 = simple k-d tree\n"
     "1 = ANNTree\n"
     "2 = BOCTree\n"
-    "3 = BruteForce")
+    "3 = BruteForce\n"
+    "4 = uniform grid")
     ("loop6DAlgo,L", po::value<int>(&loopSlam6DAlgo)->default_value(0),
      "selects the method for closing the loop explicitly\n"
      "0 = no loop closing technique\n"
@@ -293,7 +310,16 @@ po::options_description generic("Generic options");
     ("loopclosefile", po::value<boost::filesystem::path>(&loopclosefile),
     "filename to write scan poses")
     ("maxmeta", po::value<int>(&max_num_metascans)->default_value(-1),
-     "maximum nr of previous scans to combine to a metascan in scan matching");
+     "maximum nr of previous scans to combine to a metascan in scan matching")
+    ("profile", po::value<string>(&profile),
+     "write the time spent in each stage of every scan to file <arg>, "
+     "as JSON if it ends in .json and as CSV otherwise")
+    ("frames-format", po::value<FramesFormat>(&frames_format)->default_value(FRAMES_TEXT, "text"),
+     "format of the .frames files: text, binary (run length encoded) or "
+     "delta (binary with poses relative to the previous frame)")
+    ("defer-transform", po::bool_switch(&deferTransform)->default_value(false),
+     "transform the reduced points of a scan once after ICP instead of in "
+     "every iteration, the correspondence search applies the pose on the fly");
 
   po::options_description hidden("Hidden options");
   hidden.add_options()
@@ -393,6 +419,11 @@ void matchGraph6Dautomatic(double cldist,
   double dist, min_dist = -1;
   int first = 0, last = 0;
 
+  // positions of the scans that are far enough back in the sequence to
+  // close a loop with the current one
+  PoseIndex loop_index(cldist);
+  vector<int> close;
+
   for(int i = 1; i < n; i++) {
     cout << i << "/" << n << endl;
 
@@ -454,9 +485,15 @@ void matchGraph6Dautomatic(double cldist,
       loop_detection = 2;
     }
 
-    for(int j = 0; j < i - loopsize; j++) {
-      dist = Dist2(allScans[j]->get_rPos(), allScans[i]->get_rPos());
-      if(dist < cldist2) {
+    {
+      ProfileScope profile(PROFILE_LOOP_DETECTION, allScans[i]->scanNr);
+      if(i - loopsize - 1 >= 0) {
+        loop_index.insert(i - loopsize - 1);
+      }
+      loop_index.radiusSearch(allScans[i]->get_rPos(), cldist2, close);
+      for(size_t k = 0; k < close.size(); k++) {
+        int j = close[k];
+        dist = Dist2(allScans[j]->get_rPos(), allScans[i]->get_rPos());
         loop_detection = 1;
         if(min_dist < 0 || dist < min_dist) {
           min_dist = dist;
@@ -488,6 +525,9 @@ void matchGraph6Dautomatic(double cldist,
           j++;
         } while (j < nrIt && ret > epsilonSLAM);
       }
+
+      // loop closing and global relaxation moved the earlier scans
+      loop_index.update();
     }
   }
 
@@ -583,6 +623,9 @@ int main(int argc, char **argv)
   int bucketSize = 20;
   boost::filesystem::path loopclose("loopclose.pts");
   int max_num_metascans = -1;
+  string profile;
+  FramesFormat frames_format = FRAMES_TEXT;
+  bool deferTransform = false;
 
   parse_options(argc, argv, dir, red, rand, mdm, mdml, mdmll, mni, start, end,
             maxDist, minDist, customFilter, quiet, veryQuiet, eP, meta,
@@ -590,7 +633,10 @@ int main(int argc, char **argv)
             mni_lum, net, cldist, clpairs, loopsize, epsilonICP, epsilonSLAM,
             nns_method, exportPts, distLoop, iterLoop, graphDist, octree, type,
             scanserver, pairing_mode, continue_processing, bucketSize,
-            loopclose, max_num_metascans);
+            loopclose, max_num_metascans, profile, frames_format,
+            deferTransform);
+
+  if (!profile.empty()) Profiler::setEnabled(true);
 
   /* writing frames in zip archives is not supported by BasicScan */
   if(!boost::filesystem::is_directory(dir)) {
@@ -604,6 +650,7 @@ int main(int argc, char **argv)
 
   if (continue_processing) Scan::continueProcessing();
   Scan::setProcessingCommand(argc, argv);
+  Scan::setFramesFormat(frames_format);
 
   Scan::openDirectory(scanserver, dir, type, start, end);
 
@@ -713,6 +760,7 @@ int main(int argc, char **argv)
     icp6D *my_icp = 0;
     my_icp = new icp6D(my_icp6Dminimizer, mdm, mni, quiet, meta, rand, eP,
                        anim, epsilonICP, nns_method,false,false,max_num_metascans);
+    my_icp->set_deferred_transform(deferTransform);
     // check if CAD matching was selected as type
     if (type == UOS_CAD)
     {
@@ -726,6 +774,7 @@ int main(int argc, char **argv)
     icp6D *my_icp = 0;
     my_icp = new icp6D(my_icp6Dminimizer, mdm, mni, quiet, meta, rand, eP,
                        anim, epsilonICP, nns_method,false,false,max_num_metascans);
+    my_icp->set_deferred_transform(deferTransform);
     my_icp->doICP(Scan::allScans, pairing_mode);
     graphSlam6D *my_graphSlam6D = new lum6DEuler(my_icp6Dminimizer,
                                                  mdm, mdml, mni, quiet, meta,
@@ -766,6 +815,7 @@ int main(int argc, char **argv)
       icp6D *my_icp = 0;
       my_icp = new icp6D(my_icp6Dminimizer, mdm, mni, quiet, meta, rand, eP,
                          anim, epsilonICP, nns_method);
+      my_icp->set_deferred_transform(deferTransform);
       my_icp->doICP(Scan::allScans, pairing_mode);
 
       Graph* structure;
@@ -781,6 +831,7 @@ int main(int argc, char **argv)
       if(algo > 0) {
         my_icp = new icp6D(my_icp6Dminimizer, mdm, mni, quiet, meta, rand, eP,
                            anim, epsilonICP, nns_method);
+        my_icp->set_deferred_transform(deferTransform);
 
         loopSlam6D *my_loopSlam6D = 0;
         switch(loopSlam6DAlgo) {
@@ -866,6 +917,11 @@ int main(int argc, char **argv)
   }
   redptsout.close();
 
+  if (!profile.empty()) {
+    Profiler::write(profile);
+    cout << "Stage profile written to " << profile << endl;
+  }
+
   Scan::closeDirectory();
   delete my_icp6Dminimizer;
 
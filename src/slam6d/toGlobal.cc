@@ -9,6 +9,7 @@
 
 #include <fstream>
 #include <iostream>
+#include <vector>
 
 #include "slam6d/point.h"
 #include "slam6d/globals.icc"
@@ -94,7 +95,6 @@ int main(int argc, char **argv)
   std::cout << outFileName << std::endl;
   std::ofstream redptsout(outFileName);
   std::stringstream outdat;
-  int pointcnt=0;
   for (;;) {
     if (end > -1 && fileCounter > end) break; // 'nuf read
     snprintf(frameFileName,255,"%sscan%.3d.frames",dir,fileCounter);
@@ -123,39 +123,35 @@ int main(int argc, char **argv)
      }
     }
 
-    Point p;
-//    double range, theta, phi, reflectance;
-    unsigned int rgb[3];
-    std::cout.precision(10);
-    while(scan_in.good()) {
-  /*    scan_in >> p.z >> p.x >> p.y >> range >> theta >> phi >> reflectance;
-   */ //scan_in >> p.z >> p.x >> p.y >> range >> theta >> phi >> reflectance;
-      scan_in >> p.x >> p.y >> p.z >> rgb[0] >> rgb[1] >> rgb[2];
-     /* p.x *= -100;
-      p.y *= 100;
-      p.z *= 100;
-    */
-      p.transform(transMat);
-      //Matrix4ToEuler(transMat,rPosTheta,rPos);
-
-      //cout << p.y << " " << p.z << " " << -p.x << " " << reflectance << endl;
-      //cout << p.y << " " << p.z << " " << -p.x << endl;
-      //cout << p.x*0.01 << " " << p.z*0.01 << " " << p.y*0.01 << " " << p.reflectance << endl;
-      //cout << (int)p.x << " " << (int)p.y << " " << (int)p.z << endl;// << " " << p.reflectance << endl;
-      outdat << std::setprecision(15) << p.z*0.01 << " " << -p.x*0.01 << " " << p.y*0.01 << " " << rgb[0] << " " << rgb[1] << " " << rgb[2] << std::endl;
-      pointcnt++;
-      if(pointcnt > 100) {
-        redptsout.write(outdat.str().c_str(), outdat.str().size());
-        pointcnt = 0;
-        outdat.clear();
-        outdat.str("");
+    // points are read in blocks and transformed at once
+    const size_t block = 4096;
+    std::vector<double> xyz;
+    std::vector<unsigned int> rgb;
+    xyz.reserve(3*block);
+    rgb.reserve(3*block);
+    auto flush = [&]() {
+      size_t n = xyz.size() / 3;
+      transform3points(transMat, xyz.data(), n);
+      for (size_t i = 0; i < n; i++) {
+        const double *q = &xyz[3*i];
+        const unsigned int *c = &rgb[3*i];
+        outdat << std::setprecision(15) << q[2]*0.01 << " " << -q[0]*0.01 << " " << q[1]*0.01 << " " << c[0] << " " << c[1] << " " << c[2] << std::endl;
       }
-
+      redptsout.write(outdat.str().c_str(), outdat.str().size());
+      outdat.clear();
+      outdat.str("");
+      xyz.clear();
+      rgb.clear();
+    };
+
+    double x, y, z;
+    unsigned int r, g, b;
+    while(scan_in >> x >> y >> z >> r >> g >> b) {
+      xyz.push_back(x); xyz.push_back(y); xyz.push_back(z);
+      rgb.push_back(r); rgb.push_back(g); rgb.push_back(b);
+      if (xyz.size() == 3*block) flush();
     }
-    redptsout.write(outdat.str().c_str(), outdat.str().size());
-    pointcnt = 0;
-    outdat.clear();
-    outdat.str("");
+    flush();
 
 
     scan_in.close();
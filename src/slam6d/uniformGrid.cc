@@ -0,0 +1,206 @@
+/*
+ * UniformGridSearch implementation
+ *
+ * Released under the GPL version 3.
+ *
+ */
+
+/**
+ * @file
+ * @brief Closest point search in a uniform grid, the CPU version of CuGrid
+ */
+
+#include "slam6d/uniformGrid.h"
+#include "slam6d/globals.icc"
+
+#include <algorithm>
+#include <stdexcept>
+#include <cmath>
+#include <cfloat>
+
+//! largest number of cells per axis, the cell number must fit into 64 bit
+static const long max_cells_per_axis = 1L << 21;
+
+UniformGridSearch::UniformGridSearch(double **pts, size_t n, double cellSize)
+{
+  if (n >= UINT32_MAX)
+    throw std::runtime_error("Too many points for UniformGridSearch");
+
+  double mins[3] = { 0.0, 0.0, 0.0 }, maxs[3] = { 0.0, 0.0, 0.0 };
+  for (size_t i = 0; i < n; i++) {
+    for (int k = 0; k < 3; k++) {
+      if (i == 0 || pts[i][k] < mins[k]) mins[k] = pts[i][k];
+      if (i == 0 || pts[i][k] > maxs[k]) maxs[k] = pts[i][k];
+    }
+  }
+
+  double extent = std::max(std::max(maxs[0] - mins[0], maxs[1] - mins[1]),
+                           maxs[2] - mins[2]);
+  if (cellSize <= 0.0) {
+    // one point per cell if the points filled the bounding box, scan points
+    // lie on surfaces, so the occupied cells hold several
+    double volume = (maxs[0] - mins[0] + 1.0) * (maxs[1] - mins[1] + 1.0)
+      * (maxs[2] - mins[2] + 1.0);
+    cellSize = cbrt(volume / (n > 0 ? n : 1));
+  }
+  cellSize = std::max(cellSize, extent / (max_cells_per_axis - 1));
+  if (!(cellSize > 0.0)) cellSize = 1.0;
+
+  cell_size = cellSize;
+  inv_cell_size = 1.0 / cellSize;
+  for (int k = 0; k < 3; k++) {
+    origin[k] = mins[k];
+    dims[k] = (long)((maxs[k] - mins[k]) * inv_cell_size) + 1;
+  }
+
+  // cell number of every point
+  std::vector<uint64_t> cell(n);
+  for (size_t i = 0; i < n; i++) {
+    long c[3];
+    for (int k = 0; k < 3; k++) {
+      c[k] = (long)((pts[i][k] - origin[k]) * inv_cell_size);
+      c[k] = std::min(std::max(c[k], 0L), dims[k] - 1);
+    }
+    cell[i] = ((uint64_t)c[0] * dims[1] + c[1]) * dims[2] + c[2];
+  }
+
+  // order of the points sorted by cell, stable within a cell
+  std::vector<uint32_t> order(n);
+  uint64_t ncells = (uint64_t)dims[0] * dims[1] * dims[2];
+  dense = ncells <= 8 * (uint64_t)n + 1024;
+  if (dense) {
+    // counting sort
+    cell_start.assign(ncells + 1, 0);
+    for (size_t i = 0; i < n; i++) cell_start[cell[i] + 1]++;
+    for (uint64_t c = 0; c < ncells; c++) cell_start[c + 1] += cell_start[c];
+    std::vector<uint32_t> next(cell_start.begin(), cell_start.end() - 1);
+    for (size_t i = 0; i < n; i++) order[next[cell[i]]++] = i;
+  } else {
+    for (size_t i = 0; i < n; i++) order[i] = i;
+    std::stable_sort(order.begin(), order.end(),
+                     [&cell](uint32_t a, uint32_t b) { return cell[a] < cell[b]; });
+    for (size_t i = 0; i < n; ) {
+      size_t j = i;
+      while (j < n && cell[order[j]] == cell[order[i]]) j++;
+      cell_map[cell[order[i]]] = std::make_pair((uint32_t)i, (uint32_t)j);
+      i = j;
+    }
+  }
+
+  xyz.resize(3 * n);
+  xs.resize(n);
+  ys.resize(n);
+  zs.resize(n);
+  for (size_t i = 0; i < n; i++) {
+    const double *p = pts[order[i]];
+    xyz[3 * i] = xs[i] = p[0];
+    xyz[3 * i + 1] = ys[i] = p[1];
+    xyz[3 * i + 2] = zs[i] = p[2];
+  }
+}
+
+UniformGridSearch::~UniformGridSearch()
+{
+}
+
+bool UniformGridSearch::cellRange(long cx, long cy, long cz,
+                                  uint32_t &begin, uint32_t &end) const
+{
+  uint64_t c = ((uint64_t)cx * dims[1] + cy) * dims[2] + cz;
+  if (dense) {
+    begin = cell_start[c];
+    end = cell_start[c + 1];
+    return begin != end;
+  }
+  std::unordered_map<uint64_t, std::pair<uint32_t, uint32_t> >::const_iterator
+    it = cell_map.find(c);
+  if (it == cell_map.end()) return false;
+  begin = it->second.first;
+  end = it->second.second;
+  return true;
+}
+
+/// squared distance of v to the interval [lo, lo + size]
+static inline double axisDist2(double v, double lo, double size)
+{
+  double d = lo - v;
+  if (d > 0.0) return d * d;
+  d = v - (lo + size);
+  return d > 0.0 ? d * d : 0.0;
+}
+
+double *UniformGridSearch::FindClosest(double *_p, double maxdist2, int threadNum) const
+{
+  if (xs.empty()) return 0;
+
+  const double px = _p[0], py = _p[1], pz = _p[2];
+  long ext = (long)ceil(sqrt(maxdist2) * inv_cell_size);
+  long c[3], lo[3], hi[3];
+  for (int k = 0; k < 3; k++) {
+    double f = floor((_p[k] - origin[k]) * inv_cell_size);
+    // query far outside of the grid
+    if (f + ext < 0.0 || f - ext > dims[k] - 1) return 0;
+    c[k] = (long)f;
+    lo[k] = std::max(c[k] - ext, 0L);
+    hi[k] = std::min(c[k] + ext, dims[k] - 1);
+  }
+
+  const double *x = xs.data(), *y = ys.data(), *z = zs.data();
+  double best_d2 = maxdist2;
+  long best = -1;
+  // visit the cells in rings around the cell of the query, the search ends
+  // as soon as the cube of the rings visited so far contains a ball around
+  // the query with the closest point found so far
+  for (long r = 0; r <= ext; r++) {
+    if (r > 0) {
+      double inner = DBL_MAX;
+      for (int k = 0; k < 3; k++) {
+        double cell_lo = origin[k] + (c[k] - r + 1) * cell_size;
+        double cell_hi = origin[k] + (c[k] + r) * cell_size;
+        inner = std::min(inner, std::min(_p[k] - cell_lo, cell_hi - _p[k]));
+      }
+      if (sqr(inner) >= best_d2) break;
+    }
+    for (long cx = std::max(c[0] - r, lo[0]); cx <= std::min(c[0] + r, hi[0]); cx++) {
+      double dx2 = axisDist2(px, origin[0] + cx * cell_size, cell_size);
+      if (dx2 >= best_d2) continue;
+      bool x_shell = cx == c[0] - r || cx == c[0] + r;
+      for (long cy = std::max(c[1] - r, lo[1]); cy <= std::min(c[1] + r, hi[1]); cy++) {
+        double dxy2 = dx2 + axisDist2(py, origin[1] + cy * cell_size, cell_size);
+        if (dxy2 >= best_d2) continue;
+        bool shell = x_shell || cy == c[1] - r || cy == c[1] + r;
+        // inside the ring only its two cells at c[2] -+ r
+        long step = shell || r == 0 ? 1 : 2 * r;
+        for (long cz = c[2] - r; cz <= c[2] + r; cz += step) {
+          if (cz < lo[2] || cz > hi[2]) continue;
+          double dxyz2 = dxy2 + axisDist2(pz, origin[2] + cz * cell_size, cell_size);
+          if (dxyz2 >= best_d2) continue;
+          uint32_t begin, end;
+          if (!cellRange(cx, cy, cz, begin, end)) continue;
+
+          // smallest distance in the cell in one vectorized pass, the index
+          // is only looked up if it improves on the best one
+          double m = best_d2;
+#pragma omp simd reduction(min:m)
+          for (uint32_t i = begin; i < end; i++) {
+            double dx = x[i] - px, dy = y[i] - py, dz = z[i] - pz;
+            double d2 = dx * dx + dy * dy + dz * dz;
+            m = d2 < m ? d2 : m;
+          }
+          if (m < best_d2) {
+            for (uint32_t i = begin; i < end; i++) {
+              double dx = x[i] - px, dy = y[i] - py, dz = z[i] - pz;
+              if (dx * dx + dy * dy + dz * dz == m) {
+                best = i;
+                break;
+              }
+            }
+            best_d2 = m;
+          }
+        }
+      }
+    }
+  }
+
+  return best < 0 ? 0 : const_cast<double*>(&xyz[3 * best]);
+}
@@ -0,0 +1,130 @@
+/*
+ * voxelReducer implementation
+ *
+ * Released under the GPL version 3.
+ *
+ */
+
+/** @file
+ *  @brief Voxel grid point reduction for streamed point clouds
+ */
+
+#include "slam6d/voxelReducer.h"
+#include "slam6d/globals.icc"
+
+#include <cmath>
+#include <limits>
+
+VoxelReducer::VoxelReducer(double voxelSize, int nrpts, size_t minPoints,
+                           unsigned int seed)
+  : voxelSize(voxelSize), nrpts(nrpts), minPoints(minPoints),
+    width(nrpts > 1 ? nrpts : 1), rng(seed)
+{
+}
+
+void VoxelReducer::store(size_t slot, const double* p, const float* r,
+                         const unsigned char* c, int source)
+{
+  for (int j = 0; j < 3; j++) slotXYZ[3*slot + j] = p[j];
+  slotReflectance[slot] = r ? *r : 0.0;
+  for (int j = 0; j < 3; j++) slotRGB[3*slot + j] = c ? c[j] : 0.0;
+  slotSource[slot] = source;
+}
+
+void VoxelReducer::add(const double* xyz, const float* reflectance,
+                       const unsigned char* rgb, size_t n, int source)
+{
+  for (size_t i = 0; i < n; i++) {
+    const double* p = xyz + 3*i;
+    const float* r = reflectance ? reflectance + i : 0;
+    const unsigned char* c = rgb ? rgb + 3*i : 0;
+
+    VoxelKey key = { (int64_t)std::floor(p[0] / voxelSize),
+                     (int64_t)std::floor(p[1] / voxelSize),
+                     (int64_t)std::floor(p[2] / voxelSize) };
+    auto found = voxels.emplace(key, counts.size());
+    size_t v = found.first->second;
+    if (found.second) {
+      counts.push_back(0);
+      slotXYZ.resize(3 * width * counts.size(), 0.0);
+      slotReflectance.resize(width * counts.size(), 0.0);
+      slotRGB.resize(3 * width * counts.size(), 0.0);
+      slotSource.resize(width * counts.size(), source);
+      if (nrpts == 0)
+        centerDist.push_back(std::numeric_limits<double>::max());
+    }
+    uint64_t k = counts[v]++;
+
+    if (nrpts < 0) {
+      // running sums, divided by the count in getPoints
+      for (int j = 0; j < 3; j++) slotXYZ[3*v + j] += p[j];
+      slotReflectance[v] += r ? *r : 0.0;
+      for (int j = 0; j < 3; j++) slotRGB[3*v + j] += c ? c[j] : 0.0;
+    } else if (nrpts == 0) {
+      double d2 = 0.0;
+      double center[3] = { (key.x + 0.5) * voxelSize,
+                           (key.y + 0.5) * voxelSize,
+                           (key.z + 0.5) * voxelSize };
+      for (int j = 0; j < 3; j++) d2 += sqr(p[j] - center[j]);
+      if (d2 < centerDist[v]) {
+        centerDist[v] = d2;
+        store(v, p, r, c, source);
+      }
+    } else {
+      // reservoir sampling keeps a uniform random subset of width points
+      // without knowing how many points will end up in the voxel
+      if (k < width) {
+        store(v * width + k, p, r, c, source);
+      } else {
+        uint64_t s = rng() % (k + 1);
+        if (s < width) store(v * width + s, p, r, c, source);
+      }
+    }
+  }
+}
+
+void VoxelReducer::getPoints(std::vector<double>& xyz,
+                             std::vector<float>* reflectance,
+                             std::vector<unsigned char>* rgb,
+                             std::vector<int>* source) const
+{
+  for (size_t v = 0; v < counts.size(); v++) {
+    if (counts[v] < minPoints) continue;
+
+    if (nrpts < 0) {
+      double n = (double)counts[v];
+      for (int j = 0; j < 3; j++) xyz.push_back(slotXYZ[3*v + j] / n);
+      if (reflectance)
+        reflectance->push_back((float)(slotReflectance[v] / n));
+      if (rgb)
+        for (int j = 0; j < 3; j++)
+          rgb->push_back((unsigned char)(slotRGB[3*v + j] / n + 0.5));
+      if (source)
+        source->push_back(slotSource[v]);
+      continue;
+    }
+
+    size_t kept = counts[v] < width ? (size_t)counts[v] : width;
+    for (size_t s = v * width; s < v * width + kept; s++) {
+      for (int j = 0; j < 3; j++) xyz.push_back(slotXYZ[3*s + j]);
+      if (reflectance)
+        reflectance->push_back((float)slotReflectance[s]);
+      if (rgb)
+        for (int j = 0; j < 3; j++)
+          rgb->push_back((unsigned char)slotRGB[3*s + j]);
+      if (source)
+        source->push_back(slotSource[s]);
+    }
+  }
+}
+
+void VoxelReducer::clear()
+{
+  voxels.clear();
+  counts.clear();
+  centerDist.clear();
+  slotXYZ.clear();
+  slotReflectance.clear();
+  slotRGB.clear();
+  slotSource.clear();
+}
@@ -0,0 +1,59 @@
+/*
+ * Random points and the brute force searches the tests compare the
+ * spatial data structures with.
+ */
+
+#ifndef __TESTING_BRUTE_FORCE_H__
+#define __TESTING_BRUTE_FORCE_H__
+
+#include "slam6d/globals.icc"
+
+#include <stdlib.h>
+#include <cmath>
+#include <algorithm>
+#include <vector>
+
+// uniformly distributed in [dmin, dmax], seed with srand
+static inline double drand(double dmin, double dmax)
+{
+    return dmin + (double)rand() / RAND_MAX * (dmax - dmin);
+}
+
+// closest of the n points with a squared distance below maxdist2
+static inline double *closestPoint(double **pa, size_t n, const double *q,
+                                   double maxdist2)
+{
+    double *best = NULL;
+    for (size_t i = 0; i < n; i++) {
+        double d2 = Dist2(q, pa[i]);
+        if (d2 < maxdist2) {
+            maxdist2 = d2;
+            best = pa[i];
+        }
+    }
+    return best;
+}
+
+// indices of the points in xyz with a squared distance below radius2
+static inline std::vector<int> pointsInRadius(const std::vector<double> &xyz,
+                                              const double *q, double radius2)
+{
+    std::vector<int> result;
+    for (size_t i = 0; i < xyz.size() / 3; i++) {
+        if (Dist2(q, &xyz[3 * i]) < radius2) result.push_back(i);
+    }
+    return result;
+}
+
+// distance of p to the ray o + t * d (d normalized) clamped to [0, tmax]
+static inline double rayDistance(const double *o, const double *d, double tmax,
+                                 const double *p, double &t)
+{
+    double v[3] = {p[0] - o[0], p[1] - o[1], p[2] - o[2]};
+    t = v[0] * d[0] + v[1] * d[1] + v[2] * d[2];
+    t = std::max(0.0, std::min(tmax, t));
+    double e[3] = {v[0] - t * d[0], v[1] - t * d[1], v[2] - t * d[2]};
+    return sqrt(Len2(e));
+}
+
+#endif
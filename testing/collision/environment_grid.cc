@@ -0,0 +1,91 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE environment_grid
+#include <boost/test/unit_test.hpp>
+#include "collision/environmentGrid.h"
+#include "../brute_force.h"
+
+#include <vector>
+
+using namespace std;
+
+#define TEST BOOST_AUTO_TEST_CASE
+
+// environment points that collide with a sphere of the radius around any
+// of the query points, by a linear search
+static vector<bool> linear(const vector<double> &env, const vector<double> &queries,
+                           double radius)
+{
+    vector<bool> colliding(env.size() / 3, false);
+    for (size_t q = 0; q < queries.size(); q += 3) {
+        vector<int> hits = pointsInRadius(env, &queries[q], sqr(radius));
+        for (size_t i = 0; i < hits.size(); i++) colliding[hits[i]] = true;
+    }
+    return colliding;
+}
+
+static vector<bool> grid(vector<double> &env, const vector<double> &queries,
+                         double radius, size_t &num_colliding)
+{
+    DataXYZ xyz(DataPointer((unsigned char*)env.data(), sizeof(double) * env.size()));
+    EnvironmentGrid grid(xyz, radius);
+    for (size_t q = 0; q < queries.size(); q += 3) {
+        grid.collide(&queries[q], sqr(radius));
+    }
+    vector<bool> colliding(env.size() / 3, false);
+    num_colliding = grid.getColliding(colliding);
+    return colliding;
+}
+
+TEST(single_point)
+{
+    vector<double> env = {1.0, 2.0, 3.0};
+    vector<double> near = {1.5, 2.0, 3.0}, far = {1.0, 2.0, 4.5};
+    size_t n;
+    BOOST_CHECK(grid(env, near, 1.0, n)[0]);
+    BOOST_CHECK_EQUAL(n, 1u);
+    BOOST_CHECK(!grid(env, far, 1.0, n)[0]);
+    BOOST_CHECK_EQUAL(n, 0u);
+}
+
+TEST(random_points_match_brute_force)
+{
+    srand(5);
+    // the environment reaches into negative cell coordinates
+    vector<double> env;
+    for (int i = 0; i < 20000; i++) {
+        double p[3] = {drand(-50, 50), drand(-50, 50), drand(-5, 5)};
+        env.insert(env.end(), p, p + 3);
+    }
+    // a model moved along a trajectory, consecutive poses overlap
+    vector<double> queries;
+    for (int pose = 0; pose < 20; pose++) {
+        for (int i = 0; i < 200; i++) {
+            double p[3] = {-40 + 2.0 * pose + drand(-3, 3), drand(-3, 3), drand(-3, 3)};
+            queries.insert(queries.end(), p, p + 3);
+        }
+    }
+
+    double radii[3] = {0.5, 1.0, 3.0};
+    for (int r = 0; r < 3; r++) {
+        size_t n;
+        vector<bool> expected = linear(env, queries, radii[r]);
+        vector<bool> result = grid(env, queries, radii[r], n);
+        BOOST_CHECK(result == expected);
+        BOOST_CHECK_EQUAL(n, (size_t)count(expected.begin(), expected.end(), true));
+        BOOST_CHECK(n > 0);
+    }
+}
+
+TEST(bounding_box_culling)
+{
+    vector<double> env = {0.0, 0.0, 0.0, 10.0, 5.0, 2.0};
+    DataXYZ xyz(DataPointer((unsigned char*)env.data(), sizeof(double) * env.size()));
+    EnvironmentGrid grid(xyz, 1.0);
+    BOOST_CHECK_EQUAL(grid.numCells(), 2u);
+    double lo[3] = {10.5, 5.5, 2.5}, hi[3] = {20.0, 20.0, 20.0};
+    BOOST_CHECK(grid.overlaps(lo, hi));
+    double lo2[3] = {11.5, 0.0, 0.0};
+    BOOST_CHECK(!grid.overlaps(lo2, hi));
+    double lo3[3] = {-20.0, -20.0, -20.0}, hi3[3] = {-1.5, 20.0, 20.0};
+    BOOST_CHECK(!grid.overlaps(lo3, hi3));
+}
@@ -0,0 +1,166 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE occupancy_grid
+#include <boost/test/unit_test.hpp>
+#include "floorplan/occupancyGrid.h"
+
+#include <cmath>
+#include <vector>
+#include <algorithm>
+
+using namespace std;
+using floorplan::OccupancyGrid;
+
+#define TEST BOOST_AUTO_TEST_CASE
+
+// a room of X * Y * Z voxels scanned from its middle
+static const int X = 40, Y = 25, Z = 30;
+static const double scanner[3] = {20.5, 12.5, 15.5};
+
+struct Ray {
+    double dir[3];
+    double range;
+    int hit[3];
+};
+
+// casts rays in all directions to the walls, floor and ceiling of the room
+static vector<Ray> scan()
+{
+    const double size[3] = {X, Y, Z};
+    vector<Ray> rays;
+    for (int i = 0; i < 90; i++) {
+        for (int j = 1; j < 45; j++) {
+            double phi = i * 2 * M_PI / 90, theta = j * M_PI / 45;
+            Ray ray;
+            ray.dir[0] = sin(theta) * cos(phi);
+            ray.dir[1] = cos(theta);
+            ray.dir[2] = sin(theta) * sin(phi);
+            ray.range = 1e9;
+            for (int k = 0; k < 3; k++) {
+                if (ray.dir[k] > 1e-9) {
+                    ray.range = min(ray.range, (size[k] - scanner[k]) / ray.dir[k]);
+                } else if (ray.dir[k] < -1e-9) {
+                    ray.range = min(ray.range, -scanner[k] / ray.dir[k]);
+                }
+            }
+            for (int k = 0; k < 3; k++) {
+                double p = scanner[k] + ray.range * ray.dir[k];
+                ray.hit[k] = max(0, min((int)size[k] - 1, (int)floor(p)));
+            }
+            rays.push_back(ray);
+        }
+    }
+    return rays;
+}
+
+static inline int index(int x, int y, int z)
+{
+    return (x * Y + y) * Z + z;
+}
+
+TEST(empty_grid)
+{
+    OccupancyGrid grid(X, Y, Z);
+    BOOST_CHECK_EQUAL(grid.count(), 0u);
+    BOOST_CHECK_EQUAL(grid.brickCount(), 0u);
+    BOOST_CHECK(!grid.get(0, 0, 0));
+    // outside of the grid
+    grid.set(-1, 0, 0);
+    grid.set(X, 0, 0);
+    grid.set(0, Y, 0);
+    grid.set(0, 0, Z);
+    BOOST_CHECK_EQUAL(grid.count(), 0u);
+    BOOST_CHECK(!grid.get(X, 0, 0));
+    vector<int> layers = grid.layerCounts();
+    BOOST_CHECK_EQUAL(layers.size(), (size_t)Y);
+    BOOST_CHECK_EQUAL(count(layers.begin(), layers.end(), 0), Y);
+}
+
+TEST(marked_cells)
+{
+    vector<Ray> rays = scan();
+    OccupancyGrid grid(X, Y, Z);
+    vector<char> dense(X * Y * Z, 0);
+    for (size_t r = 0; r < rays.size(); r++) {
+        const int *h = rays[r].hit;
+        grid.set(h[0], h[1], h[2]);
+        dense[index(h[0], h[1], h[2])] = 1;
+    }
+
+    size_t occupied = 0;
+    for (int x = 0; x < X; x++) {
+        for (int y = 0; y < Y; y++) {
+            for (int z = 0; z < Z; z++) {
+                BOOST_REQUIRE_EQUAL(grid.get(x, y, z), dense[index(x, y, z)] != 0);
+                occupied += dense[index(x, y, z)];
+            }
+        }
+    }
+    BOOST_CHECK_EQUAL(grid.count(), occupied);
+    // the bricks inside of the room are not stored
+    int bricks = ((X + 7) / 8) * ((Y + 7) / 8) * ((Z + 7) / 8);
+    BOOST_CHECK(grid.brickCount() < (size_t)bricks);
+
+    // projections
+    vector<int> layers = grid.layerCounts();
+    vector<bool> useLayer(Y, false);
+    for (int y = 5; y < 20; y++) useLayer[y] = true;
+    vector<vector<int> > columns = grid.columnCounts(useLayer);
+    BOOST_REQUIRE_EQUAL(columns.size(), (size_t)X);
+    for (int y = 0; y < Y; y++) {
+        int n = 0;
+        for (int x = 0; x < X; x++) {
+            for (int z = 0; z < Z; z++) n += dense[index(x, y, z)];
+        }
+        BOOST_CHECK_EQUAL(layers[y], n);
+    }
+    for (int x = 0; x < X; x++) {
+        BOOST_REQUIRE_EQUAL(columns[x].size(), (size_t)Z);
+        for (int z = 0; z < Z; z++) {
+            int n = 0;
+            for (int y = 5; y < 20; y++) n += dense[index(x, y, z)];
+            BOOST_CHECK_EQUAL(columns[x][z], n);
+        }
+    }
+
+    // merging two halves of the scan gives the same grid
+    OccupancyGrid first(X, Y, Z), second(X, Y, Z);
+    for (size_t r = 0; r < rays.size(); r++) {
+        const int *h = rays[r].hit;
+        (r % 2 ? first : second).set(h[0], h[1], h[2]);
+    }
+    first.merge(second);
+    BOOST_CHECK_EQUAL(first.count(), grid.count());
+    BOOST_CHECK_EQUAL(first.brickCount(), grid.brickCount());
+    BOOST_CHECK(first.layerCounts() == layers);
+}
+
+TEST(free_space_along_rays)
+{
+    vector<Ray> rays = scan();
+    OccupancyGrid grid(X, Y, Z);
+    for (size_t r = 0; r < rays.size(); r++) {
+        const int *h = rays[r].hit;
+        grid.set(h[0], h[1], h[2]);
+    }
+
+    // the voxels a ray traverses before it reaches the layer of voxels
+    // along the walls are free, the hit itself is occupied
+    const int size[3] = {X, Y, Z};
+    size_t traversed = 0;
+    for (size_t r = 0; r < rays.size(); r++) {
+        const Ray &ray = rays[r];
+        for (double t = 0.0; t < ray.range; t += 0.25) {
+            int v[3];
+            bool inside = true;
+            for (int k = 0; k < 3; k++) {
+                v[k] = (int)floor(scanner[k] + t * ray.dir[k]);
+                inside = inside && v[k] > 0 && v[k] < size[k] - 1;
+            }
+            if (!inside) break;
+            BOOST_REQUIRE(!grid.get(v[0], v[1], v[2]));
+            traversed++;
+        }
+        BOOST_CHECK(grid.get(ray.hit[0], ray.hit[1], ray.hit[2]));
+    }
+    BOOST_CHECK(traversed > 40 * rays.size());
+}
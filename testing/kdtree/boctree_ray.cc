@@ -0,0 +1,92 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE boctree_ray
+#include <boost/test/unit_test.hpp>
+#include "slam6d/Boctree.h"
+#include "../brute_force.h"
+
+#include <algorithm>
+
+using namespace std;
+
+#define TEST BOOST_AUTO_TEST_CASE
+
+TEST(single_point)
+{
+    double *pa[1] = {new double[3]{10.0, 0.5, 0.0}};
+    BOctTree<double> tree(pa, 1, 1.0);
+    double o[3] = {0.0, 0.0, 0.0};
+    double d[3] = {2.0, 0.0, 0.0};
+    double t = 0.0;
+    // the tree keeps copies of the points
+    double *hit = tree.FirstHit(o, d, 1.0, 20.0, &t);
+    BOOST_REQUIRE(hit != NULL);
+    BOOST_CHECK(hit[0] == pa[0][0] && hit[1] == pa[0][1] && hit[2] == pa[0][2]);
+    BOOST_CHECK_CLOSE(t, 10.0, 1e-9);
+    // too thin or too short
+    BOOST_CHECK(tree.FirstHit(o, d, 0.4, 20.0) == NULL);
+    BOOST_CHECK(tree.FirstHit(o, d, 1.0, 5.0) == NULL);
+    double e[3] = {-20.0, 0.0, 0.0};
+    BOOST_CHECK(!tree.SegmentOccupied(o, e, 1.0));
+    double f[3] = {20.0, 0.0, 0.0};
+    BOOST_CHECK(tree.SegmentOccupied(o, f, 1.0));
+    delete[] pa[0];
+}
+
+TEST(random_rays_match_brute_force)
+{
+    srand(42);
+    const int n = 20000;
+    double **pa = new double*[n];
+    for (int i = 0; i < n; ++i) {
+        pa[i] = new double[3];
+        for (int k = 0; k < 3; ++k) pa[i][k] = drand(-100.0, 100.0);
+    }
+    BOctTree<double> tree(pa, n, 5.0);
+
+    for (int r = 0; r < 100; ++r) {
+        double o[3], d[3];
+        for (int k = 0; k < 3; ++k) {
+            o[k] = drand(-100.0, 100.0);
+            d[k] = drand(-1.0, 1.0);
+        }
+        double len = sqrt(Len2(d));
+        double dn[3] = {d[0] / len, d[1] / len, d[2] / len};
+        double radius = 1.0 + r % 3, tmax = 150.0;
+
+        double first = tmax + 1.0;
+        size_t count = 0;
+        for (int i = 0; i < n; ++i) {
+            double t;
+            if (rayDistance(o, dn, tmax, pa[i], t) <= radius) {
+                count++;
+                first = min(first, t);
+            }
+        }
+
+        double t = 0.0;
+        double *hit = tree.FirstHit(o, d, radius, tmax, &t);
+        vector<double*> hits;
+        tree.RayHits(o, d, radius, tmax, hits);
+        double end[3] = {o[0] + tmax * dn[0], o[1] + tmax * dn[1], o[2] + tmax * dn[2]};
+
+        BOOST_CHECK_EQUAL(hits.size(), count);
+        BOOST_CHECK_EQUAL(hit != NULL, count > 0);
+        BOOST_CHECK_EQUAL(tree.SegmentOccupied(o, end, radius), count > 0);
+        if (hit != NULL) {
+            BOOST_CHECK_CLOSE(t, first, 1e-9);
+        }
+    }
+
+    // rays to the points themselves hit at most at their target
+    double o[3] = {0.0, 0.0, 0.0};
+    vector<double*> hits(100);
+    vector<double> dists(100);
+    tree.FirstHits(o, pa, 100, 0.5, 0.0, &hits[0], &dists[0]);
+    for (int i = 0; i < 100; ++i) {
+        BOOST_CHECK(hits[i] != NULL);
+        BOOST_CHECK(dists[i] <= sqrt(Len2(pa[i])) + 1e-9);
+    }
+
+    for (int i = 0; i < n; ++i) delete[] pa[i];
+    delete[] pa;
+}
@@ -0,0 +1,67 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE pose_index
+#include <boost/test/unit_test.hpp>
+#include "slam6d/poseIndex.h"
+#include "../brute_force.h"
+
+#include <vector>
+
+using namespace std;
+
+#define TEST BOOST_AUTO_TEST_CASE
+
+TEST(no_poses)
+{
+    PoseIndex index(10.0);
+    double q[3] = {0.0, 0.0, 0.0};
+    vector<int> result(1, 0);
+    index.radiusSearch(q, 100.0, result);
+    BOOST_CHECK(result.empty());
+    BOOST_CHECK_EQUAL(index.size(), 0u);
+}
+
+TEST(random_poses)
+{
+    srand(7);
+    vector<double> pos;
+    PoseIndex index(25.0);
+    for (int id = 0; id < 3000; id++) {
+        double p[3] = {drand(-1000, 1000), drand(-20, 20), drand(-1000, 1000)};
+        pos.insert(pos.end(), p, p + 3);
+        index.insert(id, p);
+    }
+    BOOST_CHECK_EQUAL(index.size(), 3000u);
+
+    // radii smaller and larger than the cell size
+    double radii[3] = {10.0, 25.0, 120.0};
+    vector<int> result;
+    for (int r = 0; r < 3; r++) {
+        for (int i = 0; i < 500; i++) {
+            double q[3] = {drand(-1000, 1000), drand(-20, 20), drand(-1000, 1000)};
+            index.radiusSearch(q, sqr(radii[r]), result);
+            vector<int> expected = pointsInRadius(pos, q, sqr(radii[r]));
+            BOOST_CHECK_EQUAL_COLLECTIONS(result.begin(), result.end(),
+                                          expected.begin(), expected.end());
+        }
+    }
+}
+
+TEST(move_poses)
+{
+    PoseIndex index(5.0);
+    double a[3] = {0.0, 0.0, 0.0}, b[3] = {100.0, 0.0, 0.0};
+    index.insert(0, a);
+    index.insert(1, a);
+    index.insert(1, b);
+    BOOST_CHECK_EQUAL(index.size(), 2u);
+    BOOST_CHECK(index.contains(1));
+    BOOST_CHECK(!index.contains(2));
+
+    vector<int> result;
+    index.radiusSearch(a, 25.0, result);
+    BOOST_CHECK_EQUAL(result.size(), 1u);
+    BOOST_CHECK_EQUAL(result[0], 0);
+    index.radiusSearch(b, 25.0, result);
+    BOOST_CHECK_EQUAL(result.size(), 1u);
+    BOOST_CHECK_EQUAL(result[0], 1);
+}
@@ -0,0 +1,66 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE uniform_grid
+#include <boost/test/unit_test.hpp>
+#include "slam6d/uniformGrid.h"
+#include "../brute_force.h"
+
+#include <vector>
+
+using namespace std;
+
+#define TEST BOOST_AUTO_TEST_CASE
+
+// compares the distances only, equidistant points may be returned by either
+static void compare(double **pa, size_t n, double cellSize, double maxdist2)
+{
+    UniformGridSearch grid(pa, n, cellSize);
+    SearchTree &g = grid;
+    for (int i = 0; i < 2000; i++) {
+        double q[3] = {drand(-120, 120), drand(-120, 120), drand(-30, 30)};
+        double *r1 = g.FindClosest(q, maxdist2);
+        double *r2 = closestPoint(pa, n, q, maxdist2);
+        BOOST_REQUIRE_EQUAL(r1 == NULL, r2 == NULL);
+        if (r1) {
+            BOOST_CHECK_EQUAL(Dist2(q, r1), Dist2(q, r2));
+        }
+    }
+}
+
+TEST(no_points)
+{
+    UniformGridSearch grid(NULL, 0, 1.0);
+    double q[3] = {0.0, 0.0, 0.0};
+    BOOST_CHECK(grid.FindClosest(q, 100.0) == NULL);
+}
+
+TEST(single_point)
+{
+    double p[3] = {1.0, 2.0, 3.0};
+    double *pa[1] = {p};
+    UniformGridSearch grid(pa, 1, 0.5);
+    double q[3] = {1.0, 2.0, 5.0};
+    // the distance has to be below the maximal one
+    BOOST_CHECK(grid.FindClosest(q, 4.0) == NULL);
+    double *r = grid.FindClosest(q, 4.0001);
+    BOOST_REQUIRE(r != NULL);
+    BOOST_CHECK(r[0] == p[0] && r[1] == p[1] && r[2] == p[2]);
+}
+
+TEST(random_points)
+{
+    srand(7);
+    size_t n = 20000;
+    vector<double> pts(3 * n);
+    vector<double*> pa(n);
+    for (size_t i = 0; i < n; i++) {
+        pts[3 * i] = drand(-100, 100);
+        pts[3 * i + 1] = drand(-100, 100);
+        pts[3 * i + 2] = drand(-10, 10);
+        pa[i] = &pts[3 * i];
+    }
+    // dense cell index
+    compare(&pa[0], n, 5.0, sqr(5.0));
+    compare(&pa[0], n, 0.0, sqr(20.0));
+    // sparse cell index, the search reaches over several cells
+    compare(&pa[0], n, 0.3, sqr(1.0));
+}
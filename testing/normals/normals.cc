@@ -0,0 +1,91 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE normals
+#include <boost/test/unit_test.hpp>
+#include "slam6d/normals.h"
+
+#include <cmath>
+#include <cstdlib>
+
+using namespace std;
+
+// A * evec[i] == eval[i] * evec[i], orthonormal eigenvectors, ascending order
+static void check_decomposition(const double A[6], double tol)
+{
+  double eval[3], evec[9];
+  eigenSymmetric3x3(A, eval, evec);
+
+  double scale = 0.0;
+  for (int j = 0; j < 6; ++j) scale = max(scale, fabs(A[j]));
+
+  BOOST_CHECK(eval[0] <= eval[1]);
+  BOOST_CHECK(eval[1] <= eval[2]);
+  for (int i = 0; i < 3; ++i) {
+    const double *v = evec + 3 * i;
+    double Av[3] = { A[0] * v[0] + A[1] * v[1] + A[2] * v[2],
+                     A[1] * v[0] + A[3] * v[1] + A[4] * v[2],
+                     A[2] * v[0] + A[4] * v[1] + A[5] * v[2] };
+    for (int j = 0; j < 3; ++j) {
+      BOOST_CHECK_SMALL(Av[j] - eval[i] * v[j], tol * max(scale, 1.0));
+    }
+    for (int k = 0; k < 3; ++k) {
+      const double *w = evec + 3 * k;
+      double d = v[0] * w[0] + v[1] * w[1] + v[2] * w[2];
+      BOOST_CHECK_SMALL(d - (i == k ? 1.0 : 0.0), tol);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(eigen_diagonal) {
+  double A[6] = { 3.0, 0.0, 0.0, 1.0, 0.0, 2.0 };
+  double eval[3], evec[9];
+  eigenSymmetric3x3(A, eval, evec);
+  BOOST_CHECK_CLOSE(eval[0], 1.0, 1e-9);
+  BOOST_CHECK_CLOSE(eval[1], 2.0, 1e-9);
+  BOOST_CHECK_CLOSE(eval[2], 3.0, 1e-9);
+  BOOST_CHECK_CLOSE(fabs(evec[1]), 1.0, 1e-9);
+  BOOST_CHECK_CLOSE(fabs(evec[5]), 1.0, 1e-9);
+  BOOST_CHECK_CLOSE(fabs(evec[6]), 1.0, 1e-9);
+  check_decomposition(A, 1e-12);
+}
+
+BOOST_AUTO_TEST_CASE(eigen_degenerate) {
+  double zero[6] = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+  check_decomposition(zero, 1e-12);
+  double identity[6] = { 2.0, 0.0, 0.0, 2.0, 0.0, 2.0 };
+  check_decomposition(identity, 1e-12);
+  // double eigenvalues, smallest and largest one repeated
+  double twice_small[6] = { 1.0, 0.0, 0.0, 1.0, 0.0, 5.0 };
+  check_decomposition(twice_small, 1e-12);
+  double twice_large[6] = { 5.0, 0.0, 0.0, 5.0, 0.0, 1.0 };
+  check_decomposition(twice_large, 1e-12);
+  double rank_one[6] = { 1.0, 1.0, 1.0, 1.0, 1.0, 1.0 };
+  check_decomposition(rank_one, 1e-12);
+}
+
+BOOST_AUTO_TEST_CASE(eigen_random) {
+  srand(42);
+  for (int n = 0; n < 1000; ++n) {
+    double A[6];
+    for (int j = 0; j < 6; ++j) {
+      A[j] = (rand() / (double)RAND_MAX - 0.5) * pow(10.0, n % 7 - 3);
+    }
+    check_decomposition(A, 1e-9);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(normal_plane) {
+  // noise free points of the plane x + 2y + 2z = 3
+  vector<Point> points;
+  for (int i = -3; i <= 3; ++i) {
+    for (int j = -3; j <= 3; ++j) {
+      double y = 0.1 * i, z = 0.1 * j + 0.05 * i;
+      points.push_back(Point(3.0 - 2.0 * y - 2.0 * z, y, z));
+    }
+  }
+  double norm[3], eigen[3];
+  calculateNormal(points, norm, eigen);
+  double dot = (norm[0] + 2.0 * norm[1] + 2.0 * norm[2]) / 3.0;
+  BOOST_CHECK_CLOSE(fabs(dot), 1.0, 1e-9);
+  BOOST_CHECK_SMALL(eigen[0], 1e-12);
+  BOOST_CHECK(eigen[1] > 0.0);
+}
@@ -2,6 +2,7 @@
 #define BOOST_TEST_MODULE scanio
 #include <boost/test/unit_test.hpp>
 #include <sstream>
+#include <cstdlib>
 #include <slam6d/pointfilter.h>
 #include <slam6d/io_types.h>
 #include <scanio/helper.h>
@@ -110,4 +111,41 @@ TEST(spec5) {
     BOOST_CHECK(readASCII(inf, spec, transform, filter, &xyz) == true);
 }
 
+// points outside the range are dropped from all channels
+TEST(filter1) {
+    IODataType spec[5] = { DATA_XYZ, DATA_XYZ, DATA_XYZ, DATA_REFLECTANCE, DATA_TERMINATOR };
+    vector<double> xyz, truexyz = { 1.0, 0.0, 0.0, 0.0, 3.0, 0.0 };
+    vector<float> refl, truerefl = { 1.0, 3.0 };
+    PointFilter filter; ScanDataTransform_identity transform;
+    filter.setRange(4.0, 0.5);
+    istringstream inf("1 0 0 1\n0 0 5 2\n0 3 0 3\n0 0 0.1 4\n");
+    BOOST_CHECK(readASCII(inf, spec, transform, filter, &xyz, 0, &refl) == true);
+    BOOST_CHECK_EQUAL_COLLECTIONS(xyz.begin(), xyz.end(), truexyz.begin(), truexyz.end());
+    BOOST_CHECK_EQUAL_COLLECTIONS(refl.begin(), refl.end(), truerefl.begin(), truerefl.end());
+}
+
+// the batch check agrees with checking the points one by one
+TEST(filterBatch) {
+    PointFilter filter, single;
+    filter.setRange(80.0, 10.0).setHeight(30.0, -20.0).setScale(0.5);
+    single.setRange(80.0, 10.0).setHeight(30.0, -20.0).setScale(0.5);
+    size_t n = 10000;
+    vector<double> xyz(3 * n), expected(3 * n);
+    srand(0);
+    for (size_t i = 0; i < 3 * n; ++i)
+        xyz[i] = expected[i] = (rand() % 20000) / 100.0 - 100.0;
+    vector<unsigned char> keep(n);
+    size_t accepted = filter.check(xyz.data(), n, keep.data()), count = 0;
+    for (size_t i = 0; i < n; ++i) {
+        bool accept = single.check(&expected[3 * i]);
+        BOOST_CHECK_EQUAL(accept, keep[i] != 0);
+        if (!accept) continue;
+        count++;
+        for (int k = 0; k < 3; ++k)
+            BOOST_CHECK_EQUAL(xyz[3 * i + k], expected[3 * i + k]);
+    }
+    BOOST_CHECK_EQUAL(accepted, count);
+    BOOST_CHECK(count > 0 && count < n);
+}
+
 /* vim: set ts=4 sw=4 et: */
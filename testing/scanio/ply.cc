@@ -0,0 +1,151 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE ply
+#include <boost/test/unit_test.hpp>
+#include <boost/filesystem/operations.hpp>
+#include <slam6d/pointfilter.h>
+#include <scanio/scan_io_ply.h>
+
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <stdexcept>
+#include <stdint.h>
+
+using namespace std;
+namespace fs = boost::filesystem;
+
+#define TEST BOOST_AUTO_TEST_CASE
+
+struct Vertex {
+    float x;
+    double y;
+    int16_t z;
+    float intensity;
+    unsigned char rgb[3];
+};
+
+static vector<Vertex> vertices()
+{
+    vector<Vertex> v;
+    for (int i = 0; i < 1000; i++) {
+        Vertex p = {0.25f * i, -1.5 * i + 0.125, (int16_t)(i % 300 - 150), 0.5f,
+                    {(unsigned char)i, (unsigned char)(3 * i), (unsigned char)(255 - i % 256)}};
+        v.push_back(p);
+    }
+    return v;
+}
+
+// the header of a vertex element with the given format, colour names and
+// an optional list property that makes the vertex size variable
+static string header(const string &format, size_t count, const string &color,
+                     bool list = false)
+{
+    ostringstream out;
+    out << "ply\nformat " << format << " 1.0\ncomment test\n"
+        << "element vertex " << count << "\n"
+        << "property float x\nproperty double y\nproperty short z\n"
+        << "property float intensity\n"
+        << "property uchar " << color << "red\n"
+        << "property uchar " << color << "green\n"
+        << "property uchar " << color << "blue\n";
+    if (list) out << "property list uchar int index\n";
+    out << "end_header\n";
+    return out.str();
+}
+
+static void writeBinary(const fs::path &path, const vector<Vertex> &v,
+                        const string &color = "", bool list = false)
+{
+    ofstream out(path.string().c_str(), ios::binary);
+    out << header("binary_little_endian", v.size(), color, list);
+    for (size_t i = 0; i < v.size(); i++) {
+        out.write((const char*)&v[i].x, 4);
+        out.write((const char*)&v[i].y, 8);
+        out.write((const char*)&v[i].z, 2);
+        out.write((const char*)&v[i].intensity, 4);
+        out.write((const char*)v[i].rgb, 3);
+        if (list) {
+            unsigned char n = 1;
+            int32_t index = i;
+            out.write((const char*)&n, 1);
+            out.write((const char*)&index, 4);
+        }
+    }
+}
+
+static void writeAscii(const fs::path &path, const vector<Vertex> &v)
+{
+    ofstream out(path.string().c_str());
+    out << header("ascii", v.size(), "");
+    out.precision(17);
+    for (size_t i = 0; i < v.size(); i++) {
+        out << v[i].x << " " << v[i].y << " " << v[i].z << " " << v[i].intensity
+            << " " << (int)v[i].rgb[0] << " " << (int)v[i].rgb[1] << " "
+            << (int)v[i].rgb[2] << "\n";
+    }
+}
+
+static void read(const fs::path &dir, const char *identifier,
+                 vector<double> &xyz, vector<unsigned char> &rgb)
+{
+    ScanIO_ply sio;
+    PointFilter filter;
+    xyz.clear();
+    rgb.clear();
+    sio.readScan(dir.string().c_str(), identifier, filter, &xyz, &rgb,
+                 0, 0, 0, 0, 0, 0);
+}
+
+TEST(binary_matches_ascii)
+{
+    fs::path dir = fs::temp_directory_path() / fs::unique_path();
+    fs::create_directories(dir);
+    vector<Vertex> v = vertices();
+    // fixed layout, read without rply
+    writeBinary(dir / "scan000.ply", v);
+    // read by rply
+    writeAscii(dir / "scan001.ply", v);
+    writeBinary(dir / "scan002.ply", v, "", true);
+    writeBinary(dir / "scan003.ply", v, "diffuse_");
+
+    vector<double> xyz, expected_xyz;
+    vector<unsigned char> rgb, expected_rgb;
+    read(dir, "001", expected_xyz, expected_rgb);
+    BOOST_REQUIRE_EQUAL(expected_xyz.size(), 3 * v.size());
+    BOOST_CHECK_EQUAL(expected_xyz[3 * 5 + 1], v[5].y);
+    BOOST_CHECK_EQUAL(expected_rgb[3 * 7 + 2], v[7].rgb[2]);
+
+    const char *identifiers[3] = {"000", "002", "003"};
+    for (int i = 0; i < 3; i++) {
+        read(dir, identifiers[i], xyz, rgb);
+        BOOST_CHECK_EQUAL_COLLECTIONS(xyz.begin(), xyz.end(),
+                                      expected_xyz.begin(), expected_xyz.end());
+        BOOST_CHECK_EQUAL_COLLECTIONS(rgb.begin(), rgb.end(),
+                                      expected_rgb.begin(), expected_rgb.end());
+    }
+
+    // appends to the given vectors like the rply path
+    ScanIO_ply sio;
+    PointFilter filter;
+    sio.readScan(dir.string().c_str(), "000", filter, &xyz, &rgb, 0, 0, 0, 0, 0, 0);
+    BOOST_CHECK_EQUAL(xyz.size(), 2 * expected_xyz.size());
+    BOOST_CHECK(equal(expected_xyz.begin(), expected_xyz.end(),
+                      xyz.begin() + expected_xyz.size()));
+
+    fs::remove_all(dir);
+}
+
+TEST(truncated_binary)
+{
+    fs::path dir = fs::temp_directory_path() / fs::unique_path();
+    fs::create_directories(dir);
+    vector<Vertex> v = vertices();
+    writeBinary(dir / "scan000.ply", v);
+    // the header announces more vertices than the file holds, which is
+    // left to rply and its error
+    fs::resize_file(dir / "scan000.ply", fs::file_size(dir / "scan000.ply") - 10);
+    vector<double> xyz;
+    vector<unsigned char> rgb;
+    BOOST_CHECK_THROW(read(dir, "000", xyz, rgb), runtime_error);
+    fs::remove_all(dir);
+}
@@ -6,6 +6,7 @@
 #include <slam6d/io_types.h>
 #include <slam6d/globals.icc>
 #include <slam6d/scan.h>
+#include <scanio/scan_io.h>
 
 #define TOLERANCE 0.0000000000001
 
@@ -79,4 +80,36 @@ BOOST_AUTO_TEST_CASE(readscans_xyz) {
     Scan::closeDirectory();
 }
 
+BOOST_AUTO_TEST_CASE(readscans_uos_chunked) {
+    ScanIO* sio = ScanIO::getScanIO(UOS);
+    PointFilter filter;
+    size_t nr_points = 0, nr_chunks = 0;
+    double first[3];
+    sio->readScanChunked("../data/icosphere/uos/", "000", filter, 1000,
+            [&](ScanChunk& chunk) -> bool {
+        BOOST_CHECK(chunk.size() <= 1000);
+        if (nr_points == 0) {
+            for (int i = 0; i < 3; i++) first[i] = chunk.xyz[i];
+        }
+        nr_points += chunk.size();
+        nr_chunks++;
+        return true;
+    });
+    // the chunks have to add up to the whole scan
+    BOOST_CHECK(nr_points == 20472);
+    BOOST_CHECK(nr_chunks == 21);
+    BOOST_CHECK(first[0] == -0.525731);
+    BOOST_CHECK(first[1] == 0.850651);
+    BOOST_CHECK(first[2] == 0);
+
+    // returning false stops after the first chunk
+    nr_points = 0;
+    sio->readScanChunked("../data/icosphere/uos/", "000", filter, 1000,
+            [&](ScanChunk& chunk) -> bool {
+        nr_points += chunk.size();
+        return false;
+    });
+    BOOST_CHECK(nr_points == 1000);
+}
+
 /* vim: set ts=4 sw=4 et: */
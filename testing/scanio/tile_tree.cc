@@ -0,0 +1,191 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE tile_tree
+#include <boost/test/unit_test.hpp>
+#include <boost/filesystem/operations.hpp>
+#include <scanio/tile_tree.h>
+#include "../brute_force.h"
+
+#include <cmath>
+#include <vector>
+#include <algorithm>
+
+using namespace std;
+namespace fs = boost::filesystem;
+
+#define TEST BOOST_AUTO_TEST_CASE
+
+// three scans with a ground plane, a wall and a dense cluster
+static vector<vector<double> > make_scans()
+{
+    srand(3);
+    vector<vector<double> > scans(3);
+    for (int i = 0; i < 60000; i++) {
+        double p[3] = {drand(-500, 500), -100, drand(-500, 500)};
+        scans[0].insert(scans[0].end(), p, p + 3);
+        double q[3] = {drand(-500, 500), drand(-100, 200), 300};
+        scans[1].insert(scans[1].end(), q, q + 3);
+        double r[3] = {drand(10, 12), drand(10, 12), drand(10, 12)};
+        scans[2].insert(scans[2].end(), r, r + 3);
+    }
+    return scans;
+}
+
+// coordinates rounded to the quantization step, sorted
+static vector<vector<long> > quantized(const vector<double> &xyz, double min_x,
+                                       double min_y, double min_z, double step)
+{
+    vector<vector<long> > result;
+    for (size_t i = 0; i < xyz.size(); i += 3) {
+        vector<long> q(3);
+        q[0] = lround((xyz[i] - min_x) / step);
+        q[1] = lround((xyz[i + 1] - min_y) / step);
+        q[2] = lround((xyz[i + 2] - min_z) / step);
+        result.push_back(q);
+    }
+    sort(result.begin(), result.end());
+    return result;
+}
+
+static vector<double> read_tree(const TileTree &tree, int level,
+                                const double *min = 0, const double *max = 0)
+{
+    vector<double> xyz;
+    tree.read(level, min, max, 7000, [&](ScanChunk &chunk) -> bool {
+        BOOST_CHECK(chunk.size() <= 7000);
+        BOOST_CHECK_EQUAL(chunk.reflectance.size(), chunk.size());
+        BOOST_CHECK_EQUAL(chunk.rgb.size(), 3 * chunk.size());
+        xyz.insert(xyz.end(), chunk.xyz.begin(), chunk.xyz.end());
+        return true;
+    });
+    return xyz;
+}
+
+TEST(build_and_read)
+{
+    vector<vector<double> > scans = make_scans();
+    fs::path dir = fs::temp_directory_path() / fs::unique_path();
+    {
+        // small tiles, chunks and buffers to exercise all stages
+        TileTreeWriter writer(dir.string(), 0.1, 2000, 30000, 10000);
+        writer.build(scans.size(), [&](size_t s, ScanChunkHandler handler) {
+            ScanChunk chunk;
+            for (size_t i = 0; i < scans[s].size(); i += 3 * 5000) {
+                chunk.clear();
+                size_t end = min(i + 3 * 5000, scans[s].size());
+                chunk.xyz.assign(scans[s].begin() + i, scans[s].begin() + end);
+                handler(chunk);
+            }
+        });
+    }
+
+    TileTree tree(dir.string());
+    BOOST_CHECK(tree.getDepth() > 2);
+    BOOST_CHECK(!fs::exists(dir / "tmp"));
+    double min[3], max[3];
+    tree.getBounds(min, max);
+
+    // every point is stored once
+    vector<double> all;
+    for (size_t s = 0; s < scans.size(); s++)
+        all.insert(all.end(), scans[s].begin(), scans[s].end());
+    vector<double> xyz = read_tree(tree, tree.getDepth());
+    BOOST_CHECK_EQUAL(tree.countPoints(tree.getDepth()), all.size() / 3);
+    BOOST_CHECK(quantized(xyz, min[0], min[1], min[2], 0.1)
+                == quantized(all, min[0], min[1], min[2], 0.1));
+
+    // the levels add up, a level below a split dense chunk may add nothing
+    // once the tiles are sampled at the quantization step
+    size_t previous = 0;
+    for (int level = 0; level <= tree.getDepth(); level++) {
+        size_t n = read_tree(tree, level).size() / 3;
+        BOOST_CHECK_EQUAL(n, tree.countPoints(level));
+        BOOST_CHECK(n >= previous);
+        previous = n;
+    }
+    BOOST_CHECK(tree.countPoints(1) > tree.countPoints(0));
+
+    // a region gives the same points as filtering the whole tree
+    double rmin[3] = {-50, -150, 250}, rmax[3] = {120, 50, 320};
+    vector<double> expected;
+    for (size_t i = 0; i < xyz.size(); i += 3) {
+        if (xyz[i] >= rmin[0] && xyz[i] <= rmax[0] && xyz[i + 1] >= rmin[1]
+            && xyz[i + 1] <= rmax[1] && xyz[i + 2] >= rmin[2]
+            && xyz[i + 2] <= rmax[2]) {
+            expected.insert(expected.end(), &xyz[i], &xyz[i] + 3);
+        }
+    }
+    vector<double> region = read_tree(tree, tree.getDepth(), rmin, rmax);
+    BOOST_CHECK(expected.size() > 0);
+    BOOST_CHECK(quantized(region, 0, 0, 0, 0.1) == quantized(expected, 0, 0, 0, 0.1));
+
+    fs::remove_all(dir);
+}
+
+TEST(dense_cell)
+{
+    // all points of the cluster fall into one cell of the counting grid
+    vector<vector<double> > scans = make_scans();
+    scans.erase(scans.begin(), scans.begin() + 2);
+    fs::path dir = fs::temp_directory_path() / fs::unique_path();
+    double min[3] = {-500, -500, -500}, max[3] = {500, 500, 500};
+    {
+        TileTreeWriter writer(dir.string(), 0.1, 2000, 30000, 10000);
+        writer.setBounds(min, max);
+        writer.build(scans.size(), [&](size_t s, ScanChunkHandler handler) {
+            ScanChunk chunk;
+            chunk.xyz = scans[s];
+            handler(chunk);
+        });
+        BOOST_CHECK(writer.getLargestChunk() > 0);
+        BOOST_CHECK(writer.getLargestChunk() <= 30000);
+    }
+
+    TileTree tree(dir.string());
+    BOOST_CHECK(!fs::exists(dir / "tmp"));
+    vector<double> xyz = read_tree(tree, tree.getDepth());
+    BOOST_CHECK_EQUAL(tree.countPoints(tree.getDepth()), scans[0].size() / 3);
+    BOOST_CHECK(quantized(xyz, min[0], min[1], min[2], 0.1)
+                == quantized(scans[0], min[0], min[1], min[2], 0.1));
+
+    fs::remove_all(dir);
+}
+
+TEST(rebuild_after_abort)
+{
+    vector<vector<double> > scans = make_scans();
+    size_t nr_points = 0;
+    for (size_t s = 0; s < scans.size(); s++) nr_points += scans[s].size() / 3;
+    fs::path dir = fs::temp_directory_path() / fs::unique_path();
+
+    // calls of the stream, the last one is aborted in the first build
+    size_t calls = 0, abort_at = 0;
+    TileTreeWriter::ScanStream stream = [&](size_t s, ScanChunkHandler handler) {
+        if (++calls == abort_at) throw runtime_error("aborted");
+        ScanChunk chunk;
+        chunk.xyz = scans[s];
+        handler(chunk);
+    };
+    {
+        TileTreeWriter writer((dir / "full").string(), 0.1, 2000, 30000, 10000);
+        writer.build(scans.size(), stream);
+    }
+    abort_at = calls;
+    calls = 0;
+    {
+        TileTreeWriter writer(dir.string(), 0.1, 2000, 30000, 10000);
+        BOOST_CHECK_THROW(writer.build(scans.size(), stream), runtime_error);
+    }
+    BOOST_CHECK(fs::exists(dir / "tmp"));
+    abort_at = 0;
+    {
+        TileTreeWriter writer(dir.string(), 0.1, 2000, 30000, 10000);
+        writer.build(scans.size(), stream);
+    }
+
+    // the chunks of the aborted build are not part of the tiles
+    TileTree tree(dir.string());
+    BOOST_CHECK_EQUAL(tree.countPoints(tree.getDepth()), nr_points);
+    BOOST_CHECK_EQUAL(read_tree(tree, tree.getDepth()).size() / 3, nr_points);
+
+    fs::remove_all(dir);
+}
@@ -2,6 +2,8 @@
 #define BOOST_TEST_MODULE segmentation
 #include <boost/test/unit_test.hpp>
 #include <segmentation/segment-graph.h>
+#include <vector>
+#include <algorithm>
 
 using namespace std;
 
@@ -22,3 +24,26 @@ BOOST_AUTO_TEST_CASE(segmentgraph) {
     BOOST_CHECK(uni->find(i) == 1);
   }
 }
+
+BOOST_AUTO_TEST_CASE(sortedges) {
+  // large enough to take the radix sort path, with negative weights and
+  // many duplicates to check stability
+  const int n = 100000;
+  vector<edge> e(n);
+  unsigned int seed = 42;
+  for (int i = 0; i < n; i++) {
+    seed = seed * 1103515245 + 12345;
+    e[i].w = ((int)(seed >> 16) % 2000 - 1000) / 8.0f;
+    e[i].a = i;
+    e[i].b = 0;
+  }
+  vector<edge> expected(e);
+  stable_sort(expected.begin(), expected.end());
+
+  sort_edges(n, e.data());
+
+  for (int i = 0; i < n; i++) {
+    BOOST_CHECK(e[i].w == expected[i].w);
+    BOOST_CHECK(e[i].a == expected[i].a);
+  }
+}
@@ -0,0 +1,133 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE deferred_icp
+#include <boost/test/unit_test.hpp>
+#include "slam6d/basicScan.h"
+#include "slam6d/metaScan.h"
+#include "slam6d/icp6D.h"
+#include "slam6d/icp6Dquat.h"
+#include "../brute_force.h"
+
+#include <cmath>
+#include <vector>
+
+using namespace std;
+
+#define TEST BOOST_AUTO_TEST_CASE
+
+// three walls of a room corner and a slanted plane, in [0, 10]^3
+static vector<vector<double> > corner()
+{
+    srand(11);
+    vector<vector<double> > pts;
+    for (int i = 0; i < 1500; i++) {
+        double u = drand(0, 10), v = drand(0, 10);
+        pts.push_back({0, u, v});
+        pts.push_back({u, 0, v});
+        pts.push_back({u, v, 0});
+        pts.push_back({u, 10 - 0.5 * u, v});
+    }
+    return pts;
+}
+
+static Scan *makeScan(const vector<vector<double> > &pts, size_t begin,
+                      size_t end, const double *pose)
+{
+    vector<double*> p;
+    for (size_t i = begin; i < end; i++) p.push_back(const_cast<double*>(pts[i].data()));
+    double rPos[3] = {pose[0], pose[1], pose[2]};
+    double rPosTheta[3] = {pose[3], pose[4], pose[5]};
+    Scan *scan = new BasicScan(rPos, rPosTheta, p);
+    scan->setSearchTreeParameter(simpleKD);
+    scan->toGlobal();
+    return scan;
+}
+
+struct Result {
+    int iterations;
+    // pose and reduced points of every moving scan
+    vector<vector<double> > transMat;
+    vector<vector<double> > reduced;
+    // largest distance of a matched point to its original position
+    double error;
+};
+
+// matches the corner seen from a slightly wrong pose to the corner, the
+// moving points are split into two scans of a meta scan if meta is set
+static Result match(bool deferred, bool meta)
+{
+    vector<vector<double> > pts = corner();
+    double origin[6] = {0, 0, 0, 0, 0, 0};
+    double offset[6] = {0.3, -0.2, 0.25, rad(2.0), rad(-1.5), rad(3.0)};
+
+    Scan *model = makeScan(pts, 0, pts.size(), origin);
+    model->createSearchTree();
+    vector<Scan*> moving;
+    if (meta) {
+        moving.push_back(makeScan(pts, 0, pts.size() / 2, offset));
+        moving.push_back(makeScan(pts, pts.size() / 2, pts.size(), offset));
+    } else {
+        moving.push_back(makeScan(pts, 0, pts.size(), offset));
+    }
+    Scan *current = meta ? new MetaScan(moving) : moving[0];
+
+    icp6D_QUAT minimizer(true);
+    icp6D icp(&minimizer, 1.0, 100, true);
+    icp.set_deferred_transform(deferred);
+
+    Result result;
+    result.iterations = icp.match(model, current);
+    result.error = 0.0;
+    size_t first = 0;
+    for (size_t s = 0; s < moving.size(); s++) {
+        BOOST_CHECK(moving[s]->getPendingTransform() == 0);
+        const double *m = moving[s]->get_transMat();
+        result.transMat.push_back(vector<double>(m, m + 16));
+        DataXYZ xyz(moving[s]->get("xyz reduced"));
+        vector<double> r;
+        for (size_t i = 0; i < xyz.size(); i++) {
+            r.insert(r.end(), xyz[i], xyz[i] + 3);
+            result.error = max(result.error, sqrt(Dist2(xyz[i], pts[first + i].data())));
+        }
+        first += xyz.size();
+        result.reduced.push_back(r);
+    }
+
+    if (meta) delete current;
+    for (size_t s = 0; s < moving.size(); s++) delete moving[s];
+    delete model;
+    return result;
+}
+
+static void compare(const Result &eager, const Result &deferred)
+{
+    BOOST_CHECK_EQUAL(eager.iterations, deferred.iterations);
+    BOOST_REQUIRE_EQUAL(eager.transMat.size(), deferred.transMat.size());
+    for (size_t s = 0; s < eager.transMat.size(); s++) {
+        for (int i = 0; i < 16; i++) {
+            BOOST_CHECK_SMALL(eager.transMat[s][i] - deferred.transMat[s][i], 1e-9);
+        }
+        BOOST_REQUIRE_EQUAL(eager.reduced[s].size(), deferred.reduced[s].size());
+        double worst = 0.0;
+        for (size_t i = 0; i < eager.reduced[s].size(); i++) {
+            worst = max(worst, fabs(eager.reduced[s][i] - deferred.reduced[s][i]));
+        }
+        BOOST_CHECK_SMALL(worst, 1e-9);
+    }
+    // the matching undid the offset
+    BOOST_CHECK_SMALL(eager.error, 1e-3);
+    BOOST_CHECK_SMALL(deferred.error, 1e-3);
+}
+
+TEST(single_scan)
+{
+    Result eager = match(false, false);
+    BOOST_CHECK(eager.iterations > 1);
+    compare(eager, match(true, false));
+}
+
+TEST(meta_scan)
+{
+    Result eager = match(false, true);
+    BOOST_CHECK(eager.iterations > 1);
+    compare(eager, match(true, true));
+}
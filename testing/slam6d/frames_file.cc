@@ -0,0 +1,92 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE frames_file
+#include <boost/test/unit_test.hpp>
+#include "slam6d/framesFile.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdint.h>
+#include <vector>
+
+using namespace std;
+
+#define TEST BOOST_AUTO_TEST_CASE
+
+static void identity(double *m)
+{
+    for (int k = 0; k < 16; k++) m[k] = (k % 5 == 0) ? 1.0 : 0.0;
+}
+
+// reads a uint64 of the file header at the given byte offset
+static uint64_t headerField(const string &filename, size_t offset)
+{
+    ifstream file(filename.c_str(), ios::binary);
+    vector<char> data((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+    uint64_t value = 0;
+    BOOST_REQUIRE(data.size() >= offset + sizeof(value));
+    memcpy(&value, &data[offset], sizeof(value));
+    return value;
+}
+
+static void checkRoundTrip(const string &filename, const vector<Frame> &frames)
+{
+    FramesFile file(filename);
+    BOOST_REQUIRE(file.size() == frames.size());
+    for (size_t i = 0; i < frames.size(); i++) {
+        Frame f;
+        file.get(i, f);
+        BOOST_CHECK(f.type == frames[i].type);
+        for (int k = 0; k < 16; k++)
+            BOOST_CHECK_CLOSE(f.transformation[k] + 1.0, frames[i].transformation[k] + 1.0, 1e-7);
+    }
+}
+
+TEST(changed_poses)
+{
+    vector<Frame> frames;
+    double m[16];
+    identity(m);
+    for (int i = 0; i < 300; i++) {
+        m[12] = i * 0.5;
+        m[13] = -i;
+        frames.push_back(Frame(m, i % 3));
+    }
+
+    const char *formats[] = { "binary", "delta" };
+    FramesFormat format[] = { FRAMES_BINARY, FRAMES_BINARY_DELTA };
+    for (int j = 0; j < 2; j++) {
+        string filename = string("frames_file_") + formats[j] + ".frames";
+        FramesFile::write(filename, frames.data(), frames.size(), format[j]);
+        BOOST_CHECK(FramesFile::isBinary(filename));
+        checkRoundTrip(filename, frames);
+        remove(filename.c_str());
+    }
+}
+
+TEST(repeats_with_changing_type)
+{
+    // one pose repeated over and over, every frame with another type than
+    // the previous one, so each frame is a record of its own
+    vector<Frame> frames;
+    double m[16];
+    identity(m);
+    m[12] = 3.0;
+    for (int i = 0; i < 1000; i++) frames.push_back(Frame(m, i % 2));
+
+    string filename = "frames_file_repeats.frames";
+    FramesFile::write(filename, frames.data(), frames.size(), FRAMES_BINARY_DELTA);
+    checkRoundTrip(filename, frames);
+
+    // header: magic, version, key_interval, frames, records, index_offset,
+    // index_entries
+    uint64_t records = headerField(filename, 24);
+    uint64_t keys = headerField(filename, 40);
+    BOOST_CHECK(records == frames.size());
+    // at most key_interval records follow a key frame
+    BOOST_CHECK(records <= keys * (FramesFile::key_interval + 1));
+    remove(filename.c_str());
+}
+
+/* vim: set ts=4 sw=4 et: */
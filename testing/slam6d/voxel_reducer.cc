@@ -0,0 +1,121 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE voxel_reducer
+#include <boost/test/unit_test.hpp>
+#include "slam6d/voxelReducer.h"
+#include "slam6d/provenance.h"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+#define TEST BOOST_AUTO_TEST_CASE
+
+// three scans, the last one without points
+static void addSources(VoxelReducer &reducer)
+{
+    // voxel (0,0,0) and voxel (2,0,0)
+    double scan0[] = { 0.1, 0.1, 0.1,   2.2, 0.5, 0.5 };
+    // voxel (0,0,0) closer to its center, voxel (2,0,0) farther from its
+    // center and the new voxel (-1,0,0)
+    double scan1[] = { 0.5, 0.5, 0.5,   2.9, 0.9, 0.9,   -0.5, 0.5, 0.5 };
+    float refl0[] = { 1.0f, 2.0f };
+    float refl1[] = { 3.0f, 4.0f, 5.0f };
+    reducer.add(scan0, refl0, 0, 2, 0);
+    reducer.add(scan1, refl1, 0, 3, 1);
+    reducer.add(0, 0, 0, 0, 2);
+}
+
+TEST(closest_to_center)
+{
+    VoxelReducer reducer(1.0);
+    addSources(reducer);
+    BOOST_CHECK(reducer.size() == 3);
+
+    vector<double> xyz;
+    vector<float> refl;
+    vector<int> source;
+    reducer.getPoints(xyz, &refl, 0, &source);
+    // in the order the voxels were first seen
+    double expected[] = { 0.5, 0.5, 0.5,   2.2, 0.5, 0.5,   -0.5, 0.5, 0.5 };
+    BOOST_REQUIRE(xyz.size() == 9);
+    for (int i = 0; i < 9; i++) BOOST_CHECK(xyz[i] == expected[i]);
+    BOOST_REQUIRE(refl.size() == 3);
+    BOOST_CHECK(refl[0] == 3.0f);
+    BOOST_CHECK(refl[1] == 2.0f);
+    BOOST_CHECK(refl[2] == 5.0f);
+    BOOST_REQUIRE(source.size() == 3);
+    BOOST_CHECK(source[0] == 1);
+    BOOST_CHECK(source[1] == 0);
+    BOOST_CHECK(source[2] == 1);
+}
+
+TEST(average)
+{
+    VoxelReducer reducer(1.0, -1);
+    addSources(reducer);
+
+    vector<double> xyz;
+    vector<int> source;
+    reducer.getPoints(xyz, 0, 0, &source);
+    BOOST_REQUIRE(xyz.size() == 9);
+    BOOST_CHECK_CLOSE(xyz[0], 0.3, 1e-9);
+    BOOST_CHECK_CLOSE(xyz[3], 2.55, 1e-9);
+    BOOST_CHECK_CLOSE(xyz[4], 0.7, 1e-9);
+    // averaged voxels report the source of their first point
+    BOOST_REQUIRE(source.size() == 3);
+    BOOST_CHECK(source[0] == 0);
+    BOOST_CHECK(source[1] == 0);
+    BOOST_CHECK(source[2] == 1);
+}
+
+TEST(min_points)
+{
+    VoxelReducer reducer(1.0, 0, 2);
+    addSources(reducer);
+
+    vector<double> xyz;
+    vector<int> source;
+    reducer.getPoints(xyz, 0, 0, &source);
+    // the voxel with a single point is dropped
+    BOOST_CHECK(xyz.size() == 6);
+    BOOST_CHECK(source.size() == 2);
+
+    reducer.clear();
+    BOOST_CHECK(reducer.size() == 0);
+}
+
+TEST(provenance_round_trip)
+{
+    VoxelReducer reducer(1.0);
+    addSources(reducer);
+    vector<double> xyz;
+    vector<int> source;
+    reducer.getPoints(xyz, 0, 0, &source);
+
+    vector<string> identifiers;
+    identifiers.push_back("000");
+    identifiers.push_back("001");
+    identifiers.push_back("002");
+    {
+        ofstream srcout("scan000.src");
+        writeProvenance(srcout, identifiers, source);
+    }
+
+    vector<string> read_identifiers;
+    vector<size_t> counts;
+    BOOST_REQUIRE(readProvenance("", 0, read_identifiers, &counts));
+    BOOST_CHECK(read_identifiers == identifiers);
+    BOOST_REQUIRE(counts.size() == 3);
+    BOOST_CHECK(counts[0] == 1);
+    BOOST_CHECK(counts[1] == 2);
+    // the empty scan is still listed
+    BOOST_CHECK(counts[2] == 0);
+    remove("scan000.src");
+
+    BOOST_CHECK(!readProvenance("", 1, read_identifiers));
+}
+
+/* vim: set ts=4 sw=4 et: */